@@ -26,6 +26,8 @@ struct opt_t {
 	std::vector <size_t> cratios2d;
 	std::vector <string> xvarnames;
 	std::vector <string> xdimnames;
+	int qbits;
+	OptionParser::Boolean_T	fast;
 	OptionParser::Boolean_T	debug;
 	OptionParser::Boolean_T	quiet;
 	OptionParser::Boolean_T	help;
@@ -72,6 +74,13 @@ OptionParser::OptDescRec_T	set_opts[] = {
 		"xdimnames",1, "", "Colon delimited list of dimension names "
 		"to exclude from compression."
     },
+	{
+		"qbits",1, "0", "Number of bits to which the wavelet coefficients "
+		"of floating point variables are quantized, in the range 2 to 32. "
+		"0 => no quantization"
+	},
+	{"fast",	0,	"",	"Compress with the fast wavelet transform, "
+		"which differs from the default by rounding"},
 	{"debug",	0,	"",	"Enable diagnostic"},
 	{"quiet",	0,	"",	"Operate quietly"},
 	{"help",	0,	"",	"Print this message and exit"},
@@ -90,6 +99,8 @@ OptionParser::Option_T	get_options[] = {
 	{"cratios2d",Wasp::CvtToSize_tVec,&opt.cratios2d,sizeof(opt.cratios2d)},
     {"xvarnames", Wasp::CvtToStrVec, &opt.xvarnames, sizeof(opt.xvarnames)},
     {"xdimnames", Wasp::CvtToStrVec, &opt.xdimnames, sizeof(opt.xdimnames)},
+	{"qbits", Wasp::CvtToInt, &opt.qbits, sizeof(opt.qbits)},
+	{"fast", Wasp::CvtToBoolean, &opt.fast, sizeof(opt.fast)},
 	{"debug", Wasp::CvtToBoolean, &opt.debug, sizeof(opt.debug)},
 	{"quiet", Wasp::CvtToBoolean, &opt.quiet, sizeof(opt.quiet)},
 	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
@@ -414,6 +425,11 @@ void Process(string ncdffile, string waspfile) {
 		exit(1);
 	}
 
+	rc = wasp.SetQuantization(opt.qbits);
+	if (rc < 0) exit(1);
+
+	wasp.SetFastTransform(opt.fast);
+
 	rc = DefFile(ncdf, wasp);
 	if (rc < 0) exit(1);
 
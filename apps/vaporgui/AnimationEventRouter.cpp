@@ -458,6 +458,10 @@ void AnimationEventRouter::SetFrameRate(int rate) {
 void AnimationEventRouter::setPlay(int direction) {
 	_direction = direction;
 
+	// Read ahead the next frame's data while the current one is drawn
+	//
+	_controlExec->SetPrefetch(_direction != 0);
+
 	if (_direction) {
 
 		// If on is true send notification (signal) that we are in
@@ -41,6 +41,7 @@
 #include <QToolBar>
 #include <QComboBox>
 #include <QMessageBox>
+#include <QPushButton>
 #include <QFileDialog>
 #include <QUrl>
 #include <QDesktopServices>
@@ -212,6 +213,7 @@ void MainForm::_initMembers() {
 	_dataClose_MetafileAction = NULL;
 	_plotAction = NULL;
 	_statsAction = NULL;
+	_cacheStatsAction = NULL;
 
 	_captureStartJpegCaptureAction = NULL;
 	_captureEndJpegCaptureAction = NULL;
@@ -909,9 +911,14 @@ void MainForm::_createToolsMenu() {
 	_statsAction->setText("Data Statistics");
 	_statsAction->setEnabled(false);
 
+	_cacheStatsAction = new QAction(this);
+	_cacheStatsAction->setText("Cache Statistics");
+	_cacheStatsAction->setEnabled(false);
+
 	_Tools = menuBar()->addMenu(tr("Tools"));
 	_Tools->addAction(_plotAction);
 	_Tools->addAction(_statsAction);
+	_Tools->addAction(_cacheStatsAction);
 
 	connect(
 		_statsAction, SIGNAL(triggered()),
@@ -921,6 +928,10 @@ void MainForm::_createToolsMenu() {
 		_plotAction, SIGNAL(triggered()),
 		this, SLOT(launchPlotUtility())
 	);
+	connect(
+		_cacheStatsAction, SIGNAL(triggered()),
+		this, SLOT(launchCacheStats())
+	);
 
 }
 
@@ -2136,6 +2147,7 @@ void MainForm::enableWidgets(bool onOff) {
 	_tabMgr->setEnabled(onOff);
 	_statsAction->setEnabled(onOff);
 	_plotAction->setEnabled(onOff);
+	_cacheStatsAction->setEnabled(onOff);
 
 	_tabMgr->EnableRouters(onOff);
 
@@ -2311,6 +2323,54 @@ void MainForm::launchPlotUtility(){
 }
 
 
+// Show the cache and I/O statistics of each open data set. The
+// full statistics, in JSON, are available as detailed text.
+//
+void MainForm::launchCacheStats(){
+	if (! _controlExec) return;
+
+	DataStatus *dataStatus = _controlExec->GetDataStatus();
+	vector <string> dataSetNames = dataStatus->GetDataMgrNames();
+
+	ostringstream summary;
+	ostringstream details;
+	details << "{\n";
+	for (int i=0; i<dataSetNames.size(); i++) {
+		DataMgr *dataMgr = dataStatus->GetDataMgr(dataSetNames[i]);
+		if (! dataMgr) continue;
+
+		DataMgr::CacheStats stats = dataMgr->GetCacheStats();
+
+		summary << dataSetNames[i] << " : hit ratio " 
+			<< stats.HitRatio() << ", " 
+			<< stats.bytes_read / (1024*1024) << " MB read in "
+			<< stats.read_time << " s, derived variables "
+			<< stats.derived_time << " s, " << stats.evictions 
+			<< " evictions, cache " << stats.mem_used / (1024*1024) 
+			<< " MB (peak " << stats.mem_peak / (1024*1024) << " MB)\n";
+
+		if (i) details << ",\n";
+		details << "\"" << dataSetNames[i] << "\": " << stats.ToJSON();
+	}
+	details << "}\n";
+
+	QMessageBox box(this);
+	box.setWindowTitle("Cache Statistics");
+	box.setText(QString::fromStdString(summary.str()));
+	box.setDetailedText(QString::fromStdString(details.str()));
+	box.addButton(QMessageBox::Close);
+	QPushButton *resetButton = box.addButton("Reset", QMessageBox::ResetRole);
+	box.exec();
+
+	if (box.clickedButton() == (QAbstractButton *) resetButton) {
+		for (int i=0; i<dataSetNames.size(); i++) {
+			DataMgr *dataMgr = dataStatus->GetDataMgr(dataSetNames[i]);
+			if (dataMgr) dataMgr->ResetCacheStats();
+		}
+	}
+}
+
+
 //Begin capturing animation images.
 //Launch a file save dialog to specify the names
 //Then start file saving mode.
@@ -164,6 +164,7 @@ private:
  QAction* _fileNew_SessionAction;
  QAction* _plotAction;
  QAction* _statsAction;
+ QAction* _cacheStatsAction;
 
  // Capture menu
  //
@@ -346,6 +347,7 @@ private slots:
  void installCLITools();
  void launchStats();
  void launchPlotUtility();
+ void launchCacheStats();
 
  //Set navigate mode
  void setNavigate(bool);
@@ -267,6 +267,7 @@ void MappingFrame::populateHistogram() {
 		if (v==grid->GetMissingValue()) continue;
 		_histogram->addToBin(v);
 	}
+	_dataMgr->UnlockGrid(grid);
 	delete grid;
 }
 
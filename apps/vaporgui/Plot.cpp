@@ -547,6 +547,22 @@ void Plot::_spaceTabPlotClicked()
     for( int i = 0; i < point1.size(); i++ )
         p1p2span.push_back( point2[i] - point1[i] );
 
+    // Sample points along the line, shared by all of the variables
+    std::vector<double>     samples( 3 * numOfSamples, 0.0 );
+    for( int i = 0; i < numOfSamples; i++ )
+    {
+        for( int j = 0; j < point1.size() && j < 3; j++ )
+        {
+            if( i == 0 )
+                samples[3*i+j] = point1[j];
+            else if( i == numOfSamples - 1 )
+                samples[3*i+j] = point2[j];
+            else
+                samples[3*i+j] = (double)i / (double)(numOfSamples-1) * 
+                                  p1p2span[j] + point1[j];
+        }
+    }
+
     std::vector< std::vector<float> >    sequences;
     for( int v = 0; v < enabledVars.size(); v++ )
     {
@@ -556,24 +572,11 @@ void Plot::_spaceTabPlotClicked()
         if( grid )
         {
             float missingVal  = grid->GetMissingValue();
+            grid->GetValues( samples.data(), numOfSamples, seq.data() );
             for( int i = 0; i < numOfSamples; i++ )
             {
-                std::vector<double>     sample;
-                if( i == 0 )
-                    sample = point1;
-                else if( i == numOfSamples - 1 )
-                    sample = point2;
-                else
-                {
-                    for( int j = 0; j < point1.size(); j++ )
-                        sample.push_back( (double)i / (double)(numOfSamples-1) * 
-                                           p1p2span[j] + point1[j] );
-                }
-                float fieldVal = grid->GetValue( sample );
-                if( fieldVal == missingVal )
+                if( seq[i] == missingVal )
                     seq[i] = std::nanf("1");
-                else
-                    seq[i] = fieldVal;
             }
             sequences.push_back( seq );
         }
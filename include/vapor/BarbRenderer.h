@@ -94,9 +94,6 @@ namespace VAPoR {
 		vector <Grid *> variableData
 	);
 
-	float getHeightOffset(Grid* heightVar, float xCoord,
-		float yCoord, bool& missing);	
-
 	void renderGrid(int rakeGrid[3],double rakeExts[6],
 		vector <Grid *> variableData, int timestep,
 		float vectorLengthScale, float rad, BarbParams* params);
@@ -5,6 +5,10 @@
 #ifndef	_BlkMemMgr_h_
 #define	_BlkMemMgr_h_
 
+#include <cstdio>
+#include <map>
+#include <set>
+#include <unordered_map>
 #include <vapor/MyBase.h>
 
 namespace VAPoR {
@@ -19,6 +23,13 @@ namespace VAPoR {
 //! A block-based memory allocator. Allocates contiguous runs of
 //! memory blocks from a memory pool of user defined size.
 //!
+//! Free runs of blocks are indexed both by address and by size. 
+//! Allocation returns the smallest free run large enough to satisfy
+//! the request, the one with the lowest address if several are the 
+//! same size (address-ordered best fit). Freed runs are immediately 
+//! coalesced with free neighbors. Both are O(log n) in the number of 
+//! free runs.
+//!
 //! N.B. the memory pool is stored in a static class member and
 //! can only be freed by calling RequestMemSize() with a zero value 
 //! after all instances of this class have been destroyed
@@ -71,16 +82,115 @@ public:
 
  static size_t GetBlkSize() {return(_blk_size);}
 
+ //! Memory pool backing store
+ //!
+ //! \var HEAP Memory allocated from the heap
+ //! \var HUGE_PAGES Anonymous memory backed by huge pages. Explicit 
+ //! (hugetlbfs) huge pages are used if the system has reserved any,
+ //! otherwise transparent huge pages are requested.
+ //! \var FILE_MAPPED A memory mapped scratch file. The pool may exceed
+ //! physical memory, with the kernel paging regions to and from the file.
+ //! Disk space for the file is reserved up front. If it can't be, the
+ //! pool is allocated from the heap instead.
+ //
+ enum Backing {HEAP, HUGE_PAGES, FILE_MAPPED};
+
+ //! Set the backing store for the memory pool
+ //!
+ //! Like RequestMemSize(), the request takes effect when the static 
+ //! memory pool is next (re)initialized. Only HEAP is supported on
+ //! Windows.
+ //!
+ //! \param[in] backing The type of memory for the pool
+ //! \param[in] dir Directory in which to create the scratch file
+ //! for FILE_MAPPED. If empty, $TMPDIR or /tmp is used. The file is 
+ //! unlinked as soon as it is created.
+ //!
+ //! \retval status A negative int is returned if \p backing is not
+ //! supported
+ //
+ static int RequestBacking(Backing backing, string dir = "");
+
+ static Backing GetBacking() {return(_backing);}
+
+ //! Memory pool statistics
+ //!
+ //! All sizes are in blocks.
+ //
+ class Stats {
+ public:
+  Stats() :
+	total_blks(0), free_blks(0), largest_free_run(0), 
+	num_free_runs(0), num_allocs(0), peak_used_blks(0) {}
+
+  size_t total_blks;		// size of memory pool
+  size_t free_blks;		// number of free blocks
+  size_t largest_free_run;	// largest run of contiguous free blocks
+  size_t num_free_runs;	// number of runs of contiguous free blocks
+  size_t num_allocs;		// number of live allocations
+  size_t peak_used_blks;	// largest number of blocks in use
+
+  //! Return the external fragmentation of the pool: the fraction 
+  //! of free memory not available to the largest possible request.
+  //
+  double Fragmentation() const {
+	return(free_blks ? 1.0 - (double) largest_free_run / free_blks : 0.0);
+  }
+ };
+
+ //! Return memory pool statistics
+ //
+ static Stats GetStats();
+
+ //! Reset the peak usage reported by GetStats() to the current usage
+ //
+ static void ResetPeakUsage();
+
+ //! Print a fragmentation report
+ //!
+ //! Writes the memory pool statistics, and a histogram of the 
+ //! sizes of free runs, to \p fp
+ //
+ static void PrintFragmentationReport(FILE *fp);
+
+ //! Record allocations to a trace file
+ //!
+ //! Each subsequent call to Alloc() and FreeMem() is written to 
+ //! \p fp, one per line, as "A <num_blks> <ptr>" or "F <ptr>". A failed
+ //! allocation is recorded with a null pointer. The trace may be 
+ //! replayed with the test_blkmemmgr benchmark.
+ //!
+ //! \param[in] fp An open file, or NULL to stop tracing
+ //
+ static void SetTraceFile(FILE *fp);
+
 private:
+ // Ordered by size, then address
+ //
+ typedef std::set <std::pair <size_t, unsigned char *> > _free_by_size_t;
+
  typedef struct {
 	size_t _nfree;	// number of contiguous free blocks
+	int _region;	// index of memory region containing the blocks
+	_free_by_size_t::iterator _sitr;	// position in _free_by_size
+ } _free_run_t;
+
+ typedef struct {
 	size_t _nused;	// number of contiguous used blocks
-	void *_blk;		// pointer to first free/used block
- } _mem_allocation_t; 
- 
- static vector < vector <_mem_allocation_t > > _mem_regions;
+	int _region;	// index of memory region containing the blocks
+ } _used_run_t;
+
+ // Free runs indexed by starting address and by size, and used
+ // runs indexed by starting address
+ //
+ static std::map <unsigned char *, _free_run_t> _free_by_addr;
+ static _free_by_size_t _free_by_size;
+ static std::unordered_map <void *, _used_run_t> _used;
+
  static vector <size_t>	_mem_region_sizes;	// size of mem in blocks
  static vector <unsigned char *> _blks;	// memory pool
+ static vector <size_t> _blks_size;	// size of each _blks allocation in bytes
+ static vector <Backing> _blks_backing;	// backing of each _blks allocation
 
  static size_t	_mem_size_max_req;	// max requested size of mem in blocks
  static bool	_page_aligned_req;	// requested page align memory 
@@ -90,9 +200,23 @@ private:
  static bool	_page_aligned;	// page align memory 
  static size_t	_blk_size;	// size of block in bytes
 
+ static Backing _backing_req;	// requested backing store
+ static string _backing_dir_req;	// requested scratch file directory
+ static Backing _backing;	// backing store
+ static string _backing_dir;	// scratch file directory
+
  static int _ref_count;	// # instances of object.
 
+ static FILE *_trace_fp;
+ static size_t _used_blks;	// number of blocks in use
+ static size_t _peak_used_blks;	// largest value of _used_blks
+
  static int	_Reinit(size_t n);
+ static void _insert_free(unsigned char *blk, size_t n, int region);
+ static void _erase_free(std::map <unsigned char *, _free_run_t>::iterator itr);
+ static void _clear();
+ static unsigned char *_mem_alloc(size_t size, Backing &backing);
+ static void _mem_free(unsigned char *blks, size_t size, Backing backing);
 
 };
 };
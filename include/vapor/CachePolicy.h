@@ -0,0 +1,162 @@
+#ifndef _CachePolicy_h_
+#define _CachePolicy_h_
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <vapor/common.h>
+
+namespace VAPoR {
+
+//
+//! \class CachePolicy
+//! \brief Eviction policy for a cache of variably sized items
+//!
+//! A CachePolicy decides which item to evict from a cache when space
+//! is needed. The cache notifies the policy of each item's insertion,
+//! access, and removal. Items are identified by an opaque, unique
+//! pointer. Each item has a size (in bytes), and a cost: the time, in
+//! seconds, it took to produce the item (e.g. read and decompress it).
+//!
+//! A CachePolicy is not thread safe. Callers must serialize access.
+//!
+//! \sa DataMgr
+//
+class VDF_API CachePolicy {
+public:
+ virtual ~CachePolicy() {}
+
+ //! Return the name of the policy
+ //
+ virtual std::string GetName() const = 0;
+
+ //! Add an item to the policy.
+ //!
+ //! \param[in] id Unique identifier for the item
+ //! \param[in] size Size of the item in bytes
+ //! \param[in] cost Time in seconds needed to produce the item. The
+ //! cost may be updated with SetCost() once known.
+ //
+ virtual void Insert(const void *id, size_t size, double cost) = 0;
+
+ //! Update the cost of an item
+ //
+ virtual void SetCost(const void *id, double cost) = 0;
+
+ //! Notify the policy that an item was accessed
+ //
+ virtual void Touch(const void *id) = 0;
+
+ //! Remove an item from the policy
+ //
+ virtual void Erase(const void *id) = 0;
+
+ //! Remove all items
+ //
+ virtual void Clear() = 0;
+
+ //! Select an item for eviction
+ //!
+ //! Return the item that should be evicted first among all of the
+ //! items for which \p evictable returns true. The item is not removed
+ //! from the policy: the caller is expected to call Erase() once the
+ //! item has been evicted.
+ //!
+ //! \retval id The selected item, or NULL if no item is evictable
+ //
+ virtual const void *Victim(
+	const std::function <bool (const void *)> &evictable
+ ) = 0;
+
+ //! Construct a policy by name
+ //!
+ //! \param[in] name One of the names returned by GetPolicyNames()
+ //! \retval policy A new policy, or NULL if \p name is not recognized
+ //
+ static CachePolicy *Create(std::string name);
+
+ //! Return the names of the policies known to Create()
+ //
+ static std::vector <std::string> GetPolicyNames();
+};
+
+//
+//! \class CachePolicyLRU
+//! \brief Least recently used eviction. Size and cost are ignored.
+//
+class VDF_API CachePolicyLRU : public CachePolicy {
+public:
+ CachePolicyLRU() {}
+
+ std::string GetName() const { return("lru"); }
+ void Insert(const void *id, size_t size, double cost);
+ void SetCost(const void *id, double cost) {}
+ void Touch(const void *id);
+ void Erase(const void *id);
+ void Clear();
+ const void *Victim(const std::function <bool (const void *)> &evictable);
+
+private:
+ std::list <const void *> _lruList;
+ std::unordered_map <const void *, std::list <const void *>::iterator> _index;
+};
+
+//
+//! \class CachePolicyGD
+//! \brief GreedyDual family of size and cost aware eviction policies
+//!
+//! Each item is given a priority H = L + F * C / S, where S is the
+//! item's size, C its cost, and F the number of times it has been
+//! accessed. The item with the lowest priority is evicted, and the
+//! inflation value L is set to the evicted item's priority, so that
+//! items that have not been accessed recently age out of the cache.
+//!
+//! With \p use_cost false C is 1, and with \p use_freq false F is 1.
+//! GD-Size (neither) favors keeping many small items over a few large
+//! ones. GDSF (both) additionally favors items that are expensive to
+//! reproduce and those that are accessed frequently. GetName() and
+//! CachePolicy::Create() name the variants "gds" (neither), "gd" (cost
+//! only), "gdsf-nocost" (frequency only) and "gdsf" (both).
+//!
+//! \sa Cherkasova, L., "Improving WWW Proxies Performance with
+//! Greedy-Dual-Size-Frequency Caching Policy", HP Labs, 1998.
+//
+class VDF_API CachePolicyGD : public CachePolicy {
+public:
+ CachePolicyGD(bool use_cost, bool use_freq);
+
+ std::string GetName() const;
+ void Insert(const void *id, size_t size, double cost);
+ void SetCost(const void *id, double cost);
+ void Touch(const void *id);
+ void Erase(const void *id);
+ void Clear();
+ const void *Victim(const std::function <bool (const void *)> &evictable);
+
+private:
+ typedef std::multimap <double, const void *> queue_t;
+
+ class Entry {
+ public:
+	size_t size;
+	double cost;
+	size_t freq;
+	queue_t::iterator itr;
+ };
+
+ bool _useCost;
+ bool _useFreq;
+ double _L;
+ queue_t _queue;
+ std::unordered_map <const void *, Entry> _entries;
+
+ double _priority(const Entry &e) const;
+ void _requeue(const void *id, Entry &e);
+};
+
+};
+
+#endif
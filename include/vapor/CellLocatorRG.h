@@ -0,0 +1,100 @@
+#ifndef _CellLocatorRG_
+#define _CellLocatorRG_
+
+#include <vector>
+#include <vapor/Grid.h>
+
+namespace VAPoR {
+//
+//! \class CellLocatorRG
+//! \brief Point location for the horizontal cells of a curvilinear grid
+//!
+//! This class finds the quadrilateral cell of a 2D structured grid
+//! that contains a point. The bounding rectangle of each cell is
+//! registered with every bin of a uniform bin grid that it overlaps.
+//! A query visits only the cells registered with the single bin
+//! containing the point, and the first of those for which the point
+//! has non-negative Wachspress coordinates is returned. With roughly
+//! one bin per cell the number of candidates is small and independent
+//! of the grid size, so point location is O(1) on average.
+//!
+//! Unlike a search for the nearest grid vertex followed by a test of the
+//! cells sharing it, the bin grid always finds the containing cell,
+//! even when cells are highly distorted.
+//!
+//! \sa KDTreeRG
+//
+class VDF_API CellLocatorRG {
+public:
+
+ //! Construct a cell locator for a structured grid
+ //!
+ //! \param[in] xg A 2D Grid instance giving the X user coordinates
+ //! of each grid vertex.
+ //! \param[in] yg A 2D Grid instance giving the Y user coordinates
+ //! of each grid vertex. The \p xg and \p yg Grid
+ //! instances must have identical configurations, differing only in their
+ //! data values.
+ //!
+ //! Cells with a vertex coordinate that is not finite are never
+ //! returned by FindCell().
+ //
+ CellLocatorRG(const Grid &xg, const Grid &yg);
+
+ virtual ~CellLocatorRG() {}
+
+ //! Find the cell containing a point
+ //!
+ //! \param[in] x X user coordinate of the point
+ //! \param[in] y Y user coordinate of the point
+ //! \param[out] i I index of the vertex with the smallest I and J
+ //! indices of the cell containing the point
+ //! \param[out] j J index of the vertex with the smallest I and J
+ //! indices of the cell containing the point
+ //! \param[out] lambda The Wachspress coordinates of the point with
+ //! respect to the cell vertices (i,j), (i+1,j), (i+1,j+1), and (i,j+1).
+ //!
+ //! \retval inside Returns true if the point is inside the grid. If false
+ //! \p i, \p j, and \p lambda are not defined
+ //!
+ //! \sa VAPoR::WachspressCoords2D()
+ //
+ bool FindCell(
+	double x, double y, size_t &i, size_t &j, double lambda[4]
+ ) const;
+
+ //! Returns the dimensions of the Grid instances passed to the constructor
+ //
+ std::vector <size_t> GetDimensions() const { return(_dims); }
+
+ //! Returns the dimensions of the bin grid
+ //
+ std::vector <size_t> GetBinDimensions() const {
+	return(std::vector <size_t> {_nbins[0], _nbins[1]});
+ }
+
+ //! Returns the number of bytes of memory used by this class instance
+ //
+ size_t GetMemoryUsage() const;
+
+private:
+ std::vector <size_t> _dims;
+ std::vector <float> _xy;	// interleaved vertex X and Y coordinates
+ double _min[2];			// bin grid extents
+ double _max[2];
+ double _scale[2];			// inverse of bin width along X and Y
+ size_t _nbins[2];
+ std::vector <size_t> _binOffsets;	// start of each bin's list in _cells
+ std::vector <size_t> _cells;		// linear offsets of cells in each bin
+
+ bool _cellBounds(size_t i, size_t j, double min[2], double max[2]) const;
+
+ void _binRange(
+	const double min[2], const double max[2], size_t b0[2], size_t b1[2]
+ ) const;
+
+};
+
+};
+
+#endif
@@ -218,6 +218,114 @@ public:
 	vector <SignificanceMap > &sigmaps, int l
  );
 
+ //! Quantize and entropy code a collection of coefficients
+ //!
+ //! Quantizes a collection of coefficients returned by Decompose() with
+ //! a uniform step, and codes the quantized magnitudes of each wavelet 
+ //! subband with their own bit depth and Golomb-Rice parameter. The 
+ //! step is the finest that lets the coded collection fit in 
+ //! GetQuantizedSize() bytes, so the quantization error adapts to each
+ //! collection: a collection of small or similar coefficients is
+ //! restored more accurately than one whose coefficients span a wide 
+ //! range.
+ //!
+ //! Approximation coefficients, the first GetNumUnquantized() entries of
+ //! the first collection, are not quantized and are not stored in 
+ //! \p dst_arr. They must be stored separately.
+ //!
+ //! \param[in] src_arr The coefficients of the collection
+ //! \param[in] sigmap The significance map of the collection, as
+ //! returned by Decompose()
+ //! \param[in] nbits Average number of bits per quantized coefficient, in
+ //! the range 2 to 32
+ //! \param[out] dst_arr The coded coefficients. Must point to 
+ //! GetQuantizedSize() bytes
+ //!
+ //! \retval size The number of bytes stored in \p dst_arr. A negative
+ //! value indicates failure
+ //! \sa Dequantize(), GetQuantizedSize()
+ //
+ int Quantize(
+	const float *src_arr, SignificanceMap &sigmap, int nbits, 
+	unsigned char *dst_arr
+ ) const;
+ int Quantize(
+	const double *src_arr, SignificanceMap &sigmap, int nbits, 
+	unsigned char *dst_arr
+ ) const;
+ int Quantize(
+	const int *src_arr, SignificanceMap &sigmap, int nbits, 
+	unsigned char *dst_arr
+ ) const;
+ int Quantize(
+	const long *src_arr, SignificanceMap &sigmap, int nbits, 
+	unsigned char *dst_arr
+ ) const;
+
+ //! Restore coefficients quantized with Quantize()
+ //!
+ //! The error of each restored coefficient is at most half the
+ //! quantization step chosen by Quantize(). Entries of \p dst_arr
+ //! that hold unquantized approximation coefficients are not modified.
+ //!
+ //! \param[in] src_arr Coded coefficients returned by Quantize()
+ //! \param[in] sigmap The significance map passed to Quantize()
+ //! \param[in] nbits Must match the value passed to Quantize()
+ //! \param[out] dst_arr The restored coefficients, one for each entry
+ //! of \p sigmap
+ //!
+ //! \retval status A negative value indicates failure
+ //! \sa Quantize()
+ //
+ int Dequantize(
+	const unsigned char *src_arr, SignificanceMap &sigmap, int nbits, 
+	float *dst_arr
+ ) const;
+ int Dequantize(
+	const unsigned char *src_arr, SignificanceMap &sigmap, int nbits, 
+	double *dst_arr
+ ) const;
+ int Dequantize(
+	const unsigned char *src_arr, SignificanceMap &sigmap, int nbits, 
+	int *dst_arr
+ ) const;
+ int Dequantize(
+	const unsigned char *src_arr, SignificanceMap &sigmap, int nbits, 
+	long *dst_arr
+ ) const;
+
+ //! Returns the size of a quantized collection of coefficients
+ //!
+ //! Returns the size in bytes reserved by Quantize() for \p num_entries
+ //! coefficients, not counting unquantized approximation coefficients,
+ //! at an average of \p nbits bits each.
+ //!
+ //! \sa Quantize()
+ //
+ size_t GetQuantizedSize(size_t num_entries, int nbits) const;
+
+ //! Returns the quantization step of a quantized collection
+ //!
+ //! \param[in] src_arr Coded coefficients returned by Quantize()
+ //!
+ //! \retval step The step chosen by Quantize(), or zero if every
+ //! quantized coefficient of the collection is zero
+ //!
+ //! \sa Quantize(), Dequantize()
+ //
+ static double GetQuantizationStep(const unsigned char *src_arr);
+
+ //! Returns the number of coefficients that are not quantized
+ //!
+ //! When KeepAppOnOff() is set the approximation coefficients are 
+ //! stored first in the first collection returned by Decompose(),
+ //! and are not quantized by Quantize(). Returns their number, or zero
+ //! if KeepAppOnOff() is not set.
+ //!
+ //! \sa Quantize()
+ //
+ size_t GetNumUnquantized() const;
+
  //! Return true if the given grid array is compressible 
  //!
  //! Return true if the given grid array is compressible based on
@@ -272,13 +380,14 @@ public:
  //! Returns the size of an encoded SignficanceMap() 
  //!
  //! Returns the size in bytes of an encoded SignificanceMap()
- //! used to store \p num_entries entries.
+ //! used to store \p num_entries entries. If \p packed is true the
+ //! size of a map restricted to the packed encoding is returned.
  //!
- //! \sa Compress(), Decompose()
+ //! \sa Compress(), Decompose(), SignificanceMap::GetMapSize()
  //!
- size_t GetSigMapSize(size_t num_entries) const { 
+ size_t GetSigMapSize(size_t num_entries, bool packed = false) const { 
 	std::vector <size_t> dims; dims.push_back(GetNumWaveCoeffs());
-	return(SignificanceMap::GetMapSize(dims, num_entries));
+	return(SignificanceMap::GetMapSize(dims, num_entries, packed));
   };
 
 
@@ -401,7 +510,7 @@ private:
 
 	vector <size_t> _dims;	// dimensions of array
 	int _nlevels;	// Number of wavelet transformation levels
-	vector <void *> _indexvec; // used to sort wavelet coefficients
+	vector <void *> _indexvec; // used to select wavelet coefficients
 	size_t _nx;
 	size_t _ny;
 	size_t _nz;
@@ -409,6 +518,7 @@ private:
 	size_t _CLen;
 	size_t *_L; // wavelet coefficient book keeping array
 	size_t _LLen;	
+	vector <size_t> _subbands;	// offset of each subband in _C
 	bool _keepapp;	// if true, approximation coeffs are not used in compression
 	bool _clamp_min_flag;
 	bool _clamp_max_flag;
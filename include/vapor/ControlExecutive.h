@@ -96,6 +96,23 @@ public:
 	_dataStatus->SetCacheSize(sizeMB);
  }
 
+ //! Enable or disable data prefetching
+ //!
+ //! When enabled, the data managers of all open data sets predict
+ //! the next time step that will be requested for each variable from
+ //! the stride between successive requests, and read it in the 
+ //! background. This hides I/O latency behind rendering during
+ //! animation playback. The setting also applies to data sets 
+ //! opened later.
+ //!
+ //! \sa DataMgr::SetPrefetchPredictor()
+ //
+ void SetPrefetch(bool enable);
+
+ bool GetPrefetch() const {
+	return(_prefetch);
+ }
+
 
  //! Create a new visualizer
  //!
@@ -553,6 +570,7 @@ private:
  DataStatus* _dataStatus;
  std::map <string, ShaderMgr *> _shaderMgrs;
  std::map <string, Visualizer *> _visualizers;
+ bool _prefetch;
  
  //! obtain an existing visualizer
  //! \param[in] viz Handle of desired visualizer
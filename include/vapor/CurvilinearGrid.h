@@ -4,6 +4,7 @@
 #include <vapor/Grid.h>
 #include <vapor/RegularGrid.h>
 #include <vapor/KDTreeRG.h>
+#include <vapor/CellLocatorRG.h>
 
 
 namespace VAPoR {
@@ -59,9 +60,16 @@ public:
  //! that may be used to find the nearest grid vertex to a given point
  //! expressed in user coordintes. The offsets returned by \p kdtree will
  //! be used as indeces into \p xrg and \p yrg.
+ //! \param[in] locator An optional CellLocatorRG instance, built from
+ //! \p xrg and \p yrg, used to find the cell containing a point. If NULL
+ //! the cells sharing the vertex returned by \p kdtree are searched, 
+ //! which is slower and may fail to find the containing cell when cells
+ //! are highly distorted. The \p kdtree and \p locator pointers are
+ //! shallow copied and must remain valid for the lifetime of this 
+ //! class instance.
  //!
  //!
- //! \sa RegularGrid()
+ //! \sa RegularGrid(), CellLocatorRG
  //
  CurvilinearGrid(
 	const std::vector <size_t> &dims,
@@ -70,7 +78,8 @@ public:
 	const RegularGrid &xrg,
 	const RegularGrid &yrg,
 	const std::vector <double> &zcoords,
-	const KDTreeRG *kdtree
+	const KDTreeRG *kdtree,
+	const CellLocatorRG *locator = NULL
  );
 
  CurvilinearGrid() = default;
@@ -132,6 +141,20 @@ public:
  //
  virtual bool InsideGrid(const std::vector <double> &coords) const override;
 
+ virtual void GetUserCoordinates(
+	const Size_tArr3 &indices, DblArr3 &coords
+ ) const override;
+
+ virtual void GetIndices(
+	const DblArr3 &coords, Size_tArr3 &indices
+ ) const override;
+
+ virtual bool GetIndicesCell(
+	const DblArr3 &coords, Size_tArr3 &indices
+ ) const override;
+
+ virtual bool InsideGrid(const DblArr3 &coords) const override;
+
 
 
 
@@ -218,6 +241,7 @@ private:
  mutable std::vector <double> _minu;
  mutable std::vector <double> _maxu;
  const KDTreeRG *_kdtree;
+ const CellLocatorRG *_locator;
  RegularGrid _xrg;
  RegularGrid _yrg;
 
@@ -225,7 +249,8 @@ private:
 	const RegularGrid &xrg,
 	const RegularGrid &yrg,
 	const std::vector <double> &zcoords,
-	const KDTreeRG *kdtree
+	const KDTreeRG *kdtree,
+	const CellLocatorRG *locator
  );
 
  void _GetUserExtents(
@@ -242,6 +267,10 @@ private:
 	double lambda[4], double zwgt[2]
  ) const;
 
+ bool _insideGridKDTree(
+	double x, double y, size_t &i, size_t &j, double lambda[4]
+ ) const;
+
  virtual void _getMinCellExtents(std::vector <double> &minCellExtents) const; 
 
 };
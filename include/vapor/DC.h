@@ -1782,6 +1782,43 @@ public:
 	return(getDimLensAtLevel(varname, level, dims_at_level, bs_at_level));
  }
 
+ //! Return value ranges recorded for a variable
+ //!
+ //! Some data collections record, at the time a variable is written,
+ //! the minimum and maximum value of each of the variable's storage
+ //! blocks, and of the variable as a whole. Missing values are excluded.
+ //! When available these ranges allow the range of a variable, or of
+ //! a subregion of a variable, to be determined without reading
+ //! the variable's data.
+ //!
+ //! The ranges are those of the data as they were written, at the
+ //! native grid resolution. If the variable is compressed, the ranges
+ //! of its approximations may differ slightly.
+ //!
+ //! \param[in] ts Time step of the variable
+ //! \param[in] varname Data variable name
+ //! \param[out] range A two-element vector containing the minimum and 
+ //! maximum value of the variable. If no ranges are recorded for the 
+ //! variable \p range is empty. If the variable contains only missing 
+ //! values range[0] is greater than range[1].
+ //! \param[out] blkranges A vector of min, max pairs, one for each block
+ //! of the variable at the native resolution (see GetDimLensAtLevel()).
+ //! Blocks are ordered with the fastest varying dimension first. A 
+ //! block containing only missing values has a minimum that is greater
+ //! than its maximum.
+ //!
+ //! \retval status Zero is returned upon success, otherwise -1. Success
+ //! with an empty \p range indicates that no ranges are recorded.
+ //!
+ //! \sa GetDimLensAtLevel()
+ //
+ virtual int GetBlockRanges(
+	size_t ts, string varname, std::vector <double> &range,
+	std::vector <double> &blkranges
+ ) {
+	return(getBlockRanges(ts, varname, range, blkranges));
+ }
+
  //! Return default Proj4 map projection string.
  //!
  //! For georeference data sets that have map projections this
@@ -2540,6 +2577,19 @@ protected:
 	std::vector <size_t> &bs_at_level
  ) const = 0;
 
+ //! \copydoc GetBlockRanges()
+ //!
+ //! The default implementation records no ranges
+ //
+ virtual int getBlockRanges(
+	size_t ts, string varname, std::vector <double> &range,
+	std::vector <double> &blkranges
+ ) {
+	range.clear();
+	blkranges.clear();
+	return(0);
+ }
+
  //! \copydoc GetMapProjection()
  //
  virtual string getMapProjection() const = 0;
@@ -1,6 +1,12 @@
 #include <vector>
 #include <iostream>
 #include <list>
+#include <unordered_map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <cassert>
 #include <vapor/BlkMemMgr.h>
 #include <vapor/DC.h>
@@ -11,6 +17,10 @@
 #include <vapor/CurvilinearGrid.h>
 #include <vapor/UnstructuredGrid2D.h>
 #include <vapor/KDTreeRG.h>
+#include <vapor/CellLocatorRG.h>
+#include <vapor/FaceLocatorUG2D.h>
+#include <vapor/GridStats.h>
+#include <vapor/CachePolicy.h>
 #include <vapor/UDUnitsClass.h>
 
 #ifndef	DataMgvV3_0_h
@@ -47,6 +57,22 @@ class DerivedCoordVar;
 //! not, unless otherwise documented, log an error message upon
 //! failure (return of false).
 //!
+//! GetVariable(), UnlockGrid(), GetDataRange(), GetVariableExtents()
+//! and the metadata query methods may be called concurrently from 
+//! multiple threads. Concurrent requests satisfied by the cache 
+//! proceed in parallel. Cache misses are serialized per variable and 
+//! time step, so concurrent requests for the same data share a single 
+//! read, while misses on different variables or time steps allocate 
+//! cache memory, evict, and restore data from the compressed second
+//! tier in parallel. The underlying data collection is not thread safe:
+//! its open, read and close calls, including those made by the 
+//! prefetch thread, are still made one at a time.
+//! Cache memory backing a Grid returned with \p lock 
+//! false may be reclaimed by another thread's request at any time, so
+//! concurrent callers should request locked grids and release them
+//! with UnlockGrid(). Initialize() and Clear() must not be called
+//! while other threads are using the object.
+//!
 //! \param level 
 //! \parblock
 //! Grid refinement level for multiresolution variables. 
@@ -116,6 +142,16 @@ public:
  //! variables in memory. The \p mem_size specifies the requested cache
  //! size in MEGABYTES!!!
  //!
+ //! By default the cache is allocated from the heap. The Initialize()
+ //! option "-mem_backing hugepages" backs it with huge pages, and 
+ //! "-mem_backing file" with a memory mapped scratch file created in the
+ //! directory given by "-mem_backing_dir <dir>", allowing a cache of 
+ //! \p mem_size MBs to exceed physical memory.
+ //!
+ //! The Initialize() option "-kdtree_cache_dir <dir>" enables caching 
+ //! of the k-d trees built for curvilinear and unstructured grids in 
+ //! \a dir. See SetKDTreeCacheDir().
+ //!
  //! \param[in] format A string indicating the format of data collection.
  //!
  //! \param[in] mem_size Size of memory cache to be created, specified
@@ -442,11 +478,77 @@ std::vector <size_t> GetCRatios(string varname) const;
 	std::vector <double> &min , std::vector <double> &max
  );
 
+ //! Compute the range of a variable
+ //!
+ //! Returns the minimum and maximum value of the variable at refinement
+ //! level \p level and level-of-detail \p lod, excluding missing values.
+ //! Recorded value ranges (see DC::GetBlockRanges()) describe the
+ //! variable at its native resolution. They are used, and no data are
+ //! read, when \p level and \p lod select the native data: the finest
+ //! refinement level, and the finest level-of-detail if it is stored 
+ //! without loss. Otherwise the variable is read at \p level and 
+ //! \p lod and scanned.
+ //!
+ //! \param[out] range A two-element vector containing the minimum and
+ //! maximum value
+ //
  int GetDataRange(
     size_t ts, string varname, int level,
     int lod, std::vector <double> &range
  ) ;
 
+ //! Compute the range of a subregion of a variable
+ //!
+ //! This method is identical to GetDataRange() above, however, a 
+ //! subregion is specified by the voxel coordinates \p min and \p max
+ //! at refinement level \p level, as with GetVariable(). If recorded
+ //! value ranges are used the returned range is the union of 
+ //! the ranges of all of the blocks that intersect the region, and
+ //! may therefore be wider than the range of the region itself.
+ //!
+ //! \sa GetDataRange(), GetVariable()
+ //
+ int GetDataRange(
+    size_t ts, string varname, int level, int lod,
+	std::vector <size_t> min, std::vector <size_t> max,
+	std::vector <double> &range
+ ) ;
+
+ //! Compute the moments of a variable
+ //!
+ //! Returns the count of valid values, and their range, mean, and 
+ //! variance, excluding missing values. The variable is read, and reduced
+ //! in parallel with GridStats::ComputeMoments(). The result is cached,
+ //! so subsequent calls with the same arguments read no data.
+ //!
+ //! \param[out] moments The moments of the variable's values
+ //!
+ //! \sa GridStats, GetDataRange()
+ //
+ int GetDataMoments(
+    size_t ts, string varname, int level, int lod,
+	GridStats::Moments &moments
+ );
+
+ //! Compute a histogram of a variable
+ //!
+ //! Counts the variable's valid values in \p nbins equal width bins
+ //! spanning the range returned by GetDataRange(). Because that range
+ //! may come from ranges recorded at native resolution some values
+ //! of a compressed approximation may lie outside of it, and are
+ //! counted by Histogram::below and Histogram::above. As with 
+ //! GetDataMoments() the result is cached.
+ //!
+ //! \param[in] nbins Number of bins
+ //! \param[out] histo The histogram
+ //!
+ //! \sa GridStats, GetDataRange()
+ //
+ int GetDataHistogram(
+    size_t ts, string varname, int level, int lod, size_t nbins,
+	GridStats::Histogram &histo
+ );
+
  
  //! \copydoc DC::GetDimLensAtLevel()
  //!
@@ -467,7 +569,9 @@ std::vector <size_t> GetCRatios(string varname) const;
  //! unlock region of memory previously locked with GetVariable().
  //! When the lock counter reaches zero the region is simply
  //! marked available for
- //! internal garbage collection during subsequent GetVariable() calls
+ //! internal garbage collection during subsequent GetVariable() calls.
+ //! Calling UnlockGrid() on a grid that was not returned locked, or
+ //! that has already been unlocked, has no effect
  //!
  //! \param[in] rg A pointer to a Grid previosly
  //! returned by GetVariable()
@@ -588,18 +692,383 @@ std::vector <size_t> GetCRatios(string varname) const;
  //!
  void PurgeVariable(string varname);
 
+ //! Asynchronously read a variable hyperslab into the cache
+ //!
+ //! This method queues a request to read the same hyperslab as
+ //! GetVariable(ts, varname, level, lod, min, max) and returns
+ //! immediately. The request is serviced by a background thread that
+ //! reads (and decompresses) the data into the cache. A subsequent
+ //! GetVariable() call for the same hyperslab waits for an in-flight
+ //! request to complete, and then finds the data in the cache.
+ //!
+ //! Prefetched data are not locked, and are subject to the
+ //! cache's normal eviction policy. A prefetch never evicts
+ //! data used by the most recent call made by the caller, so unlocked
+ //! grids previously returned by GetVariable() remain valid until
+ //! the next DataMgr call, as before. Errors encountered while
+ //! prefetching are otherwise ignored.
+ //!
+ //! \param[in] ts A valid time step between 0 and GetNumTimesteps()-1
+ //! \param[in] varname A valid variable name
+ //! \param[in] level Refinement level requested
+ //! \param[in] lod Compression level of detail requested
+ //! \param[in] min Minimum extents of the region of interest, in user
+ //! coordinates. 
+ //! \param[in] max Maximum extents of the region of interest
+ //!
+ //! \sa GetVariable(), CancelPrefetch(), SetPrefetchPredictor()
+ //
+ void Prefetch(
+	size_t ts, string varname, int level, int lod,
+	std::vector <double> min, std::vector <double> max
+ );
+
+ //! Discard any queued Prefetch() requests
+ //!
+ //! A request that is already being serviced runs to completion.
+ //
+ void CancelPrefetch();
+
+ //! Enable or disable time step prediction
+ //!
+ //! When enabled, each GetVariable() call that specifies a
+ //! region in user coordinates is compared with the previous call
+ //! for the same variable, refinement level and level-of-detail. If
+ //! the time step changed, the difference is taken as the stride and
+ //! Prefetch() is called for the next \p depth time steps along that
+ //! stride, using the same region.
+ //! 
+ //! This is intended to be enabled during animation playback.
+ //!
+ //! \param[in] enable Boolean enabling or disabling the predictor
+ //! \param[in] depth Number of time steps to prefetch ahead 
+ //!
+ //! \sa Prefetch()
+ //
+ void SetPrefetchPredictor(bool enable, int depth = 1);
+ bool GetPrefetchPredictor() const {
+	return(_prefetchPredict);
+ }
+
+ //! Select the cache eviction policy
+ //!
+ //! The eviction policy chooses which unlocked regions are freed when
+ //! the cache is full. The default, "lru", frees the least recently
+ //! used region. "gds" prefers freeing large regions, and "gdsf"
+ //! additionally weighs how often a region has been used and how long
+ //! it took to produce: the time to read and decompress it or, for
+ //! derived variables, to read their inputs and compute them. "gd" and
+ //! "gdsf-nocost" weigh only the time to produce a region or only how
+ //! often it has been used.
+ //! The policy may also be selected with the Initialize() option
+ //! "-cache_policy <name>".
+ //!
+ //! \param[in] name A policy name returned by
+ //! CachePolicy::GetPolicyNames()
+ //!
+ //! \retval status A negative int is returned if \p name is not
+ //! a known policy
+ //!
+ //! \sa CachePolicy, GetCacheStats()
+ //
+ int SetCachePolicy(string name);
+
+ //! Install a user defined cache eviction policy
+ //!
+ //! The DataMgr takes ownership of \p policy, which is deleted when
+ //! replaced or when the DataMgr is destroyed.
+ //
+ void SetCachePolicy(CachePolicy *policy);
+
+ //! Return the name of the current cache eviction policy
+ //
+ string GetCachePolicy() const;
+
+ //! Cache statistics for a single variable, refinement level, and 
+ //! level-of-detail
+ //!
+ //! \var hits Number of region lookups satisfied by the cache
+ //! \var misses Number of regions read (or computed) on a cache miss
+ //! \var bytes_read Total size of regions read on a cache miss
+ //! \var read_time Seconds spent reading regions, including any
+ //! decompression or, for derived variables, evaluation
+ //
+ class VarStats {
+ public:
+  VarStats() : 
+	level(0), lod(0), hits(0), misses(0), bytes_read(0), read_time(0.0) {}
+
+  string varname;
+  int level;
+  int lod;
+  size_t hits;
+  size_t misses;
+  size_t bytes_read;
+  double read_time;
+ };
+
+ //! Cache and I/O statistics
+ //!
+ //! \var hits Number of region lookups satisfied by the cache
+ //! \var misses Number of regions read (or computed) on a cache miss
+ //! \var evictions Number of regions freed by the eviction policy
+ //! \var bytes_read Total size of regions read on a cache miss
+ //! \var bytes_reread Portion of \p bytes_read for regions that had
+ //! previously been evicted.
+ //! \var compressed_hits Number of misses satisfied by the compressed
+ //! second tier cache, without reading the region.
+ //! \var compressed_bytes Bytes currently held by the compressed second
+ //! tier cache
+ //! \var compressed_raw_bytes Uncompressed size of the regions held by 
+ //! the second tier cache
+ //! \var compressed_max_error Largest error, relative to the range of 
+ //! the values in a quantization chunk, of any region restored from the 
+ //! second tier cache. Always zero in the lossless mode.
+ //! \var reduced_bytes Total size of the blocks read on a cache miss
+ //! and stored in the cache with reduced precision
+ //! \var reduced_raw_bytes Full precision size of those blocks
+ //! \var reduced_max_error Largest error, relative to the range of 
+ //! the values in a quantization chunk, of any block stored with reduced
+ //! precision. Always zero unless SetCacheStorageMode() is used.
+ //! \var read_time Seconds spent reading, and decompressing, native
+ //! variables
+ //! \var derived_time Seconds spent evaluating derived variables
+ //! \var bounding_grid_time Seconds spent finding the grid bounding
+ //! a region given in user coordinates
+ //! \var bounding_grid_calls Number of bounding grid searches
+ //! \var mem_used Bytes currently allocated from the memory pool. The
+ //! pool is shared by all DataMgr instances.
+ //! \var mem_peak Largest value of \p mem_used 
+ //! \var vars Statistics for each variable, level, and lod accessed
+ //
+ class CacheStats {
+ public:
+  CacheStats() : 
+	hits(0), misses(0), evictions(0), bytes_read(0), bytes_reread(0),
+	compressed_hits(0), compressed_bytes(0), compressed_raw_bytes(0),
+	compressed_max_error(0.0), reduced_bytes(0), reduced_raw_bytes(0),
+	reduced_max_error(0.0), read_time(0.0), derived_time(0.0),
+	bounding_grid_time(0.0), bounding_grid_calls(0), 
+	mem_used(0), mem_peak(0) {}
+
+  size_t hits;
+  size_t misses;
+  size_t evictions;
+  size_t bytes_read;
+  size_t bytes_reread;
+  size_t compressed_hits;
+  size_t compressed_bytes;
+  size_t compressed_raw_bytes;
+  double compressed_max_error;
+  size_t reduced_bytes;
+  size_t reduced_raw_bytes;
+  double reduced_max_error;
+  double read_time;
+  double derived_time;
+  double bounding_grid_time;
+  size_t bounding_grid_calls;
+  size_t mem_used;
+  size_t mem_peak;
+  std::vector <VarStats> vars;
+
+  double HitRatio() const {
+	return(hits+misses ? (double) hits / (double) (hits+misses) : 0.0);
+  }
+
+  //! Return the statistics formatted as a JSON object
+  //
+  string ToJSON() const;
+ };
+
+ //! Return cache statistics accumulated since construction, or since
+ //! the last call to ResetCacheStats()
+ //!
+ //! Counters are updated as a side effect of normal cache bookkeeping,
+ //! and are always enabled.
+ //
+ CacheStats GetCacheStats() const;
+ void ResetCacheStats();
+
+ //! Set the size of the compressed second tier cache
+ //!
+ //! Regions evicted from the cache may be kept in a second tier, 
+ //! compressed with a fast lossless codec, so that they can be restored
+ //! without re-reading and decoding them. The second tier is disabled
+ //! by default. It may also be enabled with the Initialize() option
+ //! "-compressed_cache_size <MBs>".
+ //!
+ //! \param[in] mem_size Size of the second tier in MEGABYTES. 
+ //! Zero disables the second tier.
+ //!
+ //! \sa CompressedRegionCache
+ //
+ void SetCompressedCacheSize(size_t mem_size);
+ size_t GetCompressedCacheSize() const;
+
+ //! Encodings for cached regions
+ //!
+ //! \sa SetCompressedCacheMode(), SetCacheStorageMode()
+ //
+ enum CompressedCacheMode {
+	LOSSLESS,	//!< XOR with the previous word, keep significant bytes
+	HALF,		//!< IEEE half precision
+	QUANT16,	//!< 16-bit values, with a scale and offset per chunk
+	QUANT8		//!< 8-bit values, with a scale and offset per chunk
+ };
+
+ //! Set how regions are encoded by the compressed second tier cache
+ //!
+ //! In the default, lossless, mode the second tier typically holds 1.5
+ //! to 3 times its size in regions. The reduced precision modes store 
+ //! floating point data as IEEE half precision values (2x), or as 16 or 8
+ //! bit integers quantized with a scale and offset for each chunk of 
+ //! 4096 values (2x and 4x). Values are decoded when a region is 
+ //! restored to the cache. Missing values are always restored exactly.
+ //!
+ //! These modes apply only to evicted regions held by the second tier.
+ //! See SetCacheStorageMode() to store the primary cache with reduced
+ //! precision.
+ //!
+ //! The error of each decoded value, relative to the range (max - min)
+ //! of the values in its chunk, is bounded by \p tolerance. Chunks that
+ //! would exceed it, or that contain non-finite values other than the
+ //! missing value, are stored without loss. Integer data, such as the connectivity of
+ //! unstructured grids, are always stored without loss.
+ //! The largest error of any restored region is reported by 
+ //! GetCacheStats().
+ //!
+ //! The mode may also be set with the Initialize() options
+ //! "-compressed_cache_mode <lossless|half|quant16|quant8>" and
+ //! "-compressed_cache_tolerance <tolerance>".
+ //!
+ //! \param[in] mode Encoding for regions subsequently evicted 
+ //! \param[in] tolerance Bound on the relative error of reduced 
+ //! precision modes
+ //!
+ //! \sa SetCompressedCacheSize()
+ //
+ void SetCompressedCacheMode(
+	CompressedCacheMode mode, double tolerance = 0.005
+ );
+ CompressedCacheMode GetCompressedCacheMode() const;
+ double GetCompressedCacheTolerance() const;
+
+ //! Set how blocks of data are stored in the cache
+ //!
+ //! By default, LOSSLESS, the blocks of structured grid data variables 
+ //! are cached as floats. In the reduced precision modes, described 
+ //! under SetCompressedCacheMode(), blocks read on a cache miss are
+ //! encoded before they are cached, so that 2 (HALF, QUANT16) to 4
+ //! (QUANT8) times as many fit in the same memory. The grids returned
+ //! by GetVariable() reference the encoded blocks, and decode each one
+ //! the first time it is accessed, keeping the decoded block for the 
+ //! life of the grid.
+ //!
+ //! Coordinate and connectivity variables, and blocks that are not read
+ //! from the data collection, such as those of derived variables, are
+ //! always stored at full precision. Blocks stored with reduced 
+ //! precision are not re-encoded by the compressed second tier when 
+ //! they are evicted. The largest error of any stored block is reported
+ //! by GetCacheStats().
+ //!
+ //! Changing the mode does not affect blocks already cached. It may 
+ //! also be set with the Initialize() options 
+ //! "-cache_storage_mode <lossless|half|quant16|quant8>" and
+ //! "-cache_storage_tolerance <tolerance>".
+ //!
+ //! \param[in] mode Encoding of subsequently read blocks
+ //! \param[in] tolerance Bound on the error of each value relative to
+ //! the range of the values in its chunk
+ //!
+ //! \sa SetCompressedCacheMode()
+ //
+ void SetCacheStorageMode(
+	CompressedCacheMode mode, double tolerance = 0.005
+ );
+ CompressedCacheMode GetCacheStorageMode() const;
+ double GetCacheStorageTolerance() const;
+
+ //! Set the directory for cached k-d trees
+ //!
+ //! Building the k-d tree that locates points in a curvilinear or 
+ //! unstructured grid can take seconds for a large mesh. If \p dir
+ //! is not empty each tree built is written to a file in \p dir, named
+ //! after the coordinate variables and a hash of their values, and
+ //! later requests for the same coordinates, in this or another session,
+ //! map the file instead of rebuilding the tree. Failures to read or
+ //! write the directory are not errors; the tree is built in memory.
+ //!
+ //! Files are never removed by the DataMgr. 
+ //!
+ //! \param[in] dir A directory path, or the empty string, the default,
+ //! to disable caching
+ //!
+ //! \sa KDTreeRG::Read(), KDTreeRG::Write()
+ //
+ void SetKDTreeCacheDir(string dir);
+ string GetKDTreeCacheDir() const;
 
+ //! Enable or disable the fast wavelet transform
+ //!
+ //! When enabled, compressed variables of a VDC data collection are 
+ //! reconstructed by GetVariable() with the fast transform described 
+ //! under WASP::SetFastTransform(), whose inverse wavelet transform is
+ //! about 1.5 to 2 times faster. Reconstructed values differ from those of
+ //! the default by rounding, about 1e-7 of their magnitude. Other data
+ //! collection formats are not affected. Regions already cached are not
+ //! re-read. The fast transform is disabled by default. It may also be
+ //! enabled with the Initialize() option "-fast_transform".
+ //!
+ //! \param[in] enable Boolean enabling the fast transform
+ //!
+ //! \sa VDCNetCDF::SetFastTransform()
+ //
+ void SetFastTransform(bool enable);
+ bool GetFastTransform() const;
+
+
+ //! \class BlkExts
+ //! \brief User coordinate bounding boxes of the blocks of a grid
+ //!
+ //! Records the axis aligned bounding box of each block of a grid and
+ //! finds the range of blocks intersecting a box in user coordinates.
+ //! After all blocks are inserted Build() constructs a bounding volume
+ //! hierarchy over them. Each node of the hierarchy covers a box of
+ //! block coordinates, which is split in half along its longest 
+ //! dimension to form the node's children, and records the union of the
+ //! blocks' bounding boxes. Because neighboring blocks are close in user
+ //! space the nodes' boxes are compact, and Intersect() visits only
+ //! the nodes that overlap the query box and could extend the range
+ //! found so far - O(log n) nodes for a box overlapping a compact
+ //! range of blocks, rather than every block.
+ //
  class BlkExts {
  public:
   BlkExts();
   BlkExts(const std::vector <size_t> &bmin, const std::vector <size_t> &bmax);
 
+  //! Record the bounding box of the block with block coordinates 
+  //! \p bcoord. Up to three user coordinates are stored. Different 
+  //! blocks may be inserted concurrently.
+  //
   void Insert(
 	const std::vector <size_t> &bcoord, 
 	const std::vector <double> &min, 
 	const std::vector <double> &max 
   );
 
+  //! Build the bounding volume hierarchy. Must be called after all 
+  //! blocks have been inserted, and before Intersect()
+  //
+  void Build();
+
+  //! Find the range of blocks intersecting a box
+  //!
+  //! \param[out] bmin Minimum block coordinates of the blocks whose 
+  //! bounding boxes intersect the box defined by \p min and \p max
+  //! \param[out] bmax Maximum block coordinates
+  //! \retval status False if no block intersects the box
+  //
   bool Intersect(
 	const std::vector <double> &min, 
 	const std::vector <double> &max,
@@ -607,17 +1076,359 @@ std::vector <size_t> GetCRatios(string varname) const;
 	std::vector <size_t> &bmax
   ) const;
 
+  //! Return the number of blocks
+  //
+  size_t GetNumBlocks() const { return(_mins.size() / 3); }
+
   friend std::ostream &operator<<(
 	std::ostream &o, const BlkExts &b
   );
 
  private:
 
+  // A node of the hierarchy. The children of an interior node are the
+  // node following it and the node indexed by \a right
+  //
+  class Node {
+  public:
+	double min[3];
+	double max[3];
+	size_t bmin[3];
+	size_t bmax[3];
+	size_t right;
+  };
+
 	std::vector <size_t> _bmin;
 	std::vector <size_t> _bmax;
-	std::vector < std::vector < double > > _mins;
-	std::vector < std::vector < double > > _maxs;
+	std::vector <double> _mins;	// three coordinates per block
+	std::vector <double> _maxs;
+	std::vector <Node> _nodes;
+
+	size_t _build(const size_t bmin[3], const size_t bmax[3]);
+
+	void _intersect(
+		size_t node, const double min[3], const double max[3],
+		size_t bmin[3], size_t bmax[3], bool &intersection
+	) const;
+ };
+
+ //! \class RegionCache
+ //! \brief Bookkeeping for regions of variable data held in memory
+ //!
+ //! A region is identified by the tuple (time step, variable name,
+ //! refinement level, level-of-detail, block min, block max). The
+ //! RegionCache indexes regions with a hash table on that tuple (the
+ //! variable name is interned to an integer id), and orders them in
+ //! a least-recently-used list. Lookup, insertion, removal, and
+ //! marking a region as most recently used are all O(1).
+ //!
+ //! The RegionCache does not manage the memory pointed to by a region.
+ //
+ class RegionCache {
+ public:
+  typedef struct {
+	size_t ts;
+	string varname;
+	int level;
+	int lod;
+	std::vector <size_t> bmin;
+	std::vector <size_t> bmax;
+	int lock_counter;
+	void *blks;
+	size_t epoch;	// DataMgr request count when last used by the caller
+	size_t size;	// size of region in bytes
+	double cost;	// time in seconds to produce the region
+	VarStats *stats;	// statistics for region's variable, level, and lod
+	bool loaded;	// false until the region's data have been produced
+	CompressedCacheMode mode;	// encoding of blks, LOSSLESS if floats
+  } region_t;
+
+  typedef std::list <region_t>::iterator iterator;
+  typedef std::list <region_t>::const_iterator const_iterator;
+
+  RegionCache() {};
+
+  //! Find a region and make it the most recently used
+  //!
+  //! \retval region A pointer to the region if found, otherwise NULL
+  //
+  region_t *Find(
+	size_t ts, const string &varname, int level, int lod,
+	const std::vector <size_t> &bmin, const std::vector <size_t> &bmax
+  );
+
+  //! Find a region without changing its place in the LRU order
+  //!
+  //! \retval region A pointer to the region if found, otherwise NULL
+  //
+  region_t *Peek(
+	size_t ts, const string &varname, int level, int lod,
+	const std::vector <size_t> &bmin, const std::vector <size_t> &bmax
+  );
+
+  //! Find the region whose memory starts at \p blks
+  //!
+  //! \retval region A pointer to the region if found, otherwise NULL
+  //
+  region_t *Find(const void *blks);
+
+  //! Add a region as the most recently used
+  //!
+  //! If a region with the same identifying tuple already exists (e.g.
+  //! because it is locked and could not be freed) it is no longer
+  //! returned by the tuple version of Find(), but remains in the cache
+  //! until it is removed with Erase().
+  //!
+  //! \retval region A pointer to the cached copy of \p region
+  //
+  region_t *Insert(const region_t &region);
+
+  //! Remove a region.
+  //
+  void Erase(const region_t *region);
+  iterator Erase(iterator itr);
+
+  //! Iterators over regions ordered from least to most recently used
+  //
+  iterator begin() { return(_lruList.begin()); }
+  iterator end() { return(_lruList.end()); }
+  const_iterator begin() const { return(_lruList.begin()); }
+  const_iterator end() const { return(_lruList.end()); }
+
+  size_t size() const { return(_lruList.size()); }
+  bool empty() const { return(_lruList.empty()); }
+
+  void Clear();
+
+  //! Hashable form of a region's identifying tuple. Keys are only
+  //! comparable between keys made by the same RegionCache, and are 
+  //! invalidated by Clear().
+  //
+  class Key {
+  public:
+	int varid;
+	int level;
+	int lod;
+	size_t ts;
+	size_t ndim;
+	size_t bmin[3];
+	size_t bmax[3];
+
+	bool operator==(const Key &k) const;
+  };
+
+  class KeyHash {
+  public:
+	size_t operator()(const Key &k) const;
+  };
+
+  //! Return the key of a region, which need not be cached
+  //
+  Key MakeKey(
+	size_t ts, const string &varname, int level, int lod,
+	const std::vector <size_t> &bmin, const std::vector <size_t> &bmax
+  );
+  Key MakeKey(const region_t &region);
+
+ private:
+  std::list <region_t> _lruList;
+  std::unordered_map <Key, iterator, KeyHash> _index;
+  std::unordered_map <const void *, iterator> _blksIndex;
+  std::unordered_map <string, int> _varIds;
+
+  bool _make_key(
+	size_t ts, const string &varname, int level, int lod,
+	const std::vector <size_t> &bmin, const std::vector <size_t> &bmax,
+	bool intern, Key &key
+  );
+  void _unindex(iterator itr);
+  iterator _lookup(
+	size_t ts, const string &varname, int level, int lod,
+	const std::vector <size_t> &bmin, const std::vector <size_t> &bmax
+  );
+
  };
+
+ //! \class CompressedRegionCache
+ //! \brief Second tier cache for regions evicted from the DataMgr cache
+ //!
+ //! Holds the contents of evicted regions in memory, compressed with a
+ //! lossless codec that is much cheaper to decode than the wavelet
+ //! transform: each 32-bit word is XOR'd with its predecessor, and only
+ //! the non-zero low order bytes of the result are stored. Smoothly
+ //! varying fields typically compress by a factor of 1.5 to 3. 
+ //! Floating point regions may instead be stored with reduced precision,
+ //! see SetMode(). The same encodings are used by the primary cache
+ //! when DataMgr::SetCacheStorageMode() is set.
+ //! Entries are discarded in least-recently-inserted order to stay 
+ //! within a memory budget.
+ //!
+ //! The cache is thread safe. Regions are encoded by Insert() before its
+ //! lock is taken, so evicting threads may compress concurrently.
+ //
+ class CompressedRegionCache {
+ public:
+  CompressedRegionCache() : 
+	_maxSize(0), _size(0), _rawSize(0), _mode(LOSSLESS), _tolerance(0.005)
+  {};
+
+  //! Set the encoding of subsequently inserted regions
+  //!
+  //! \sa DataMgr::SetCompressedCacheMode()
+  //
+  void SetMode(CompressedCacheMode mode, double tolerance) {
+	std::lock_guard <std::mutex> guard(_mutex);
+	_mode = mode;
+	_tolerance = tolerance;
+  }
+  CompressedCacheMode GetMode() const { 
+	std::lock_guard <std::mutex> guard(_mutex);
+	return(_mode); 
+  }
+  double GetTolerance() const { 
+	std::lock_guard <std::mutex> guard(_mutex);
+	return(_tolerance); 
+  }
+
+  //! Set the memory budget in bytes. Zero disables the cache.
+  //
+  void SetMaxSize(size_t max_size);
+  size_t GetMaxSize() const { 
+	std::lock_guard <std::mutex> guard(_mutex);
+	return(_maxSize); 
+  }
+
+  //! Return the total size in bytes of the compressed data held
+  //
+  size_t GetSize() const { 
+	std::lock_guard <std::mutex> guard(_mutex);
+	return(_size); 
+  }
+
+  //! Return the total uncompressed size in bytes of the regions held
+  //
+  size_t GetRawSize() const { 
+	std::lock_guard <std::mutex> guard(_mutex);
+	return(_rawSize); 
+  }
+
+  //! Compress and add a region's data
+  //!
+  //! \param[in] key Identifies the region, see RegionCache::MakeKey()
+  //! \param[in] varname Name of the region's variable
+  //! \param[in] data The region's data
+  //! \param[in] size Size of \p data in bytes
+  //! \param[in] cost Time in seconds it took to produce the region
+  //! \param[in] isFloat True if \p data are floats, which may be 
+  //! encoded with reduced precision. Otherwise the region is always
+  //! encoded without loss.
+  //! \param[in] mv The missing value, restored exactly. Ignored if
+  //! \p hasMissing is false.
+  //!
+  //! \retval bool False if the region does not fit in the budget
+  //
+  bool Insert(
+	const RegionCache::Key &key, const string &varname, const void *data, 
+	size_t size, double cost, 
+	bool isFloat = false, bool hasMissing = false, float mv = 0.0
+  );
+
+  //! Return true if the region identified by \p key is cached
+  //
+  bool Contains(const RegionCache::Key &key) const {
+	std::lock_guard <std::mutex> guard(_mutex);
+	return(_index.find(key) != _index.end());
+  }
+
+  //! Decompress a region's data and remove it from the cache
+  //!
+  //! \param[in] key Identifies the region
+  //! \param[out] data Buffer of at least \p size bytes
+  //! \param[in] size Size of the region in bytes
+  //! \param[out] cost Cost recorded by Insert()
+  //! \param[out] maxError Largest relative error of the decoded data
+  //!
+  //! \retval bool False if the region is not cached, or is not 
+  //! \p size bytes
+  //
+  bool Extract(
+	const RegionCache::Key &key, void *data, size_t size, double &cost,
+	double &maxError
+  );
+
+  //! Remove all regions belonging to \p varname
+  //
+  void EraseVar(const string &varname);
+
+  void Clear();
+
+  static void Encode(
+	const unsigned char *src, size_t size, std::vector <unsigned char> &dst
+  );
+  static bool Decode(
+	const std::vector <unsigned char> &src, unsigned char *dst, size_t size
+  );
+
+  //! Encode floats with reduced precision
+  //!
+  //! \param[in] src Values to encode
+  //! \param[in] n Number of values in \p src
+  //! \param[in] mode Encoding. Must not be LOSSLESS.
+  //! \param[in] tolerance Bound on the error of each value relative to
+  //! the range (max - min) of the values in its chunk
+  //! \param[in] hasMissing True if \p src may contain missing values
+  //! \param[in] mv The missing value
+  //! \param[out] dst Encoded values
+  //! \param[out] maxError Largest relative error of any value
+  //
+  static void EncodeReduced(
+	const float *src, size_t n, CompressedCacheMode mode, double tolerance,
+	bool hasMissing, float mv, std::vector <unsigned char> &dst,
+	double &maxError
+  );
+
+  //! Decode values encoded by EncodeReduced()
+  //!
+  //! \param[in] src Encoded values
+  //! \param[in] size Size of \p src in bytes
+  //!
+  //! \retval bool False if \p src is not the encoding of \p n values
+  //
+  static bool DecodeReduced(
+	const unsigned char *src, size_t size, CompressedCacheMode mode, 
+	bool hasMissing, float mv, float *dst, size_t n
+  );
+
+ private:
+  class Entry {
+  public:
+	string varname;
+	size_t size;
+	double cost;
+	CompressedCacheMode mode;
+	bool hasMissing;
+	float mv;
+	double maxError;
+	std::vector <unsigned char> data;
+	std::list <RegionCache::Key>::iterator itr;
+  };
+
+  typedef std::unordered_map <
+	RegionCache::Key, Entry, RegionCache::KeyHash
+  > index_t;
+
+  size_t _maxSize;
+  size_t _size;
+  size_t _rawSize;
+  CompressedCacheMode _mode;
+  double _tolerance;
+  std::list <RegionCache::Key> _fifo;
+  index_t _index;
+  mutable std::mutex _mutex;
+
+  void _erase(index_t::iterator itr);
+ };
+
 private:
 
  //
@@ -733,6 +1544,7 @@ private:
 	bool Get(
 		string hash, std::vector <void *> &values
 	) const {
+		std::lock_guard <std::mutex> guard(_mutex);
 		values.clear();
 		std::map <string, std::vector <void *> >::const_iterator itr;
 		itr = _cacheVoidPtr.find(hash);
@@ -755,6 +1567,7 @@ private:
 	} 
 
 	vector <string> GetVoidPtrHash() const {
+		std::lock_guard <std::mutex> guard(_mutex);
 		vector <string> keys;
 		std::map <string, std::vector <void *> >::const_iterator itr;
 		for (itr = _cacheVoidPtr.begin(); itr != _cacheVoidPtr.end(); ++itr) {
@@ -764,6 +1577,7 @@ private:
 	}
 
 	void Clear() {
+		std::lock_guard <std::mutex> guard(_mutex);
 		_cacheSize_t.clear(); 
 		_cacheDouble.clear(); 
 		_cacheVoidPtr.clear(); 
@@ -778,7 +1592,7 @@ private:
   std::map <string, std::vector <size_t> > _cacheSize_t;
   std::map <string, std::vector <double> > _cacheDouble;
   std::map <string, std::vector <void *> > _cacheVoidPtr;
-
+  mutable std::mutex _mutex;
 
  };
 
@@ -800,21 +1614,14 @@ private:
  string _proj4String;
  string _proj4StringDefault;
 
- typedef struct {
-	size_t ts;
-	string varname;
-	int level;
-	int lod;
-	std::vector <size_t> bmin;
-	std::vector <size_t> bmax;
-	int lock_counter;
-	void *blks;
- } region_t;
+ typedef RegionCache::region_t region_t;
 
- // a list of all allocated regions
- std::list <region_t> _regionsList;
+ // all allocated regions
+ RegionCache _regionCache;
 
  VAPoR::BlkMemMgr  *_blk_mem_mgr;
+ BlkMemMgr::Backing _memBacking;
+ string _memBackingDir;
 
 
  std::vector <PipeLine *> _PipeLines;
@@ -823,6 +1630,113 @@ private:
  mutable VarInfoCache _varInfoCache;
  std::map <string, BlkExts> _blkExtsCache;
 
+ //
+ // Locking. _cacheMutex protects the region cache, the block memory 
+ // manager, _blkExtsCache and _lockedGrids. Regions evicted to make 
+ // room are compressed and freed after releasing it: the memory pool
+ // and _compressedCache have their own locks. Cache misses are 
+ // serialized per variable and time step by the fixed set of locks in
+ // _ioLocks, shared by hashing (see _io_lock()). They are never nested,
+ // so a shared lock delays, but can't deadlock, another variable's 
+ // misses. An I/O lock may be 
+ // acquired before _cacheMutex, but never while holding it. DC's (and
+ // derived variables) are not thread safe, so each open, read and close
+ // sequence holds _dcMutex, which is acquired last and never held
+ // while acquiring another lock. _varInfoCache is protected by its 
+ // own mutex.
+ // _kdtreeMutex serializes construction of the KD trees and cell and
+ // face locators stored in _varInfoCache, and protects _kdtreeCacheDir.
+ //
+ mutable std::recursive_mutex _cacheMutex;
+ mutable std::recursive_mutex _dcMutex;
+ static const size_t NumIOLocks = 64;
+ std::recursive_mutex _ioLocks[NumIOLocks];
+ mutable std::mutex _kdtreeMutex;
+
+ string _kdtreeCacheDir;
+ bool _fastTransform;	// See SetFastTransform(). Protected by _dcMutex
+
+ // Cache regions locked on behalf of each grid returned by 
+ // GetVariable() with lock == true
+ //
+ std::map <const Grid *, std::vector <const void *> > _lockedGrids;
+
+ //
+ // Eviction policy and statistics, protected by _cacheMutex. The keys 
+ // of recently evicted regions are remembered so that re-reads can be
+ // counted. Statistics are kept per variable, one entry for each level
+ // and lod read. Cached regions point to their entry, so entries must
+ // not move once added.
+ //
+ CachePolicy *_cachePolicy;
+ CacheStats _cacheStats;
+ std::unordered_map <string, std::deque <VarStats> > _varStats;
+ CompressedRegionCache _compressedCache;
+ CompressedCacheMode _storageMode;	// see SetCacheStorageMode()
+ double _storageTolerance;
+ std::unordered_map <
+	RegionCache::Key, int, RegionCache::KeyHash
+ > _evictedKeys;
+ std::deque <RegionCache::Key> _evictedKeyQueue;
+
+ //
+ // Prefetching. A single worker thread services Prefetch() requests. 
+ //
+ class PrefetchReq {
+ public:
+	size_t ts;
+	string varname;
+	int level;
+	int lod;
+	std::vector <double> min;
+	std::vector <double> max;
+
+	bool operator==(const PrefetchReq &r) const {
+		return(
+			ts == r.ts && varname == r.varname && level == r.level &&
+			lod == r.lod && min == r.min && max == r.max
+		);
+	}
+ };
+
+ mutable std::atomic <size_t> _epoch;	// count of requests made by callers
+
+ // Marks the scope of a request made by a caller. Requests made 
+ // while another is in progress on the same thread are part of the
+ // outer request. Scopes are chained per thread, so concurrent 
+ // callers never see each other's requests
+ //
+ class RequestScope {
+ public:
+	RequestScope(const DataMgr *dm);
+	~RequestScope();
+
+	const DataMgr *_dm;
+	RequestScope *_outer;	// enclosing scope on this thread, if any
+	bool _stamped;	// true if request has advanced _epoch
+ };
+
+ static thread_local RequestScope *_threadRequest;	// innermost scope
+
+ std::thread _prefetchThread;
+ std::mutex _prefetchQueueMutex;
+ std::condition_variable _prefetchCV;
+ std::deque <PrefetchReq> _prefetchQueue;
+ bool _prefetchBusy;
+ bool _prefetchStop;
+ std::atomic <bool> _prefetchPredict;
+ int _prefetchDepth;
+ std::map <string, size_t> _prefetchLastTS;
+
+ size_t _request_epoch() const;
+ void _prefetch_thread();
+ void _prefetch_stop();
+ void _prefetch(const PrefetchReq &req);
+ void _predict_prefetch(
+	size_t ts, string varname, int level, int lod,
+	const std::vector <double> &min, const std::vector <double> &max
+ );
+
  std::vector <string> _get_var_dependencies(string varname) const;
 
  // Return true if native data set is georeferenced
@@ -851,6 +1765,7 @@ private:
 
  VAPoR::RegularGrid *_make_grid_regular(
     const std::vector <size_t> &dims,
+    const std::vector <float *> &data_blks,
     const std::vector <float *> &blkvec,
     const std::vector <size_t> &bs,
     const std::vector <size_t> &bmin,
@@ -859,6 +1774,7 @@ private:
 
  VAPoR::StretchedGrid *_make_grid_stretched(
     const std::vector <size_t> &dims,
+    const std::vector <float *> &data_blks,
     const std::vector <float *> &blkvec,
     const std::vector <size_t> &bs,
     const std::vector <size_t> &bmin,
@@ -867,6 +1783,7 @@ private:
 
  VAPoR::LayeredGrid *_make_grid_layered(
     const std::vector <size_t> &dims,
+    const std::vector <float *> &data_blks,
     const std::vector <float *> &blkvec,
     const std::vector <size_t> &bs,
     const std::vector <size_t> &bmin,
@@ -879,6 +1796,7 @@ private:
 	int lod,
     const vector <DC::CoordVar> &cvarsinfo,
     const std::vector <size_t> &dims,
+    const std::vector <float *> &data_blks,
     const std::vector <float *> &blkvec,
     const std::vector <size_t> &bs,
     const std::vector <size_t> &bmin,
@@ -904,6 +1822,7 @@ UnstructuredGrid2D *_make_grid_unstructured2d(
 	const DC::DataVar &dvarinfo,
 	const vector <DC::CoordVar> &cvarsinfo,
 	const vector <size_t> &dims,
+	const vector <float *> &data_blks,
 	const vector <float *> &blkvec,
 	const vector <size_t> &bs,
 	const vector <size_t> &bmin,
@@ -921,6 +1840,7 @@ UnstructuredGrid2D *_make_grid_unstructured2d(
 	const VAPoR::DC::DataVar &var,
 	const std::vector <size_t> &roi_dims,
 	const std::vector <size_t> &dims,
+	const std::vector <float *> &data_blks,
 	const std::vector <float *> &blkvec,
 	const std::vector < std::vector <size_t > > &bsvec,
 	const std::vector < std::vector <size_t > > &bminvec,
@@ -1040,6 +1960,20 @@ UnstructuredGrid2D *_make_grid_unstructured2d(
 	bool lock
  );
 
+ template <typename T> 
+ int _get_blocks(
+	size_t ts,
+	string varname,
+	int level,
+	int nlevels,
+	int lod,
+	int nlods,
+	const std::vector <size_t> &bs,
+	const std::vector <size_t> &bmin,
+	const std::vector <size_t> &bmax,
+	std::vector <T *> &blks
+ );
+
  template <typename T> 
  int _get_regions(
 	size_t ts,
@@ -1053,8 +1987,14 @@ UnstructuredGrid2D *_make_grid_unstructured2d(
  ); 
 
  void _unlock_blocks(const void *blks);
+ void _unlock_blocks(const std::vector <float *> &blks);
 
  std::vector <string> _get_native_variables() const;
+
+ int _get_block_ranges(
+	size_t ts, string varname, int level, int lod,
+	std::vector <double> &range, std::vector <double> &blkranges
+ );
  std::vector <string> _get_derived_variables() const;
 
  void   *_alloc_region(
@@ -1070,6 +2010,19 @@ UnstructuredGrid2D *_make_grid_unstructured2d(
 	bool fill
  ); 
 
+ void   *_alloc_region(
+	size_t ts,
+	string varname,
+	int level,
+	int lod,
+	std::vector <size_t> bmin,
+	std::vector <size_t> bmax,
+	size_t size,
+	CompressedCacheMode mode,
+	bool    lock,
+	bool fill
+ ); 
+
  void    _free_region(
 	size_t ts,
 	string varname,
@@ -1079,7 +2032,42 @@ UnstructuredGrid2D *_make_grid_unstructured2d(
 	std::vector <size_t> bmax
  );
 
- bool _free_lru();
+ // A region removed from the cache by _evict_lru(), whose memory has
+ // not yet been freed
+ //
+ class EvictedRegion {
+ public:
+	EvictedRegion() : 
+		blks(NULL), size(0), cost(0.0), encoded(false), isFloat(false), 
+		hasMissing(false), mv(0.0) {}
+
+	RegionCache::Key key;
+	string varname;
+	void *blks;
+	size_t size;
+	double cost;
+	bool encoded;	// stored with reduced precision by the primary cache
+	bool isFloat;
+	bool hasMissing;
+	float mv;
+ };
+
+ bool _evict_lru(EvictedRegion &evicted);
+ void _release_evicted(const EvictedRegion &evicted);
+ void _record_miss(const void *blks, double cost, size_t rawSize = 0);
+ void _set_block_decoder(
+	Grid *g, const string &varname, const std::vector <float *> &blks
+ );
+ std::recursive_mutex &_io_lock(size_t ts, string varname);
+ VarStats *_var_stats(const string &varname, int level, int lod);
+ bool _is_float_var(const string &varname, bool &hasMissing, float &mv) const;
+
+ template <typename T>
+ T *_get_region_from_compressed(
+	size_t ts, string varname, int level, int lod,
+	const std::vector <size_t> &bs, const std::vector <size_t> &bmin,
+	const std::vector <size_t> &bmax, bool lock
+ );
  void _free_var(string varname);
 
  int _level_correction(string varname, int &level) const;
@@ -1096,6 +2084,34 @@ UnstructuredGrid2D *_make_grid_unstructured2d(
 	const vector <size_t> &bmax
  );
 
+ KDTreeRG *_readKDTree(
+	string path, const std::vector <size_t> &dims, int ncoords
+ ) const;
+
+ void _writeKDTree(string path, const KDTreeRG *kdtree) const;
+
+ const CellLocatorRG *_getCellLocator2D(
+	size_t ts,
+	int level,
+	int lod,
+	const vector <DC::CoordVar> &cvarsinfo,
+	const Grid &xg,
+	const Grid &yg,
+	const vector <size_t> &bmin,
+	const vector <size_t> &bmax
+ );
+
+ const FaceLocatorUG2D *_getFaceLocator2D(
+	size_t ts,
+	int level,
+	int lod,
+	const vector <DC::CoordVar> &cvarsinfo,
+	const UnstructuredGrid &xg,
+	const UnstructuredGrid &yg,
+	const vector <size_t> &bmin,
+	const vector <size_t> &bmax
+ );
+
  vector <string> _getDataVarNamesDerived(int ndim) const;
 
  vector <string> _getCoordVarNamesDerived() const;
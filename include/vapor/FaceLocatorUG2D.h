@@ -0,0 +1,134 @@
+#ifndef _FaceLocatorUG2D_
+#define _FaceLocatorUG2D_
+
+#include <vector>
+#include <vapor/UnstructuredGrid.h>
+
+namespace VAPoR {
+//
+//! \class FaceLocatorUG2D
+//! \brief Point location for the faces of a 2D unstructured grid
+//!
+//! This class finds the face (polygon) of a 2D unstructured mesh that
+//! contains a point. Two searches are provided:
+//!
+//! \li A bin grid search. The bounding rectangle of each face is
+//! registered with every bin of a uniform bin grid that it overlaps, and
+//! only the faces registered with the bin containing the point are
+//! tested.
+//!
+//! \li A walking search, that starts at a given face and repeatedly
+//! crosses the edge that the point lies furthest outside of. When
+//! consecutive points are close together, as when sampling along a
+//! line or a raster, seeding the walk with the face found for the previous
+//! point usually locates the next point within a step or two.
+//!
+//! The vertex coordinates of each face are copied into a flat array
+//! at construction so that queries neither allocate memory nor go
+//! through the Grid accessors.
+//!
+//! \sa KDTreeRG, CellLocatorRG
+//
+class VDF_API FaceLocatorUG2D {
+public:
+
+ //! Construct a face locator for an unstructured grid
+ //!
+ //! \param[in] xug A 2D node-centered UnstructuredGrid instance giving
+ //! the X user coordinates of each node. Its connectivity arrays
+ //! describe the mesh.
+ //! \param[in] yug A 2D UnstructuredGrid instance giving the Y user
+ //! coordinates of each node. The \p xug and \p yug
+ //! instances must have identical configurations, differing only in their
+ //! data values.
+ //!
+ //! Nodes of each face must be ordered counter-clockwise. Faces with
+ //! fewer than three nodes, or a node coordinate that is not finite, are
+ //! never returned.
+ //
+ FaceLocatorUG2D(const UnstructuredGrid &xug, const UnstructuredGrid &yug);
+
+ virtual ~FaceLocatorUG2D() {}
+
+ //! Find the face containing a point with the bin grid
+ //!
+ //! \param[in] x X user coordinate of the point
+ //! \param[in] y Y user coordinate of the point
+ //! \param[out] face Index of the face containing the point
+ //! \param[out] lambda The Wachspress coordinates of the point with
+ //! respect to the face's nodes, in the order they appear in the
+ //! grid's \p vertexOnFace array. Must have room for
+ //! GetMaxVertexPerFace() elements.
+ //! \param[out] nlambda The number of nodes of \p face, and of
+ //! elements of \p lambda that were set.
+ //!
+ //! \retval inside Returns true if the point is inside the grid. If false
+ //! \p face, \p lambda, and \p nlambda are not defined
+ //!
+ //! \sa VAPoR::WachspressCoords2D()
+ //
+ bool FindFace(
+	double x, double y, size_t &face, double *lambda, int &nlambda
+ ) const;
+
+ //! Find the face containing a point by walking from a known face
+ //!
+ //! Walks the mesh starting at face \p seed. If the walk leaves the
+ //! mesh or doesn't reach the point within a small number of steps the
+ //! bin grid is searched instead, so the result is the same as that of
+ //! FindFace(double, double, size_t &, double *, int &) except,
+ //! possibly, for points on a shared edge.
+ //!
+ //! \param[in] seed Index of the face at which to start. Typically the
+ //! face containing a nearby point.
+ //
+ bool FindFace(
+	double x, double y, size_t seed,
+	size_t &face, double *lambda, int &nlambda
+ ) const;
+
+ //! Return the number of faces in the mesh
+ //
+ size_t GetNumFaces() const { return(_nverts.size()); }
+
+ //! Return the maximum number of nodes that a face may have
+ //
+ size_t GetMaxVertexPerFace() const { return(_maxVertexPerFace); }
+
+ //! Returns the dimensions of the bin grid
+ //
+ std::vector <size_t> GetBinDimensions() const {
+	return(std::vector <size_t> {_nbins[0], _nbins[1]});
+ }
+
+ //! Returns the number of bytes of memory used by this class instance
+ //
+ size_t GetMemoryUsage() const;
+
+private:
+ size_t _maxVertexPerFace;
+ std::vector <int> _nverts;			// number of nodes of each face
+ std::vector <double> _verts;		// interleaved X,Y of each face's nodes
+ std::vector <int> _neighbors;		// face across each edge, or -1
+ double _min[2];					// bin grid extents
+ double _max[2];
+ double _scale[2];					// inverse of bin width along X and Y
+ size_t _nbins[2];
+ std::vector <size_t> _binOffsets;	// start of each bin's list in _faces
+ std::vector <size_t> _faces;		// faces in each bin
+
+ bool _faceBounds(size_t face, double min[2], double max[2]) const;
+
+ void _binRange(
+	const double min[2], const double max[2], size_t b0[2], size_t b1[2]
+ ) const;
+
+ bool _insideFace(
+	size_t face, const double pt[2], double *lambda, int &nlambda
+ ) const;
+
+};
+
+};
+
+#endif
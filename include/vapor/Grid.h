@@ -4,8 +4,11 @@
 #include <iostream>
 #include <ostream>
 #include <vector>
+#include <array>
 #include <cassert>
 #include <memory>
+#include <functional>
+#include <algorithm>
 #include <vapor/common.h>
 
 #ifdef WIN32
@@ -43,6 +46,36 @@ namespace VAPoR {
 class VDF_API Grid {
 public:
 
+ //! Fixed size index and coordinate arrays
+ //!
+ //! Most methods that take or return grid indices or user coordinates
+ //! have an overload that uses these three element arrays in place of 
+ //! vectors, so that they can be called in a loop without allocating 
+ //! memory. Only the first GetDimensions().size() elements of an index
+ //! array, or GetGeometryDim() elements of a coordinate array, are used.
+ //! Unused elements are ignored on input and set to zero on output.
+ //
+ typedef std::array <size_t, 3> Size_tArr3;
+ typedef std::array <double, 3> DblArr3;
+
+ //! Copy a vector to a fixed size array, zeroing any elements of 
+ //! \p dst that \p src doesn't have
+ //
+ template <typename T>
+ static void CopyToArr3(const std::vector <T> &src, std::array <T, 3> &dst) {
+	for (int i=0; i<3; i++) dst[i] = i < src.size() ? src[i] : T(0);
+ }
+
+ //! Copy the first \p n elements of a fixed size array to a vector
+ //
+ template <typename T>
+ static void CopyFromArr3(
+	const std::array <T, 3> &src, size_t n, std::vector <T> &dst
+ ) {
+	assert(n <= 3);
+	dst.assign(src.begin(), src.begin() + n);
+ }
+
  //!
  //! Construct a structured or unstructured grid sampling a 3D or 
  //! 2D scalar function
@@ -129,7 +162,56 @@ public:
  //! Return the internal data structure containing a copy of the blocks
  //! passed in by the constructor
  //!
- const std::vector <float *> &GetBlks() const { return(_blks); };
+ //! If a block decoder is set every block is decoded, and the decoded
+ //! blocks are returned.
+ //!
+ //! \sa SetBlockDecoder(), GetBlock()
+ //
+ const std::vector <float *> &GetBlks() const;
+
+ //! Return a block of grid data
+ //!
+ //! \param[in] b Offset of the block, with the first dimension varying
+ //! fastest, in the range 0..n-1, where n is the product of the
+ //! dimensions returned by GetDimensionInBlks()
+ //!
+ //! \retval blk The block passed to the constructor or, if a block 
+ //! decoder is set, the decoded block. NULL if the grid is dataless.
+ //!
+ //! \sa SetBlockDecoder()
+ //
+ float *GetBlock(size_t b) const {
+	if (! _blks.size()) return(NULL);
+	if (_decoded) return(_decodeBlock(b));
+	return(_blks[b]);
+ }
+
+ //! Decode a block stored with reduced precision
+ //!
+ //! \param[in] b Offset of the block, as for GetBlock()
+ //! \param[in] blk The block passed to the constructor
+ //! \param[out] buf Space for the decoded block: the product of the
+ //! block dimensions returned by GetBlockSize() floats
+ //!
+ //! \retval decoded \p buf, or \p blk if the block is not encoded
+ //
+ typedef std::function <
+	const float *(size_t b, const float *blk, float *buf)
+ > BlockDecoder;
+
+ //! Store the grid's blocks in an encoded form
+ //!
+ //! After this call the blocks passed to the constructor need not 
+ //! hold floats: each one is passed to \p decoder the first time it 
+ //! is accessed, by any method, and the decoded block is kept for the
+ //! life of the grid and of any copies of it. Blocks that are never 
+ //! accessed are never decoded. Decoding is thread safe.
+ //!
+ //! \param[in] decoder Block decoder. Must be safe to call concurrently
+ //!
+ //! \sa GetBlock()
+ //
+ void SetBlockDecoder(const BlockDecoder &decoder);
 
  //! Get the data value at the indicated grid point
  //!
@@ -147,6 +229,13 @@ public:
  //!
  virtual float AccessIndex(const std::vector <size_t> &indices) const;
 
+ //! \copydoc AccessIndex(const std::vector <size_t> &indices) const
+ //!
+ //! This version doesn't allocate memory. Elements of \p indices beyond
+ //! the dimensionality of the grid are ignored.
+ //
+ float AccessIndex(const Size_tArr3 &indices) const;
+
  //! Set the data value at the indicated grid point
  //!
  //! This method sets the data value of the grid point indexed by 
@@ -197,7 +286,28 @@ public:
 	std::vector <double> coords = {x, y, z};
 	return(GetValue(coords));
  }
- 
+
+ //! Get the reconstructed values of the sampled scalar function at
+ //! many points
+ //!
+ //! The result is the same as calling GetValue() once for each point.
+ //! However, derived classes may locate the points and reconstruct
+ //! their values in batches, reading grid samples directly from the
+ //! data blocks, without the per point memory allocation and virtual
+ //! function calls of GetValue(). Use this method when sampling a grid
+ //! at more than a handful of points.
+ //!
+ //! \param[in] xyz Array of \p n points, stored interleaved: the
+ //! coordinates of point \a p are xyz[3*p], xyz[3*p+1], and xyz[3*p+2].
+ //! The third coordinate is ignored if GetGeometryDim() is less than
+ //! three.
+ //! \param[in] n Number of points
+ //! \param[out] values Array of \p n values
+ //!
+ //! \sa GetValue()
+ //
+ virtual void GetValues(const double *xyz, size_t n, float *values) const;
+
 
  //! Return the extents of the user coordinate system
  //!
@@ -361,6 +471,16 @@ public:
 	size_t i, size_t j, size_t k, double &x, double &y, double &z
  ) const;
 
+ //! \copydoc GetUserCoordinates()
+ //!
+ //! This version doesn't allocate memory. The default implementation 
+ //! calls the vector version, and derived classes override it with one
+ //! that doesn't.
+ //
+ virtual void GetUserCoordinates(
+	const Size_tArr3 &indices, DblArr3 &coords
+ ) const;
+
 
  //! Return the closest grid point to the specified user coordinates
  //!
@@ -379,6 +499,12 @@ public:
 	std::vector <size_t> &indices
  ) const = 0;
 
+ //! \copydoc GetIndices()
+ //!
+ //! This version doesn't allocate memory
+ //
+ virtual void GetIndices(const DblArr3 &coords, Size_tArr3 &indices) const;
+
  //! Return the indices of the cell containing the
  //! specified user coordinates
  //!
@@ -400,6 +526,14 @@ public:
     std::vector <size_t> &indices
  ) const = 0;
 
+ //! \copydoc GetIndicesCell()
+ //!
+ //! This version doesn't allocate memory
+ //
+ virtual bool GetIndicesCell(
+	const DblArr3 &coords, Size_tArr3 &indices
+ ) const;
+
  //! Return the min and max data value
  //!
  //! This method returns the values of grid points with min and max values,
@@ -427,6 +561,12 @@ public:
  //!
  virtual bool InsideGrid(const std::vector <double> &coords) const = 0;
 
+ //! \copydoc InsideGrid()
+ //!
+ //! This version doesn't allocate memory
+ //
+ virtual bool InsideGrid(const DblArr3 &coords) const;
+
  //! Get the indices of the nodes that define a cell
  //!
  //! This method returns a vector of index vectors. Each index vector 
@@ -447,6 +587,16 @@ public:
 	std::vector <std::vector <size_t> > &nodes
  ) const = 0;
 
+ //! \copydoc GetCellNodes()
+ //!
+ //! In this version each node's indices are a fixed size array. 
+ //! \p nodes is resized, not reallocated, so no memory is allocated
+ //! when the same \p nodes vector is passed to successive calls.
+ //
+ virtual bool GetCellNodes(
+	const Size_tArr3 &cindices, std::vector <Size_tArr3> &nodes
+ ) const;
+
  //! Get the IDs (indices) of all of the cells that border a cell
  //!
  //! This method returns a vector of index vectors. Each index vector 
@@ -493,6 +643,13 @@ public:
  //
  virtual void ClampCoord(std::vector <double> &coords) const = 0;
 
+ //! \copydoc ClampCoord()
+ //!
+ //! This version doesn't allocate memory. Elements of \p coords beyond
+ //! GetGeometryDim() are set to zero.
+ //
+ virtual void ClampCoord(DblArr3 &coords) const;
+
  //! Clamp grid array indices 
  //!
  //! This method ensures that grid indices are not out of bounds and
@@ -522,12 +679,33 @@ public:
 	}
 	assert(indices.size() == dims.size());
 	for (int i=0; i<indices.size(); i++) {
-		if (indices[i] >= dims[i]-1) {
-			indices[i] = dims[i] - 2;
+		if (indices[i] >= dims[i]) {
+			indices[i] = dims[i] - 1;
 		}
 	}
  }
 
+ //! \copydoc ClampIndex()
+ //!
+ //! This version doesn't allocate memory. Elements of \p indices beyond
+ //! GetNodeDimensions() are set to zero.
+ //
+ void ClampIndex(Size_tArr3 &indices) const {
+	const std::vector <size_t> &dims = GetNodeDimensions();
+	for (int i=0; i<3; i++) {
+		if (i >= dims.size()) indices[i] = 0;
+		else if (indices[i] >= dims[i]) indices[i] = dims[i] - 1;
+	}
+ }
+
+ void ClampCellIndex(Size_tArr3 &indices) const {
+	const std::vector <size_t> &dims = GetCellDimensions();
+	for (int i=0; i<3; i++) {
+		if (i >= dims.size()) indices[i] = 0;
+		else if (indices[i] >= dims[i]) indices[i] = dims[i] - 1;
+	}
+ }
+
 
  //! Set periodic boundaries
  //!
@@ -556,6 +734,14 @@ public:
 	return(_periodic);
  }
 
+ //! Return true if the boundary along axis \p dim is periodic
+ //!
+ //! Equivalent to GetPeriodic()[dim], but doesn't copy a vector
+ //
+ bool IsPeriodic(size_t dim) const {
+	return(dim < _periodic.size() && _periodic[dim]);
+ }
+
  //! Get topological dimension of the mesh
  //!
  //! Return the number of topological dimensions for the mesh cells. Valid
@@ -614,6 +800,13 @@ public:
 	}
 	return(true);
   }
+
+  bool operator()(const double *pt, size_t n) const {
+	for (int i=0; i<_min.size() && i<n; i++) {
+		if (pt[i] < _min[i] || pt[i] > _max[i]) return (false);
+	}
+	return(true);
+  }
  
  private:
   std::vector <double> _min;
@@ -911,6 +1104,7 @@ public:
   ConstCoordItr _coordItr;
 #else
   const Grid *_g;
+  mutable std::vector <Size_tArr3> _nodes;
   bool _cellInsideBox(const std::vector <size_t> &cindices) const;
 #endif
 
@@ -1055,6 +1249,243 @@ public:
 
  ConstIterator cend() const { return(ConstIterator(this, false)); }
 
+ //! Describes the portion of a block visited by ForEachBlock()
+ //!
+ //! The elements of a block are stored contiguously, with the first
+ //! dimension varying fastest: element (i,j,k) of block \a blk is
+ //! blk[(k * bs[1] + j) * bs[0] + i]. The visited elements are those
+ //! with \a i, \a j, and \a k in the ranges [min[0], max[0]], 
+ //! [min[1], max[1]], and [min[2], max[2]], respectively. Element 
+ //! (i,j,k) has grid indices (origin[0]+i, origin[1]+j, origin[2]+k). 
+ //! For grids with fewer than three dimensions the unused dimensions
+ //! have min, max, and origin of zero, and a block size of one.
+ //
+ class BlockExtents {
+ public:
+  size_t min[3];
+  size_t max[3];
+  size_t origin[3];
+  size_t bs[3];
+ };
+
+ //! Invoke a function on each block of grid data
+ //!
+ //! Invokes \p fn once for each block that intersects the region of the 
+ //! grid defined by the grid indices \p min and \p max, passing
+ //! a pointer to the block's data and a description of the part of the 
+ //! block that lies within the region. Blocks are visited in storage
+ //! order. No per-element index or coordinate calculations are 
+ //! performed, and the elements of each block row are contiguous in 
+ //! memory, so this is the fastest way to process the values of a grid
+ //! when the order in which they are visited does not matter.
+ //!
+ //! Missing values are not skipped.
+ //!
+ //! \param[in] min Minimum grid indices of the region
+ //! \param[in] max Maximum grid indices of the region. Indices outside
+ //! of the grid are clamped to the grid boundary
+ //! \param[in] fn Function to invoke
+ //!
+ //! \sa BlockExtents, BlockIterator
+ //
+ void ForEachBlock(
+	const std::vector <size_t> &min, const std::vector <size_t> &max,
+	const std::function <void (const float *, const BlockExtents &)> &fn
+ ) const;
+
+ //! Invoke a function on each block of grid data
+ //!
+ //! Visits every element of the grid
+ //
+ void ForEachBlock(
+	const std::function <void (const float *, const BlockExtents &)> &fn
+ ) const;
+
+ //! Invoke a function on each block of grid data from several threads
+ //!
+ //! Like ForEachBlock(), but the blocks are shared out dynamically among
+ //! \p nthreads threads, so \p fn is invoked concurrently and blocks are
+ //! not visited in any particular order. The index of the invoking 
+ //! thread, from zero to \p nthreads - 1, is passed to \p fn, which 
+ //! typically accumulates a partial result per thread that is combined
+ //! once all blocks have been visited.
+ //!
+ //! \param[in] min Minimum grid indices of the region
+ //! \param[in] max Maximum grid indices of the region. Indices outside
+ //! of the grid are clamped to the grid boundary
+ //! \param[in] fn Function to invoke. Must be safe to call concurrently
+ //! \param[in] nthreads Number of threads. If less than one the number
+ //! of processors is used. No more threads are started than there are
+ //! blocks to visit.
+ //!
+ //! \retval nthreads The number of threads actually used. Thread
+ //! indices passed to \p fn are less than this.
+ //!
+ //! \sa ForEachBlock()
+ //
+ int ForEachBlockParallel(
+	const std::vector <size_t> &min, const std::vector <size_t> &max,
+	const std::function <
+		void (const float *, const BlockExtents &, int)
+	> &fn,
+	int nthreads = 0
+ ) const;
+
+ //! A forward iterator over the data values of a grid in storage order
+ //!
+ //! Unlike Grid::Iterator the BlockIterator visits the values of the 
+ //! grid one block at a time, in the order in which they are stored in 
+ //! memory, and performs no coordinate calculations or virtual function
+ //! calls. Incrementing the iterator is a pointer increment, except at
+ //! the end of a block row. Use it where the order of traversal 
+ //! does not matter, for example when computing a range or histogram.
+ //! The grid indices of the current element are available from 
+ //! GetIndices().
+ //!
+ //! \p T is float or const float
+ //!
+ //! \sa ForEachBlock()
+ //
+ template <class T>
+ class BlockIterator {
+ public:
+  BlockIterator() : _g(nullptr), _y(0), _z(0), _blk(nullptr), 
+	_ptr(nullptr), _rowStart(nullptr), _rowEnd(nullptr) {}
+
+  BlockIterator(
+	const Grid *g, 
+	const std::vector <size_t> &min, const std::vector <size_t> &max
+  ) : BlockIterator() {
+	const std::vector <size_t> &dims = g->GetDimensions();
+	const std::vector <size_t> &bs = g->GetBlockSize();
+	const std::vector <size_t> &bdims = g->GetDimensionInBlks();
+
+	_g = g;
+	if (g->_blks.empty()) return;
+
+	for (int i=0; i<3; i++) {
+		bool used = i < dims.size();
+		_bs[i] = used ? bs[i] : 1;
+		_bdims[i] = used ? bdims[i] : 1;
+		_min[i] = used && i < min.size() ? min[i] : 0;
+		_max[i] = used && i < max.size() ? std::min(max[i], dims[i]-1) : 0;
+		if (_min[i] > _max[i]) return;	// empty region
+
+		_b[i] = _min[i] / _bs[i];
+	}
+	_setBlock();
+  }
+
+  T &operator*() const {return(*_ptr);}
+
+  BlockIterator<T> &operator++() {	// ++prefix
+	if (++_ptr == _rowEnd) _nextRow();
+	return(*this);
+  }
+
+  BlockIterator<T> operator++(int) {	// postfix++
+	BlockIterator<T> temp(*this);
+	++(*this);
+	return(temp);
+  }
+
+  bool operator==(const BlockIterator<T> &rhs) const {
+	return(_ptr == rhs._ptr);
+  }
+  bool operator!=(const BlockIterator<T> &rhs) const {
+	return(_ptr != rhs._ptr);
+  }
+
+  //! Return the grid indices of the current element
+  //
+  void GetIndices(size_t &i, size_t &j, size_t &k) const {
+	i = _b[0] * _bs[0] + (_ptr - _rowStart);
+	j = _b[1] * _bs[1] + _y;
+	k = _b[2] * _bs[2] + _z;
+  }
+
+ private:
+  const Grid *_g;
+  size_t _bs[3];
+  size_t _bdims[3];
+  size_t _min[3];	// region, in grid indices
+  size_t _max[3];
+  size_t _b[3];		// current block
+  size_t _lo[3];	// part of current block within region
+  size_t _hi[3];
+  size_t _y;
+  size_t _z;
+  T *_blk;
+  T *_ptr;
+  T *_rowStart;
+  T *_rowEnd;
+
+  void _setRow() {
+	_rowStart = _blk + (_z * _bs[1] + _y) * _bs[0];
+	_ptr = _rowStart + _lo[0];
+	_rowEnd = _rowStart + _hi[0] + 1;
+  }
+
+  void _setBlock() {
+	for (int i=0; i<3; i++) {
+		size_t origin = _b[i] * _bs[i];
+		_lo[i] = _min[i] > origin ? _min[i] - origin : 0;
+		_hi[i] = std::min(_max[i] - origin, _bs[i] - 1);
+	}
+	_blk = _g->GetBlock((_b[2] * _bdims[1] + _b[1]) * _bdims[0] + _b[0]);
+	_y = _lo[1];
+	_z = _lo[2];
+	_setRow();
+  }
+
+  void _nextRow() {
+	if (++_y <= _hi[1]) {
+		_setRow();
+		return;
+	}
+	_y = _lo[1];
+	if (++_z <= _hi[2]) {
+		_setRow();
+		return;
+	}
+
+	for (int i=0; i<3; i++) {
+		if (++_b[i] <= _max[i] / _bs[i]) {
+			_setBlock();
+			return;
+		}
+		_b[i] = _min[i] / _bs[i];
+	}
+	_ptr = _rowStart = _rowEnd = nullptr;	// end
+  }
+ };
+
+ typedef Grid::BlockIterator<float> BlkIterator;
+ typedef Grid::BlockIterator<const float> ConstBlkIterator;
+
+ //! Construct a begin block iterator that will iterate through elements
+ //! with grid indices inside or on the box defined by \p min and \p max
+ //
+ BlkIterator blkbegin(
+	const std::vector <size_t> &min, const std::vector <size_t> &max
+ ) {
+	return(BlkIterator(this, min, max));
+ }
+ BlkIterator blkbegin() {
+	return(BlkIterator(this, std::vector <size_t> (), _dims));
+ }
+ BlkIterator blkend() { return(BlkIterator()); }
+
+ ConstBlkIterator cblkbegin(
+	const std::vector <size_t> &min, const std::vector <size_t> &max
+ ) const {
+	return(ConstBlkIterator(this, min, max));
+ }
+ ConstBlkIterator cblkbegin() const {
+	return(ConstBlkIterator(this, std::vector <size_t> (), _dims));
+ }
+ ConstBlkIterator cblkend() const { return(ConstBlkIterator()); }
+
 protected:
 
  virtual float GetValueNearestNeighbor(
@@ -1069,6 +1500,52 @@ protected:
 	const std::vector <float *> &blks, const std::vector <size_t> &indices
  ) const;
 
+ float *AccessIndex(
+	const std::vector <float *> &blks, const Size_tArr3 &indices
+ ) const;
+
+ //! Location of a point within a cell of a structured grid
+ //!
+ //! \a index contains the indices of the cell's minimum corner node,
+ //! and \a wgt the point's position within the cell along each axis,
+ //! in the range [0,1]: the weight given to the node at \a index + 1.
+ //! Unused dimensions have an index and weight of zero. \a inside is
+ //! false if the point lies outside of the grid.
+ //
+ class CellLocation {
+ public:
+  size_t index[3];
+  double wgt[3];
+  bool inside;
+ };
+
+ //! Reconstruct the values of the sampled function at many points
+ //!
+ //! Helper for GetValues() implementations. For each point, 
+ //! \p locate is passed a pointer to the point's coordinates in 
+ //! \p xyz and must return the point's location in the grid. The
+ //! value at the point is then the trilinear interpolation of the 
+ //! nodes of the cell containing it or, if \p nearest is true, the
+ //! value of the nearest node. Nodes whose interpolation weight is
+ //! zero are not accessed. The missing value is returned for points
+ //! that are not inside the grid, and for points whose reconstruction
+ //! would use a missing value.
+ //!
+ //! Points are processed in fixed size batches so that their locations
+ //! remain in cache.
+ //!
+ //! \param[in] xyz Array of \p n points, with a stride of three
+ //! \param[in] n Number of points
+ //! \param[in] nearest Use nearest neighbor reconstruction
+ //! \param[in] locate Function that locates a point
+ //! \param[out] values Array of \p n values
+ //
+ void InterpolatePoints(
+	const double *xyz, size_t n, bool nearest,
+	const std::function <void (const double *, CellLocation &)> &locate,
+	float *values
+ ) const;
+
 
 private:
 
@@ -1077,6 +1554,12 @@ private:
  std::vector <size_t> _bdims;   // dimensions (specified in blocks) of ROI
  std::vector <float *> _blks;
  std::vector <bool> _periodic;	// periodicity of boundaries
+
+ // Blocks decoded by the BlockDecoder, shared with copies of the grid.
+ // NULL unless SetBlockDecoder() is called
+ //
+ class DecodedBlocks;
+ std::shared_ptr <DecodedBlocks> _decoded;
  size_t _topologyDimension;
  float _missingValue;
  bool _hasMissing;
@@ -1084,8 +1567,27 @@ private:
  long _nodeIDOffset;
  long _cellIDOffset;
 
- virtual void _getUserCoordinatesHelper(
-	const std::vector <double> &coords, double &x, double &y, double &z
+ float *_decodeBlock(size_t b) const;
+
+ float *_accessIndex(const Size_tArr3 &indices) const;
+
+ bool _blockOffset(
+	const Size_tArr3 &indices, size_t &b, size_t &offset
+ ) const;
+
+ void _interpolateCells(
+	const std::vector <CellLocation> &locs, bool nearest, float *values
+ ) const;
+
+ bool _blockRange(
+	const std::vector <size_t> &min, const std::vector <size_t> &max,
+	size_t rmin[3], size_t rmax[3], size_t bmin[3], size_t bmax[3],
+	size_t bs[3], size_t bdims[3]
+ ) const;
+
+ void _blockExtents(
+	size_t ib, size_t jb, size_t kb,
+	const size_t rmin[3], const size_t rmax[3], BlockExtents &ext
  ) const;
 
 };
@@ -0,0 +1,220 @@
+#ifndef _GridStats_
+#define _GridStats_
+
+#include <vector>
+#include <vapor/Grid.h>
+
+namespace VAPoR {
+//
+//! \class GridStats
+//! \brief Parallel reductions over the values of a Grid
+//!
+//! This class computes summary statistics - the range, the count,
+//! mean, and variance, and fixed-bin histograms - of the values of a
+//! Grid, or of a box of grid indices within it. The blocks of the
+//! region are shared among several threads with
+//! Grid::ForEachBlockParallel(). Each thread reduces the blocks it
+//! visits into a partial result of its own, and the partial results
+//! are merged once all blocks have been visited, so no locking is
+//! needed and the result does not depend on how the blocks were shared
+//! out, except for floating point rounding.
+//!
+//! Missing values, and values that are not finite, are skipped.
+//!
+//! \sa Grid::ForEachBlockParallel()
+//
+class VDF_API GridStats {
+public:
+
+ //! Count, range, mean, and variance of a set of values
+ //!
+ //! Values are accumulated with Welford's algorithm, and sets are
+ //! merged with the pairwise update of Chan et al, so the variance does
+ //! not suffer the cancellation of the textbook sum of squares formula.
+ //! Weighted values use West's generalization, for which the weight
+ //! of an unweighted value is one.
+ //
+ class Moments {
+ public:
+  Moments() { Clear(); }
+
+  void Clear() {
+	count = 0;
+	weight = 0.0;
+	min = max = 0.0;
+	mean = 0.0;
+	m2 = 0.0;
+  }
+
+  //! Add a value
+  //
+  void Add(double v) { Add(v, 1.0); }
+
+  //! Add a value with a weight. Values with a weight that is not
+  //! positive are ignored.
+  //
+  void Add(double v, double w);
+
+  //! Combine with the moments of another set of values
+  //
+  void Merge(const Moments &m);
+
+  //! Return the (population) variance, the weighted mean of the
+  //! squared deviations from the mean. Zero if there are no values
+  //
+  double Variance() const { return(weight > 0.0 ? m2 / weight : 0.0); }
+
+  //! Return the square root of Variance()
+  //
+  double StdDev() const;
+
+  size_t count;		// number of values
+  double weight;	// sum of the weights
+  double min;		// minimum value. Zero if count is zero
+  double max;		// maximum value. Zero if count is zero
+  double mean;		// weighted mean
+  double m2;		// weighted sum of squared deviations from the mean
+ };
+
+ //! A histogram with equal width bins
+ //!
+ //! The range [\a lo, \a hi] is divided into equal width bins. A value
+ //! equal to \a hi is counted in the last bin. Values outside of the
+ //! range are counted by \a below and \a above.
+ //
+ class Histogram {
+ public:
+  Histogram() { Init(0.0, 1.0, 1); }
+  Histogram(double lo, double hi, size_t nbins) { Init(lo, hi, nbins); }
+
+  //! Set the range and number of bins, and clear the counts.
+  //! \p nbins is clamped to at least one.
+  //
+  void Init(double lo, double hi, size_t nbins);
+
+  //! Count a value. NaN is ignored
+  //
+  void Add(double v) {
+	if (v < lo) below++;
+	else if (v > hi) above++;
+	else if (v == v) {
+		size_t b = (size_t) ((v - lo) * _scale);
+		counts[b < counts.size() ? b : counts.size()-1]++;
+	}
+  }
+
+  //! Add the counts of another histogram with the same range and
+  //! number of bins
+  //
+  void Merge(const Histogram &h);
+
+  //! Return the total number of values counted, including those
+  //! outside of the histogram's range
+  //
+  size_t GetTotal() const;
+
+  //! Estimate a percentile
+  //!
+  //! Values are assumed to be distributed evenly within each bin.
+  //! Values below or above the histogram's range are treated as equal
+  //! to \a lo or \a hi, respectively.
+  //!
+  //! \param[in] p Percentile in the range [0.0, 1.0]
+  //! \retval value The estimated value. \a lo if no values have been
+  //! counted
+  //
+  double Percentile(double p) const;
+
+  double lo;
+  double hi;
+  std::vector <size_t> counts;	// count of values in each bin
+  size_t below;			// count of values less than lo
+  size_t above;			// count of values greater than hi
+
+ private:
+  double _scale;
+ };
+
+ //! Compute the range of a region of a grid
+ //!
+ //! \param[in] g The grid
+ //! \param[in] min Minimum grid indices of the region
+ //! \param[in] max Maximum grid indices of the region. Indices outside
+ //! of the grid are clamped to the grid boundary
+ //! \param[out] range The minimum and maximum values. If the region
+ //! contains no valid values both are zero.
+ //! \param[in] nthreads Number of threads. If less than one the number
+ //! of processors is used.
+ //!
+ //! \retval count The number of valid values in the region
+ //
+ static size_t ComputeRange(
+	const Grid &g,
+	const std::vector <size_t> &min, const std::vector <size_t> &max,
+	double range[2], int nthreads = 0
+ );
+
+ //! Compute the range of a grid
+ //
+ static size_t ComputeRange(const Grid &g, double range[2], int nthreads = 0);
+
+ //! Compute the moments of the values in a region of a grid
+ //!
+ //! \param[in] g The grid
+ //! \param[in] min Minimum grid indices of the region
+ //! \param[in] max Maximum grid indices of the region. Indices outside
+ //! of the grid are clamped to the grid boundary
+ //! \param[out] m The moments
+ //! \param[in] nthreads Number of threads. If less than one the number
+ //! of processors is used.
+ //
+ static void ComputeMoments(
+	const Grid &g,
+	const std::vector <size_t> &min, const std::vector <size_t> &max,
+	Moments &m, int nthreads = 0
+ );
+
+ //! Compute the moments of the values of a grid
+ //
+ static void ComputeMoments(const Grid &g, Moments &m, int nthreads = 0);
+
+ //! Compute weighted moments of the values in a region of a grid
+ //!
+ //! Like ComputeMoments(), but each value of \p g is weighted by the
+ //! value of \p w with the same grid indices - typically a cell
+ //! volume or area. Values whose weight is missing or not positive
+ //! are skipped.
+ //!
+ //! \param[in] w The weights. Must have the same dimensions and block
+ //! size as \p g.
+ //!
+ //! \retval status A negative int is returned if \p w and \p g
+ //! are not compatible
+ //
+ static int ComputeWeightedMoments(
+	const Grid &g, const Grid &w,
+	const std::vector <size_t> &min, const std::vector <size_t> &max,
+	Moments &m, int nthreads = 0
+ );
+
+ //! Compute a histogram of the values in a region of a grid
+ //!
+ //! \param[in,out] h The histogram. Its range and number of bins
+ //! must be set with Histogram::Init() beforehand. The counts of the
+ //! region's values are added to any already in \p h.
+ //
+ static void ComputeHistogram(
+	const Grid &g,
+	const std::vector <size_t> &min, const std::vector <size_t> &max,
+	Histogram &h, int nthreads = 0
+ );
+
+ //! Compute a histogram of the values of a grid
+ //
+ static void ComputeHistogram(const Grid &g, Histogram &h, int nthreads = 0);
+
+};
+
+};
+
+#endif
@@ -2,11 +2,10 @@
 #define _KDTreeRG_
 
 #include <ostream>
+#include <string>
 #include <vector>
 #include <vapor/Grid.h>
 
-#include "nanoflann.hpp"
-
 struct kdtree;
 
 namespace VAPoR {
@@ -14,8 +13,17 @@ namespace VAPoR {
 //! \class KDTreeRG
 //! \brief This class implements a k-d space partitioning tree.
 //!
-//! This class provides an object-oriented interface to kdtree.c, which
-//! implements a k-d space partitioning tree. 
+//! This class implements a 2D or 3D k-d space partitioning tree over
+//! the vertices of a grid, and supports nearest neighbor queries.
+//!
+//! The tree is stored implicitly in three flat arrays: the point
+//! coordinates, permuted so that each subtree occupies a contiguous
+//! range with its splitting point at the middle of the range; the
+//! original offset of each point; and the splitting dimension of each
+//! subtree. Subtrees are built concurrently, and because the arrays
+//! contain no pointers a tree may be written to a file with Write()
+//! and later mapped back into memory with Read() instead of being 
+//! rebuilt.
 //!
 //! \sa https://en.wikipedia.org/wiki/K-d_tree
 //
@@ -36,10 +44,15 @@ public:
  //! for each point in the k-d tree. The \p xg and \p yg Grid
  //! instances must have identical configurations, differing only in their
  //! data values.
+ //! \param[in] nthreads Number of threads used to build the tree. A
+ //! value of 0, the default, indicates that the thread count should be
+ //! determined by the environment.
+ //!
+ //! Points with a coordinate that is not finite are not inserted.
  //!
  //! \sa Grid()
  //
- KDTreeRG( const Grid &xg, const Grid &yg );
+ KDTreeRG( const Grid &xg, const Grid &yg, int nthreads = 0 );
 
  //! Construct a 3D k-d tree for a structured grid
  //!
@@ -50,16 +63,49 @@ public:
  //! \param[in] yg A Grid instance giving the Y user coordinates
  //! for each point in the k-d tree.
  //! \param[in] zg A Grid instance giving the Z user coordinates
- //! for each point in the k-d tree. The \p xg, \p yg, and \p yg Grid
+ //! for each point in the k-d tree. The \p xg, \p yg, and \p zg Grid
  //! instances must have identical configurations, differing only in their
  //! data values.
+ //! \param[in] nthreads Number of threads used to build the tree.
  //!
  //! \sa KDTreeRG(const Grid, const Grid)
  //
- //KDTreeRG( const Grid &xg, const Grid &yg, const Grid &zg );
+ KDTreeRG( const Grid &xg, const Grid &yg, const Grid &zg, int nthreads = 0 );
 
  virtual ~KDTreeRG();
 
+ //! Read a k-d tree from a file
+ //!
+ //! Reads a k-d tree previously written with Write(). Where supported
+ //! the file is memory mapped rather than read, so the cost of loading
+ //! a tree is independent of its size until it is queried.
+ //!
+ //! \param[in] path Path to the file
+ //!
+ //! \retval kdtree A newly allocated k-d tree, which the caller
+ //! must delete, or NULL on failure, in which case an error message
+ //! is logged with MyBase::SetErrMsg()
+ //!
+ //! \sa Write()
+ //
+ static KDTreeRG *Read(const std::string &path);
+
+ //! Write the k-d tree to a file
+ //!
+ //! The file is written to a temporary file in the same directory and
+ //! renamed, so concurrent readers never see a partial file. The file
+ //! format is native to the host, and files are not portable between
+ //! hosts with different byte order or word size.
+ //!
+ //! \param[in] path Path to the file
+ //!
+ //! \retval status A negative int is returned on failure and an error
+ //! message will be logged with MyBase::SetErrMsg()
+ //!
+ //! \sa Read()
+ //
+ int Write(const std::string &path) const;
+
  //! Return indecies of nearest point
  //!
  //! This method returns the \a ijk indeces of the grid vertex nearest, by 
@@ -68,7 +114,8 @@ public:
  //! Grid instances passed into the constructor.
  //!
  //! \param[in] coordu A 2D or 3D vector of user coordinates specifying
- //! the location of a point in space.
+ //! the location of a point in space. The size of \p coordu must
+ //! match the number of coordinate Grids passed to the constructor.
  //!
  //! \param[out] index The \a ijk indecies of the grid vertex nearest 
  //! \p coordu.
@@ -83,6 +130,16 @@ public:
     this->Nearest(coordu_f, index);
  }
 
+ //! Return indecies of nearest point without allocating memory
+ //!
+ //! \param[in] coordu User coordinates of the point. Only the first
+ //! GetNumCoordinates() elements are used.
+ //! \param[out] index The \a ijk indecies of the grid vertex nearest 
+ //! \p coordu. Elements beyond the dimensionality of the grids passed
+ //! to the constructor are set to zero.
+ //
+ void Nearest(const Grid::DblArr3 &coordu, Grid::Size_tArr3 &index) const;
+
  //! Returns the dimesionality of the structured grids passed to the 
  //! constructor.
  //!
@@ -96,76 +153,52 @@ public:
     return (_dims);
  }
 
+ //! Returns the number of coordinates of each point, 2 or 3
+ //
+ int GetNumCoordinates() const { return(_ncoords); }
+
+ //! Returns the number of points stored in the tree
+ //
+ size_t GetNumPoints() const { return(_npoints); }
+
+ //! Returns the number of bytes of memory used by this class instance,
+ //! including any mapped file
+ //
+ size_t GetMemoryUsage() const;
+
 private:
 
-    class  PointCloud2D
-    {
-    public:
-        // Constructor
-        PointCloud2D( const Grid& xg, const Grid& yg )
-        {
-            assert(xg.GetDimensions() == yg.GetDimensions());
-            assert(xg.GetDimensions().size() <= 2);
-
-            // number of elements
-            std::vector<size_t> dims = xg.GetDimensions();
-            size_t nelem = 1;
-            for (int i=0; i<dims.size(); i++) 
-                nelem *= dims[i];
-            this->X.resize( nelem );
-            this->Y.resize( nelem );
-
-            // Store the point coordinates in the k-d tree
-            Grid::ConstIterator xitr = xg.cbegin();
-            Grid::ConstIterator yitr = yg.cbegin();
-
-            for (size_t i=0; i<nelem; ++i, ++xitr, ++yitr)
-            {
-                this->X[i] = *xitr;
-                this->Y[i] = *yitr;
-            }
-        } // end of the Constructor
-
-        // Must return the number of data points
-        inline size_t kdtree_get_point_count() const 
-        { 
-            assert( X.size() == Y.size() );
-            return X.size(); 
-        }
-
-        // Returns the dim'th component of the idx'th point in the class:
-        // Since this is inlined and the "dim" argument is typically an immediate value, the
-        //  "if/else's" are actually solved at compile time.
-        inline float kdtree_get_pt(const size_t idx, int dim) const
-        {
-            if (dim == 0) 
-                return X[idx];
-            else 
-                return Y[idx];
-        }
-
-        // Optional bounding-box computation: return false to default to a standard bbox computation loop.
-        //   Return true if the BBOX was already computed by the class and returned in "bb" 
-        //   so it can be avoided to redo it again.
-        //   Look at bb.size() to find out the expected dimensionality (e.g. 2 or 3 for point clouds)
-        template <class BBOX>
-        bool kdtree_get_bbox(BBOX& /* bb */) const 
-        { 
-            return false; 
-        }
-
-    private:
-        std::vector<float> X, Y;
-
-    };  // end of class PointCloud2D
-
-    typedef  nanoflann::KDTreeSingleIndexAdaptor< 
-                        nanoflann::L2_Simple_Adaptor<float, PointCloud2D>,
-                        PointCloud2D, 2/* dimension */ >   KDTreeType;
-
-    PointCloud2D        _points;
-    KDTreeType          _kdtree;
-    std::vector<size_t> _dims;
+ int _ncoords;
+ size_t _npoints;
+ std::vector<size_t> _dims;
+ float _bounds[6];				// bounding box of the points
+
+ // Either point into the vectors below or into the mapped file
+ //
+ const float *_coords;			// interleaved point coordinates
+ const size_t *_offsets;		// offset of each point in the grid
+ const unsigned char *_splits;	// splitting dimension of each subtree
+
+ std::vector <float> _coordsBuf;
+ std::vector <size_t> _offsetsBuf;
+ std::vector <unsigned char> _splitsBuf;
+
+ void *_map;
+ size_t _mapSize;
+
+ KDTreeRG();
+ KDTreeRG(const KDTreeRG &);
+ KDTreeRG &operator=(const KDTreeRG &);
+
+ void _build(const std::vector <const Grid *> &grids, int nthreads);
+
+ size_t _nearestOffset(const float *pt) const;
+
+ void _nearest(
+	const float *pt, size_t lo, size_t hi, float mindist, float dists[3],
+	size_t &best, float &bestDist
+ ) const;
+
 };  // end of class KDTreeRG.
 
 
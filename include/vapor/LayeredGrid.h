@@ -66,6 +66,51 @@ public:
  //!
  float GetValue(const std::vector <double> &coords) const override;
 
+ //! \copydoc Grid::GetValues()
+ //
+ virtual void GetValues(
+	const double *xyz, size_t n, float *values
+ ) const override;
+
+ //! Extract a horizontal surface at a constant level
+ //!
+ //! Reconstruct the sampled function on the surface where the function
+ //! sampled by \p level, typically pressure, is equal to \p value. 
+ //! For each grid column (I,J) the
+ //! first layer, searching up from K = 0, whose two nodes bracket 
+ //! \p value is found, and the function is linearly interpolated 
+ //! between the two nodes. \p level may increase or decrease with K.
+ //!
+ //! The blocks of the grid are visited once, in parallel, so this is
+ //! much faster than calling GetValue() for each column.
+ //!
+ //! \param[in] level A grid with the same dimensions and block size as
+ //! this grid
+ //! \param[in] value The level of the surface
+ //! \param[out] values An array of dims[0] * dims[1] values, with the I
+ //! index varying fastest. A column's value is the missing value if
+ //! no layer of the column brackets \p value, or if either of the 
+ //! bracketing nodes has a missing value.
+ //! \param[in] nthreads The number of threads to use. If less than one
+ //! the number of processors is used.
+ //!
+ //! \sa GetValuesAtHeight(), GetMissingValue()
+ //
+ void GetValuesAtLevel(
+	const Grid &level, double value, float *values, int nthreads = 0
+ ) const;
+
+ //! Extract a horizontal surface at a constant height
+ //!
+ //! Equivalent to GetValuesAtLevel() with the grid of Z coordinates 
+ //! passed to the constructor as \p level.
+ //!
+ //! \param[in] z The Z user coordinate of the surface
+ //!
+ //! \sa GetValuesAtLevel()
+ //
+ void GetValuesAtHeight(double z, float *values, int nthreads = 0) const;
+
  //! \copydoc Grid::GetInterpolationOrder()
  //
  virtual int GetInterpolationOrder() const override {
@@ -115,16 +160,15 @@ public:
 	std::vector <double> &coords
  ) const override;
 
+ void GetUserCoordinates(
+	const Size_tArr3 &indices, DblArr3 &coords
+ ) const override;
+
  void GetUserCoordinates(
 	size_t i, size_t j, size_t k,
 	double &x, double &y, double &z
  ) const override {
-	std::vector <size_t> indices = {i,j,k};
-	std::vector <double> coords;
-	GetUserCoordinates(indices, coords);
-	x = coords[0];
-	y = coords[1];
-	z = coords[2];
+	StructuredGrid::GetUserCoordinates(i, j, k, x, y, z);
  }
 
  //! \copydoc Grid::GetIndices()
@@ -134,6 +178,10 @@ public:
     std::vector <size_t> &indices
  ) const override;
 
+ void GetIndices(
+	const DblArr3 &coords, Size_tArr3 &indices
+ ) const override;
+
  //! \copydoc Grid::GetIndicesCell
  //!
  virtual bool GetIndicesCell(
@@ -141,10 +189,16 @@ public:
 	std::vector <size_t> &indices
  ) const override;
 
+ virtual bool GetIndicesCell(
+	const DblArr3 &coords, Size_tArr3 &indices
+ ) const override;
+
  //! \copydoc Grid::InsideGrid()
  //!
  bool InsideGrid(const std::vector <double> &coords) const override;
 
+ bool InsideGrid(const DblArr3 &coords) const override;
+
  //! \copydoc Grid::GetPeriodic()
  //!
  //! Only horizonal dimensions can be periodic. Layered (third) dimension
@@ -326,6 +380,10 @@ private:
 	size_t i, size_t j, double z, size_t &k
  ) const;
 
+ float _zAt(size_t i, size_t j, size_t k) const;
+
+ void _getColumn(size_t i, size_t j, float *zcol) const;
+
 };
 };
 #endif
@@ -188,10 +188,27 @@ public:
  //
  bool &InvalidFloatAbortOnOff() {return(_InvalidFloatAbort);};
 
+ //! Set or get the fast transform flag
+ //!
+ //! When set, float signals are transformed in single precision, and 
+ //! wavelets whose filters factor into lifting steps (bior2.2 and 
+ //! bior4.4) are transformed by lifting instead of convolution. The
+ //! results differ from the default transform by rounding: about 1e-7
+ //! of the signal's magnitude for float signals, and 1e-11 for double
+ //! signals transformed with bior4.4, whose tabulated filter 
+ //! coefficients carry about 12 digits. By default the flag is not 
+ //! set, so that the coefficients written to a data collection do not
+ //! depend on it.
+ //!
+ //! \retval flag A reference to the fast transform flag
+ //
+ bool &FastTransformOnOff() {return(_FastTransform);};
+
 protected:
 
 private:
  bool _InvalidFloatAbort;
+ bool _FastTransform;
  dwtmode_t _mode;
  WaveFiltBase *_wf;
  string _wname;
@@ -238,13 +238,13 @@ public:
  //! either through the error message callback or the error message
  //! FILE pointer. 
  //! 
+ //! The setting applies only to the calling thread.
+ //! 
  //! \param[in] enable Boolean flag to enable or disable error reporting
  //!
- static bool EnableErrMsg(bool enable) {
-	bool prev = Enabled; Enabled = enable; return (prev);
- };
+ static bool EnableErrMsg(bool enable);
 
- static bool GetEnableErrMsg() {return Enabled; }
+ static bool GetEnableErrMsg();
 
  // N.B. the error codes/messages are stored in static class members!!!
  static char 	*ErrMsg;
@@ -257,7 +257,6 @@ public:
  static int	DiagMsgSize;
  static FILE	*DiagMsgFilePtr;
  static DiagMsgCB_T DiagMsgCB;
- static bool Enabled;
 
  
 
@@ -84,6 +84,10 @@ public:
 	std::vector <double> &coords
  ) const override;
 
+ virtual void GetUserCoordinates(
+	const Size_tArr3 &indices, DblArr3 &coords
+ ) const override;
+
  //! \copydoc Grid::GetIndices()
  //
  virtual void GetIndices(
@@ -91,6 +95,10 @@ public:
 	std::vector <size_t> &indices
  ) const override;
 
+ virtual void GetIndices(
+	const DblArr3 &coords, Size_tArr3 &indices
+ ) const override;
+
  //! \copydoc Grid::GetIndicesCell
  //!
  virtual bool GetIndicesCell(
@@ -98,10 +106,22 @@ public:
 	std::vector <size_t> &indices
  ) const override;
 
+ virtual bool GetIndicesCell(
+	const DblArr3 &coords, Size_tArr3 &indices
+ ) const override;
+
  //! \copydoc Grid::InsideGrid()
  //
  virtual bool InsideGrid(const std::vector <double> &coords) const override;
 
+ virtual bool InsideGrid(const DblArr3 &coords) const override;
+
+ //! \copydoc Grid::GetValues()
+ //
+ virtual void GetValues(
+	const double *xyz, size_t n, float *values
+ ) const override;
+
 
  class ConstCoordItrRG : public Grid::ConstCoordItrAbstract {
  public:
@@ -30,6 +30,23 @@ namespace VAPoR {
 //! This class implements a quick and dirty significance map - a mapping 
 //! indicating which entries in an array are valid and which are not. 
 //!
+//! The encoded form of a map returned by GetMap() stores the sorted
+//! entries in one of three ways, whichever has the smallest worst case
+//! size for the map's dimensions and number of entries:
+//!
+//! \li Packed: each entry is stored with the number of bits needed for
+//! the largest possible entry. This is the only encoding understood by
+//! versions of this class prior to the addition of the other two, and
+//! maps using it are still written in the old format.
+//! \li Gaps: the differences between successive entries are Golomb-Rice
+//! coded. Best for sparse maps.
+//! \li Bitmap: one bit for each possible entry. Best for dense maps.
+//!
+//! Because the choice depends only on the dimensions and number of
+//! entries, the space needed to store an encoded map is known before
+//! the entries are, and is returned by GetMapSize(). Encoded maps
+//! of any version are accepted by SetMap().
+//!
 
 
 class WASP_API SignificanceMap : public Wasp::MyBase {
@@ -192,8 +209,14 @@ public:
  //! signficance map that would be returned by GetMap() for a 
  //! SignificanceMap of given dimension, \p dims, and number of 
  //! entries, \p num_entries.
+ //!
+ //! \param packed[in] If true, the size of a map that uses only the
+ //! packed encoding, readable by older versions of this class, is
+ //! returned.
  //
- static size_t GetMapSize(vector <size_t> dims, size_t num_entries);
+ static size_t GetMapSize(
+	vector <size_t> dims, size_t num_entries, bool packed = false
+ );
 
  //! Return size in bytes of an encoded signficance map of given size
  //!
@@ -206,10 +229,12 @@ public:
  //! this is not the same value for the current significance map.
  //!
  //! \param num_entries[in] Number of entries in the signficance map
+ //! \param packed[in] If true, the size of a map that uses only the
+ //! packed encoding is returned
  //!
  //! \sa GetMap()
  //
- size_t GetMapSize(size_t num_entries) const;
+ size_t GetMapSize(size_t num_entries, bool packed = false) const;
 
 
  //! Return size in bytes of current encoded signficance map
@@ -228,17 +253,22 @@ public:
  //!
  //! \param map[out] Encoded significance map data
  //! \param maplen[out] Length of \p map in bytes
+ //! \param packed[in] If true, the map is encoded with the packed
+ //! encoding, readable by older versions of this class
  //
- void GetMap(const unsigned char **map, size_t *maplen);
+ void GetMap(const unsigned char **map, size_t *maplen, bool packed = false);
 
  //! Return the compressed representation of the significance map. The data 
  //! returned are only suitable passing as an argument to the constructor.
  //!
  //! \param map[out] Encoded significance map data. Caller is 
  //! responsible for allocating memory. The array \p map must be of 
- //! size GetMapSize().
+ //! size GetMapSize(). If the map has fewer entries than the worst
+ //! case for its encoding the remaining bytes are not written.
+ //! \param packed[in] If true, the map is encoded with the packed
+ //! encoding, readable by older versions of this class
  //
- void GetMap(unsigned char *map);
+ void GetMap(unsigned char *map, bool packed = false);
 
  //
  //! Reinitialize the significance map with the map, \p map , returned from a 
@@ -302,7 +332,13 @@ public:
 private:
 
 	static const int HEADER_SIZE = 64;
-	static const int VDF_VERSION = 2;
+	static const int VDF_VERSION = 3;
+	static const int PACKED_VERSION = 2;	// last version with packed only
+	static const int MaxRiceK = 24;		// largest GAPS Rice parameter
+
+	// Encodings of the entries of a map
+	//
+	enum encoding_t {PACKED = 0, GAPS = 1, BITMAP = 2};
 	size_t _nx;
 	size_t _ny;
 	size_t _nz;
@@ -327,6 +363,11 @@ private:
 
 	static size_t _GetBitsPerIdx(vector <size_t> dims);
 
+	static size_t _GetEncoding(
+		vector <size_t> dims, size_t num_entries, bool packed,
+		encoding_t &encoding, int &k
+	);
+
 };
 
 
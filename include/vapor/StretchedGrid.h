@@ -101,6 +101,10 @@ public:
 	std::vector <double> &coords
  ) const override;
 
+ virtual void GetUserCoordinates(
+	const Size_tArr3 &indices, DblArr3 &coords
+ ) const override;
+
  // \copydoc GetGrid::GetIndices()
  //
  virtual void GetIndices(
@@ -108,6 +112,10 @@ public:
 	std::vector <size_t> &indices
  ) const override;
 
+ virtual void GetIndices(
+	const DblArr3 &coords, Size_tArr3 &indices
+ ) const override;
+
  //! \copydoc Grid::GetIndicesCell
  //!
  virtual bool GetIndicesCell(
@@ -115,10 +123,22 @@ public:
 	std::vector <size_t> &indices
  ) const override;
 
+ virtual bool GetIndicesCell(
+	const DblArr3 &coords, Size_tArr3 &indices
+ ) const override;
+
  // \copydoc GetGrid::InsideGrid()
  //
  virtual bool InsideGrid(const std::vector <double> &coords) const override;
 
+ virtual bool InsideGrid(const DblArr3 &coords) const override;
+
+ //! \copydoc Grid::GetValues()
+ //
+ virtual void GetValues(
+	const double *xyz, size_t n, float *values
+ ) const override;
+
  //! Returns reference to vector containing X user coordinates
  //!
  //! Returns reference to vector passed to constructor 
@@ -221,6 +241,8 @@ private:
 	double xwgt[2], double ywgt[2], double zwgt[2]
  ) const;
 
+ void _locateCell(const double *coords, CellLocation &loc) const;
+
  virtual void _getMinCellExtents(std::vector <double> &minCellExtents) const; 
 
 };
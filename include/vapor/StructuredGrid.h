@@ -88,6 +88,12 @@ public:
 	std::vector <std::vector <size_t> > &nodes
  ) const override;
 
+ //! \copydoc Grid::GetCellNodes(const Size_tArr3 &, std::vector <Size_tArr3> &) const
+ //!
+ virtual bool GetCellNodes(
+	const Size_tArr3 &cindices, std::vector <Size_tArr3> &nodes
+ ) const override;
+
  //! \copydoc Grid::GetCellNeighbors()
  //!
  virtual bool GetCellNeighbors(
@@ -103,8 +109,14 @@ public:
  ) const override;
 
 
+ //! \copydoc Grid::ClampCoord()
+ //!
  virtual void ClampCoord(std::vector <double> &coords) const override;
 
+ //! \copydoc Grid::ClampCoord(DblArr3 &) const
+ //!
+ virtual void ClampCoord(DblArr3 &coords) const override;
+
 
 
 
@@ -114,6 +126,34 @@ public:
 
 protected: 
 
+ //! Clamp a single coordinate as ClampCoord() does
+ //!
+ //! \param[in] x Coordinate to clamp
+ //! \param[in] dim Length of the grid dimension for the coordinate's axis
+ //! \param[in] periodic True if the axis is periodic
+ //! \param[in] minu Minimum user extent along the axis
+ //! \param[in] maxu Maximum user extent along the axis
+ //!
+ //! \retval x Clamped coordinate
+ //!
+ //! This is a lightweight version of ClampCoord() for batch operations,
+ //! such as GetValues(), that fetch the grid's dimensions, extents and
+ //! periodicity once rather than for each point.
+ //
+ static double ClampCoord(
+	double x, size_t dim, bool periodic, double minu, double maxu
+ ) {
+	if (dim == 1) return(minu);
+
+	if (x<minu && periodic) {
+		while (x<minu) x+= maxu-minu;
+	}
+	if (x>maxu && periodic) {
+		while (x>maxu) x-= maxu-minu;
+	}
+	return(x);
+ }
+
 private:
  std::vector <size_t> _cellDims;
 
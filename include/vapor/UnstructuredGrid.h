@@ -135,6 +135,12 @@ public:
 	std::vector <std::vector <size_t> > &nodes
  ) const override;
 
+ //! \copydoc Grid::GetCellNodes(const Size_tArr3 &, std::vector <Size_tArr3> &) const
+ //!
+ virtual bool GetCellNodes(
+	const Size_tArr3 &cindices, std::vector <Size_tArr3> &nodes
+ ) const override;
+
  //! \copydoc Grid::GetCellNeighbors()
  //!
  virtual bool GetCellNeighbors(
@@ -191,6 +197,26 @@ public:
 	_boundaryID = v;
  }
 
+ //! Return the node IDs of the corners of each face
+ //!
+ //! Returns the \p vertexOnFace array passed to the constructor
+ //!
+ const int *GetVertexOnFace() const { return(_vertexOnFace); }
+
+ //! Return the face IDs of the faces sharing each node
+ //!
+ //! Returns the \p faceOnVertex array passed to the constructor
+ //!
+ const int *GetFaceOnVertex() const { return(_faceOnVertex); }
+
+ //! Return the maximum number of nodes that a face may have
+ //!
+ size_t GetMaxVertexPerFace() const { return(_maxVertexPerFace); }
+
+ //! Return the maximum number of faces that may share a node
+ //!
+ size_t GetMaxFacePerVertex() const { return(_maxFacePerVertex); }
+
  virtual void ClampCoord(std::vector <double> &coords) const override {
 	assert(coords.size() >= GetGeometryDim());
     while (coords.size() > GetGeometryDim()) {
@@ -198,6 +224,10 @@ public:
     }
  }
 
+ virtual void ClampCoord(DblArr3 &coords) const override {
+	for (int i=GetGeometryDim(); i<3; i++) coords[i] = 0.0;
+ }
+
 
 
 
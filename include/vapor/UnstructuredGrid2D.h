@@ -8,6 +8,7 @@
 #include <vapor/UnstructuredGrid.h>
 #include <vapor/UnstructuredGridCoordless.h>
 #include <vapor/KDTreeRG.h>
+#include <vapor/FaceLocatorUG2D.h>
 
 
 #ifdef WIN32
@@ -27,6 +28,14 @@ public:
 
  //! Construct a unstructured grid sampling 2D scalar function
  //!
+ //! \param[in] kdtree A KDTreeRG instance built from \p xug and \p yug,
+ //! used to find the nearest node to a point.
+ //! \param[in] locator An optional FaceLocatorUG2D instance built from
+ //! \p xug and \p yug, used to find the face containing a point. If NULL
+ //! the faces sharing the node returned by \p kdtree are searched, 
+ //! which is slower and may miss the containing face. The \p kdtree 
+ //! and \p locator pointers are shallow copied and must remain valid 
+ //! for the lifetime of this class instance.
  //
  UnstructuredGrid2D(
 	const std::vector <size_t> &vertexDims,
@@ -43,7 +52,8 @@ public:
 	const UnstructuredGridCoordless &xug,
 	const UnstructuredGridCoordless &yug,
 	const UnstructuredGridCoordless &zug,
-	const KDTreeRG *kdtree
+	const KDTreeRG *kdtree,
+	const FaceLocatorUG2D *locator = NULL
  );
 
  UnstructuredGrid2D() = default;
@@ -83,6 +93,20 @@ void GetIndices(
 
  bool InsideGrid(const std::vector <double> &coords) const override;
 
+ void GetUserCoordinates(
+	const Size_tArr3 &indices, DblArr3 &coords
+ ) const override;
+
+ void GetIndices(
+	const DblArr3 &coords, Size_tArr3 &indices
+ ) const override;
+
+ bool GetIndicesCell(
+	const DblArr3 &coords, Size_tArr3 &indices
+ ) const override;
+
+ bool InsideGrid(const DblArr3 &coords) const override;
+
  float GetValueNearestNeighbor (
 	const std::vector <double> &coords
  ) const override;
@@ -91,6 +115,16 @@ void GetIndices(
 	const std::vector <double> &coords
  ) const override;
 
+ //! \copydoc Grid::GetValues()
+ //!
+ //! If a FaceLocatorUG2D was provided to the constructor, each point
+ //! is located by walking the mesh from the face containing the 
+ //! previous point, so coherent points are located quickly.
+ //
+ virtual void GetValues(
+	const double *xyz, size_t n, float *values
+ ) const override;
+
 
  /////////////////////////////////////////////////////////////////////////////
  //
@@ -157,27 +191,25 @@ private:
  UnstructuredGridCoordless _yug;
  UnstructuredGridCoordless _zug;
  const KDTreeRG *_kdtree;
+ const FaceLocatorUG2D *_locator;
 
  bool _insideGrid(
-	const std::vector <double> &coords,
-	std::vector <size_t> &face_indices,
+	const double pt[2], size_t &face,
 	double *lambda, int &nlambda, double zwgt[2]
  ) const;
 
  bool _insideGridNodeCentered(
-	const std::vector <double> &coords,
-	std::vector <size_t> &face_indices,
+	const double pt[2], size_t &face,
 	double *lambda, int &nlambda, double zwgt[2]
  ) const;
 
  bool _insideGridFaceCentered(
-	const std::vector <double> &coords,
-	std::vector <size_t> &face_indices,
+	const double pt[2], size_t &face,
 	double *lambda, int &nlambda, double zwgt[2]
  ) const;
 
  bool _insideFace(
-	size_t face, double pt[2],
+	size_t face, const double pt[2],
 	double *lambda, int &nlambda, double zwgt[2]
  ) const;
 
@@ -98,6 +98,28 @@ void GetIndices(
 	return(false);
  }
 
+ void GetUserCoordinates(
+	const Size_tArr3 &, DblArr3 &coords
+ ) const override {
+	coords = {{0.0, 0.0, 0.0}};
+ }
+
+ void GetIndices(
+	const DblArr3 &, Size_tArr3 &indices
+ ) const override {
+	indices = {{0, 0, 0}};
+ }
+
+ bool GetIndicesCell(
+	const DblArr3 &, Size_tArr3 &indices
+ ) const override {
+	return(false);
+ }
+
+ bool InsideGrid(const DblArr3 &coords) const override {
+	return(false);
+ }
+
  float GetValueNearestNeighbor (
 	const std::vector <double> &coords
  ) const override {
@@ -148,6 +148,17 @@ public:
  //
  size_t GetVariableThreshold() const {return _variable_threshold; };
 
+ //! Enable or disable the fast wavelet transform
+ //!
+ //! Applies WASP::SetFastTransform() to the files from which variables
+ //! are subsequently opened for reading or writing. 
+ //! By default the fast transform is disabled.
+ //!
+ //! \sa WASP::SetFastTransform()
+ //
+ void SetFastTransform(bool enable) {_fastTransform = enable; };
+ bool GetFastTransform() const {return(_fastTransform); };
+
 
 
  //! \copydoc VDC::OpenVariableWrite()
@@ -259,6 +270,11 @@ protected:
     int lod = 0
  ) const;
 
+ int getBlockRanges(
+	size_t ts, string varname, std::vector <double> &range,
+	std::vector <double> &blkranges
+ );
+
 private:
  string _version;
  WASP *_master;	// Master NetCDF file
@@ -272,7 +288,7 @@ private:
   )  : FileObject( ts, varname, level, lod), 
 		_file_ts(file_ts), _wasp_data(wasp_data), _wasp_mask(wasp_mask), 
 		_varname_mask(varname_mask), _level_mask(level_mask), 
-		_file_ts_mask(file_ts_mask), _mv(mv)
+		_file_ts_mask(file_ts_mask), _mv(mv), _blkranges_complete(false)
   {}
 
   size_t GetFileTS() const {return(_file_ts);}
@@ -282,6 +298,13 @@ private:
   int GetLevelMask() const {return(_level_mask);}
   size_t GetFileTSMask() const {return(_file_ts_mask);}
   double GetMissingValue() const {return(_mv);}
+
+  // Per-block min, max pairs accumulated while writing. Empty if
+  // ranges are not recorded for the variable
+  //
+  std::vector <double> &GetBlockRanges() {return(_blkranges);}
+  bool GetBlockRangesComplete() const {return(_blkranges_complete);}
+  void SetBlockRangesComplete(bool complete) {_blkranges_complete = complete;}
  private:
   size_t _file_ts;
   WASP *_wasp_data;
@@ -290,6 +313,8 @@ private:
   int _level_mask;
   size_t _file_ts_mask;
   double _mv;
+  std::vector <double> _blkranges;
+  bool _blkranges_complete;
 
  };
 
@@ -297,6 +322,7 @@ private:
  Wasp::SmartBuf _mask_buffer;
  
  size_t _chunksizehint;	// NetCDF chunk size hint for file creates
+ bool _fastTransform;	// See SetFastTransform()
  size_t _master_threshold;
  size_t _variable_threshold;
  int _nthreads;
@@ -318,6 +344,14 @@ private:
  template <class T>
  int _writeSliceTemplate(int fd, const T *slice);
 
+ template <class T>
+ void _updateBlockRanges(
+	VDCFileObject *o, const vector <size_t> &min, const vector <size_t> &max,
+	const T *data, const unsigned char *mask
+ );
+
+ int _writeBlockRanges(VDCFileObject *o);
+
  int _ReadMasterDimensions();
  int _ReadMasterAttributes (
 	string prefix, map <string, Attribute> &atts
@@ -344,6 +378,9 @@ private:
  int _DefBaseVar(WASP *ncdf, const VDC::BaseVar &var, size_t max_ts);
  int _DefDataVar(WASP *ncdf, const VDC::DataVar &var, size_t max_ts);
  int _DefCoordVar(WASP *ncdf, const VDC::CoordVar &var, size_t max_ts);
+ int _DefBlockRangeVar(WASP *ncdf, const VDC::DataVar &var, size_t max_ts);
+ bool _blockRangeVarDefined(NetCDFCpp *ncdf, string varname) const;
+ size_t _numBlocks(string varname) const;
 
  bool _var_in_master(const VDC::BaseVar &var) const;
 
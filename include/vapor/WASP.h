@@ -216,6 +216,62 @@ public:
     string name, string &wname, vector <size_t> &bs, vector <size_t> &cratios
  ) const;
 
+ //! Set the quantization of subsequently defined variables
+ //!
+ //! By default the wavelet coefficients of a compressed variable are
+ //! stored with the variable's external type. When quantization is
+ //! enabled the coefficients of compressed variables defined by DefVar()
+ //! after this call are instead quantized to \p nbits bits each with
+ //! Compressor::Quantize(), shrinking the storage needed for them by
+ //! a factor of about 8 * NetCDFCpp::SizeOf(xtype) / \p nbits at the cost
+ //! of a bounded quantization error. Only variables with a floating
+ //! point external type are quantized.
+ //!
+ //! The number of bits is recorded with each quantized variable in the
+ //! attribute named by AttNameQuantization(), and coefficients are
+ //! restored automatically when the variable is read.
+ //!
+ //! \param[in] nbits Number of bits per coefficient, in the range 2
+ //! to 32, or zero to disable quantization (the default)
+ //!
+ //! \sa InqVarQuantization(), Compressor::Quantize()
+ //
+ int SetQuantization(int nbits);
+
+ //! Return the quantization set by SetQuantization()
+ //
+ int GetQuantization() const {return(_quantization); };
+
+ //! Inquire the quantization of a variable
+ //!
+ //! \param[in] name The variable name.
+ //! \param[out] nbits The number of bits to which the variable's
+ //! wavelet coefficients are quantized, or zero if they are not quantized
+ //!
+ //! \sa SetQuantization()
+ //
+ int InqVarQuantization(string name, int &nbits) const;
+
+ //! Enable or disable the fast wavelet transform
+ //!
+ //! When enabled, the compressors created by subsequent calls to 
+ //! OpenVarWrite() and OpenVarRead() transform float variables in single
+ //! precision, and by lifting for wavelets whose filters factor into
+ //! lifting steps (see MatWaveBase::FastTransformOnOff()). The wavelet
+ //! transform of a block is about 1.5 to 2 times faster, and the values
+ //! differ from those of the default transform by rounding: about 1e-7
+ //! of their magnitude for float variables. The setting is 
+ //! not recorded in the file, which may be read with either setting.
+ //! By default the fast transform is disabled.
+ //!
+ //! \param[in] enable Boolean enabling the fast transform
+ //
+ void SetFastTransform(bool enable) {_fastTransform = enable; };
+
+ //! Return the setting made by SetFastTransform()
+ //
+ bool GetFastTransform() const {return(_fastTransform); };
+
  //! Return the dimensions of a multi-resolution grid at a specified level in
  //! the hierarchy
  //!
@@ -684,6 +740,10 @@ public:
  //! NetCDF attribute name specifying Wavelet name
  static string AttNameWavelet() {return("WASP.Wavelet");}
 
+ //! NetCDF attribute name specifying the number of bits to which 
+ //! wavelet coefficients are quantized. Absent if not quantized
+ static string AttNameQuantization() {return("WASP.Quantization");}
+
  //! NetCDF attribute name specifying compression block dimensions 
  static string AttNameBlockSize() {return("WASP.BlockSize");}
 
@@ -717,6 +777,8 @@ private:
  int _numfiles; // Number of NetCDF files 
  int _currentVersion; // Current WASP version number;
  int _fileVersion; // version number of opened file;
+ int _quantization; // quantization of variables defined by DefVar()
+ bool _fastTransform; // transform with MatWaveBase::FastTransformOnOff()
  Wasp::SmartBuf _blockbuf;    // Dynamic storage for blocks
  Wasp::SmartBuf _coeffbuf;    // Dynamic storage wavelet coefficients
  Wasp::SmartBuf _sigbuf;  // Dynamic storage encoded signficance maps
@@ -733,6 +795,7 @@ private:
  bool _open_waspvar;	// opened variable is a WASP variable?
  string _open_varname;  // name of opened variable
  nc_type _open_varxtype;  // external type of opened variable
+ int _open_qbits;  // coefficient quantization of opened variable, or 0
  vector <Compressor *> _open_compressors;  // Compressor for opened variable
 
 
@@ -749,6 +812,7 @@ private:
     vector <size_t> bs,
     vector <size_t> cratios,
 	int xtype,
+	int qbits,
     vector <string> &cdimnames,
     vector <size_t> &cdims,
     vector <string> &encoded_dim_names,
@@ -759,9 +823,14 @@ private:
 
  void _get_encoding_vectors(
     string wname, vector <size_t> bs, vector <size_t> cratios, int xtype,
-    vector <size_t> &ncoeffs, vector <size_t> &encoded_dims
+    int qbits, vector <size_t> &ncoeffs, vector <size_t> &encoded_dims
  ) const;
 
+ // Files prior to version 4 store significance maps with the packed
+ // encoding only
+ //
+ bool _packed_sigmaps() const {return(_fileVersion < 4); };
+
 
  bool _validate_compression_params(
 	string wname, vector <size_t> dims, 
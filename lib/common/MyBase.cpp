@@ -9,6 +9,7 @@
 #include <vector>
 #include <iostream>
 #include <sstream>
+#include <mutex>
 
 #include <vapor/MyBase.h>
 #ifdef WIN32
@@ -61,7 +62,16 @@ FILE	*MyBase::DiagMsgFilePtr = NULL;
 #endif
 void (*MyBase::DiagMsgCB) (const char *msg) = NULL;
 
-bool MyBase::Enabled = true;
+// Error reporting is enabled or disabled per thread, so that a thread
+// suppressing errors doesn't silence (or re-enable) another's
+//
+static thread_local bool Enabled = true;
+
+// Serializes updates to the shared message buffers, which may be
+// posted from worker threads. Recursive because message callbacks
+// may themselves post messages.
+//
+static std::recursive_mutex MsgMutex;
 
 MyBase::MyBase() {
 	SetClassName("MyBase");
@@ -132,6 +142,8 @@ void	MyBase::SetErrMsg(
 
 
 	if (! Enabled) return;
+
+	std::lock_guard <std::recursive_mutex> guard(MsgMutex);
 	ErrCode = 1;
 
 	va_start(args, format);
@@ -155,6 +167,8 @@ void	MyBase::SetErrMsg(
 
 
 	if (! Enabled) return;
+
+	std::lock_guard <std::recursive_mutex> guard(MsgMutex);
 	ErrCode = errcode;
 
 	va_start(args, format);
@@ -169,12 +183,24 @@ void	MyBase::SetErrMsg(
 	}
 }
 
+bool	MyBase::EnableErrMsg(bool enable) {
+	bool prev = Enabled; 
+	Enabled = enable; 
+	return (prev);
+}
+
+bool	MyBase::GetEnableErrMsg() {
+	return(Enabled);
+}
+
 void	MyBase::SetDiagMsg(
 	const char *format, 
 	...
 ) {
 	va_list args;	// initialize to make valgrind shutup
 
+	std::lock_guard <std::recursive_mutex> guard(MsgMutex);
+
 	va_start(args, format);
 	_SetErrMsg(&DiagMsg, &DiagMsgSize, format, args);
 	va_end(args);
@@ -203,7 +203,10 @@ int BarbRenderer::_paintGL(){
 		);
 		if(rc<0) {
 			for (int i = 0; i<varData.size(); i++){
-				if (varData[i]) _dataMgr->UnlockGrid(varData[i]);
+				if (varData[i]) {
+					_dataMgr->UnlockGrid(varData[i]);
+					delete varData[i];
+				}
 			}
 			goto RETURN;
 		}
@@ -221,7 +224,10 @@ int BarbRenderer::_paintGL(){
 			);
 		if(rc<0) {
 			for (int i = 0; i<varData.size(); i++){
-				if (varData[i]) _dataMgr->UnlockGrid(varData[i]);
+				if (varData[i]) {
+					_dataMgr->UnlockGrid(varData[i]);
+					delete varData[i];
+				}
 			}
 			goto RETURN;
 		}
@@ -239,7 +245,10 @@ int BarbRenderer::_paintGL(){
 	
 	//Release the locks on the data:
 	for (int i = 0; i<varData.size(); i++){
-		if (varData[i]) _dataMgr->UnlockGrid(varData[i]);
+		if (varData[i]) {
+			_dataMgr->UnlockGrid(varData[i]);
+			delete varData[i];
+		}
 	}
     
 RETURN:
@@ -451,18 +460,6 @@ int BarbRenderer::performRendering(
 	return 0;
 }
 
-float BarbRenderer::getHeightOffset(Grid* heightVar, 
-	float xCoord, float yCoord, bool& missing) {
-	assert(heightVar);	
-	float missingVal = heightVar->GetMissingValue();
-	float offset = heightVar->GetValue(xCoord, yCoord, 0.f);
-	if (offset == missingVal) {
-		missing = true;
-		offset = 0.f;
-	}
-	return offset;
-}
-
 void BarbRenderer::renderGrid(int rakeGrid[3], double rakeExts[6],
 	vector <Grid *> variableData, int timestep, 
 	float length,
@@ -492,68 +489,97 @@ void BarbRenderer::renderGrid(int rakeGrid[3], double rakeExts[6],
 		tf->makeLut(clut);
 	}
 
-	float xCoord, yCoord, zCoordGrid, zCoord;
+	// Positions of the barbs. The variables are sampled at all of the
+	// positions at once with Grid::GetValues(), which is much faster
+	// than sampling them one barb at a time
+	//
+	size_t nbarbs = (size_t) rakeGrid[0] * rakeGrid[1] * rakeGrid[2];
+	vector <double> xyz(3 * nbarbs);
+	size_t n = 0;
 	for (int k = 1; k<=rakeGrid[2]; k++){
-		zCoordGrid = zStride * k + rakeExts[2];
 		for (int j = 1; j<=rakeGrid[1]; j++){
-			yCoord = yStride * j + rakeExts[1];
 			for (int i = 1; i<=rakeGrid[0]; i++){
-				xCoord = xStride * i + rakeExts[0];
-				zCoord = zCoordGrid;
+				xyz[3*n] = (float) (xStride * i + rakeExts[0]);
+				xyz[3*n+1] = (float) (yStride * j + rakeExts[1]);
+				xyz[3*n+2] = 0.0;
+				n++;
+			}
+		}
+	}
 
-				bool missing = false;
-				if (heightVar) {
-					zCoord += getHeightOffset(heightVar, 
-						xCoord, yCoord, missing);
-				}
+	vector <bool> missing(nbarbs, false);
 
-				float direction[3] = {0.f, 0.f, 0.f};
-				for (int dim=0; dim<3; dim++) {
-					direction[dim]=0.f;
-					if (variableData[dim]) {
-						direction[dim] = variableData[dim]->GetValue(
-							xCoord, yCoord, zCoord
-						);
-
-						float missingVal = variableData[dim]->GetMissingValue();
-						if (direction[dim] == missingVal) {
-							missing = true;
-						}
-					}
-				}
+	vector <float> values(nbarbs);
+	if (heightVar) {
+		heightVar->GetValues(xyz.data(), nbarbs, values.data());
+	}
+	float missingVal = heightVar ? heightVar->GetMissingValue() : 0.f;
+	n = 0;
+	for (int k = 1; k<=rakeGrid[2]; k++){
+		float zCoord = zStride * k + rakeExts[2];
+		for (size_t ij = 0; ij < (size_t) rakeGrid[0] * rakeGrid[1]; ij++){
+			float offset = heightVar ? values[n] : 0.f;
+			if (heightVar && offset == missingVal) {
+				missing[n] = true;
+				offset = 0.f;
+			}
+			xyz[3*n+2] = zCoord + offset;
+			n++;
+		}
+	}
 
-				float point[3] = {xCoord, yCoord, zCoord};
-				end[0] = point[0] + scales[0]*direction[0]*length;
-				end[1] = point[1] + scales[1]*direction[1]*length;
-				end[2] = point[2] + scales[2]*direction[2]*length;
-				
-				if (doColorMapping) {
-					float val = variableData[4]->GetValue(point[0],
-						point[1],point[2]);
-					if (val == variableData[4]->GetMissingValue()) 
-						missing=true;
-					else{
-						missing= GetColorMapping(tf, val, clut);
-					}
-				}
-				if (!missing) {
-					string datasetName = GetMyDatasetName();
-					string myVisName = GetVisualizer();
-					VAPoR::ViewpointParams* vpp = _paramsMgr->GetViewpointParams(myVisName); 
-					
-
-					Transform *t = vpp->GetTransform(datasetName);
-					assert(t);
-					vector<double> scales = t->GetScales();
-					
-					glMatrixMode(GL_MODELVIEW);
-					glPushMatrix();
-					glScalef(1.f/scales[0], 1.f/scales[1], 1.f/scales[2]);
-					drawBarb(point, end, rad*10);
-					glPopMatrix();
-				}
+	vector <float> direction[3];
+	for (int dim=0; dim<3; dim++) {
+		direction[dim].resize(nbarbs, 0.f);
+		if (! variableData[dim]) continue;
+
+		variableData[dim]->GetValues(
+			xyz.data(), nbarbs, direction[dim].data()
+		);
+		float mv = variableData[dim]->GetMissingValue();
+		for (n = 0; n<nbarbs; n++) {
+			if (direction[dim][n] == mv) missing[n] = true;
+		}
+	}
+
+	vector <float> colorValues;
+	if (doColorMapping) {
+		colorValues.resize(nbarbs);
+		variableData[4]->GetValues(xyz.data(), nbarbs, colorValues.data());
+	}
+
+	for (n = 0; n<nbarbs; n++) {
+		float point[3] = {
+			(float) xyz[3*n], (float) xyz[3*n+1], (float) xyz[3*n+2]
+		};
+		end[0] = point[0] + scales[0]*direction[0][n]*length;
+		end[1] = point[1] + scales[1]*direction[1][n]*length;
+		end[2] = point[2] + scales[2]*direction[2][n]*length;
+
+		if (doColorMapping) {
+			float val = colorValues[n];
+			if (val == variableData[4]->GetMissingValue()) 
+				missing[n]=true;
+			else{
+				missing[n]= GetColorMapping(tf, val, clut);
 			}
 		}
+		if (!missing[n]) {
+			string datasetName = GetMyDatasetName();
+			string myVisName = GetVisualizer();
+			VAPoR::ViewpointParams* vpp = _paramsMgr->GetViewpointParams(myVisName); 
+			
+
+			Transform *t = vpp->GetTransform(datasetName);
+			assert(t);
+			vector<double> scales = t->GetScales();
+			
+			glMatrixMode(GL_MODELVIEW);
+			glPushMatrix();
+			glScalef(1.f/scales[0], 1.f/scales[1], 1.f/scales[2]);
+			drawBarb(point, end, rad*10);
+			glPopMatrix();
+		}
 	}
 	return;
 }
@@ -157,25 +157,46 @@ int ContourRenderer::_buildCache()
 		_cacheParams.boxMin, _cacheParams.boxMax
 	);
 
+    // Per-cell buffers are reused across cells so that the loop doesn't
+    // allocate memory once they've grown to the largest cell
+    //
+    Grid::Size_tArr3 cell;
+    vector<Grid::Size_tArr3> nodes;
+    vector<Grid::DblArr3> coords;
+    vector<double> xyz;
+    vector<float> values;
+    vector<float> heights;
+
     Grid::ConstCellIterator end = grid->ConstCellEnd();
     for (; it != end; ++it)
     {
-        vector<size_t> cell = *it;
-        vector<vector<size_t>> nodes;
+        Grid::CopyToArr3(*it, cell);
         grid->GetCellNodes(cell, nodes);
         
-        vector<double> *coords = new vector<double>[nodes.size()];
-        float *values = new float[nodes.size()];
-		bool hasMissing = false;
+        coords.resize(nodes.size());
+        xyz.resize(3 * nodes.size());
+        values.resize(nodes.size());
         for (int i = 0; i < nodes.size(); i++)
         {
             grid->GetUserCoordinates(nodes[i], coords[i]);
-            values[i] = grid->GetValue(coords[i]);
+            for (int j = 0; j < 3; j++)
+                xyz[3*i + j] = coords[i][j];
+        }
+        grid->GetValues(xyz.data(), nodes.size(), values.data());
+
+		bool hasMissing = false;
+        for (int i = 0; i < nodes.size(); i++)
+        {
 			if (values[i] == mv) {
 				hasMissing = true;
 			}
         }
 		if (hasMissing) continue;
+
+        // Heights of the cell's nodes, looked up only if a contour
+        // crosses the cell
+        //
+        heights.clear();
         
         glBegin(GL_LINES);
         
@@ -200,17 +221,19 @@ int ContourRenderer::_buildCache()
                 
                 if (heightGrid)
                 {
-                    float aHeight = heightGrid->GetValue(coords[a]);
-                    float bHeight = heightGrid->GetValue(coords[b]);
-                    v[2] = aHeight + t * (bHeight - aHeight);
+                    if (heights.empty()) {
+                        heights.resize(nodes.size());
+                        heightGrid->GetValues(
+                            xyz.data(), nodes.size(), heights.data()
+                        );
+                    }
+                    v[2] = heights[a] + t * (heights[b] - heights[a]);
                 }
                 
                 glVertex3fv(v);
             }
         }
         glEnd();
-        delete [] coords;
-        delete [] values;
     }
     
     glEndList();
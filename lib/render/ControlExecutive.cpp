@@ -27,6 +27,7 @@ ControlExec::ControlExec(
 	_dataStatus = new DataStatus(cacheSizeMB, nThreads);
 	_shaderMgrs.clear();
 	_visualizers.clear();
+	_prefetch = false;
 
 }
 
@@ -520,6 +521,8 @@ int ControlExec::OpenData(
 		dataSetName, _dataStatus->GetDataMgr(dataSetName)
 	);
 
+	_dataStatus->GetDataMgr(dataSetName)->SetPrefetchPredictor(_prefetch);
+
 	// Re-initialize the ControlExec to match the new state
 	//
 	rc = openDataHelper(true);
@@ -559,6 +562,16 @@ void ControlExec::CloseData(string dataSetName) {
 }
 
 
+void ControlExec::SetPrefetch(bool enable) {
+	_prefetch = enable;
+
+	vector <string> dataSetNames = _dataStatus->GetDataMgrNames();
+	for (int i=0; i<dataSetNames.size(); i++) {
+		DataMgr *dataMgr = _dataStatus->GetDataMgr(dataSetNames[i]);
+		if (dataMgr) dataMgr->SetPrefetchPredictor(enable);
+	}
+}
+
 int ControlExec::EnableImageCapture(string filename, string winName)
 {
 	Visualizer* v = getVisualizer(winName);
@@ -140,6 +140,7 @@ int HelloRenderer::_paintGL(){
 	}
 
 	_dataMgr->UnlockGrid(helloGrid);
+	delete helloGrid;
 	
 	//Obtain the line width
 	float width = (float)rParams->GetLineThickness();
@@ -866,6 +866,8 @@ const GLvoid *TwoDDataRenderer::_getTexture(
 
 	if (g->GetTopologyDim() != 2) {
 		SetErrMsg("Invalid variable: %s ", varname.c_str());
+		dataMgr->UnlockGrid(g);
+		delete g;
 		return(NULL);
 	}
 	
@@ -887,28 +889,43 @@ const GLvoid *TwoDDataRenderer::_getTexture(
 
     size_t texSize = _texWidth * _texHeight;
     GLfloat *texture = (float *) _sb_texture.Alloc(texSize * _texelSize);
-	GLfloat *texptr = texture;
-	Grid::Iterator itr;
-	Grid::Iterator enditr = g->end();
-//	for (itr = g->begin(minBoxReq, maxBoxReq); itr != enditr; ++itr) {
-	for (itr = g->begin(); itr != enditr; ++itr) {
-		float v = *itr;
-
-		if (v == g->GetMissingValue()) {
-			*texptr++ = 0.0;	// Data value
-			*texptr++ = 1.0;	// Missing value flag
+
+	// Texels are laid out in grid index order, with the first dimension
+	// varying fastest, for both structured and unstructured grids
+	//
+	size_t nx = dims[0];
+	size_t ny = dims.size() > 1 ? dims[1] : 1;
+	float mv = g->GetMissingValue();
+	g->ForEachBlock([&](const float *blk, const Grid::BlockExtents &ext) {
+		for (size_t k=ext.min[2]; k<=ext.max[2]; k++) {
+		for (size_t j=ext.min[1]; j<=ext.max[1]; j++) {
+			const float *row = blk + (k * ext.bs[1] + j) * ext.bs[0];
+			GLfloat *texptr = texture + 2 * (
+				((ext.origin[2] + k) * ny + ext.origin[1] + j) * nx + 
+				ext.origin[0]
+			);
+			for (size_t i=ext.min[0]; i<=ext.max[0]; i++) {
+				float v = row[i];
+
+				if (v == mv) {
+					texptr[2*i] = 0.0;	// Data value
+					texptr[2*i+1] = 1.0;	// Missing value flag
+				}
+				else {
+					texptr[2*i] = v;
+					texptr[2*i+1] = 0;
+				}
+			}
 		}
-		else {
-			*texptr++ = v;
-			*texptr++ = 0;
 		}
-	}
+	});
 
 	_texStateSet(dataMgr);
 
 	//Unlock the Grid
 	//
 	dataMgr->UnlockGrid(g);
+	delete g;
 
 	return(texture);
 }
@@ -4,8 +4,12 @@
 #include <cerrno>
 #include <iostream>
 #include <new>
+#include <mutex>
+#include <cassert>
 #ifndef WIN32
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #endif
 
 #include <vapor/BlkMemMgr.h>
@@ -26,11 +30,186 @@ size_t BlkMemMgr::_blk_size = 0;
 
 vector <size_t>	BlkMemMgr::_mem_region_sizes;
 vector <unsigned char *> BlkMemMgr::_blks;
-vector < vector <BlkMemMgr::_mem_allocation_t > > BlkMemMgr::_mem_regions;
+vector <size_t> BlkMemMgr::_blks_size;
+vector <BlkMemMgr::Backing> BlkMemMgr::_blks_backing;
+
+BlkMemMgr::Backing BlkMemMgr::_backing_req = BlkMemMgr::HEAP;
+string BlkMemMgr::_backing_dir_req;
+BlkMemMgr::Backing BlkMemMgr::_backing = BlkMemMgr::HEAP;
+string BlkMemMgr::_backing_dir;
+map <unsigned char *, BlkMemMgr::_free_run_t> BlkMemMgr::_free_by_addr;
+BlkMemMgr::_free_by_size_t BlkMemMgr::_free_by_size;
+unordered_map <void *, BlkMemMgr::_used_run_t> BlkMemMgr::_used;
 #ifdef	VAPOR3_0_0_ALPHA
 #endif
 
 int	BlkMemMgr::_ref_count = 0;
+FILE	*BlkMemMgr::_trace_fp = NULL;
+size_t	BlkMemMgr::_used_blks = 0;
+size_t	BlkMemMgr::_peak_used_blks = 0;
+
+// The memory pool is shared by all instances, which may be used
+// from different threads
+//
+static std::recursive_mutex PoolMutex;
+
+void	BlkMemMgr::_insert_free(unsigned char *blk, size_t n, int region) {
+	_free_run_t run;
+	run._nfree = n;
+	run._region = region;
+	run._sitr = _free_by_size.insert(make_pair(n, blk)).first;
+	_free_by_addr[blk] = run;
+}
+
+void	BlkMemMgr::_erase_free(map <unsigned char *, _free_run_t>::iterator itr) {
+	_free_by_size.erase(itr->second._sitr);
+	_free_by_addr.erase(itr);
+}
+
+#ifndef WIN32
+// Reserve disk space for the first size bytes of a file, extending it
+// if needed. A sparse file would raise SIGBUS when a page is first 
+// touched after the disk fills up. Returns 0, or an errno value
+//
+static int reserve_file(int fd, size_t size) {
+#ifdef __APPLE__
+	fstore_t store;
+	store.fst_flags = F_ALLOCATEALL;
+	store.fst_posmode = F_PEOFPOSMODE;
+	store.fst_offset = 0;
+	store.fst_length = size;
+	store.fst_bytesalloc = 0;
+	if (fcntl(fd, F_PREALLOCATE, &store) < 0) return(errno);
+	if (ftruncate(fd, size) < 0) return(errno);
+	return(0);
+#else
+	return(posix_fallocate(fd, 0, size));
+#endif
+}
+#endif
+
+// Allocate size bytes for the memory pool from the current backing store
+//
+unsigned char *BlkMemMgr::_mem_alloc(size_t size, Backing &backing) {
+
+	backing = _backing;
+
+#ifndef WIN32
+	if (backing == HUGE_PAGES) {
+
+		// Explicit huge pages must be reserved by the administrator. If
+		// none are available fall back to transparent huge pages.
+		//
+		const size_t huge_page_size = 2 * 1024 * 1024;
+		size_t hsize = ((size + huge_page_size - 1) / huge_page_size) * 
+			huge_page_size;
+
+		void *ptr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+		ptr = mmap(
+			NULL, hsize, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0
+		);
+#endif
+		if (ptr == MAP_FAILED) {
+			ptr = mmap(
+				NULL, hsize, PROT_READ | PROT_WRITE, 
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+			);
+			if (ptr == MAP_FAILED) return(NULL);
+#ifdef MADV_HUGEPAGE
+			(void) madvise(ptr, hsize, MADV_HUGEPAGE);
+#endif
+			SetDiagMsg("BlkMemMgr() : using transparent huge pages");
+		}
+		return((unsigned char *) ptr);
+	}
+
+	if (backing == FILE_MAPPED) {
+
+		// The file is unlinked as soon as it is mapped so that it is 
+		// removed even if we exit abnormally
+		//
+		string dir = _backing_dir;
+		if (dir.empty() && getenv("TMPDIR")) dir = getenv("TMPDIR");
+		if (dir.empty()) dir = "/tmp";
+
+		string path = dir + "/vapor_blkmem_XXXXXX";
+		vector <char> pathbuf(path.begin(), path.end());
+		pathbuf.push_back('\0');
+
+		int fd = mkstemp(pathbuf.data());
+		if (fd < 0) {
+			SetErrMsg(
+				"Failed to create memory pool file %s : %M", pathbuf.data()
+			);
+			return(NULL);
+		}
+		unlink(pathbuf.data());
+
+		// If the space can't be reserved fall back to the heap
+		//
+		int rc = reserve_file(fd, size);
+		if (rc != 0) {
+			SetDiagMsg(
+				"BlkMemMgr() : failed to reserve %lld bytes for memory pool "
+				"file %s : %s, using heap", (long long) size, pathbuf.data(), 
+				strerror(rc)
+			);
+			close(fd);
+		}
+		else {
+			void *ptr = mmap(
+				NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0
+			);
+			close(fd);
+			if (ptr == MAP_FAILED) {
+				SetErrMsg(
+					"Failed to map memory pool file %s : %M", pathbuf.data()
+				);
+				return(NULL);
+			}
+			return((unsigned char *) ptr);
+		}
+	}
+#endif
+
+	backing = HEAP;
+	return(new(nothrow) unsigned char[size]);
+}
+
+void	BlkMemMgr::_mem_free(unsigned char *blks, size_t size, Backing backing) {
+	if (! blks) return;
+
+#ifndef WIN32
+	if (backing == HUGE_PAGES) {
+		const size_t huge_page_size = 2 * 1024 * 1024;
+		size = ((size + huge_page_size - 1) / huge_page_size) * huge_page_size;
+		munmap(blks, size);
+		return;
+	}
+	if (backing == FILE_MAPPED) {
+		munmap(blks, size);
+		return;
+	}
+#endif
+	delete [] blks;
+}
+
+void	BlkMemMgr::_clear() {
+	for (int i=0; i<_blks.size(); i++) {
+		_mem_free(_blks[i], _blks_size[i], _blks_backing[i]);
+	}
+	_blks.clear();
+	_blks_size.clear();
+	_blks_backing.clear();
+	_mem_region_sizes.clear();
+	_free_by_addr.clear();
+	_free_by_size.clear();
+	_used.clear();
+	_used_blks = 0;
+	_peak_used_blks = 0;
+}
 
 int	BlkMemMgr::_Reinit(size_t n)
 {
@@ -42,6 +221,8 @@ int	BlkMemMgr::_Reinit(size_t n)
 	_page_aligned = _page_aligned_req;
 	_mem_size_max = _mem_size_max_req;
 	_blk_size = _blk_size_req;
+	_backing = _backing_req;
+	_backing_dir = _backing_dir_req;
 
 	//
 	// Calculate starting region size
@@ -53,7 +234,7 @@ int	BlkMemMgr::_Reinit(size_t n)
 	//
 	size_t total_size = 0;
 	int r;
-	for (r=0; r<_mem_regions.size(); r++) total_size += _mem_region_sizes[r];
+	for (r=0; r<_mem_region_sizes.size(); r++) total_size += _mem_region_sizes[r];
 
 	//
 	// New region size is double preceding one
@@ -78,11 +259,12 @@ int	BlkMemMgr::_Reinit(size_t n)
 	}
 
 	unsigned char *blks;
+	Backing backing;
 	do {
 		size = (size_t) _blk_size * (size_t) mem_size;
 		size += (size_t) page_size;
 
-		blks = new(nothrow) unsigned char[size];
+		blks = _mem_alloc(size, backing);
 		if (! blks) {
 			SetDiagMsg(
 				"BlkMemMgr::_Reinit() : failed to allocate %d blocks, retrying",
@@ -92,7 +274,7 @@ int	BlkMemMgr::_Reinit(size_t n)
 		}
 	} while (blks == NULL && mem_size > 0 && _blk_size > 0);
 
-	if (! blks && mem_size > 0 && _blk_size > 0) {
+	if (! blks) {
 		SetDiagMsg("Memory allocation of %lu bytes failed", size);
 		return(false);
 	}
@@ -106,15 +288,10 @@ int	BlkMemMgr::_Reinit(size_t n)
 		blkptr += page_size - (((size_t) blks) % page_size);
 	}
 
-	_mem_allocation_t m;
-	vector <_mem_allocation_t> mem_region;
-	m._nfree = mem_size;
-	m._nused = 0;
-	m._blk = blkptr;
-	mem_region.push_back(m);
-
-	_mem_regions.push_back(mem_region);
+	_insert_free(blkptr, mem_size, _blks.size());
 	_blks.push_back(blks);
+	_blks_size.push_back(size);
+	_blks_backing.push_back(backing);
 	_mem_region_sizes.push_back(mem_size);
 
 	return(true);
@@ -130,6 +307,8 @@ int	BlkMemMgr::RequestMemSize(
 		"BlkMemMgr::RequestMemSize(%u,%u,%d)", blk_size, num_blks, page_aligned
 	);
 
+	std::lock_guard <std::recursive_mutex> guard(PoolMutex);
+
 	//
 	// If there are no instances of this object, re-initialized
 	// the static memory pool if needed
@@ -146,11 +325,31 @@ int	BlkMemMgr::RequestMemSize(
 	return(0);
 }
 
+int	BlkMemMgr::RequestBacking(Backing backing, string dir) {
+
+	SetDiagMsg("BlkMemMgr::RequestBacking(%d,%s)", backing, dir.c_str());
+
+	std::lock_guard <std::recursive_mutex> guard(PoolMutex);
+
+#ifdef WIN32
+	if (backing != HEAP) {
+		SetErrMsg("Only heap memory is supported on this platform");
+		return(-1);
+	}
+#endif
+
+	_backing_req = backing;
+	_backing_dir_req = dir;
+
+	return(0);
+}
+
 BlkMemMgr::BlkMemMgr(
 ) {
 
 	SetDiagMsg("BlkMemMgr::BlkMemMgr()");
 
+	std::lock_guard <std::recursive_mutex> guard(PoolMutex);
 
 	//
 	// If there are no other instances of this object, re-initialized
@@ -161,16 +360,13 @@ BlkMemMgr::BlkMemMgr(
 		return;
 	}
 
-	for (int i=0; i<_blks.size(); i++) {
-		if (_blks[i]) delete [] _blks[i];
-	}
-	_mem_regions.clear();
-	_mem_region_sizes.clear();
-	_blks.clear();
+	_clear();
 
 	_page_aligned = _page_aligned_req;
 	_mem_size_max = _mem_size_max_req;
 	_blk_size = _blk_size_req;
+	_backing = _backing_req;
+	_backing_dir = _backing_dir_req;
 
 	_ref_count = 1;
 
@@ -179,17 +375,13 @@ BlkMemMgr::BlkMemMgr(
 BlkMemMgr::~BlkMemMgr() {
 	SetDiagMsg("BlkMemMgr::~BlkMemMgr()");
 
+	std::lock_guard <std::recursive_mutex> guard(PoolMutex);
+
 	if (_ref_count > 0) _ref_count--;
 
 	if (_ref_count != 0) return;
 
-	for (int i=0; i<_blks.size(); i++) {
-		if (_blks[i]) delete [] _blks[i];
-	}
-	_blks.clear();
-	_mem_regions.clear();
-	_mem_region_sizes.clear();
-
+	_clear();
 }
 
 void	*BlkMemMgr::Alloc(
@@ -198,50 +390,57 @@ void	*BlkMemMgr::Alloc(
 ) {
 	SetDiagMsg("BlkMemMgr::Alloc(%d)", n);
 
+	std::lock_guard <std::recursive_mutex> guard(PoolMutex);
+
+	if (n < 1) n = 1;
+
 	//
-	// Check each region, find the first run of blocks large enough
-	// to satisfy the request
+	// Find the smallest run of free blocks large enough to satisfy
+	// the request. Of runs of that size, take the lowest addressed
 	//
-	void *blk = NULL;
-	for (int r=0; r<_mem_regions.size() && ! blk; r++) {
-		vector <_mem_allocation_t> &mem_region = _mem_regions[r];
-		for (int i=0; i<mem_region.size() && ! blk; i++) {
-
-			if (n<=mem_region[i]._nfree) {	// Found a run of blocks
-				blk = mem_region[i]._blk;
-				mem_region[i]._nused = n;
-
-				//
-				// If run is strictly larger than request split it
-				//
-				if (n<mem_region[i]._nfree) {
-					_mem_allocation_t m;
-					m._nfree = mem_region[i]._nfree - n;
-					m._nused = 0;
-					m._blk = (unsigned char *) mem_region[i]._blk + (_blk_size * n);
-					mem_region.insert(mem_region.begin()+i+1, m);
-				}
-				mem_region[i]._nfree = 0;
-			}
-		}
-	}
-				
-	
-	if (! blk) {
+	_free_by_size_t::iterator sitr = _free_by_size.lower_bound(
+		make_pair(n, (unsigned char *) NULL)
+	);
+	if (sitr == _free_by_size.end()) {
+
 		// Couldn't find space in existing memory pool.
 		// Try to allocate more memory.
 		//
-		if (! BlkMemMgr::_Reinit(n)) 
+		if (! BlkMemMgr::_Reinit(n)) {
+			if (_trace_fp) fprintf(_trace_fp, "A %zu %p\n", n, (void *) NULL);
 			return(NULL);
+		}
 
 		return(Alloc(n,fill));
 	}
-				
-	if (fill) {
-		unsigned char *ptr = (unsigned char *) blk;
-		for (size_t i=0; i<n*_blk_size; i++) ptr[i] = 0;
+
+	unsigned char *blk = sitr->second;
+	map <unsigned char *, _free_run_t>::iterator aitr = _free_by_addr.find(blk);
+	assert(aitr != _free_by_addr.end());
+
+	size_t nfree = aitr->second._nfree;
+	int region = aitr->second._region;
+	_erase_free(aitr);
+
+	//
+	// If run is strictly larger than request split it
+	//
+	if (n < nfree) {
+		_insert_free(blk + (_blk_size * n), nfree - n, region);
 	}
 
+	_used_run_t used;
+	used._nused = n;
+	used._region = region;
+	_used[blk] = used;
+
+	_used_blks += n;
+	if (_used_blks > _peak_used_blks) _peak_used_blks = _used_blks;
+
+	if (fill) memset(blk, 0, n*_blk_size);
+
+	if (_trace_fp) fprintf(_trace_fp, "A %zu %p\n", n, (void *) blk);
+
 	return(blk);
 }
 
@@ -250,38 +449,127 @@ void	BlkMemMgr::FreeMem(
 ) {
 	SetDiagMsg("BlkMemMgr::FreeMem()");
 
+	std::lock_guard <std::recursive_mutex> guard(PoolMutex);
+
+	unordered_map <void *, _used_run_t>::iterator uitr = _used.find(ptr);
+	if (uitr == _used.end()) {
+		cerr << "Failed to free block " << ptr << endl;
+		return;
+	}
+
+	if (_trace_fp) fprintf(_trace_fp, "F %p\n", ptr);
 
-	bool found = false;
-	for (int r=0; r<_mem_regions.size() && ! found; r++) {
-		vector <_mem_allocation_t> &mem_region = _mem_regions[r];
-		for (int i=0; i<mem_region.size() && ! found; i++) {
-			if (ptr == mem_region[i]._blk) {
-				found = true;
-				mem_region[i]._nfree = mem_region[i]._nused;
-				mem_region[i]._nused = 0;
+	unsigned char *blk = (unsigned char *) ptr;
+	size_t n = uitr->second._nused;
+	int region = uitr->second._region;
+	_used.erase(uitr);
 
-			}
+	_used_blks -= n;
+
+	//
+	// Coalesce with the adjacent free runs, if any, from the same
+	// memory region
+	//
+	map <unsigned char *, _free_run_t>::iterator next;
+	next = _free_by_addr.lower_bound(blk);
+	if (next != _free_by_addr.end() && next->second._region == region &&
+		next->first == blk + (_blk_size * n)) {
+
+		n += next->second._nfree;
+		map <unsigned char *, _free_run_t>::iterator tmp = next++;
+		_erase_free(tmp);
+	}
+
+	if (next != _free_by_addr.begin()) {
+		map <unsigned char *, _free_run_t>::iterator prev = next;
+		--prev;
+		if (prev->second._region == region &&
+			prev->first + (_blk_size * prev->second._nfree) == blk) {
+
+			blk = prev->first;
+			n += prev->second._nfree;
+			_erase_free(prev);
 		}
 	}
-	if (! found) cerr << "Failed to free block " << ptr << endl;
 
+	_insert_free(blk, n, region);
+}
+
+BlkMemMgr::Stats	BlkMemMgr::GetStats() {
+
+	std::lock_guard <std::recursive_mutex> guard(PoolMutex);
+
+	Stats stats;
+	for (int r=0; r<_mem_region_sizes.size(); r++) {
+		stats.total_blks += _mem_region_sizes[r];
+	}
+
+	_free_by_size_t::const_iterator itr;
+	for (itr = _free_by_size.begin(); itr != _free_by_size.end(); ++itr) {
+		stats.free_blks += itr->first;
+	}
+	if (! _free_by_size.empty()) {
+		stats.largest_free_run = _free_by_size.rbegin()->first;
+	}
+	stats.num_free_runs = _free_by_size.size();
+	stats.num_allocs = _used.size();
+	stats.peak_used_blks = _peak_used_blks;
+
+	return(stats);
+}
+
+void	BlkMemMgr::ResetPeakUsage() {
+
+	std::lock_guard <std::recursive_mutex> guard(PoolMutex);
+
+	_peak_used_blks = _used_blks;
+}
+
+void	BlkMemMgr::PrintFragmentationReport(FILE *fp) {
+
+	std::lock_guard <std::recursive_mutex> guard(PoolMutex);
+
+	Stats stats = GetStats();
+
+	fprintf(fp, "Block size : %zu bytes\n", _blk_size);
+	fprintf(fp, "Pool size : %zu blocks\n", stats.total_blks);
+	fprintf(fp, "Used : %zu blocks in %zu allocations, peak %zu\n", 
+		stats.total_blks - stats.free_blks, stats.num_allocs, 
+		stats.peak_used_blks
+	);
+	fprintf(fp, "Free : %zu blocks in %zu runs, largest %zu\n", 
+		stats.free_blks, stats.num_free_runs, stats.largest_free_run
+	);
+	fprintf(fp, "Fragmentation : %f\n", stats.Fragmentation());
+
+	// Histogram of free run sizes, in power of two bins
 	//
-	// Collapse any two adjacent runs of they're both free
-	//
-	bool collapse;
-	do {
-		collapse = false;
-		for (int r=0; r<_mem_regions.size(); r++) {
-		vector <_mem_allocation_t> &mem_region = _mem_regions[r];
-			for (int i=0; i<mem_region.size()-1; i++) {
-				if (mem_region[i]._nfree && mem_region[i+1]._nfree) {
-					mem_region[i]._nfree += mem_region[i+1]._nfree;
-					mem_region.erase(mem_region.begin() + i+1);
-					collapse = true;
-					break;
-				}
-			}
+	vector <size_t> counts;
+	vector <size_t> blks;
+	_free_by_size_t::const_iterator itr;
+	for (itr = _free_by_size.begin(); itr != _free_by_size.end(); ++itr) {
+		size_t bin = 0;
+		while (((size_t) 1 << (bin+1)) <= itr->first) bin++;
+		if (bin >= counts.size()) {
+			counts.resize(bin+1, 0);
+			blks.resize(bin+1, 0);
 		}
-	} while (collapse);
+		counts[bin]++;
+		blks[bin] += itr->first;
+	}
+	fprintf(fp, "Free runs by size (blocks) :\n");
+	for (size_t bin=0; bin<counts.size(); bin++) {
+		if (! counts[bin]) continue;
+
+		fprintf(fp, "  [%zu, %zu) : %zu runs, %zu blocks\n",
+			(size_t) 1 << bin, (size_t) 1 << (bin+1), counts[bin], blks[bin]
+		);
+	}
+}
+
+void	BlkMemMgr::SetTraceFile(FILE *fp) {
+
+	std::lock_guard <std::recursive_mutex> guard(PoolMutex);
 
+	_trace_fp = fp;
 }
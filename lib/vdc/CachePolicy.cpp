@@ -0,0 +1,153 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cmath>
+
+#include <vapor/CachePolicy.h>
+
+using namespace std;
+using namespace VAPoR;
+
+namespace {
+
+// Costs are measured with a monotonic clock and may be reported
+// as zero for items that are very cheap to produce.
+//
+const double MinCost = 1e-6;
+
+};
+
+CachePolicy *CachePolicy::Create(string name) {
+	if (name == "lru") return(new CachePolicyLRU());
+	if (name == "gds") return(new CachePolicyGD(false, false));
+	if (name == "gd") return(new CachePolicyGD(true, false));
+	if (name == "gdsf-nocost") return(new CachePolicyGD(false, true));
+	if (name == "gdsf") return(new CachePolicyGD(true, true));
+	return(NULL);
+}
+
+vector <string> CachePolicy::GetPolicyNames() {
+	vector <string> names;
+	names.push_back("lru");
+	names.push_back("gds");
+	names.push_back("gd");
+	names.push_back("gdsf-nocost");
+	names.push_back("gdsf");
+	return(names);
+}
+
+void CachePolicyLRU::Insert(const void *id, size_t size, double cost) {
+	Erase(id);
+	_lruList.push_back(id);
+	_index[id] = --_lruList.end();
+}
+
+void CachePolicyLRU::Touch(const void *id) {
+	auto itr = _index.find(id);
+	if (itr == _index.end()) return;
+
+	_lruList.splice(_lruList.end(), _lruList, itr->second);
+}
+
+void CachePolicyLRU::Erase(const void *id) {
+	auto itr = _index.find(id);
+	if (itr == _index.end()) return;
+
+	_lruList.erase(itr->second);
+	_index.erase(itr);
+}
+
+void CachePolicyLRU::Clear() {
+	_lruList.clear();
+	_index.clear();
+}
+
+const void *CachePolicyLRU::Victim(
+	const std::function <bool (const void *)> &evictable
+) {
+	list <const void *>::iterator itr;
+	for (itr = _lruList.begin(); itr != _lruList.end(); ++itr) {
+		if (evictable(*itr)) return(*itr);
+	}
+	return(NULL);
+}
+
+CachePolicyGD::CachePolicyGD(bool use_cost, bool use_freq) {
+	_useCost = use_cost;
+	_useFreq = use_freq;
+	_L = 0.0;
+}
+
+string CachePolicyGD::GetName() const {
+	if (_useCost && _useFreq) return("gdsf");
+	if (_useCost) return("gd");
+	if (_useFreq) return("gdsf-nocost");
+	return("gds");
+}
+
+double CachePolicyGD::_priority(const Entry &e) const {
+	double c = _useCost ? max(e.cost, MinCost) : 1.0;
+	double f = _useFreq ? (double) e.freq : 1.0;
+	double s = e.size ? (double) e.size : 1.0;
+
+	return(_L + f * c / s);
+}
+
+void CachePolicyGD::_requeue(const void *id, Entry &e) {
+	_queue.erase(e.itr);
+	e.itr = _queue.insert(make_pair(_priority(e), id));
+}
+
+void CachePolicyGD::Insert(const void *id, size_t size, double cost) {
+	Erase(id);
+
+	Entry e;
+	e.size = size;
+	e.cost = cost;
+	e.freq = 1;
+	e.itr = _queue.insert(make_pair(_priority(e), id));
+	_entries[id] = e;
+}
+
+void CachePolicyGD::SetCost(const void *id, double cost) {
+	auto itr = _entries.find(id);
+	if (itr == _entries.end()) return;
+
+	itr->second.cost = cost;
+	_requeue(id, itr->second);
+}
+
+void CachePolicyGD::Touch(const void *id) {
+	auto itr = _entries.find(id);
+	if (itr == _entries.end()) return;
+
+	itr->second.freq++;
+	_requeue(id, itr->second);
+}
+
+void CachePolicyGD::Erase(const void *id) {
+	auto itr = _entries.find(id);
+	if (itr == _entries.end()) return;
+
+	_queue.erase(itr->second.itr);
+	_entries.erase(itr);
+}
+
+void CachePolicyGD::Clear() {
+	_queue.clear();
+	_entries.clear();
+	_L = 0.0;
+}
+
+const void *CachePolicyGD::Victim(
+	const std::function <bool (const void *)> &evictable
+) {
+	queue_t::iterator itr;
+	for (itr = _queue.begin(); itr != _queue.end(); ++itr) {
+		if (evictable(itr->second)) {
+			_L = itr->first;
+			return(itr->second);
+		}
+	}
+	return(NULL);
+}
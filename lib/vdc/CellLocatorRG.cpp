@@ -0,0 +1,198 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+#include <vapor/CellLocatorRG.h>
+#include <vapor/vizutil.h>
+
+using namespace std;
+using namespace VAPoR;
+
+CellLocatorRG::CellLocatorRG(const Grid &xg, const Grid &yg) {
+	assert(xg.GetDimensions() == yg.GetDimensions());
+	assert(xg.GetDimensions().size() == 2);
+
+	_dims = xg.GetDimensions();
+	for (int i=0; i<2; i++) {
+		_min[i] = _max[i] = 0.0;
+		_scale[i] = 0.0;
+		_nbins[i] = 1;
+	}
+
+	size_t nverts = _dims[0] * _dims[1];
+	_xy.resize(2*nverts);
+
+	// Copy the vertex coordinates so that cell tests don't have to
+	// go through the blocked Grid accessors
+	//
+	Grid::ConstIterator xitr = xg.cbegin();
+	Grid::ConstIterator yitr = yg.cbegin();
+	bool first = true;
+	for (size_t i=0; i<nverts; ++i, ++xitr, ++yitr) {
+		double x = *xitr;
+		double y = *yitr;
+		_xy[2*i] = x;
+		_xy[2*i+1] = y;
+
+		if (! (std::isfinite(x) && std::isfinite(y))) continue;
+
+		if (first) {
+			_min[0] = _max[0] = x;
+			_min[1] = _max[1] = y;
+			first = false;
+		}
+		_min[0] = min(_min[0], x);
+		_max[0] = max(_max[0], x);
+		_min[1] = min(_min[1], y);
+		_max[1] = max(_max[1], y);
+	}
+
+	size_t ncells = 0;
+	if (_dims[0] > 1 && _dims[1] > 1) ncells = (_dims[0]-1) * (_dims[1]-1);
+
+	// Size the bin grid so that there is about one bin per cell, with
+	// bins that are roughly square in user coordinates
+	//
+	double w = _max[0] - _min[0];
+	double h = _max[1] - _min[1];
+	if (ncells) {
+		double aspect = (w > 0.0 && h > 0.0) ? w / h : 1.0;
+		if (w > 0.0) {
+			_nbins[0] = max((size_t) 1, (size_t) sqrt(ncells * aspect));
+		}
+		if (h > 0.0) {
+			_nbins[1] = max((size_t) 1, ncells / _nbins[0]);
+		}
+	}
+	if (w > 0.0) _scale[0] = _nbins[0] / w;
+	if (h > 0.0) _scale[1] = _nbins[1] / h;
+
+	// Register each cell with every bin its bounding rectangle overlaps.
+	// The first pass counts the cells in each bin, the second stores
+	// them.
+	//
+	_binOffsets.assign(_nbins[0] * _nbins[1] + 1, 0);
+	double cmin[2], cmax[2];
+	size_t b0[2], b1[2];
+	for (size_t j=0; ncells && j<_dims[1]-1; j++) {
+	for (size_t i=0; i<_dims[0]-1; i++) {
+		if (! _cellBounds(i, j, cmin, cmax)) continue;
+
+		_binRange(cmin, cmax, b0, b1);
+		for (size_t bj=b0[1]; bj<=b1[1]; bj++) {
+		for (size_t bi=b0[0]; bi<=b1[0]; bi++) {
+			_binOffsets[bj*_nbins[0] + bi + 1]++;
+		}
+		}
+	}
+	}
+
+	for (size_t b=1; b<_binOffsets.size(); b++) {
+		_binOffsets[b] += _binOffsets[b-1];
+	}
+	_cells.resize(_binOffsets.back());
+
+	vector <size_t> fill(_binOffsets.begin(), _binOffsets.end()-1);
+	for (size_t j=0; ncells && j<_dims[1]-1; j++) {
+	for (size_t i=0; i<_dims[0]-1; i++) {
+		if (! _cellBounds(i, j, cmin, cmax)) continue;
+
+		_binRange(cmin, cmax, b0, b1);
+		for (size_t bj=b0[1]; bj<=b1[1]; bj++) {
+		for (size_t bi=b0[0]; bi<=b1[0]; bi++) {
+			_cells[fill[bj*_nbins[0] + bi]++] = j * (_dims[0]-1) + i;
+		}
+		}
+	}
+	}
+}
+
+bool CellLocatorRG::FindCell(
+	double x, double y, size_t &i, size_t &j, double lambda[4]
+) const {
+	i = j = 0;
+
+	// Comparisons are false for NaN
+	//
+	if (! (x >= _min[0] && x <= _max[0] && y >= _min[1] && y <= _max[1])) {
+		return(false);
+	}
+	if (_cells.empty()) return(false);
+
+	size_t bi = min((size_t) ((x - _min[0]) * _scale[0]), _nbins[0]-1);
+	size_t bj = min((size_t) ((y - _min[1]) * _scale[1]), _nbins[1]-1);
+	size_t b = bj*_nbins[0] + bi;
+
+	double pt[] = {x,y};
+	double verts[8];
+	size_t nx = _dims[0];
+	for (size_t l=_binOffsets[b]; l<_binOffsets[b+1]; l++) {
+		size_t ii = _cells[l] % (nx-1);
+		size_t jj = _cells[l] / (nx-1);
+
+		size_t v[] = {jj*nx+ii, jj*nx+ii+1, (jj+1)*nx+ii+1, (jj+1)*nx+ii};
+
+		double xmin = _xy[2*v[0]], xmax = xmin;
+		double ymin = _xy[2*v[0]+1], ymax = ymin;
+		for (int m=0; m<4; m++) {
+			verts[2*m] = _xy[2*v[m]];
+			verts[2*m+1] = _xy[2*v[m]+1];
+			xmin = min(xmin, verts[2*m]);
+			xmax = max(xmax, verts[2*m]);
+			ymin = min(ymin, verts[2*m+1]);
+			ymax = max(ymax, verts[2*m+1]);
+		}
+		if (x < xmin || x > xmax || y < ymin || y > ymax) continue;
+
+		if (VAPoR::WachspressCoords2D(verts, pt, 4, lambda)) {
+			i = ii;
+			j = jj;
+			return(true);
+		}
+	}
+	return(false);
+}
+
+size_t CellLocatorRG::GetMemoryUsage() const {
+	return(
+		sizeof(*this) +
+		_xy.capacity() * sizeof(_xy[0]) +
+		_binOffsets.capacity() * sizeof(_binOffsets[0]) +
+		_cells.capacity() * sizeof(_cells[0])
+	);
+}
+
+// Compute the bounding rectangle of cell (i,j). Returns false if any
+// of the cell's vertices has a non-finite coordinate
+//
+bool CellLocatorRG::_cellBounds(
+	size_t i, size_t j, double min[2], double max[2]
+) const {
+	size_t nx = _dims[0];
+	size_t v[] = {j*nx+i, j*nx+i+1, (j+1)*nx+i+1, (j+1)*nx+i};
+
+	for (int m=0; m<4; m++) {
+		double x = _xy[2*v[m]];
+		double y = _xy[2*v[m]+1];
+		if (! (std::isfinite(x) && std::isfinite(y))) return(false);
+
+		if (m == 0 || x < min[0]) min[0] = x;
+		if (m == 0 || x > max[0]) max[0] = x;
+		if (m == 0 || y < min[1]) min[1] = y;
+		if (m == 0 || y > max[1]) max[1] = y;
+	}
+	return(true);
+}
+
+// Range of bins overlapped by a rectangle that lies within the bin grid
+//
+void CellLocatorRG::_binRange(
+	const double min[2], const double max[2], size_t b0[2], size_t b1[2]
+) const {
+	for (int i=0; i<2; i++) {
+		b0[i] = std::min((size_t) ((min[i] - _min[i]) * _scale[i]), _nbins[i]-1);
+		b1[i] = std::min((size_t) ((max[i] - _min[i]) * _scale[i]), _nbins[i]-1);
+	}
+}
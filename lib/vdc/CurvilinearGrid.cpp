@@ -3,6 +3,7 @@
 #include <cassert>
 #include <cmath>
 #include <cfloat>
+#include <algorithm>
 #include <vapor/utils.h>
 #include <vapor/CurvilinearGrid.h>
 #include <vapor/KDTreeRG.h>
@@ -15,12 +16,14 @@ void CurvilinearGrid::_curvilinearGrid(
 	const RegularGrid &xrg,
 	const RegularGrid &yrg,
 	const vector <double> &zcoords,
-	const KDTreeRG *kdtree
+	const KDTreeRG *kdtree,
+	const CellLocatorRG *locator
 ) {
 	_zcoords.clear();
 	_minu.clear();
 	_maxu.clear();
 	_kdtree = kdtree;
+	_locator = locator;
 	_xrg = xrg;
 	_yrg = yrg;
 	_zcoords = zcoords;
@@ -34,7 +37,8 @@ CurvilinearGrid::CurvilinearGrid(
 	const RegularGrid &xrg,
 	const RegularGrid &yrg,
 	const vector <double> &zcoords,
-	const KDTreeRG *kdtree
+	const KDTreeRG *kdtree,
+	const CellLocatorRG *locator
  ) : StructuredGrid(dims, bs, blks) {
 
 	assert(bs.size() == dims.size());
@@ -46,8 +50,9 @@ CurvilinearGrid::CurvilinearGrid(
 	assert(xrg.GetDimensions().size() == 2);
 	assert(yrg.GetDimensions().size() == 2);
 	assert(kdtree->GetDimensions().size() == 2);
+	assert(! locator || locator->GetDimensions() == xrg.GetDimensions());
 
-	_curvilinearGrid(xrg, yrg, zcoords, kdtree);
+	_curvilinearGrid(xrg, yrg, zcoords, kdtree, locator);
 }
 
 size_t CurvilinearGrid::GetGeometryDim() const {
@@ -121,95 +126,54 @@ void CurvilinearGrid::GetEnclosingRegion(
 	// Initialize voxels coords to full grid
 	//
 	vector <size_t> dims = GetDimensions();
+	min.clear();
+	max.clear();
 	for (int i=0; i<dims.size(); i++) {
-		min[i] = 0;
-		max[i] = dims[i] - 1;
+		min.push_back(0);
+		max.push_back(dims[i] - 1);
 	}
 
-
-	// Now shrink min and max to the smallest box containing the region
-	//
-
-	// Find min and max Y voxel
+	// Shrink min and max to the index space bounding box of the 
+	// horizontal grid points inside the region, grown by one point so
+	// that the region is enclosed. If no points are inside, the region 
+	// is smaller than a cell and the full grid is returned.
 	//
-	float xmin = cMinu[0];
-	float ymin = cMinu[1];
-	int jmin = min[1];
-	bool outside = true;
-	for (int j=0; j<dims[1] && outside; j++) {
-		for (int i=0; i<dims[0] && outside; i++) {
-			float x = _xrg.AccessIJK(i,j,0);
-			float y = _yrg.AccessIJK(i,j,0);
-
-			if (! (x > xmin && y > ymin)) outside = false;
+	size_t imin = dims[0], imax = 0;
+	size_t jmin = dims[1], jmax = 0;
+	for (size_t j=0; j<dims[1]; j++) {
+	for (size_t i=0; i<dims[0]; i++) {
+		double x = _xrg.AccessIJK(i,j,0);
+		double y = _yrg.AccessIJK(i,j,0);
+		if (x < cMinu[0] || x > cMaxu[0] || y < cMinu[1] || y > cMaxu[1]) {
+			continue;
 		}
-		if (outside) jmin = j;
+		if (i < imin) imin = i;
+		if (i > imax) imax = i;
+		if (j < jmin) jmin = j;
+		if (j > jmax) jmax = j;
 	}
-	min[1] = jmin;
-
-	float xmax = cMaxu[0];
-	float ymax = cMaxu[1];
-	int jmax = max[1];
-	outside = true;
-	for (int j=dims[1]-1; j>=0 && outside; j--) {
-		for (int i=0; i<dims[0] && outside; i++) {
-			float x = _xrg.AccessIJK(i,j,0);
-			float y = _yrg.AccessIJK(i,j,0);
-
-			if (! (x > xmin && y > ymin)) outside = false;
-		}
-		if (outside) jmax = j;
 	}
-	max[1] = jmax;
-
-	// Find min and max X voxel
-	//
-	int imin = min[0];
-	outside = true;
-	for (int i=0; i<dims[0] && outside; i++) {
-		for (int j=min[1]; j<=max[1] && outside; j++) {
-			float x = _xrg.AccessIJK(i,j,0);
-			float y = _yrg.AccessIJK(i,j,0);
-
-			if (! (x < xmax && y < ymax)) outside = false;
-		}
-		if (outside) imin = i;
+	if (imin <= imax) {
+		min[0] = imin > 0 ? imin - 1 : 0;
+		max[0] = imax + 1 < dims[0] ? imax + 1 : dims[0] - 1;
+		min[1] = jmin > 0 ? jmin - 1 : 0;
+		max[1] = jmax + 1 < dims[1] ? jmax + 1 : dims[1] - 1;
 	}
-	min[0] = imin;
-
-	int imax = max[0];
-	outside = true;
-	for (int i=dims[0]-1; i>=0 && outside; i--) {
-		for (int j=min[1]; j<=max[1] && outside; j++) {
-			float x = _xrg.AccessIJK(i,j,0);
-			float y = _yrg.AccessIJK(i,j,0);
-
-			if (! (x < xmax && y < ymax)) outside = false;
-		}
-		if (outside) imax = i;
-	}
-	max[0] = imax;
 
 	if (dims.size() < 3) return;	// 2D => we're done.
 
-	// Finally, get Z
+	// Finally, get Z. Coordinates increase along the axis
 	//
-	float zmin = cMinu[2];
-	int kmin = min[2];
-	outside = true;
-	for (int k=0; k<_zcoords.size() && outside; k++) {
-		if (_zcoords[k] < zmin) outside = false;
-		if (outside) kmin = k;
-	}
+	size_t kmin = upper_bound(
+		_zcoords.begin(), _zcoords.end(), cMinu[2]
+	) - _zcoords.begin();
+	if (kmin > 0) kmin--;
 	min[2] = kmin;
 
-	float zmax = cMaxu[2];
-	int kmax = max[2];
-	outside = true;
-	for (int k=_zcoords.size()-1; k>=min[2] && outside; k--) {
-		if (_zcoords[k] > zmax) outside = false;
-		if (outside) kmax = k;
-	}
+	size_t kmax = lower_bound(
+		_zcoords.begin(), _zcoords.end(), cMaxu[2]
+	) - _zcoords.begin();
+	if (kmax > dims[2] - 1) kmax = dims[2] - 1;
 	max[2] = kmax;
 }
 
@@ -218,51 +182,68 @@ void CurvilinearGrid::GetUserCoordinates(
 	const std::vector <size_t> &indices,
 	std::vector <double> &coords
 ) const {
-    vector <size_t> cIndices = indices;
-    ClampIndex(cIndices);
-
-	coords.clear();
+	Size_tArr3 cIndices;
+	CopyToArr3(indices, cIndices);
 
-	vector <size_t> dims = StructuredGrid::GetDimensions();
-
-	vector <size_t> cIndices2D = {cIndices[0], cIndices[1]};
+	DblArr3 cCoords;
+	GetUserCoordinates(cIndices, cCoords);
+	CopyFromArr3(cCoords, GetGeometryDim(), coords);
+}
 
-	coords.push_back(_xrg.AccessIndex(cIndices2D));
-	coords.push_back(_yrg.AccessIndex(cIndices2D));
-	if (GetGeometryDim() > 2) {
-		coords.push_back(_zcoords[cIndices[2]]);
-	}
+void CurvilinearGrid::GetUserCoordinates(
+	const Size_tArr3 &indices, DblArr3 &coords
+) const {
+	Size_tArr3 cIndices = indices;
+	ClampIndex(cIndices);
 
+	coords[0] = _xrg.AccessIJK(cIndices[0], cIndices[1], 0);
+	coords[1] = _yrg.AccessIJK(cIndices[0], cIndices[1], 0);
+	coords[2] = GetGeometryDim() > 2 ? _zcoords[cIndices[2]] : 0.0;
 }
 
 void CurvilinearGrid::GetIndices(
 	const std::vector <double> &coords,
 	std::vector <size_t> &indices
 ) const {
-	indices.clear();
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
+
+	Size_tArr3 cIndices;
+	GetIndices(cCoords, cIndices);
+	CopyFromArr3(cIndices, GetGeometryDim(), indices);
+}
+
+void CurvilinearGrid::GetIndices(
+	const DblArr3 &coords, Size_tArr3 &indices
+) const {
 
 	// Clamp coordinates on periodic boundaries to grid extents
 	//
-	vector <double> cCoords = coords;
+	DblArr3 cCoords = coords;
 	ClampCoord(cCoords);
 
 	// First get horizontal coordinates, which are on curvilinear grid
 	//
-	vector <double> coords2D = {cCoords[0], cCoords[1]};
-	_kdtree->Nearest(coords2D, indices);
+	_kdtree->Nearest(cCoords, indices);
 
-	if (cCoords.size() == 2) return;
+	indices[2] = 0;
+	if (GetGeometryDim() < 3) return;
 
 	size_t k;
 	int rc = _binarySearchRange(_zcoords, cCoords[2], k);
 	if (rc < 0) {
-		indices.push_back(0);
+		indices[2] = 0;
 	}
 	else if (rc > 0) {
-		indices.push_back(k);
+		indices[2] = _zcoords.size() - 1;
 	}
 	else {
-		indices.push_back(GetDimensions()[2] - 1);
+		indices[2] = k;
+		if (k+1 < _zcoords.size() && 
+			cCoords[2] - _zcoords[k] > _zcoords[k+1] - cCoords[2]) {
+
+			indices[2] = k+1;
+		}
 	}
 }
 
@@ -270,67 +251,70 @@ bool CurvilinearGrid::GetIndicesCell(
 	const std::vector <double> &coords,
 	std::vector <size_t> &indices
 ) const {
+	indices.clear();
+
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
+
+	Size_tArr3 cIndices;
+	if (! GetIndicesCell(cCoords, cIndices)) return(false);
+
+	CopyFromArr3(cIndices, GetGeometryDim(), indices);
+	return(true);
+}
+
+bool CurvilinearGrid::GetIndicesCell(
+	const DblArr3 &coords, Size_tArr3 &indices
+) const {
 
 	// Clamp coordinates on periodic boundaries to grid extents
 	//
-	vector <double> cCoords = coords;
+	DblArr3 cCoords = coords;
 	ClampCoord(cCoords);
 	
-	double x = cCoords[0];
-	double y = cCoords[1];
-	double z = GetGeometryDim() == 3 ? cCoords[2] : 0.0;
-	
-
 	double lambda[4], zwgt[2];
 	size_t i, j, k;
-	bool inside = _insideGrid(x,y,z,i,j,k,lambda, zwgt);
-
+	bool inside = _insideGrid(
+		cCoords[0], cCoords[1], cCoords[2], i, j, k, lambda, zwgt
+	);
 	if (! inside) return (false);
 
-	indices.push_back(i);
-	indices.push_back(j);
-
-	if (GetGeometryDim() == 2) return(true);
-
-	indices.push_back(k);
+	indices[0] = i;
+	indices[1] = j;
+	indices[2] = GetGeometryDim() == 3 ? k : 0;
 
 	return(true);
 }
-	
-
 
 bool CurvilinearGrid::InsideGrid(const std::vector <double> &coords) const {
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
+	return(InsideGrid(cCoords));
+}
+
+bool CurvilinearGrid::InsideGrid(const DblArr3 &coords) const {
 
 	// Clamp coordinates on periodic boundaries to reside within the 
 	// grid extents 
 	//
-	vector <double> cCoords = coords;
+	DblArr3 cCoords = coords;
 	ClampCoord(cCoords);
 
 	// Do a quick check to see if the point is completely outside of 
 	// the grid bounds.
 	//
-	for (int i=0; i<cCoords.size(); i++) {
+	for (int i=0; i<GetGeometryDim(); i++) {
 		if (cCoords[i] < _minu[i] || cCoords[i] > _maxu[i]) return (false);
 	}
 
 	double lambda[4], zwgt[2];
 	size_t i,j,k;	// not used
-	double x = cCoords[0];
-	double y = cCoords[1];
-	double z = GetGeometryDim() == 3 ? cCoords[2] : 0.0;
-	
-	bool inside = _insideGrid(x, y, z, i, j, k, lambda, zwgt);
-
-
-	
-
-	return(inside);
+	return(_insideGrid(
+		cCoords[0], cCoords[1], cCoords[2], i, j, k, lambda, zwgt
+	));
 }
 
 
-
-
 CurvilinearGrid::ConstCoordItrCG::ConstCoordItrCG(
 	const CurvilinearGrid *cg, bool begin
 ) : ConstCoordItrAbstract() {
@@ -663,18 +647,51 @@ bool CurvilinearGrid::_insideGrid(
 	for (int l=0; l<2; l++) zwgt[l] = 0.0;
 	i = j = k = 0;
 
-	vector <float> coordu;
-	coordu.push_back(x);
-	coordu.push_back(y);
+	bool inside = false;
+	if (_locator) {
+		inside = _locator->FindCell(x, y, i, j, lambda);
+	}
+	else {
+		inside = _insideGridKDTree(x, y, i, j, lambda);
+	}
+
+	if (! inside) {
+		return(false);
+	}
+
+	if (GetGeometryDim() == 2) {
+		zwgt[0] = 1.0;
+		zwgt[1] = 0.0;
+		return(true);
+	}
+
+	// Now verify that Z coordinate of point is in grid, and find
+	// its interpolation weights if so.
+	//
+	int rc  = _binarySearchRange(_zcoords, z, k);
+
+	if (rc != 0) return(false);
+
+	zwgt[0] = 1.0 - (z - _zcoords[k]) / (_zcoords[k+1] - _zcoords[k]);
+	zwgt[1] = 1.0 - zwgt[0];
+
+	return(true);
+}
 
+// Find the horizontal cell containing (x,y) by testing the quads that
+// share the grid vertex nearest the point
+//
+bool CurvilinearGrid::_insideGridKDTree(
+	double x, double y, size_t &i, size_t &j, double lambda[4]
+) const {
+	DblArr3 coordu = {{x, y, 0.0}};
 
 	// Find the indeces for the nearest grid point in the horizontal plane
 	//
-	vector <size_t> indices;
+	Size_tArr3 indices;
 	_kdtree->Nearest(coordu, indices);
-	assert(indices.size() == 2);
 
-	vector <size_t> dims = StructuredGrid::GetDimensions();
+	const vector <size_t> &dims = StructuredGrid::GetDimensions();
 
 	// Now visit each quadrilateral that shares a vertex with the returned
 	// grid indeces. Use Wachspress coordinates to determine if point is 
@@ -711,27 +728,7 @@ bool CurvilinearGrid::_insideGrid(
 	}
 	}
 
-	if (! inside) {
-		return(false);
-	}
-
-	if (GetGeometryDim() == 2) {
-		zwgt[0] = 1.0;
-		zwgt[1] = 0.0;
-		return(true);
-	}
-
-	// Now verify that Z coordinate of point is in grid, and find
-	// its interpolation weights if so.
-	//
-	int rc  = _binarySearchRange(_zcoords, z, k);
-
-	if (rc != 0) return(false);
-
-	zwgt[0] = 1.0 - (z - _zcoords[k]) / (_zcoords[k+1] - _zcoords[k]);
-	zwgt[1] = 1.0 - zwgt[0];
-
-	return(true);
+	return(inside);
 }
 
 void CurvilinearGrid::_getMinCellExtents(
@@ -2,11 +2,19 @@
 #include <sstream>
 #include <stdio.h>
 #include <cstring>
+#include <cstdint>
 #include <cassert>
 #include <cfloat>
+#include <cmath>
+#include <limits>
 #include <vector>
 #include <map>
+#include <functional>
+#include <algorithm>
 #include <type_traits>
+#include <chrono>
+#include <vapor/CFuncs.h>
+#include <vapor/EasyThreads.h>
 #include <vapor/GeoUtil.h>
 #include <vapor/VDCNetCDF.h>
 #include <vapor/DCWRF.h>
@@ -22,6 +30,23 @@ using namespace VAPoR;
 
 namespace {
 
+// True in a DataMgr's prefetch thread
+//
+thread_local bool InPrefetchThread = false;
+
+// Seconds from a monotonic clock, used to measure the cost of cache
+// misses and the time reported by GetCacheStats()
+//
+double steady_time() {
+	return(std::chrono::duration <double> (
+		std::chrono::steady_clock::now().time_since_epoch()
+	).count());
+}
+
+// Number of evicted regions remembered for counting re-reads
+//
+const size_t MaxEvictedKeys = 1 << 18;
+
 // Format a vector as a space-separated element string
 //
 template <class T>
@@ -36,7 +61,61 @@ string vector_to_string(vector <T> v) {
 	return(oss.str());
 }
 
+// Compute the range of a grid's values, excluding missing values
+//
+void grid_range(const Grid *g, vector <double> &range) {
+	range.resize(2);
+	GridStats::ComputeRange(*g, range.data());
+}
+
+
+
+// 64-bit FNV-1a hash
+//
+uint64_t fnv1a(const void *data, size_t n, uint64_t hash) {
+	const unsigned char *p = (const unsigned char *) data;
+	for (size_t i=0; i<n; i++) {
+		hash ^= p[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return(hash);
+}
+
+// Name of the file caching the k-d tree for a set of coordinate 
+// variables. The name is derived from the variable names, the grid 
+// dimensions, and the coordinate values themselves, so a file is never
+// used for coordinates other than those it was built from, and time
+// steps sharing coordinates share a file.
+//
+string kdtree_cache_file(
+	const vector <string> &varnames, const vector <const Grid *> &grids
+) {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (int i=0; i<varnames.size(); i++) {
+		hash = fnv1a(varnames[i].c_str(), varnames[i].size() + 1, hash);
+	}
+	vector <size_t> dims = grids[0]->GetDimensions();
+	hash = fnv1a(dims.data(), dims.size() * sizeof(dims[0]), hash);
+
+	for (int i=0; i<grids.size(); i++) {
+		grids[i]->ForEachBlock(
+			[&](const float *blk, const Grid::BlockExtents &ext) {
+			for (size_t k=ext.min[2]; k<=ext.max[2]; k++) {
+			for (size_t j=ext.min[1]; j<=ext.max[1]; j++) {
+				const float *row = blk + (k * ext.bs[1] + j) * ext.bs[0];
+				hash = fnv1a(
+					row + ext.min[0],
+					(ext.max[0] - ext.min[0] + 1) * sizeof(*row), hash
+				);
+			}
+			}
+		});
+	}
 
+	char buf[64];
+	snprintf(buf, sizeof(buf), "vapor_kdtree_%016llx.kdt", (unsigned long long) hash);
+	return(buf);
+}
 
 // Product of elements in a vector
 //
@@ -276,6 +355,45 @@ void map_blk_to_vox(
     }
 }
 
+// Return the coordinates of the block at linear offset \p offset within
+// the region of blocks bounded by \p bmin and \p bmax. 
+// Wasp::VectorizeCoords() returns coordinates relative to \p bmin
+//
+vector <size_t> offset_to_blk(
+	size_t offset, const vector <size_t> &bmin, const vector <size_t> &bmax
+) {
+	vector <size_t> bcoord = Wasp::VectorizeCoords(offset, bmin, bmax);
+	for (int i=0; i<bcoord.size(); i++) {
+		bcoord[i] += bmin[i];
+	}
+	return(bcoord);
+}
+
+// Return pointers to each of the blocks contained in a contiguous region
+// of blocks
+//
+template <typename T>
+vector <T *> region_to_blks(
+	T *region, const vector <size_t> &bs,
+	const vector <size_t> &bmin, const vector <size_t> &bmax
+) {
+	assert(bs.size() == bmin.size());
+	assert(bs.size() == bmax.size());
+
+	size_t nblocks = 1;
+	size_t block_size = 1;
+    for (int i=0; i<bs.size(); i++) {
+        nblocks *= bmax[i]-bmin[i]+1;
+        block_size *= bs[i];
+    }
+
+	vector <T *> blks;
+	for (size_t i=0; i<nblocks; i++) {
+		blks.push_back(region + i*block_size);
+	}
+	return(blks);
+}
+
 // Extract various grid related metadata from a BaseVar class object
 //
 void grid_params(
@@ -381,7 +499,7 @@ DataMgr::DataMgr(
 
 	_PipeLines.clear();
 
-	_regionsList.clear();
+	_regionCache.Clear();
 
 	_varInfoCache.Clear();
 
@@ -392,6 +510,27 @@ DataMgr::DataMgr(
 	_openVarName.clear();
 	_proj4String.clear();
 	_proj4StringDefault.clear();
+
+	_lockedGrids.clear();
+
+	_epoch = 0;
+	_prefetchQueue.clear();
+	_prefetchBusy = false;
+	_prefetchStop = false;
+	_prefetchPredict = false;
+	_prefetchDepth = 1;
+	_prefetchLastTS.clear();
+
+	_memBacking = BlkMemMgr::HEAP;
+	_memBackingDir.clear();
+	_kdtreeCacheDir.clear();
+	_fastTransform = false;
+
+	_cachePolicy = new CachePolicyLRU();
+	_storageMode = LOSSLESS;
+	_storageTolerance = 0.005;
+	_evictedKeys.clear();
+	_evictedKeyQueue.clear();
 }
 
 
@@ -399,6 +538,8 @@ DataMgr::~DataMgr(
 ) {
 	SetDiagMsg("DataMgr::~DataMgr()");
 
+	_prefetch_stop();
+
 	if (_dc) delete _dc;
 	_dc = NULL;
 
@@ -408,17 +549,38 @@ DataMgr::~DataMgr(
 
 	_blk_mem_mgr = NULL;
 
+	if (_cachePolicy) delete _cachePolicy;
+	_cachePolicy = NULL;
+
 	for (int i=0; i<_derivedVars.size(); i++) {
 		if (_derivedVars[i]) delete _derivedVars[i];
 	}
 	_derivedVars.clear();
 }
 
+namespace {
+
+bool parse_cache_mode(const string &s, DataMgr::CompressedCacheMode &mode) {
+	if (s == "lossless") mode = DataMgr::LOSSLESS;
+	else if (s == "half") mode = DataMgr::HALF;
+	else if (s == "quant16") mode = DataMgr::QUANT16;
+	else if (s == "quant8") mode = DataMgr::QUANT8;
+	else return(false);
+
+	return(true);
+}
+
+};
+
 int DataMgr::_parseOptions(vector <string> &options) {
 
 	vector <string> newOptions;
 	bool ok = true;
 	int i = 0;
+	CompressedCacheMode cacheMode = GetCompressedCacheMode();
+	double cacheTolerance = GetCompressedCacheTolerance();
+	CompressedCacheMode storageMode = GetCacheStorageMode();
+	double storageTolerance = GetCacheStorageTolerance();
 	while (i<options.size() && ok) {
 		if (options[i] == "-proj4") {
 			i++;
@@ -432,6 +594,94 @@ int DataMgr::_parseOptions(vector <string> &options) {
 		if (options[i] == "-project_to_pcs") {
 			_doTransformHorizontal = true;
 		}
+		else if (options[i] == "-fast_transform") {
+			SetFastTransform(true);
+		}
+		else if (options[i] == "-cache_policy") {
+			i++;
+			if (i>=options.size() || SetCachePolicy(options[i]) < 0) {
+				ok = false;
+			}
+		}
+		else if (options[i] == "-mem_backing") {
+			i++;
+			if (i>=options.size()) {
+				ok = false;
+			}
+			else if (options[i] == "heap") {
+				_memBacking = BlkMemMgr::HEAP;
+			}
+			else if (options[i] == "hugepages") {
+				_memBacking = BlkMemMgr::HUGE_PAGES;
+			}
+			else if (options[i] == "file") {
+				_memBacking = BlkMemMgr::FILE_MAPPED;
+			}
+			else {
+				ok = false;
+			}
+		}
+		else if (options[i] == "-mem_backing_dir") {
+			i++;
+			if (i>=options.size()) {
+				ok = false;
+			}
+			else {
+				_memBackingDir = options[i];
+			}
+		}
+		else if (options[i] == "-kdtree_cache_dir") {
+			i++;
+			if (i>=options.size()) {
+				ok = false;
+			}
+			else {
+				SetKDTreeCacheDir(options[i]);
+			}
+		}
+		else if (options[i] == "-compressed_cache_size") {
+			i++;
+			if (i>=options.size()) {
+				ok = false;
+			}
+			else {
+				SetCompressedCacheSize(atoi(options[i].c_str()));
+			}
+		}
+		else if (options[i] == "-compressed_cache_mode") {
+			i++;
+			if (i>=options.size() || 
+				! parse_cache_mode(options[i], cacheMode)) {
+
+				ok = false;
+			}
+		}
+		else if (options[i] == "-compressed_cache_tolerance") {
+			i++;
+			if (i>=options.size()) {
+				ok = false;
+			}
+			else {
+				cacheTolerance = atof(options[i].c_str());
+			}
+		}
+		else if (options[i] == "-cache_storage_mode") {
+			i++;
+			if (i>=options.size() || 
+				! parse_cache_mode(options[i], storageMode)) {
+
+				ok = false;
+			}
+		}
+		else if (options[i] == "-cache_storage_tolerance") {
+			i++;
+			if (i>=options.size()) {
+				ok = false;
+			}
+			else {
+				storageTolerance = atof(options[i].c_str());
+			}
+		}
 		else {
 			newOptions.push_back(options[i]);
 		}
@@ -443,6 +693,9 @@ int DataMgr::_parseOptions(vector <string> &options) {
 		SetErrMsg("Error parsing options");
 		return(-1);
 	}
+
+	SetCompressedCacheMode(cacheMode, cacheTolerance);
+	SetCacheStorageMode(storageMode, storageTolerance);
 	return(0);
 }
 
@@ -450,6 +703,12 @@ int DataMgr::Initialize(
 	const vector <string> &files, const std::vector <string> &options
 ) {
 
+	CancelPrefetch();
+
+	std::lock_guard <std::recursive_mutex> dcguard(_dcMutex);
+
+	_prefetchLastTS.clear();
+
 	vector <string> deviceOptions = options;
 	int rc = _parseOptions(deviceOptions);
 	if (rc<0) return(-1);
@@ -464,7 +723,9 @@ int DataMgr::Initialize(
 	}
 
 	if (_format.compare("vdc") == 0) {
-		_dc = new VDCNetCDF(_nthreads);
+		VDCNetCDF *vdc = new VDCNetCDF(_nthreads);
+		vdc->SetFastTransform(_fastTransform);
+		_dc = vdc;
 	}
 	else if (_format.compare("wrf") == 0) {
 		_dc = new DCWRF();
@@ -784,6 +1045,8 @@ Grid *DataMgr::GetVariable (
 		ts,varname.c_str(), level, lod, lock
 	);
 
+	RequestScope request(this);
+
 	int rc = _level_correction(varname, level);
 	if (rc<0) return(NULL);
 
@@ -813,6 +1076,8 @@ Grid *DataMgr::GetVariable (
 		vector_to_string(max).c_str(), lock
 	);
 
+	RequestScope request(this);
+
 	int rc = _level_correction(varname, level);
 	if (rc<0) return(NULL);
 
@@ -836,16 +1101,26 @@ Grid *DataMgr::GetVariable (
 	// by min and max
 	//
 	vector <size_t> min_ui, max_ui;
+	double t0 = steady_time();
 	rc = _find_bounding_grid(
 		ts, varname, level, lod, min, max, min_ui, max_ui
 	);
+	{
+		std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+		_cacheStats.bounding_grid_time += steady_time() - t0;
+		_cacheStats.bounding_grid_calls++;
+	}
 	if (rc<0) return(NULL);
 
 	if (! min_ui.size()) {
 		return(_make_grid_empty(varname));
 	}
 
-	return(DataMgr::GetVariable(ts, varname, level, lod, min_ui, max_ui));
+	if (_prefetchPredict && ! InPrefetchThread) {
+		_predict_prefetch(ts, varname, level, lod, min, max);
+	}
+
+	return(DataMgr::GetVariable(ts, varname, level, lod, min_ui, max_ui, lock));
 
 }
 
@@ -1147,11 +1422,47 @@ Grid *DataMgr::_getVariable(
 	//
 	if (dataless) varnames[0].clear();
 
+	// Data for structured grids are cached block by block, so that
+	// requests for overlapping regions reuse blocks that are already 
+	// in memory. Everything else is cached as a contiguous region.
+	//
+	bool blocked = false;
+	if (! dataless) {
+		GridType grid_type = _get_grid_type(varname);
+		blocked = (grid_type == REGULAR || grid_type == STRETCHED ||
+			grid_type == LAYERED || grid_type == CURVILINEAR) &&
+			bsvec[0].size() >= 2;
+	}
+
+	vector <float *> data_blks;
+	if (blocked) {
+		int nlevels = DataMgr::GetNumRefLevels(varname);
+		int nlods = DataMgr::GetCRatios(varname).size();
+		size_t my_ts = DataMgr::IsTimeVarying(varname) ? ts : 0;
+
+		rc = _get_blocks<float>(
+			my_ts, varname, level, nlevels, lod, nlods, 
+			bsvec[0], bminvec[0], bmaxvec[0], data_blks
+		);
+		if (rc < 0) return(NULL);
+
+		varnames[0].clear();
+	}
+
     vector <float *> blkvec;
 	rc = DataMgr::_get_regions<float>(
 		ts, varnames, level, lod, true, bsvec, bminvec, bmaxvec, blkvec
 	);
-	if (rc < 0) return(NULL);
+	if (rc < 0) {
+		_unlock_blocks(data_blks);
+		return(NULL);
+	}
+
+	if (blkvec[0]) {
+		data_blks = region_to_blks(
+			blkvec[0], bs_at_levelvec[0], bminvec[0], bmaxvec[0]
+		);
+	}
 
 
 	// Get dimensions for connectivity variables (if any)
@@ -1167,17 +1478,24 @@ Grid *DataMgr::_getVariable(
 		conn_dims_at_levelvec, conn_bsvec, conn_bs_at_levelvec, 
 		conn_bminvec, conn_bmaxvec
 	);
-	if (rc<0) return(NULL);
 
     vector <int *> conn_blkvec;
-	rc = DataMgr::_get_regions<int>(
-		ts, conn_varnames, level, lod, true, conn_bsvec, conn_bminvec, 
-		conn_bmaxvec, conn_blkvec
-	);
-	if (rc < 0) return(NULL);
+	if (rc == 0) {
+		rc = DataMgr::_get_regions<int>(
+			ts, conn_varnames, level, lod, true, conn_bsvec, conn_bminvec, 
+			conn_bmaxvec, conn_blkvec
+		);
+	}
+	if (rc < 0) {
+		if (blocked) _unlock_blocks(data_blks);
+		for (int i=0; i<blkvec.size(); i++) {
+			if (blkvec[i]) _unlock_blocks(blkvec[i]);
+		}
+		return(NULL);
+	}
 
 
-	if (DataMgr::IsVariableDerived(varname) && ! blkvec[0]) {
+	if (DataMgr::IsVariableDerived(varname) && data_blks.empty()) {
 		//
 		// Derived variable that is not in cache, so we need to 
 		// create it
@@ -1198,22 +1516,58 @@ Grid *DataMgr::_getVariable(
 	}
 	else {
 		rg = _make_grid(
-			ts, level, lod, dvar, roi_dims, dims_at_levelvec[0], blkvec, 
+			ts, level, lod, dvar, roi_dims, dims_at_levelvec[0], 
+			data_blks, blkvec, 
 			bs_at_levelvec, bminvec, bmaxvec,
 			conn_blkvec, conn_bs_at_levelvec, conn_bminvec, conn_bmaxvec
 		);
 		assert(rg);
+
+		if (blocked) _set_block_decoder(rg, varname, data_blks);
 	}
 
 
+	// Cache regions backing the grid: data blocks, coordinates, and
+	// connectivity
+	//
+	vector <const void *> regions;
+	if (blocked) regions.insert(regions.end(), data_blks.begin(), data_blks.end());
+	for (int i=0; i<blkvec.size(); i++) {
+		if (blkvec[i]) regions.push_back(blkvec[i]);
+	}
+	for (int i=0; i<conn_blkvec.size(); i++) {
+		if (conn_blkvec[i]) regions.push_back(conn_blkvec[i]);
+	}
+
 	// 
-	// Safe to remove locks now that were not explicitly requested
+	// Safe to remove locks now that were not explicitly requested. 
+	// Otherwise remember them so UnlockGrid() can release them all
 	//
 	if (! lock) {
-		for (int i=0; i<blkvec.size(); i++) {
-			if (blkvec[i]) _unlock_blocks(blkvec[i]);
+		for (int i=0; i<regions.size(); i++) {
+			_unlock_blocks(regions[i]);
 		}
 	}
+	else if (rg) {
+		std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+		// A stale entry means a caller deleted a locked grid without 
+		// calling UnlockGrid(), and the new grid reuses its address. 
+		// Release the leaked locks rather than leave them pinned
+		//
+		map <const Grid *, vector <const void *> >::iterator itr;
+		itr = _lockedGrids.find(rg);
+		if (itr != _lockedGrids.end()) {
+			SetDiagMsg(
+				"DataMgr::GetVariable() - releasing %d regions of a locked "
+				"grid deleted without UnlockGrid()", (int) itr->second.size()
+			);
+			for (int i=0; i<itr->second.size(); i++) {
+				_unlock_blocks(itr->second[i]);
+			}
+		}
+		_lockedGrids[rg] = regions;
+	}
 
 	return(rg);
 }
@@ -1235,6 +1589,8 @@ Grid *DataMgr::GetVariable(
 		vector_to_string(max).c_str(), lock
 	);
 
+	RequestScope request(this);
+
 	int rc = _level_correction(varname, level);
 	if (rc<0) return(NULL);
 
@@ -1272,6 +1628,8 @@ int DataMgr::GetVariableExtents(
 	min.clear();
 	max.clear();
 
+	RequestScope request(this);
+
 	int rc = _level_correction(varname, level);
 	if (rc<0) return(-1);
 
@@ -1292,11 +1650,14 @@ int DataMgr::GetVariableExtents(
 	}
 
 
-	Grid *rg = _getVariable(ts, varname, level, -1, false, true);
+	Grid *rg = _getVariable(ts, varname, level, -1, true, true);
 	if (! rg) return(-1);
 
 	rg->GetUserExtents(min, max);
 
+	UnlockGrid(rg);
+	delete rg;
+
 	// Cache results 
 	//
 	values.clear();
@@ -1317,6 +1678,8 @@ int DataMgr::GetDataRange(
 	SetDiagMsg("DataMgr::GetDataRange(%d,%s)", ts, varname.c_str());
 	range.clear();
 
+	RequestScope request(this);
+
 	int rc = _level_correction(varname, level);
 	if (rc<0) return(-1);
 
@@ -1332,100 +1695,302 @@ int DataMgr::GetDataRange(
 		return(0);
 	}
 
-	const Grid *sg = DataMgr::GetVariable(
-		ts, varname, level, lod, false
-	);
-	if (! sg) return(-1);
-
-	//
-	// Have to calculate range 
+	// Use the ranges recorded by the data collection, if any
 	//
+	vector <double> blkranges;
+	rc = _get_block_ranges(ts, varname, level, lod, range, blkranges);
+	if (rc<0) return(-1);
 
-	range.clear(); range.push_back(0.0); range.push_back(0.0);
-	bool first = true;
-	float mv = sg->GetMissingValue();
-	Grid::ConstIterator itr;
-	Grid::ConstIterator enditr = sg->cend();
-//	for (itr = sg->cbegin(); itr!=sg->cend(); ++itr) {
-	for (itr = sg->cbegin(); itr!=enditr; ++itr) {
-		float v = *itr;
-		if (v != mv) {
-			if (first) {
-				range[0] = range[1] = v;
-				first = false;
-			}
-			if (v < range[0]) range[0] = v;
-			if (v > range[1]) range[1] = v;
-		}
+	if (range.empty()) {
+
+		const Grid *sg = DataMgr::GetVariable(
+			ts, varname, level, lod, true
+		);
+		if (! sg) return(-1);
+
+		//
+		// Have to calculate range 
+		//
+		grid_range(sg, range);
+
+		UnlockGrid(sg);
+		delete sg;
 	}
-	delete sg;
 
 	_varInfoCache.Set(ts, varname, level, lod, key, range);
 
 	return(0);
 }
 
-int DataMgr::GetDimLensAtLevel( 
-    string varname, int level, 
-	std::vector <size_t> &dims_at_level,
-    std::vector <size_t> &bs_at_level
-) const {
-	assert(_dc);
+int DataMgr::GetDataRange(
+	size_t ts,
+	string varname,
+	int level,
+	int lod,
+	vector <size_t> min,
+	vector <size_t> max,
+	vector <double> &range
+) {
+	assert(min.size() == max.size());
 
-	DerivedVar *dvar = _getDerivedVar(varname);
-	if (dvar) {
-		return(
-			dvar->GetDimLensAtLevel(varname, level, dims_at_level, bs_at_level)
-		);
-	}
+	SetDiagMsg(
+		"DataMgr::GetDataRange(%d, %s, %s, %s)", ts, varname.c_str(),
+		vector_to_string(min).c_str(), vector_to_string(max).c_str()
+	);
+	range.clear();
 
-	return(_dc->GetDimLensAtLevel(varname, level, dims_at_level, bs_at_level));
+	RequestScope request(this);
 
-	return(0);
-} 
+	int rc = _level_correction(varname, level);
+	if (rc<0) return(-1);
 
-#ifdef	VAPOR3_0_0_ALPHA
+	rc = _lod_correction(varname, lod);
+	if (rc<0) return(-1);
 
-int	DataMgr::NewPipeline(PipeLine *pipeline) {
+	vector <double> blkranges;
+	rc = _get_block_ranges(ts, varname, level, lod, range, blkranges);
+	if (rc<0) return(-1);
 
-	//
-	// Delete any pipeline stage with the same name as the new one. This
-	// is a no-op if the stage doesn't exist.
-	//
-	RemovePipeline(pipeline->GetName());
+	if (range.empty()) {
+		const Grid *sg = DataMgr::GetVariable(
+			ts, varname, level, lod, min, max, true
+		);
+		if (! sg) return(-1);
 
-	// 
-	// Make sure outputs don't collide with existing outputs
-	//
-	const vector <pair <string, VarType_T> > &my_outputs = pipeline->GetOutputs();
+		grid_range(sg, range);
 
-	for (int i=0; i<_PipeLines.size(); i++) {
-		const vector <pair <string,VarType_T> > &outputs = _PipeLines[i]->GetOutputs();
-		for (int j=0; j<my_outputs.size(); j++) {
-		for (int k=0; k<outputs.size(); k++) {
-			if (my_outputs[j].first.compare(outputs[k].first)==0) {
-				SetErrMsg(
-					"Pipeline output %s already in use", 
-					my_outputs[j].first.c_str()
-				);
-				return(-1);
-			}
-		}
-		}
+		UnlockGrid(sg);
+		delete sg;
+		return(0);
 	}
 
+	// Map the region to native resolution block coordinates, and
+	// combine the ranges of the blocks it intersects
 	//
-	// Now make sure outputs don't match any native variables
-	//
-	vector <string> native_vars = _get_native_variables();
+	vector <size_t> dims, bs;
+	rc = _dc->GetDimLensAtLevel(varname, -1, dims, bs);
+	if (rc<0) return(-1);
 
-	for (int i=0; i<native_vars.size(); i++) {
-		for (int j=0; j<my_outputs.size(); j++) {
-			if (native_vars[i].compare(my_outputs[j].first) == 0) {
-				SetErrMsg(
-					"Pipeline output %s matches native variable name", 
-					my_outputs[i].first.c_str()
-				);
+	while (min.size() > dims.size()) {
+		min.pop_back();
+		max.pop_back();
+	}
+
+	int shift = -level - 1;
+	vector <size_t> bmin, bmax, nblocks;
+	for (int i=0; i<min.size(); i++) {
+		size_t lo = min[i] << shift;
+		size_t hi = ((max[i] + 1) << shift) - 1;
+		if (hi > dims[i] - 1) hi = dims[i] - 1;
+		if (lo > hi) lo = hi;
+
+		bmin.push_back(lo / bs[i]);
+		bmax.push_back(hi / bs[i]);
+		nblocks.push_back((dims[i] + bs[i] - 1) / bs[i]);
+	}
+	while (bmin.size() < 3) {
+		bmin.push_back(0);
+		bmax.push_back(0);
+		nblocks.push_back(1);
+	}
+
+	range[0] = DBL_MAX;
+	range[1] = -DBL_MAX;
+	for (size_t k = bmin[2]; k <= bmax[2]; k++) {
+	for (size_t j = bmin[1]; j <= bmax[1]; j++) {
+	for (size_t i = bmin[0]; i <= bmax[0]; i++) {
+		size_t b = 2 * (i + nblocks[0] * (j + nblocks[1] * k));
+		assert(b+1 < blkranges.size());
+
+		if (blkranges[b] > blkranges[b+1]) continue;	// no valid values
+
+		if (blkranges[b] < range[0]) range[0] = blkranges[b];
+		if (blkranges[b+1] > range[1]) range[1] = blkranges[b+1];
+	}
+	}
+	}
+
+	// Region contains only missing values
+	//
+	if (range[0] > range[1]) {
+		range[0] = range[1] = 0.0;
+	}
+
+	return(0);
+}
+
+int DataMgr::GetDataMoments(
+	size_t ts,
+	string varname,
+	int level,
+	int lod,
+	GridStats::Moments &moments
+) {
+	SetDiagMsg("DataMgr::GetDataMoments(%d,%s)", ts, varname.c_str());
+	moments.Clear();
+
+	RequestScope request(this);
+
+	int rc = _level_correction(varname, level);
+	if (rc<0) return(-1);
+
+	rc = _lod_correction(varname, lod);
+	if (rc<0) return(-1);
+
+	string key = "VariableMoments";
+	vector <double> values;
+	if (_varInfoCache.Get(ts, varname, level, lod, key, values)) {
+		assert(values.size() == 6);
+		moments.count = (size_t) values[0];
+		moments.weight = values[1];
+		moments.min = values[2];
+		moments.max = values[3];
+		moments.mean = values[4];
+		moments.m2 = values[5];
+		return(0);
+	}
+
+	const Grid *sg = DataMgr::GetVariable(ts, varname, level, lod, true);
+	if (! sg) return(-1);
+
+	GridStats::ComputeMoments(*sg, moments);
+
+	UnlockGrid(sg);
+	delete sg;
+
+	values = {
+		(double) moments.count, moments.weight, moments.min, moments.max,
+		moments.mean, moments.m2
+	};
+	_varInfoCache.Set(ts, varname, level, lod, key, values);
+
+	return(0);
+}
+
+int DataMgr::GetDataHistogram(
+	size_t ts,
+	string varname,
+	int level,
+	int lod,
+	size_t nbins,
+	GridStats::Histogram &histo
+) {
+	SetDiagMsg(
+		"DataMgr::GetDataHistogram(%d,%s,%d)", ts, varname.c_str(), nbins
+	);
+	histo.Init(0.0, 1.0, nbins);
+
+	RequestScope request(this);
+
+	int rc = _level_correction(varname, level);
+	if (rc<0) return(-1);
+
+	rc = _lod_correction(varname, lod);
+	if (rc<0) return(-1);
+
+	// The cached values are the range, the counts below and above it,
+	// and the count of each bin
+	//
+	ostringstream oss;
+	oss << "VariableHistogram" << histo.counts.size();
+	string key = oss.str();
+	vector <double> values;
+	if (_varInfoCache.Get(ts, varname, level, lod, key, values)) {
+		assert(values.size() == histo.counts.size() + 4);
+		histo.Init(values[0], values[1], histo.counts.size());
+		histo.below = (size_t) values[2];
+		histo.above = (size_t) values[3];
+		for (size_t b=0; b<histo.counts.size(); b++) {
+			histo.counts[b] = (size_t) values[b+4];
+		}
+		return(0);
+	}
+
+	vector <double> range;
+	rc = GetDataRange(ts, varname, level, lod, range);
+	if (rc<0) return(-1);
+
+	const Grid *sg = DataMgr::GetVariable(ts, varname, level, lod, true);
+	if (! sg) return(-1);
+
+	histo.Init(range[0], range[1], histo.counts.size());
+	GridStats::ComputeHistogram(*sg, histo);
+
+	UnlockGrid(sg);
+	delete sg;
+
+	values = {
+		histo.lo, histo.hi, (double) histo.below, (double) histo.above
+	};
+	for (size_t b=0; b<histo.counts.size(); b++) {
+		values.push_back((double) histo.counts[b]);
+	}
+	_varInfoCache.Set(ts, varname, level, lod, key, values);
+
+	return(0);
+}
+
+int DataMgr::GetDimLensAtLevel( 
+    string varname, int level, 
+	std::vector <size_t> &dims_at_level,
+    std::vector <size_t> &bs_at_level
+) const {
+	assert(_dc);
+
+	DerivedVar *dvar = _getDerivedVar(varname);
+	if (dvar) {
+		return(
+			dvar->GetDimLensAtLevel(varname, level, dims_at_level, bs_at_level)
+		);
+	}
+
+	return(_dc->GetDimLensAtLevel(varname, level, dims_at_level, bs_at_level));
+
+	return(0);
+} 
+
+#ifdef	VAPOR3_0_0_ALPHA
+
+int	DataMgr::NewPipeline(PipeLine *pipeline) {
+
+	//
+	// Delete any pipeline stage with the same name as the new one. This
+	// is a no-op if the stage doesn't exist.
+	//
+	RemovePipeline(pipeline->GetName());
+
+	// 
+	// Make sure outputs don't collide with existing outputs
+	//
+	const vector <pair <string, VarType_T> > &my_outputs = pipeline->GetOutputs();
+
+	for (int i=0; i<_PipeLines.size(); i++) {
+		const vector <pair <string,VarType_T> > &outputs = _PipeLines[i]->GetOutputs();
+		for (int j=0; j<my_outputs.size(); j++) {
+		for (int k=0; k<outputs.size(); k++) {
+			if (my_outputs[j].first.compare(outputs[k].first)==0) {
+				SetErrMsg(
+					"Pipeline output %s already in use", 
+					my_outputs[j].first.c_str()
+				);
+				return(-1);
+			}
+		}
+		}
+	}
+
+	//
+	// Now make sure outputs don't match any native variables
+	//
+	vector <string> native_vars = _get_native_variables();
+
+	for (int i=0; i<native_vars.size(); i++) {
+		for (int j=0; j<my_outputs.size(); j++) {
+			if (native_vars[i].compare(my_outputs[j].first) == 0) {
+				SetErrMsg(
+					"Pipeline output %s matches native variable name", 
+					my_outputs[i].first.c_str()
+				);
 				return(-1);
 			}
 		}
@@ -1613,6 +2178,42 @@ bool DataMgr::VariableExists(
 }
 
 
+// Return the value ranges recorded for a variable, if they describe the
+// variable at the given (corrected) refinement level and lod: the 
+// recorded ranges are those of the native data, which coarser levels
+// and lossy lods only approximate. Otherwise return empty ranges.
+//
+int DataMgr::_get_block_ranges(
+	size_t ts, string varname, int level, int lod,
+	vector <double> &range, vector <double> &blkranges
+) {
+	range.clear();
+	blkranges.clear();
+
+	// Derived variables are never recorded
+	//
+	if (! IsVariableNative(varname)) return(0);
+
+	if (level != -1 || lod != -1) return(0);
+
+	DC::BaseVar var;
+	int rc = GetBaseVarInfo(varname, var);
+	if (rc<0) return(-1);
+
+	vector <size_t> cratios = var.GetCRatios();
+	if (cratios.size() && cratios.back() != 1) return(0);
+
+	std::lock_guard <std::recursive_mutex> dcguard(_dcMutex);
+
+	rc = _dc->GetBlockRanges(ts, varname, range, blkranges);
+	if (rc<0) return(-1);
+
+	if (range.size() == 2 && range[0] > range[1]) {
+		range[0] = range[1] = 0.0;
+	}
+	return(0);
+}
+
 bool DataMgr::IsVariableNative(string name) const {
 	vector <string> svec = _get_native_variables();
 
@@ -1628,23 +2229,37 @@ bool DataMgr::IsVariableDerived(string name) const {
 
 void	DataMgr::Clear() {
 
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
 	_PipeLines.clear();
 
-	list <region_t>::iterator itr;
-	for(itr = _regionsList.begin(); itr!=_regionsList.end(); itr++) {
+	RegionCache::iterator itr;
+	for(itr = _regionCache.begin(); itr!=_regionCache.end(); itr++) {
 		const region_t &region = *itr;
 
 		if (region.blks) _blk_mem_mgr->FreeMem(region.blks);
 			
 	}
-	_regionsList.clear();
+	_regionCache.Clear();
+	_lockedGrids.clear();
+
+	_cachePolicy->Clear();
+	_evictedKeys.clear();
+	_evictedKeyQueue.clear();
+	_compressedCache.Clear();
 
 	vector <string> hash = _varInfoCache.GetVoidPtrHash();
 	for (int i=0; i<hash.size(); i++) {
 		vector <void *> vals;
 		_varInfoCache.Get(hash[i], vals);
+		bool isCellLocator = hash[i].compare(0, 11, "CellLocator") == 0;
+		bool isFaceLocator = hash[i].compare(0, 11, "FaceLocator") == 0;
 		for (int j=0; j<vals.size(); j++) {
-			if (vals[j]) delete (KDTreeRG *) vals[j];
+			if (! vals[j]) continue;
+
+			if (isCellLocator) delete (CellLocatorRG *) vals[j];
+			else if (isFaceLocator) delete (FaceLocatorUG2D *) vals[j];
+			else delete (KDTreeRG *) vals[j];
 		}
 	}
 	_varInfoCache.Clear();
@@ -1657,13 +2272,221 @@ void	DataMgr::UnlockGrid(
 	const Grid *rg
 ) {
 	SetDiagMsg("DataMgr::UnlockGrid()");
-	const vector <float *> &blks = rg->GetBlks();
-	if (blks.size()) _unlock_blocks(blks[0]);
 
-	const LayeredGrid *lg = dynamic_cast<const LayeredGrid *>(rg);
-	if (lg) {
-		const Grid &rg = lg->GetZRG();
-		if (rg.GetBlks().size()) _unlock_blocks(rg.GetBlks()[0]);
+	RequestScope request(this);
+
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	// Unlock every cache region (data, coordinates, connectivity) that
+	// was locked on behalf of the grid 
+	//
+	map <const Grid *, vector <const void *> >::iterator itr;
+	itr = _lockedGrids.find(rg);
+	if (itr != _lockedGrids.end()) {
+		for (int i=0; i<itr->second.size(); i++) {
+			_unlock_blocks(itr->second[i]);
+		}
+		_lockedGrids.erase(itr);
+		return;
+	}
+
+	// The grid was never locked (or has already been unlocked). Its
+	// blocks may be shared with other grids that do hold locks, so
+	// decrementing their lock counts here would let those regions be
+	// evicted while still in use.
+	//
+	SetDiagMsg("DataMgr::UnlockGrid() : grid %p is not locked", rg);
+}
+
+void DataMgr::Prefetch(
+	size_t ts, string varname, int level, int lod,
+	vector <double> min, vector <double> max
+) {
+	assert(min.size() == max.size());
+
+	SetDiagMsg(
+		"DataMgr::Prefetch(%d, %s, %d, %d, %s, %s)",
+		ts,varname.c_str(), level, lod, vector_to_string(min).c_str(),
+		vector_to_string(max).c_str()
+	);
+
+	PrefetchReq req;
+	req.ts = ts;
+	req.varname = varname;
+	req.level = level;
+	req.lod = lod;
+	req.min = min;
+	req.max = max;
+
+	std::unique_lock <std::mutex> qlock(_prefetchQueueMutex);
+
+	for (int i=0; i<_prefetchQueue.size(); i++) {
+		if (_prefetchQueue[i] == req) return;
+	}
+
+	// Bound the queue so that stale requests (e.g. for time steps that
+	// playback has already passed) don't accumulate
+	//
+	const size_t max_queue = 16;
+	if (_prefetchQueue.size() >= max_queue) _prefetchQueue.pop_front();
+
+	_prefetchQueue.push_back(req);
+
+	if (! _prefetchThread.joinable()) {
+		_prefetchStop = false;
+		_prefetchThread = std::thread(&DataMgr::_prefetch_thread, this);
+	}
+
+	qlock.unlock();
+	_prefetchCV.notify_all();
+}
+
+void DataMgr::CancelPrefetch() {
+	std::unique_lock <std::mutex> qlock(_prefetchQueueMutex);
+
+	_prefetchQueue.clear();
+
+	// Wait for a request in progress to finish
+	//
+	while (_prefetchBusy) _prefetchCV.wait(qlock);
+}
+
+void DataMgr::SetPrefetchPredictor(bool enable, int depth) {
+	std::unique_lock <std::mutex> qlock(_prefetchQueueMutex);
+
+	_prefetchPredict = enable;
+	_prefetchDepth = depth > 0 ? depth : 1;
+	_prefetchLastTS.clear();
+
+	qlock.unlock();
+
+	if (! enable) CancelPrefetch();
+}
+
+// Count requests made by callers other than the prefetch thread. The
+// prefetch thread does not evict regions used by the latest request.
+// A request advances the count the first time it uses the region cache,
+// and requests nested in another are part of the outer one. So the
+// regions behind a grid returned to a caller are protected until the
+// caller makes another request that may itself evict them.
+//
+thread_local DataMgr::RequestScope *DataMgr::_threadRequest = NULL;
+
+DataMgr::RequestScope::RequestScope(const DataMgr *dm) :
+	_dm(dm), _outer(NULL), _stamped(false)
+{
+	if (InPrefetchThread) return;
+
+	_outer = _threadRequest;
+	_threadRequest = this;
+}
+
+DataMgr::RequestScope::~RequestScope() {
+	if (InPrefetchThread) return;
+
+	_threadRequest = _outer;
+}
+
+size_t DataMgr::_request_epoch() const {
+	if (InPrefetchThread) return(_epoch);
+
+	// The outermost of this thread's scopes for this DataMgr owns
+	// the request
+	//
+	RequestScope *request = NULL;
+	for (RequestScope *s = _threadRequest; s; s = s->_outer) {
+		if (s->_dm == this) request = s;
+	}
+
+	if (request && ! request->_stamped) {
+		request->_stamped = true;
+		return(++_epoch);
+	}
+	return(_epoch);
+}
+
+void DataMgr::_prefetch_thread() {
+
+	InPrefetchThread = true;
+
+	std::unique_lock <std::mutex> qlock(_prefetchQueueMutex);
+	for (;;) {
+		while (! _prefetchStop && _prefetchQueue.empty()) {
+			_prefetchCV.wait(qlock);
+		}
+		if (_prefetchStop) return;
+
+		PrefetchReq req = _prefetchQueue.front();
+		_prefetchQueue.pop_front();
+		_prefetchBusy = true;
+		qlock.unlock();
+
+		_prefetch(req);
+
+		qlock.lock();
+		_prefetchBusy = false;
+		_prefetchCV.notify_all();
+	}
+}
+
+void DataMgr::_prefetch_stop() {
+	std::unique_lock <std::mutex> qlock(_prefetchQueueMutex);
+	_prefetchQueue.clear();
+	_prefetchStop = true;
+	qlock.unlock();
+
+	_prefetchCV.notify_all();
+
+	if (_prefetchThread.joinable()) _prefetchThread.join();
+}
+
+void DataMgr::_prefetch(const PrefetchReq &req) {
+	SetDiagMsg(
+		"DataMgr::_prefetch(%d, %s, %d, %d)",
+		req.ts, req.varname.c_str(), req.level, req.lod
+	);
+
+	if (! VariableExists(req.ts, req.varname, req.level, req.lod)) return;
+
+	Grid *rg = GetVariable(
+		req.ts, req.varname, req.level, req.lod, req.min, req.max, false
+	);
+	if (rg) delete rg;
+}
+
+// Prefetch the next time steps along the stride between this request
+// and the previous request for the same variable
+//
+void DataMgr::_predict_prefetch(
+	size_t ts, string varname, int level, int lod,
+	const vector <double> &min, const vector <double> &max
+) {
+	ostringstream oss;
+	oss << varname << ":" << level << ":" << lod;
+	string key = oss.str();
+
+	std::unique_lock <std::mutex> qlock(_prefetchQueueMutex);
+
+	map <string, size_t>::iterator itr = _prefetchLastTS.find(key);
+	if (itr == _prefetchLastTS.end()) {
+		_prefetchLastTS[key] = ts;
+		return;
+	}
+
+	long stride = (long) ts - (long) itr->second;
+	itr->second = ts;
+	int depth = _prefetchDepth;
+
+	qlock.unlock();
+
+	if (stride == 0 || ! IsTimeVarying(varname)) return;
+
+	long nts = GetNumTimeSteps(varname);
+	for (int i=1; i<=depth; i++) {
+		long next = (long) ts + (stride * i);
+		if (next < 0 || next >= nts) break;
+
+		Prefetch(next, varname, level, lod, min, max);
 	}
 }
 
@@ -1717,31 +2540,31 @@ T	*DataMgr::_get_region_from_cache(
 	bool	lock
 ) {
 
-	list <region_t>::iterator itr;
-	for(itr = _regionsList.begin(); itr!=_regionsList.end(); itr++) {
-		region_t &region = *itr;
-
-		if (region.ts == ts &&
-			region.varname.compare(varname) == 0 &&
-			region.level == level &&
-			region.lod == lod &&
-			region.bmin == bmin &&
-			region.bmax == bmax) {
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
 
-			// Increment the lock counter
-			region.lock_counter += lock ? 1 : 0;
+	// A region whose data are still being produced by another thread
+	// is a miss. That thread holds the region's I/O lock.
+	//
+	region_t *region = _regionCache.Find(ts, varname, level, lod, bmin, bmax);
+	if (region && region->loaded) {
 
-			// Move region to front of list
-			region_t tmp_region = region;
-			_regionsList.erase(itr);
-			_regionsList.push_back(tmp_region);
+		// Increment the lock counter
+		region->lock_counter += lock ? 1 : 0;
 
-			SetDiagMsg(
-				"DataMgr::_get_region_from_cache() - data in cache %xll\n",
-				 tmp_region.blks
-			);
-			return((T *) tmp_region.blks);
+		// Prefetching is not a use of the region
+		//
+		if (! InPrefetchThread) {
+			region->epoch = _request_epoch();
+			_cachePolicy->Touch(region);
+			_cacheStats.hits++;
+			if (region->stats) region->stats->hits++;
 		}
+
+		SetDiagMsg(
+			"DataMgr::_get_region_from_cache() - data in cache %xll\n",
+			 region->blks
+		);
+		return((T *) region->blks);
 	}
 
 	return(NULL);
@@ -1759,6 +2582,8 @@ T *DataMgr::_get_region_from_fs(
 	);
 	if (! blks) return(NULL);
 
+	double t0 = steady_time();
+
     vector <size_t> min, max;
 	map_blk_to_vox(bs, bmin, bmax, min, max);
 
@@ -1778,23 +2603,92 @@ T *DataMgr::_get_region_from_fs(
 		}
 	}
 
+	std::unique_lock <std::recursive_mutex> dcguard(_dcMutex);
+
 	int fd = _openVariableRead(ts, varname, level, lod);
-    if (fd < 0) return(NULL);
+    if (fd < 0) {
+		dcguard.unlock();
+		if (lock) _unlock_blocks(blks);
+		_free_region(ts,varname ,level,lod,bmin,bmax);
+		return(NULL);
+	}
 
 	int rc = _readRegionBlock(fd, min, max, blks);
     if (rc < 0) {
-		_free_region(ts,varname ,level,lod,bmin,bmax);
 		_closeVariable(fd); 
+		dcguard.unlock();
+		if (lock) _unlock_blocks(blks);
+		_free_region(ts,varname ,level,lod,bmin,bmax);
 		return(NULL);
 	}
 
 	rc = _closeVariable(fd); 
-	if (rc<0) return(NULL);
+	dcguard.unlock();
+	if (rc<0) {
+		if (lock) _unlock_blocks(blks);
+		_free_region(ts,varname ,level,lod,bmin,bmax);
+		return(NULL);
+	}
+
+	_record_miss(blks, steady_time() - t0);
 
 	SetDiagMsg("DataMgr::GetGrid() - data read from fs\n");
 	return(blks);
 }
 
+// Restore a region from the compressed second tier cache
+//
+template <typename T>
+T *DataMgr::_get_region_from_compressed(
+	size_t ts, string varname, int level, int lod,
+    const vector <size_t> &bs, const vector <size_t> &bmin, 
+	const vector <size_t> &bmax, bool lock
+) {
+	if (! _compressedCache.GetMaxSize()) return(NULL);
+
+	RegionCache::Key key;
+	{
+		std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+		key = _regionCache.MakeKey(ts, varname, level, lod, bmin, bmax);
+		if (! _compressedCache.Contains(key)) return(NULL);
+	}
+
+	T *blks = (T *) _alloc_region(
+		ts, varname, level, lod, bmin, bmax, bs, sizeof(T), lock, false
+	);
+	if (! blks) return(NULL);
+
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	// Making room for the region may have pushed it out of the second 
+	// tier
+	//
+	region_t *region = _regionCache.Find(blks);
+	double cost, maxError;
+	if (! region ||
+		! _compressedCache.Extract(key, blks, region->size, cost, maxError)) {
+
+		if (lock) _unlock_blocks(blks);
+		_free_region(ts, varname, level, lod, bmin, bmax);
+		return(NULL);
+	}
+
+	region->loaded = true;
+	region->cost = cost;
+	_cachePolicy->SetCost(region, cost);
+	_cacheStats.compressed_hits++;
+	_cacheStats.compressed_max_error = std::max(
+		_cacheStats.compressed_max_error, maxError
+	);
+
+	SetDiagMsg(
+		"DataMgr::_get_region_from_compressed() - data restored %xll\n",
+		blks
+	);
+	return(blks);
+}
+
 template <typename T>
 T *DataMgr::_get_region(
 	size_t ts,
@@ -1817,6 +2711,23 @@ T *DataMgr::_get_region(
 	T *blks = _get_region_from_cache<T>(
 		ts, varname, level, lod, bmin, bmax, lock
 	);
+	if (blks) return(blks);
+
+	// Reads of a variable's time step are serialized. Another thread 
+	// may have read the region while we waited, in which case it's now
+	// in the cache
+	//
+	std::lock_guard <std::recursive_mutex> ioguard(_io_lock(ts, varname));
+
+	blks = _get_region_from_cache<T>(
+		ts, varname, level, lod, bmin, bmax, lock
+	);
+	if (! blks) {
+		blks = _get_region_from_compressed<T>(
+			ts, varname, level, lod, decimate_dims(bs, -level - 1), 
+			bmin, bmax, lock
+		);
+	}
 	if (! blks ) {
 
 		// If level not available we recursively decimate
@@ -1824,9 +2735,11 @@ T *DataMgr::_get_region(
 		if (level < -nlevels) {
 			level++;
 
+			double t0 = steady_time();
+
 			blks = _get_region<T>(
 				ts, varname, level, nlevels, lod, nlods,
-				bs, bmin, bmax, false
+				bs, bmin, bmax, true
 			);
 			if (blks) {
 				vector <size_t> bs_at_level = decimate_dims(bs, -level - 1);
@@ -1834,11 +2747,14 @@ T *DataMgr::_get_region(
 
 				T *newblks = (T *) _alloc_region(
 					ts, varname, level-1, lod, bmin, bmax, bs_at_level_m1, 
-					sizeof(T), false, false
+					sizeof(T), lock, false
 				);
-				if (! newblks) return(NULL);
+				if (newblks) {
+					decimate(bmin, bmax, bs_at_level, blks, newblks); 
+					_record_miss(newblks, steady_time() - t0);
+				}
+				_unlock_blocks(blks);
 
-				decimate(bmin, bmax, bs_at_level, blks, newblks); 
 				return(newblks);
 			}
 		} 
@@ -1860,6 +2776,269 @@ T *DataMgr::_get_region(
 	return(blks);
 }
 
+// Get each of the blocks in the region bounded by bmin and bmax. Blocks
+// are cached individually as single-block regions. Cached blocks are
+// reused, and only the missing blocks are read. All returned blocks are
+// locked.
+//
+template <typename T>
+int DataMgr::_get_blocks(
+	size_t ts,
+	string varname,
+	int level,
+	int nlevels,
+	int lod,
+	int nlods,
+	const vector <size_t> &bs,
+	const vector <size_t> &bmin,
+	const vector <size_t> &bmax,
+	vector <T *> &blks
+) {
+	assert(bmin.size() == bmax.size());
+	assert(bmin.size() == bs.size());
+
+	blks.clear();
+
+	if (lod < -nlods) lod = -nlods;
+
+	vector <size_t> bs_at_level = decimate_dims(bs, -level - 1);
+
+	size_t nblocks = Wasp::LinearizeCoords(bmax, bmin, bmax) + 1;
+
+	// First pass: collect blocks already in cache, and lock them so they
+	// can't be freed while we're allocating space for the missing ones
+	//
+	vector <size_t> missing;
+	for (size_t offset = 0; offset<nblocks; offset++) {
+		vector <size_t> bcoord = offset_to_blk(offset, bmin, bmax);
+
+		T *blk = _get_region_from_cache<T>(
+			ts, varname, level, lod, bcoord, bcoord, true
+		);
+		if (! blk) missing.push_back(offset);
+		blks.push_back(blk);
+	}
+
+	if (missing.empty()) return(0);
+
+	// Reads of a variable's time step are serialized. Blocks read by 
+	// another thread while we waited are now in the cache
+	//
+	std::lock_guard <std::recursive_mutex> ioguard(_io_lock(ts, varname));
+
+	vector <size_t> still_missing;
+	for (size_t i=0; i<missing.size(); i++) {
+		vector <size_t> bcoord = offset_to_blk(missing[i], bmin, bmax);
+
+		blks[missing[i]] = _get_region_from_cache<T>(
+			ts, varname, level, lod, bcoord, bcoord, true
+		);
+		if (! blks[missing[i]]) {
+			blks[missing[i]] = _get_region_from_compressed<T>(
+				ts, varname, level, lod, bs_at_level, bcoord, bcoord, true
+			);
+		}
+		if (! blks[missing[i]]) still_missing.push_back(missing[i]);
+	}
+	missing = still_missing;
+
+	if (missing.empty()) return(0);
+
+	SetDiagMsg(
+		"DataMgr::_get_blocks() - %d of %d blocks not in cache",
+		missing.size(), nblocks
+	);
+
+	// If level not available we recursively decimate one block at a time
+	//
+	if (level < -nlevels) {
+		for (size_t i=0; i<missing.size(); i++) {
+			vector <size_t> bcoord = offset_to_blk(
+				missing[i], bmin, bmax
+			);
+
+			T *blk = _get_region<T>(
+				ts, varname, level, nlevels, lod, nlods, bs,
+				bcoord, bcoord, true
+			);
+			if (! blk) {
+				_unlock_blocks(blks);
+				blks.clear();
+				return(-1);
+			}
+			blks[missing[i]] = blk;
+		}
+		return(0);
+	}
+
+	size_t block_size = vproduct(bs_at_level);
+
+	CompressedCacheMode mode;
+	double tolerance;
+	{
+		std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+		mode = _storageMode;
+		tolerance = _storageTolerance;
+	}
+	bool hasMissing = false;
+	float mv = 0.0;
+	if (! std::is_same <T, float>::value || 
+		! _is_float_var(varname, hasMissing, mv)) {
+
+		mode = LOSSLESS;
+	}
+
+	// Allocate space for all of the missing blocks before reading, so 
+	// that evictions aren't made while holding the DC lock. Blocks to be
+	// stored with reduced precision are read into a scratch buffer, and
+	// are allocated once their encoded size is known
+	//
+	int rc = 0;
+	vector <T *> dst(missing.size(), NULL);
+	vector <T> scratch;
+	if (mode != LOSSLESS) {
+		scratch.resize(missing.size() * block_size);
+		for (size_t i=0; i<missing.size(); i++) {
+			dst[i] = scratch.data() + i*block_size;
+		}
+	}
+	for (size_t i=0; i<missing.size() && mode == LOSSLESS; i++) {
+		vector <size_t> bcoord = offset_to_blk(missing[i], bmin, bmax);
+		blks[missing[i]] = (T *) _alloc_region(
+			ts, varname, level, lod, bcoord, bcoord, bs_at_level,
+			sizeof(T), true, false
+		);
+		if (! blks[missing[i]]) {
+			rc = -1;
+			break;
+		}
+		dst[i] = blks[missing[i]];
+	}
+
+	vector <double> costs(missing.size(), 0.0);
+	if (rc >= 0) {
+		std::lock_guard <std::recursive_mutex> dcguard(_dcMutex);
+
+		double t0 = steady_time();
+
+		int fd = _openVariableRead(ts, varname, level, lod);
+		if (fd < 0) rc = -1;
+
+		// The cost of opening the variable is shared by all missing blocks
+		//
+		double open_cost = (steady_time() - t0) / (double) missing.size();
+
+		// Read missing blocks in runs of consecutive blocks along the 
+		// fastest varying axis.
+		//
+		T *buf = NULL;
+		size_t bufsize = 0;
+		for (size_t i=0; i<missing.size() && rc >= 0; ) {
+			size_t j = i+1;
+			vector <size_t> runmin = offset_to_blk(missing[i], bmin, bmax);
+			while (j<missing.size() && missing[j] == missing[j-1] + 1 &&
+				runmin[0] + (j-i) <= bmax[0]) {
+				j++;
+			}
+			vector <size_t> runmax = runmin;
+			runmax[0] += j-i-1;
+
+			double t1 = steady_time();
+
+			vector <size_t> min, max;
+			map_blk_to_vox(bs_at_level, runmin, runmax, min, max);
+
+			if (j-i == 1) {
+				rc = _readRegionBlock(fd, min, max, dst[i]);
+			}
+			else {
+
+				// Read the run into a scratch buffer, then copy each block
+				// into its own cache entry
+				//
+				if (bufsize < (j-i) * block_size) {
+					if (buf) delete [] buf;
+					bufsize = (j-i) * block_size;
+					buf = new T[bufsize];
+				}
+
+				rc = _readRegionBlock(fd, min, max, buf);
+				for (size_t k=i; k<j && rc >= 0; k++) {
+					memcpy(
+						dst[k], buf + (k-i)*block_size, block_size * sizeof(T)
+					);
+				}
+			}
+
+			double cost = (steady_time() - t1) / (double) (j-i) + open_cost;
+			for (size_t k=i; k<j; k++) costs[k] = cost;
+
+			i = j;
+		}
+		if (buf) delete [] buf;
+
+		if (fd >= 0) {
+			int closerc = _closeVariable(fd);
+			if (rc >= 0) rc = closerc;
+		}
+	}
+
+	// Encode the blocks to be stored with reduced precision. The cost of
+	// encoding is counted as part of the cost of reading
+	//
+	for (size_t i=0; i<missing.size() && rc >= 0 && mode != LOSSLESS; i++) {
+		double t0 = steady_time();
+
+		vector <unsigned char> encoded;
+		double maxError;
+		CompressedRegionCache::EncodeReduced(
+			(const float *) dst[i], block_size, mode, tolerance, 
+			hasMissing, mv, encoded, maxError
+		);
+
+		vector <size_t> bcoord = offset_to_blk(missing[i], bmin, bmax);
+		blks[missing[i]] = (T *) _alloc_region(
+			ts, varname, level, lod, bcoord, bcoord, encoded.size(), mode,
+			true, false
+		);
+		if (! blks[missing[i]]) {
+			rc = -1;
+			break;
+		}
+		memcpy(blks[missing[i]], encoded.data(), encoded.size());
+
+		costs[i] += steady_time() - t0;
+
+		std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+		_cacheStats.reduced_max_error = std::max(
+			_cacheStats.reduced_max_error, maxError
+		);
+	}
+
+	if (rc < 0) {
+		for (size_t i=0; i<missing.size(); i++) {
+			if (! blks[missing[i]]) continue;
+
+			vector <size_t> bcoord = offset_to_blk(
+				missing[i], bmin, bmax
+			);
+			_unlock_blocks(blks[missing[i]]);
+			_free_region(ts, varname, level, lod, bcoord, bcoord);
+			blks[missing[i]] = NULL;
+		}
+		_unlock_blocks(blks);
+		blks.clear();
+		return(-1);
+	}
+
+	for (size_t i=0; i<missing.size(); i++) {
+		_record_miss(blks[missing[i]], costs[i], block_size * sizeof(T));
+	}
+
+	SetDiagMsg("DataMgr::_get_blocks() - data read from fs\n");
+	return(0);
+}
+
 template <typename T>
 int DataMgr::_get_regions(
 	size_t ts, 
@@ -1935,13 +3114,43 @@ void	*DataMgr::_alloc_region(
 	assert(bmin.size() == bmax.size());
 	assert(bmin.size() == bs.size());
 
+	size_t size = element_sz;
+	for (int i=0; i<bmin.size(); i++) {
+		size *= (bmax[i]-bmin[i]+1) * bs[i];
+	}
+
+	return(_alloc_region(
+		ts, varname, level, lod, bmin, bmax, size, LOSSLESS, lock, fill
+	));
+}
+
+// Allocate a region of size bytes, holding data encoded with mode
+//
+void	*DataMgr::_alloc_region(
+	size_t ts,
+	string varname,
+	int level,
+	int lod,
+	vector <size_t> bmin,
+	vector <size_t> bmax,
+	size_t size,
+	CompressedCacheMode mode,
+	bool	lock,
+	bool fill
+) {
+	std::unique_lock <std::recursive_mutex> guard(_cacheMutex);
+
 	size_t mem_block_size;
 	if (! _blk_mem_mgr) {
 
-		mem_block_size = 1024 * 1024;
+		// Small allocation unit: structured-grid data are cached one
+		// block at a time, and 2D blocks may be only a few KBs
+		//
+		mem_block_size = 4 * 1024;
 
 		size_t num_blks = (_mem_size * 1024 * 1024) / mem_block_size;
 
+		BlkMemMgr::RequestBacking(_memBacking, _memBackingDir);
 		BlkMemMgr::RequestMemSize(mem_block_size, num_blks);
 		_blk_mem_mgr = new BlkMemMgr();
 	}
@@ -1951,20 +3160,24 @@ void	*DataMgr::_alloc_region(
 	//
 	_free_region(ts,varname,level,lod,bmin,bmax);
 
-
-	size_t size = element_sz;
-	for (int i=0; i<bmin.size(); i++) {
-		size *= (bmax[i]-bmin[i]+1) * bs[i];
-	}
-	
 	size_t nblocks = (size_t) ceil((double) size / (double) mem_block_size);
 		
+	// Victims are compressed into the second tier and freed without 
+	// holding the cache lock (unless the caller holds it), so cache hits
+	// in other threads aren't blocked. The caller holds the region's
+	// I/O lock, so no other thread can add this region meanwhile.
+	//
 	void *blks;
 	while (! (blks = (void *) _blk_mem_mgr->Alloc(nblocks, fill))) {
-		if (! _free_lru()) {
+		EvictedRegion evicted;
+		if (! _evict_lru(evicted)) {
 			SetErrMsg("Failed to allocate requested memory");
 			return(NULL);
 		}
+
+		guard.unlock();
+		_release_evicted(evicted);
+		guard.lock();
 	}
 
 	region_t region;
@@ -1977,8 +3190,16 @@ void	*DataMgr::_alloc_region(
 	region.bmax = bmax;
 	region.lock_counter = lock ? 1 : 0;
 	region.blks = blks;
+	region.epoch = InPrefetchThread ? 0 : _request_epoch();
+	region.size = size;
+	region.cost = 0.0;
+	region.loaded = false;
+	region.mode = mode;
+
+	region.stats = _var_stats(varname, level, lod);
 
-	_regionsList.push_back(region);
+	region_t *cached = _regionCache.Insert(region);
+	_cachePolicy->Insert(cached, cached->size, cached->cost);
 
 	return(region.blks);
 }
@@ -1992,24 +3213,16 @@ void	DataMgr::_free_region(
 	vector <size_t> bmax
 ) {
 
-	list <region_t>::iterator itr;
-	for(itr = _regionsList.begin(); itr!=_regionsList.end(); itr++) {
-		const region_t &region = *itr;
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
 
-		if (region.ts == ts &&
-			region.varname.compare(varname) == 0 &&
-			region.level == level &&
-			region.lod == lod &&
-			region.bmin == bmin &&
-			region.bmax == bmax)  {
+	// Freeing a region is not a use of it
+	//
+	region_t *region = _regionCache.Peek(ts, varname, level, lod, bmin, bmax);
+	if (region && region->lock_counter == 0) {
+		if (region->blks) _blk_mem_mgr->FreeMem(region->blks);
 
-			if (region.lock_counter == 0) {
-				if (region.blks) _blk_mem_mgr->FreeMem(region.blks);
-				
-				_regionsList.erase(itr);
-				return;
-			}
-		}
+		_cachePolicy->Erase(region);
+		_regionCache.Erase(region);
 	}
 
 	return;
@@ -2018,41 +3231,451 @@ void	DataMgr::_free_region(
 
 void	DataMgr::_free_var(string varname) {
 
-	list <region_t>::iterator itr;
-	for(itr = _regionsList.begin(); itr!=_regionsList.end(); ) {
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	RegionCache::iterator itr;
+	for(itr = _regionCache.begin(); itr!=_regionCache.end(); ) {
 		const region_t &region = *itr;
 
 		if (region.varname.compare(varname) == 0) {
 
 			if (region.blks) _blk_mem_mgr->FreeMem(region.blks);
 				
-			_regionsList.erase(itr);
-			itr = _regionsList.begin();
+			_cachePolicy->Erase(&region);
+			itr = _regionCache.Erase(itr);
 		}
 		else itr++;
 	}
 
+	_compressedCache.EraseVar(varname);
+}
+
+
+// Remove the region selected by the eviction policy from the cache. 
+// Ownership of its memory passes to the caller, who must pass it to 
+// _release_evicted()
+//
+bool	DataMgr::_evict_lru(EvictedRegion &evicted) {
+
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	// Locked regions can't be freed, nor can regions whose data are 
+	// still being produced. The prefetch thread may not evict regions 
+	// used by the caller's most recent request: they may belong to an
+	// unlocked grid that is still in use.
+	//
+	size_t epoch = _epoch;
+	region_t *region = (region_t *) _cachePolicy->Victim(
+		[epoch](const void *id) {
+			const region_t *r = (const region_t *) id;
+
+			if (InPrefetchThread && r->epoch == epoch) return(false);
+			return(r->lock_counter == 0 && r->loaded);
+		}
+	);
+
+	// nothing to free
+	if (! region) return(false);
+
+	// Remember the region so that a later re-read can be counted
+	//
+	RegionCache::Key key = _regionCache.MakeKey(*region);
+	_evictedKeys[key]++;
+	_evictedKeyQueue.push_back(key);
+	if (_evictedKeyQueue.size() > MaxEvictedKeys) {
+		auto itr = _evictedKeys.find(_evictedKeyQueue.front());
+		if (itr != _evictedKeys.end() && --(itr->second) <= 0) {
+			_evictedKeys.erase(itr);
+		}
+		_evictedKeyQueue.pop_front();
+	}
+	_cacheStats.evictions++;
+
+	evicted.key = key;
+	evicted.varname = region->varname;
+	evicted.blks = region->blks;
+	evicted.size = region->size;
+	evicted.cost = region->cost;
+	evicted.encoded = region->mode != LOSSLESS;
+	if (region->blks && _compressedCache.GetMaxSize()) {
+		evicted.isFloat = _compressedCache.GetMode() != LOSSLESS && 
+			_is_float_var(region->varname, evicted.hasMissing, evicted.mv);
+	}
+
+	_cachePolicy->Erase(region);
+	_regionCache.Erase(region);
+	return(true);
 }
 
+// Add an evicted region to the compressed second tier, if enabled, and
+// free its memory. May be called without holding _cacheMutex
+//
+void	DataMgr::_release_evicted(const EvictedRegion &evicted) {
+	if (! evicted.blks) return;
+
+	if (_compressedCache.GetMaxSize() && ! evicted.encoded) {
+		_compressedCache.Insert(
+			evicted.key, evicted.varname, evicted.blks, evicted.size, 
+			evicted.cost, evicted.isFloat, evicted.hasMissing, evicted.mv
+		);
+	}
 
-bool	DataMgr::_free_lru(
+	_blk_mem_mgr->FreeMem(evicted.blks);
+}
+
+// Return true if the regions of a variable hold floats, which may be 
+// stored with reduced precision by the compressed cache. Connectivity 
+// and other auxiliary variables are integers.
+//
+bool	DataMgr::_is_float_var(
+	const string &varname, bool &hasMissing, float &mv
+) const {
+	hasMissing = false;
+	mv = 0.0;
+
+	DC::DataVar dvar;
+	if (GetDataVarInfo(varname, dvar)) {
+		hasMissing = dvar.GetHasMissing();
+		mv = dvar.GetMissingValue();
+		return(true);
+	}
+
+	DC::CoordVar cvar;
+	return(GetCoordVarInfo(varname, cvar));
+}
+
+// Return the statistics for a variable at a level and lod, adding them
+// if needed. A variable is seldom read at more than a few levels and
+// lods, so they are searched linearly.
+//
+DataMgr::VarStats *DataMgr::_var_stats(
+	const string &varname, int level, int lod
 ) {
+	std::deque <VarStats> &stats = _varStats[varname];
+	for (int i=0; i<stats.size(); i++) {
+		if (stats[i].level == level && stats[i].lod == lod) return(&stats[i]);
+	}
+
+	stats.push_back(VarStats());
+	VarStats &vs = stats.back();
+	vs.varname = varname;
+	vs.level = level;
+	vs.lod = lod;
+	return(&vs);
+}
+
+// Record the cost of producing a region that was not in the cache, and
+// make its data available to other threads. rawSize is the size of the
+// region's data before they were encoded, if they were
+//
+void	DataMgr::_record_miss(const void *blks, double cost, size_t rawSize) {
+
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	region_t *region = _regionCache.Find(blks);
+	if (! region) return;
+
+	region->loaded = true;
+	region->cost = cost;
+	_cachePolicy->SetCost(region, cost);
+
+	if (! rawSize) rawSize = region->size;
 
-	// The least recently used region is at the front of the list
+	_cacheStats.misses++;
+	_cacheStats.bytes_read += rawSize;
+	if (_evictedKeys.count(_regionCache.MakeKey(*region))) {
+		_cacheStats.bytes_reread += rawSize;
+	}
+	if (region->mode != LOSSLESS) {
+		_cacheStats.reduced_bytes += region->size;
+		_cacheStats.reduced_raw_bytes += rawSize;
+	}
+
+	if (_getDerivedVar(region->varname)) _cacheStats.derived_time += cost;
+	else _cacheStats.read_time += cost;
+
+	if (region->stats) {
+		region->stats->misses++;
+		region->stats->bytes_read += rawSize;
+		region->stats->read_time += cost;
+	}
+}
+
+// Give a grid a decoder for those of its blocks that are stored with 
+// reduced precision, if any. The blocks must be locked
+//
+void	DataMgr::_set_block_decoder(
+	Grid *g, const string &varname, const vector <float *> &blks
+) {
+	vector <CompressedCacheMode> modes(blks.size(), LOSSLESS);
+	vector <size_t> sizes(blks.size(), 0);
+	bool encoded = false;
+	{
+		std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+		for (size_t b=0; b<blks.size(); b++) {
+			const region_t *region = _regionCache.Find(blks[b]);
+			if (! region || region->mode == LOSSLESS) continue;
+
+			modes[b] = region->mode;
+			sizes[b] = region->size;
+			encoded = true;
+		}
+	}
+	if (! encoded) return;
+
+	bool hasMissing;
+	float mv;
+	(void) _is_float_var(varname, hasMissing, mv);
+	size_t n = vproduct(g->GetBlockSize());
+
+	g->SetBlockDecoder(
+		[modes, sizes, hasMissing, mv, n](
+			size_t b, const float *blk, float *buf
+		) -> const float * {
+			if (modes[b] == LOSSLESS) return(blk);
+
+			bool ok = CompressedRegionCache::DecodeReduced(
+				(const unsigned char *) blk, sizes[b], modes[b], 
+				hasMissing, mv, buf, n
+			);
+			assert(ok);
+			if (! ok) std::fill(buf, buf + n, hasMissing ? mv : 0.0f);
+			return(buf);
+		}
+	);
+}
+
+// Return the lock serializing cache misses on a variable's time step.
+// Time steps of all variables share NumIOLocks locks, so the number of
+// locks doesn't grow with the number of variables and time steps read
+//
+std::recursive_mutex &DataMgr::_io_lock(size_t ts, string varname) {
+
+	size_t h = std::hash <string> ()(varname);
+	h ^= ts + 0x9e3779b9 + (h << 6) + (h >> 2);
+	return(_ioLocks[h % NumIOLocks]);
+}
+
+int	DataMgr::SetCachePolicy(string name) {
+	CachePolicy *policy = CachePolicy::Create(name);
+	if (! policy) {
+		SetErrMsg("Unknown cache policy : %s", name.c_str());
+		return(-1);
+	}
+	SetCachePolicy(policy);
+	return(0);
+}
+
+void	DataMgr::SetCachePolicy(CachePolicy *policy) {
+	assert(policy);
+
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	if (policy == _cachePolicy) return;
+
+	if (_cachePolicy) delete _cachePolicy;
+	_cachePolicy = policy;
+
+	// Hand the regions already cached to the new policy, from least to
+	// most recently used
 	//
-	list <region_t>::iterator itr;
-	for(itr = _regionsList.begin(); itr!=_regionsList.end(); itr++) {
-		const region_t &region = *itr;
+	RegionCache::iterator itr;
+	for(itr = _regionCache.begin(); itr!=_regionCache.end(); ++itr) {
+		_cachePolicy->Insert(&(*itr), itr->size, itr->cost);
+	}
+}
 
-		if (region.lock_counter == 0) {
-			if (region.blks) _blk_mem_mgr->FreeMem(region.blks);
-			_regionsList.erase(itr);
-			return(true);
+string	DataMgr::GetCachePolicy() const {
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	return(_cachePolicy->GetName());
+}
+
+DataMgr::CacheStats	DataMgr::GetCacheStats() const {
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	CacheStats stats = _cacheStats;
+
+	for (auto itr = _varStats.begin(); itr != _varStats.end(); ++itr) {
+		stats.vars.insert(
+			stats.vars.end(), itr->second.begin(), itr->second.end()
+		);
+	}
+	std::sort(
+		stats.vars.begin(), stats.vars.end(),
+		[](const VarStats &a, const VarStats &b) {
+			if (a.varname != b.varname) return(a.varname < b.varname);
+			if (a.level != b.level) return(a.level < b.level);
+			return(a.lod < b.lod);
+		}
+	);
+
+	stats.compressed_bytes = _compressedCache.GetSize();
+	stats.compressed_raw_bytes = _compressedCache.GetRawSize();
+
+	if (_blk_mem_mgr) {
+		BlkMemMgr::Stats mstats = BlkMemMgr::GetStats();
+		size_t blk_size = BlkMemMgr::GetBlkSize();
+		stats.mem_used = (mstats.total_blks - mstats.free_blks) * blk_size;
+		stats.mem_peak = mstats.peak_used_blks * blk_size;
+	}
+
+	return(stats);
+}
+
+void	DataMgr::ResetCacheStats() {
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	_cacheStats = CacheStats();
+
+	// Cached regions point to the per-variable statistics, so reset
+	// them in place
+	//
+	for (auto itr = _varStats.begin(); itr != _varStats.end(); ++itr) {
+		for (int i=0; i<itr->second.size(); i++) {
+			VarStats &vs = itr->second[i];
+			vs.hits = vs.misses = vs.bytes_read = 0;
+			vs.read_time = 0.0;
 		}
 	}
 
-	// nothing to free
-	return(false);
+	if (_blk_mem_mgr) BlkMemMgr::ResetPeakUsage();
+}
+
+namespace {
+
+string json_string(const string &s) {
+	string js = "\"";
+	for (int i=0; i<s.size(); i++) {
+		if (s[i] == '"' || s[i] == '\\') js += '\\';
+		js += s[i];
+	}
+	js += "\"";
+	return(js);
+}
+
+};
+
+string	DataMgr::CacheStats::ToJSON() const {
+	ostringstream oss;
+
+	oss << "{\n";
+	oss << "  \"hits\": " << hits << ",\n";
+	oss << "  \"misses\": " << misses << ",\n";
+	oss << "  \"hit_ratio\": " << HitRatio() << ",\n";
+	oss << "  \"evictions\": " << evictions << ",\n";
+	oss << "  \"bytes_read\": " << bytes_read << ",\n";
+	oss << "  \"bytes_reread\": " << bytes_reread << ",\n";
+	oss << "  \"compressed_hits\": " << compressed_hits << ",\n";
+	oss << "  \"compressed_bytes\": " << compressed_bytes << ",\n";
+	oss << "  \"compressed_raw_bytes\": " << compressed_raw_bytes << ",\n";
+	oss << "  \"compressed_max_error\": " << compressed_max_error << ",\n";
+	oss << "  \"reduced_bytes\": " << reduced_bytes << ",\n";
+	oss << "  \"reduced_raw_bytes\": " << reduced_raw_bytes << ",\n";
+	oss << "  \"reduced_max_error\": " << reduced_max_error << ",\n";
+	oss << "  \"read_time\": " << read_time << ",\n";
+	oss << "  \"derived_time\": " << derived_time << ",\n";
+	oss << "  \"bounding_grid_time\": " << bounding_grid_time << ",\n";
+	oss << "  \"bounding_grid_calls\": " << bounding_grid_calls << ",\n";
+	oss << "  \"mem_used\": " << mem_used << ",\n";
+	oss << "  \"mem_peak\": " << mem_peak << ",\n";
+	oss << "  \"vars\": [";
+	for (int i=0; i<vars.size(); i++) {
+		const VarStats &vs = vars[i];
+		oss << (i ? ",\n" : "\n");
+		oss << "    {\"varname\": " << json_string(vs.varname)
+			<< ", \"level\": " << vs.level 
+			<< ", \"lod\": " << vs.lod
+			<< ", \"hits\": " << vs.hits
+			<< ", \"misses\": " << vs.misses
+			<< ", \"bytes_read\": " << vs.bytes_read
+			<< ", \"read_time\": " << vs.read_time << "}";
+	}
+	oss << (vars.size() ? "\n  ]\n" : "]\n");
+	oss << "}\n";
+
+	return(oss.str());
+}
+
+void	DataMgr::SetCompressedCacheSize(size_t mem_size) {
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	_compressedCache.SetMaxSize(mem_size * 1024 * 1024);
+}
+
+size_t	DataMgr::GetCompressedCacheSize() const {
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	return(_compressedCache.GetMaxSize() / (1024 * 1024));
+}
+
+void	DataMgr::SetCompressedCacheMode(
+	CompressedCacheMode mode, double tolerance
+) {
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	_compressedCache.SetMode(mode, tolerance < 0.0 ? 0.0 : tolerance);
+}
+
+DataMgr::CompressedCacheMode	DataMgr::GetCompressedCacheMode() const {
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	return(_compressedCache.GetMode());
+}
+
+double	DataMgr::GetCompressedCacheTolerance() const {
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	return(_compressedCache.GetTolerance());
+}
+
+void	DataMgr::SetCacheStorageMode(
+	CompressedCacheMode mode, double tolerance
+) {
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	_storageMode = mode;
+	_storageTolerance = tolerance < 0.0 ? 0.0 : tolerance;
+}
+
+DataMgr::CompressedCacheMode	DataMgr::GetCacheStorageMode() const {
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	return(_storageMode);
+}
+
+double	DataMgr::GetCacheStorageTolerance() const {
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
+
+	return(_storageTolerance);
+}
+
+void	DataMgr::SetKDTreeCacheDir(string dir) {
+	std::lock_guard <std::mutex> guard(_kdtreeMutex);
+
+	_kdtreeCacheDir = dir;
+}
+
+string	DataMgr::GetKDTreeCacheDir() const {
+	std::lock_guard <std::mutex> guard(_kdtreeMutex);
+
+	return(_kdtreeCacheDir);
+}
+
+void	DataMgr::SetFastTransform(bool enable) {
+	std::lock_guard <std::recursive_mutex> guard(_dcMutex);
+
+	_fastTransform = enable;
+
+	VDCNetCDF *vdc = dynamic_cast <VDCNetCDF *> (_dc);
+	if (vdc) vdc->SetFastTransform(enable);
+}
+
+bool	DataMgr::GetFastTransform() const {
+	std::lock_guard <std::recursive_mutex> guard(_dcMutex);
+
+	return(_fastTransform);
 }
 	
 
@@ -2399,6 +4022,8 @@ void DataMgr::VarInfoCache::Set(
 	const vector <size_t> &values
 ) {
 	string hash = _make_hash(key, ts, varnames, level, lod);
+
+	std::lock_guard <std::mutex> guard(_mutex);
 	_cacheSize_t[hash] = values;
 }
 
@@ -2409,6 +4034,8 @@ bool DataMgr::VarInfoCache::Get(
 	values.clear();
 
 	string hash = _make_hash(key, ts, varnames, level, lod);
+
+	std::lock_guard <std::mutex> guard(_mutex);
 	map <string, vector <size_t> >::const_iterator itr = _cacheSize_t.find(hash);
 
 	if (itr == _cacheSize_t.end()) return(false);
@@ -2421,6 +4048,8 @@ void DataMgr::VarInfoCache::PurgeSize_t(
 	size_t ts, vector <string> varnames, int level, int lod, string key
 ) {
 	string hash = _make_hash(key, ts, varnames, level, lod);
+
+	std::lock_guard <std::mutex> guard(_mutex);
 	map <string, vector <size_t> >::iterator itr = _cacheSize_t.find(hash);
 
 	if (itr == _cacheSize_t.end()) return;
@@ -2433,6 +4062,8 @@ void DataMgr::VarInfoCache::Set(
 	const vector <double> &values
 ) {
 	string hash = _make_hash(key, ts, varnames, level, lod);
+
+	std::lock_guard <std::mutex> guard(_mutex);
 	_cacheDouble[hash] = values;
 }
 
@@ -2443,6 +4074,8 @@ bool DataMgr::VarInfoCache::Get(
 	values.clear();
 
 	string hash = _make_hash(key, ts, varnames, level, lod);
+
+	std::lock_guard <std::mutex> guard(_mutex);
 	map <string, vector <double> >::const_iterator itr = _cacheDouble.find(hash);
 
 	if (itr == _cacheDouble.end()) return(false);
@@ -2455,6 +4088,8 @@ void DataMgr::VarInfoCache::PurgeDouble(
 	size_t ts, vector <string> varnames, int level, int lod, string key
 ) {
 	string hash = _make_hash(key, ts, varnames, level, lod);
+
+	std::lock_guard <std::mutex> guard(_mutex);
 	map <string, vector <double> >::iterator itr = _cacheDouble.find(hash);
 
 	if (itr == _cacheDouble.end()) return;
@@ -2467,6 +4102,8 @@ void DataMgr::VarInfoCache::Set(
 	const vector <void *> &values
 ) {
 	string hash = _make_hash(key, ts, varnames, level, lod);
+
+	std::lock_guard <std::mutex> guard(_mutex);
 	_cacheVoidPtr[hash] = values;
 }
 
@@ -2477,6 +4114,8 @@ bool DataMgr::VarInfoCache::Get(
 	values.clear();
 
 	string hash = _make_hash(key, ts, varnames, level, lod);
+
+	std::lock_guard <std::mutex> guard(_mutex);
 	map <string, vector <void *> >::const_iterator itr = _cacheVoidPtr.find(hash);
 
 	if (itr == _cacheVoidPtr.end()) return(false);
@@ -2489,11 +4128,716 @@ void DataMgr::VarInfoCache::PurgeVoidPtr(
 	size_t ts, vector <string> varnames, int level, int lod, string key
 ) {
 	string hash = _make_hash(key, ts, varnames, level, lod);
+
+	std::lock_guard <std::mutex> guard(_mutex);
 	map <string, vector <void *> >::iterator itr = _cacheVoidPtr.find(hash);
 
-	if (itr == _cacheVoidPtr.end()) return;
+	if (itr == _cacheVoidPtr.end()) return;
+
+	_cacheVoidPtr.erase(itr);
+}
+
+bool DataMgr::RegionCache::Key::operator==(const Key &k) const {
+	if (varid != k.varid || ts != k.ts || level != k.level || lod != k.lod) {
+		return(false);
+	}
+	if (ndim != k.ndim) return(false);
+
+	for (int i=0; i<ndim; i++) {
+		if (bmin[i] != k.bmin[i] || bmax[i] != k.bmax[i]) return(false);
+	}
+	return(true);
+}
+
+size_t DataMgr::RegionCache::KeyHash::operator()(const Key &k) const {
+
+	// Combine hashes of the individual fields (see boost::hash_combine)
+	//
+	std::hash <size_t> h;
+	size_t seed = h(k.ts);
+	seed ^= h(k.varid) + 0x9e3779b9 + (seed<<6) + (seed>>2);
+	seed ^= h(k.level) + 0x9e3779b9 + (seed<<6) + (seed>>2);
+	seed ^= h(k.lod) + 0x9e3779b9 + (seed<<6) + (seed>>2);
+	for (int i=0; i<k.ndim; i++) {
+		seed ^= h(k.bmin[i]) + 0x9e3779b9 + (seed<<6) + (seed>>2);
+		seed ^= h(k.bmax[i]) + 0x9e3779b9 + (seed<<6) + (seed>>2);
+	}
+	return(seed);
+}
+
+bool DataMgr::RegionCache::_make_key(
+	size_t ts, const string &varname, int level, int lod,
+	const vector <size_t> &bmin, const vector <size_t> &bmax,
+	bool intern, Key &key
+) {
+	assert(bmin.size() == bmax.size());
+	assert(bmin.size() <= 3);
+
+	unordered_map <string, int>::const_iterator itr = _varIds.find(varname);
+	if (itr == _varIds.end()) {
+		if (! intern) return(false);
+
+		int id = _varIds.size();
+		_varIds[varname] = id;
+		key.varid = id;
+	}
+	else {
+		key.varid = itr->second;
+	}
+
+	key.ts = ts;
+	key.level = level;
+	key.lod = lod;
+	key.ndim = bmin.size();
+	for (int i=0; i<3; i++) {
+		key.bmin[i] = i < bmin.size() ? bmin[i] : 0;
+		key.bmax[i] = i < bmax.size() ? bmax[i] : 0;
+	}
+	return(true);
+}
+
+void DataMgr::RegionCache::_unindex(iterator itr) {
+	const region_t &region = *itr;
+
+	Key key;
+	if (_make_key(
+		region.ts, region.varname, region.level, region.lod,
+		region.bmin, region.bmax, false, key
+	)) {
+		unordered_map <Key, iterator, KeyHash>::iterator kitr;
+		kitr = _index.find(key);
+
+		// The tuple index may refer to a newer region with the same key
+		//
+		if (kitr != _index.end() && kitr->second == itr) _index.erase(kitr);
+	}
+
+	unordered_map <const void *, iterator>::iterator bitr;
+	bitr = _blksIndex.find(region.blks);
+	if (bitr != _blksIndex.end() && bitr->second == itr) _blksIndex.erase(bitr);
+}
+
+DataMgr::RegionCache::Key DataMgr::RegionCache::MakeKey(
+	size_t ts, const string &varname, int level, int lod,
+	const vector <size_t> &bmin, const vector <size_t> &bmax
+) {
+	Key key;
+	(void) _make_key(ts, varname, level, lod, bmin, bmax, true, key);
+	return(key);
+}
+
+DataMgr::RegionCache::Key DataMgr::RegionCache::MakeKey(
+	const region_t &region
+) {
+	return(MakeKey(
+		region.ts, region.varname, region.level, region.lod, 
+		region.bmin, region.bmax
+	));
+}
+
+// Return the list position of a region, or end() if it isn't cached
+//
+DataMgr::RegionCache::iterator DataMgr::RegionCache::_lookup(
+	size_t ts, const string &varname, int level, int lod,
+	const vector <size_t> &bmin, const vector <size_t> &bmax
+) {
+	Key key;
+	if (! _make_key(ts, varname, level, lod, bmin, bmax, false, key)) {
+		return(_lruList.end());
+	}
+
+	unordered_map <Key, iterator, KeyHash>::iterator kitr = _index.find(key);
+	if (kitr == _index.end()) return(_lruList.end());
+
+	return(kitr->second);
+}
+
+DataMgr::RegionCache::region_t *DataMgr::RegionCache::Find(
+	size_t ts, const string &varname, int level, int lod,
+	const vector <size_t> &bmin, const vector <size_t> &bmax
+) {
+	iterator itr = _lookup(ts, varname, level, lod, bmin, bmax);
+	if (itr == _lruList.end()) return(NULL);
+
+	// Move region to most recently used end of the list. Iterators
+	// remain valid after a splice
+	//
+	_lruList.splice(_lruList.end(), _lruList, itr);
+
+	return(&(*itr));
+}
+
+DataMgr::RegionCache::region_t *DataMgr::RegionCache::Peek(
+	size_t ts, const string &varname, int level, int lod,
+	const vector <size_t> &bmin, const vector <size_t> &bmax
+) {
+	iterator itr = _lookup(ts, varname, level, lod, bmin, bmax);
+	if (itr == _lruList.end()) return(NULL);
+
+	return(&(*itr));
+}
+
+DataMgr::RegionCache::region_t *DataMgr::RegionCache::Find(const void *blks) {
+
+	unordered_map <const void *, iterator>::iterator bitr;
+	bitr = _blksIndex.find(blks);
+	if (bitr == _blksIndex.end()) return(NULL);
+
+	return(&(*bitr->second));
+}
+
+DataMgr::RegionCache::region_t *DataMgr::RegionCache::Insert(
+	const region_t &region
+) {
+
+	Key key;
+	(void) _make_key(
+		region.ts, region.varname, region.level, region.lod,
+		region.bmin, region.bmax, true, key
+	);
+
+	iterator itr = _lruList.insert(_lruList.end(), region);
+
+	_index[key] = itr;
+	if (region.blks) _blksIndex[region.blks] = itr;
+
+	return(&(*itr));
+}
+
+DataMgr::RegionCache::iterator DataMgr::RegionCache::Erase(iterator itr) {
+	_unindex(itr);
+	return(_lruList.erase(itr));
+}
+
+void DataMgr::RegionCache::Erase(const region_t *region) {
+
+	// Locate list position via the blks index if possible, otherwise
+	// fall back to searching the list
+	//
+	unordered_map <const void *, iterator>::iterator bitr;
+	bitr = _blksIndex.find(region->blks);
+	if (bitr != _blksIndex.end() && &(*bitr->second) == region) {
+		Erase(bitr->second);
+		return;
+	}
+
+	for (iterator itr = _lruList.begin(); itr != _lruList.end(); ++itr) {
+		if (&(*itr) == region) {
+			Erase(itr);
+			return;
+		}
+	}
+}
+
+void DataMgr::RegionCache::Clear() {
+	_lruList.clear();
+	_index.clear();
+	_blksIndex.clear();
+	_varIds.clear();
+}
+
+void DataMgr::CompressedRegionCache::SetMaxSize(size_t max_size) {
+	std::lock_guard <std::mutex> guard(_mutex);
+
+	_maxSize = max_size;
+
+	while (_size > _maxSize && ! _fifo.empty()) {
+		_erase(_index.find(_fifo.front()));
+	}
+}
+
+void DataMgr::CompressedRegionCache::_erase(index_t::iterator itr) {
+	assert(itr != _index.end());
+
+	_size -= itr->second.data.size();
+	_rawSize -= itr->second.size;
+	_fifo.erase(itr->second.itr);
+	_index.erase(itr);
+}
+
+bool DataMgr::CompressedRegionCache::Insert(
+	const RegionCache::Key &key, const string &varname, const void *data, 
+	size_t size, double cost, bool isFloat, bool hasMissing, float mv
+) {
+	CompressedCacheMode mode;
+	double tolerance;
+	{
+		std::lock_guard <std::mutex> guard(_mutex);
+		mode = _mode;
+		tolerance = _tolerance;
+	}
+
+	// Encode without holding the lock
+	//
+	Entry e;
+	e.varname = varname;
+	e.size = size;
+	e.cost = cost;
+	e.mode = isFloat && size % sizeof(float) == 0 ? mode : LOSSLESS;
+	e.hasMissing = hasMissing;
+	e.mv = mv;
+	e.maxError = 0.0;
+	if (e.mode == LOSSLESS) {
+		Encode((const unsigned char *) data, size, e.data);
+	}
+	else {
+		EncodeReduced(
+			(const float *) data, size / sizeof(float), e.mode, tolerance,
+			hasMissing, mv, e.data, e.maxError
+		);
+	}
+
+	std::lock_guard <std::mutex> guard(_mutex);
+
+	index_t::iterator itr = _index.find(key);
+	if (itr != _index.end()) _erase(itr);
+
+	if (e.data.size() > _maxSize) return(false);
+
+	while (_size + e.data.size() > _maxSize && ! _fifo.empty()) {
+		_erase(_index.find(_fifo.front()));
+	}
+
+	_size += e.data.size();
+	_rawSize += e.size;
+	_fifo.push_back(key);
+	e.itr = --_fifo.end();
+	_index[key] = std::move(e);
+
+	return(true);
+}
+
+bool DataMgr::CompressedRegionCache::Extract(
+	const RegionCache::Key &key, void *data, size_t size, double &cost, 
+	double &maxError
+) {
+	std::lock_guard <std::mutex> guard(_mutex);
+
+	index_t::iterator itr = _index.find(key);
+	if (itr == _index.end()) return(false);
+
+	const Entry &e = itr->second;
+	bool ok = e.size == size;
+	if (ok && e.mode == LOSSLESS) {
+		ok = Decode(e.data, (unsigned char *) data, size);
+	}
+	else if (ok) {
+		ok = DecodeReduced(
+			e.data.data(), e.data.size(), e.mode, e.hasMissing, e.mv, 
+			(float *) data, size / sizeof(float)
+		);
+	}
+
+	cost = e.cost;
+	maxError = e.maxError;
+	_erase(itr);
+	return(ok);
+}
+
+void DataMgr::CompressedRegionCache::EraseVar(const string &varname) {
+	std::lock_guard <std::mutex> guard(_mutex);
+
+	index_t::iterator itr;
+	for (itr = _index.begin(); itr != _index.end(); ) {
+		if (itr->second.varname == varname) {
+			_size -= itr->second.data.size();
+			_rawSize -= itr->second.size;
+			_fifo.erase(itr->second.itr);
+			itr = _index.erase(itr);
+		}
+		else ++itr;
+	}
+}
+
+void DataMgr::CompressedRegionCache::Clear() {
+	std::lock_guard <std::mutex> guard(_mutex);
+
+	_fifo.clear();
+	_index.clear();
+	_size = 0;
+	_rawSize = 0;
+}
+
+// Each 32-bit word is XOR'd with the previous word, and the number of 
+// significant (non-zero) low order bytes of the result, 0 to 4, is 
+// stored in a 4-bit code. The codes for all words come first, packed two
+// per byte, followed by the significant bytes of each word and finally 
+// any trailing bytes that don't make up a whole word. 
+//
+void DataMgr::CompressedRegionCache::Encode(
+	const unsigned char *src, size_t size, vector <unsigned char> &dst
+) {
+	size_t nwords = size / 4;
+	size_t ncodes = (nwords + 1) / 2;
+
+	dst.resize(ncodes + size);
+	unsigned char *codes = dst.data();
+	unsigned char *out = codes + ncodes;
+
+	memset(codes, 0, ncodes);
+
+	uint32_t prev = 0;
+	for (size_t i=0; i<nwords; i++) {
+		uint32_t w;
+		memcpy(&w, src + i*4, 4);
+		uint32_t x = w ^ prev;
+		prev = w;
+
+		unsigned char n = 0;
+		while (x) {
+			*out++ = (unsigned char) (x & 0xff);
+			x >>= 8;
+			n++;
+		}
+		codes[i/2] |= (i & 1) ? (n << 4) : n;
+	}
+
+	for (size_t i=nwords*4; i<size; i++) *out++ = src[i];
+
+	dst.resize(out - dst.data());
+	dst.shrink_to_fit();
+}
+
+bool DataMgr::CompressedRegionCache::Decode(
+	const vector <unsigned char> &src, unsigned char *dst, size_t size
+) {
+	size_t nwords = size / 4;
+	size_t ncodes = (nwords + 1) / 2;
+
+	if (src.size() < ncodes) return(false);
+
+	const unsigned char *codes = src.data();
+	const unsigned char *in = codes + ncodes;
+	const unsigned char *end = src.data() + src.size();
+
+	uint32_t prev = 0;
+	for (size_t i=0; i<nwords; i++) {
+		unsigned char n = (i & 1) ? (codes[i/2] >> 4) : (codes[i/2] & 0xf);
+		if (n > 4 || in + n > end) return(false);
+
+		uint32_t x = 0;
+		for (unsigned char j=0; j<n; j++) {
+			x |= (uint32_t) *in++ << (8*j);
+		}
+		prev ^= x;
+		memcpy(dst + i*4, &prev, 4);
+	}
+
+	size_t ntail = size - nwords*4;
+	if (in + ntail != end) return(false);
+
+	for (size_t i=0; i<ntail; i++) dst[nwords*4 + i] = *in++;
+
+	return(true);
+}
+
+namespace {
+
+// Values are encoded with reduced precision in chunks of this many
+//
+const size_t ReducedChunkSize = 4096;
+
+// Chunk encodings. Chunks that can't be encoded within the error bound
+// are stored as raw floats
+//
+const unsigned char ChunkRaw = 0;
+const unsigned char ChunkReduced = 1;
+
+// Half precision code for the missing value. A NaN that float_to_half()
+// never produces, as chunks containing NaNs are stored raw
+//
+const uint16_t HalfMissing = 0x7fff;
+
+inline uint32_t float_bits(float f) {
+	uint32_t u;
+	memcpy(&u, &f, sizeof(u));
+	return(u);
+}
+
+inline float bits_float(uint32_t u) {
+	float f;
+	memcpy(&f, &u, sizeof(f));
+	return(f);
+}
+
+// IEEE single to half precision, rounding to nearest even. Values too 
+// large for half precision become infinity. Branches are simple selects
+// so that loops over arrays can be vectorized.
+//
+inline uint16_t float_to_half(float x) {
+	const uint32_t f32infty = 255u << 23;
+	const uint32_t f16max = (127u + 16u) << 23;
+	const uint32_t denorm_magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+	uint32_t f = float_bits(x);
+	uint32_t sign = f & 0x80000000u;
+	f ^= sign;
+
+	uint16_t o;
+	if (f >= f16max) {
+		o = f > f32infty ? 0x7e00 : 0x7c00;
+	}
+	else if (f < (113u << 23)) {
+
+		// Subnormal or zero. Adding the magic number shifts the 
+		// mantissa into place, rounding it.
+		//
+		o = (uint16_t) (
+			float_bits(bits_float(f) + bits_float(denorm_magic)) - denorm_magic
+		);
+	}
+	else {
+		uint32_t mant_odd = (f >> 13) & 1;
+		f += ((uint32_t) (15 - 127) << 23) + 0xfff;
+		f += mant_odd;
+		o = (uint16_t) (f >> 13);
+	}
+	return(o | (uint16_t) (sign >> 16));
+}
+
+inline float half_to_float(uint16_t h) {
+	const uint32_t shifted_exp = 0x7c00u << 13;
+
+	uint32_t o = (uint32_t) (h & 0x7fff) << 13;
+	uint32_t exp = shifted_exp & o;
+	o += (uint32_t) (127 - 15) << 23;
+
+	if (exp == shifted_exp) {
+		o += (uint32_t) (128 - 16) << 23;	// Inf/NaN
+	}
+	else if (exp == 0) {
+		o += 1u << 23;						// zero or subnormal
+		o = float_bits(bits_float(o) - bits_float(113u << 23));
+	}
+	return(bits_float(o | ((uint32_t) (h & 0x8000) << 16)));
+}
+
+inline int reduced_bits(DataMgr::CompressedCacheMode mode) {
+	return(mode == DataMgr::QUANT8 ? 8 : 16);
+}
+
+// Find the range of the values in a chunk, excluding missing values.
+// Returns false if the chunk contains a non-finite value that isn't the
+// missing value.
+//
+bool chunk_range(
+	const float *src, size_t n, bool hasMissing, float mv, 
+	float &min, float &max
+) {
+	min = max = 0.0;
+	bool first = true;
+	for (size_t i=0; i<n; i++) {
+		if (hasMissing && src[i] == mv) continue;
+		if (! std::isfinite(src[i])) return(false);
+		if (first || src[i] < min) min = src[i];
+		if (first || src[i] > max) max = src[i];
+		first = false;
+	}
+	return(true);
+}
+
+// Encode a chunk of n values. Returns false, with dst unchanged, if the
+// error of any value would exceed tolerance times the range (max - min)
+// of the chunk's values, or the chunk contains a non-finite value that 
+// isn't the missing value. Bounding the error by the range rather than
+// the largest magnitude keeps the variation of data on a large offset.
+//
+template <typename CODE_T>
+bool encode_chunk_quant(
+	const float *src, size_t n, double tolerance, bool hasMissing, float mv,
+	vector <unsigned char> &dst, double &maxError
+) {
+	const CODE_T mvcode = std::numeric_limits<CODE_T>::max();
+
+	float min, max;
+	if (! chunk_range(src, n, hasMissing, mv, min, max)) return(false);
+	double range = (double) max - (double) min;
+
+	float step = (max - min) / (float) (mvcode - 1);
+	float scale = step > 0.0 ? 1.0 / step : 0.0;
+
+	size_t start = dst.size();
+	dst.resize(start + 1 + 2*sizeof(float) + n*sizeof(CODE_T));
+	unsigned char *ptr = dst.data() + start;
+	*ptr++ = ChunkReduced;
+	memcpy(ptr, &min, sizeof(min)); ptr += sizeof(min);
+	memcpy(ptr, &step, sizeof(step)); ptr += sizeof(step);
+
+	CODE_T codes[ReducedChunkSize];
+	double err = 0.0;
+	for (size_t i=0; i<n; i++) {
+		float q = (src[i] - min) * scale + 0.5f;
+		q = q < 0.0f ? 0.0f : (q > mvcode - 1 ? mvcode - 1 : q);
+		codes[i] = (CODE_T) q;
+
+		float v = min + (float) codes[i] * step;
+		double e = fabs(v - src[i]);
+		if (hasMissing && src[i] == mv) codes[i] = mvcode;
+		else if (! (e <= err)) err = e;		// propagates NaN
+	}
+	memcpy(ptr, codes, n*sizeof(CODE_T));
+
+	if (! (err <= tolerance * range)) {
+		dst.resize(start);
+		return(false);
+	}
+	if (range > 0.0) maxError = std::max(maxError, err / range);
+	return(true);
+}
+
+bool encode_chunk_half(
+	const float *src, size_t n, double tolerance, bool hasMissing, float mv,
+	vector <unsigned char> &dst, double &maxError
+) {
+	float min, max;
+	if (! chunk_range(src, n, hasMissing, mv, min, max)) return(false);
+	double range = (double) max - (double) min;
+
+	uint16_t codes[ReducedChunkSize];
+	double err = 0.0;
+	for (size_t i=0; i<n; i++) {
+		codes[i] = float_to_half(src[i]);
+		double e = fabs(half_to_float(codes[i]) - src[i]);
+		if (hasMissing && src[i] == mv) codes[i] = HalfMissing;
+		else if (! (e <= err)) err = e;
+	}
+
+	// Overflow to infinity makes err infinite
+	//
+	if (! (err <= tolerance * range)) return(false);
+	if (range > 0.0) maxError = std::max(maxError, err / range);
+
+	size_t start = dst.size();
+	dst.resize(start + 1 + n*sizeof(uint16_t));
+	dst[start] = ChunkReduced;
+	memcpy(dst.data() + start + 1, codes, n*sizeof(uint16_t));
+	return(true);
+}
+
+template <typename CODE_T>
+void decode_chunk_quant(
+	const unsigned char *ptr, size_t n, bool hasMissing, float mv, float *dst
+) {
+	const CODE_T mvcode = std::numeric_limits<CODE_T>::max();
+
+	float min, step;
+	memcpy(&min, ptr, sizeof(min)); ptr += sizeof(min);
+	memcpy(&step, ptr, sizeof(step)); ptr += sizeof(step);
+
+	CODE_T codes[ReducedChunkSize];
+	memcpy(codes, ptr, n*sizeof(CODE_T));
+
+	for (size_t i=0; i<n; i++) {
+		dst[i] = min + (float) codes[i] * step;
+	}
+	if (hasMissing) {
+		for (size_t i=0; i<n; i++) {
+			dst[i] = codes[i] == mvcode ? mv : dst[i];
+		}
+	}
+}
+
+void decode_chunk_half(
+	const unsigned char *ptr, size_t n, bool hasMissing, float mv, float *dst
+) {
+	uint16_t codes[ReducedChunkSize];
+	memcpy(codes, ptr, n*sizeof(uint16_t));
+
+	for (size_t i=0; i<n; i++) {
+		dst[i] = half_to_float(codes[i]);
+	}
+	if (hasMissing) {
+		for (size_t i=0; i<n; i++) {
+			dst[i] = codes[i] == HalfMissing ? mv : dst[i];
+		}
+	}
+}
+
+};
+
+// Values are encoded in chunks of ReducedChunkSize. Each chunk starts
+// with a byte giving its encoding. A reduced precision chunk is followed
+// by its codes, preceded by the offset and step as floats if quantized.
+// A raw chunk is followed by the floats themselves.
+//
+void DataMgr::CompressedRegionCache::EncodeReduced(
+	const float *src, size_t n, CompressedCacheMode mode, double tolerance,
+	bool hasMissing, float mv, vector <unsigned char> &dst, double &maxError
+) {
+	assert(mode != LOSSLESS);
+
+	dst.clear();
+	dst.reserve(n * sizeof(float) / (mode == QUANT8 ? 4 : 2) + 64);
+	maxError = 0.0;
+
+	for (size_t i0=0; i0<n; i0+=ReducedChunkSize) {
+		size_t nc = std::min(ReducedChunkSize, n - i0);
+
+		bool ok;
+		if (mode == HALF) {
+			ok = encode_chunk_half(
+				src + i0, nc, tolerance, hasMissing, mv, dst, maxError
+			);
+		}
+		else if (reduced_bits(mode) == 8) {
+			ok = encode_chunk_quant<uint8_t>(
+				src + i0, nc, tolerance, hasMissing, mv, dst, maxError
+			);
+		}
+		else {
+			ok = encode_chunk_quant<uint16_t>(
+				src + i0, nc, tolerance, hasMissing, mv, dst, maxError
+			);
+		}
+
+		if (! ok) {
+			size_t start = dst.size();
+			dst.resize(start + 1 + nc*sizeof(float));
+			dst[start] = ChunkRaw;
+			memcpy(dst.data() + start + 1, src + i0, nc*sizeof(float));
+		}
+	}
+	dst.shrink_to_fit();
+}
+
+bool DataMgr::CompressedRegionCache::DecodeReduced(
+	const unsigned char *src, size_t size, CompressedCacheMode mode, 
+	bool hasMissing, float mv, float *dst, size_t n
+) {
+	assert(mode != LOSSLESS);
+
+	size_t codesz = mode == QUANT8 ? 1 : 2;
+	size_t hdrsz = mode == HALF ? 0 : 2*sizeof(float);
 
-	_cacheVoidPtr.erase(itr);
+	const unsigned char *ptr = src;
+	const unsigned char *end = src + size;
+	for (size_t i0=0; i0<n; i0+=ReducedChunkSize) {
+		size_t nc = std::min(ReducedChunkSize, n - i0);
+
+		if (ptr >= end) return(false);
+		unsigned char kind = *ptr++;
+
+		if (kind == ChunkRaw) {
+			if (ptr + nc*sizeof(float) > end) return(false);
+			memcpy(dst + i0, ptr, nc*sizeof(float));
+			ptr += nc*sizeof(float);
+			continue;
+		}
+		if (kind != ChunkReduced) return(false);
+		if (ptr + hdrsz + nc*codesz > end) return(false);
+
+		if (mode == HALF) {
+			decode_chunk_half(ptr, nc, hasMissing, mv, dst + i0);
+		}
+		else if (mode == QUANT8) {
+			decode_chunk_quant<uint8_t>(ptr, nc, hasMissing, mv, dst + i0);
+		}
+		else {
+			decode_chunk_quant<uint16_t>(ptr, nc, hasMissing, mv, dst + i0);
+		}
+		ptr += hdrsz + nc*codesz;
+	}
+	return(ptr == end);
 }
 
 DataMgr::BlkExts::BlkExts() {
@@ -2501,6 +4845,7 @@ DataMgr::BlkExts::BlkExts() {
 	_bmax.clear();
 	_mins.clear();
 	_maxs.clear();
+	_nodes.clear();
 }
 	
 
@@ -2515,8 +4860,11 @@ DataMgr::BlkExts::BlkExts(
 
 	size_t nelements = Wasp::LinearizeCoords(bmax, bmin, bmax) + 1;
 
-	_mins.resize(nelements);
-	_maxs.resize(nelements);
+	// Unused coordinates have infinite extents, so never prevent
+	// an intersection
+	//
+	_mins.assign(3 * nelements, -std::numeric_limits<double>::infinity());
+	_maxs.assign(3 * nelements, std::numeric_limits<double>::infinity());
 }
 
 void DataMgr::BlkExts::Insert(
@@ -2524,12 +4872,80 @@ void DataMgr::BlkExts::Insert(
     const std::vector <double> &min,
     const std::vector <double> &max
 ) {
+	assert(min.size() == max.size());
 
 	size_t offset = Wasp::LinearizeCoords(bcoord, _bmin, _bmax);
 
-	_mins[offset] = min;
-	_maxs[offset] = max;
+	for (int i=0; i<min.size() && i<3; i++) {
+		_mins[3*offset + i] = min[i];
+		_maxs[3*offset + i] = max[i];
+	}
+}
+
+void DataMgr::BlkExts::Build() {
+	_nodes.clear();
+	if (_mins.empty()) return;
+
+	size_t bmin[3] = {0,0,0};
+	size_t bmax[3] = {0,0,0};
+	for (int i=0; i<_bmin.size(); i++) {
+		bmin[i] = _bmin[i];
+		bmax[i] = _bmax[i];
+	}
+
+	_nodes.reserve(2 * GetNumBlocks() - 1);
+	(void) _build(bmin, bmax);
+}
+
+// Append the subtree for the blocks with block coordinates bmin 
+// through bmax, and return the index of its root
+//
+size_t DataMgr::BlkExts::_build(const size_t bmin[3], const size_t bmax[3]) {
+	size_t index = _nodes.size();
+	_nodes.push_back(Node());
+
+	int axis = 0;
+	for (int i=1; i<3; i++) {
+		if (bmax[i] - bmin[i] > bmax[axis] - bmin[axis]) axis = i;
+	}
+
+	Node node;
+	for (int i=0; i<3; i++) {
+		node.bmin[i] = bmin[i];
+		node.bmax[i] = bmax[i];
+	}
+	node.right = 0;
+
+	if (bmin[axis] == bmax[axis]) {
+
+		// Leaf: a single block
+		//
+		vector <size_t> bcoord(bmin, bmin + _bmin.size());
+		size_t offset = Wasp::LinearizeCoords(bcoord, _bmin, _bmax);
+		for (int i=0; i<3; i++) {
+			node.min[i] = _mins[3*offset + i];
+			node.max[i] = _maxs[3*offset + i];
+		}
+	}
+	else {
+		size_t mid = bmin[axis] + (bmax[axis] - bmin[axis]) / 2;
+
+		size_t lmax[3] = {bmax[0], bmax[1], bmax[2]};
+		lmax[axis] = mid;
+		size_t rmin[3] = {bmin[0], bmin[1], bmin[2]};
+		rmin[axis] = mid + 1;
+
+		size_t left = _build(bmin, lmax);
+		node.right = _build(rmin, bmax);
+
+		for (int i=0; i<3; i++) {
+			node.min[i] = std::min(_nodes[left].min[i], _nodes[node.right].min[i]);
+			node.max[i] = std::max(_nodes[left].max[i], _nodes[node.right].max[i]);
+		}
+	}
 
+	_nodes[index] = node;
+	return(index);
 }
 
 bool DataMgr::BlkExts::Intersect(
@@ -2539,43 +4955,65 @@ bool DataMgr::BlkExts::Intersect(
     std::vector <size_t> &bmax
 ) const {
 	assert(_mins.size() >= 1);
+	assert(! _nodes.empty());
 
 	bmin = _bmax;
 	bmax = _bmin;
 
+	double qmin[3], qmax[3];
+	for (int i=0; i<3; i++) {
+		qmin[i] = i < min.size() ? min[i] : -std::numeric_limits<double>::infinity();
+		qmax[i] = i < max.size() ? max[i] : std::numeric_limits<double>::infinity();
+	}
+
+	size_t rmin[3], rmax[3];
 	bool intersection = false;
+	_intersect(0, qmin, qmax, rmin, rmax, intersection);
+	if (! intersection) return(false);
 
-	// Test for intersection with the axis aligned bounding box of each
-	// block. 
-	//
-	for (size_t offset=0; offset<_mins.size(); offset++) {
-		bool overlap = true;
-		for (int j=0; j<min.size(); j++) {
-			if (_maxs[offset][j] < min[j] || _mins[offset][j] > max[j]) {
-				overlap = false;
-				continue;
-			}
-		}
+	for (int i=0; i<bmin.size(); i++) {
+		bmin[i] = rmin[i];
+		bmax[i] = rmax[i];
+	}
+	return(true);
+}
 
-		// If the current block intersects the specified bounding volume
-		// compute the block coordinates of the first and last block
-		// that intersect the volume
-		//
-		if (overlap) {
-			intersection = true;	// at least one block intersects
+// Grow the block range bmin, bmax to include the blocks below node 
+// whose bounding boxes intersect the box min, max
+//
+void DataMgr::BlkExts::_intersect(
+	size_t index, const double min[3], const double max[3],
+	size_t bmin[3], size_t bmax[3], bool &intersection
+) const {
+	const Node &node = _nodes[index];
 
-			vector <size_t> coord = Wasp::VectorizeCoords(
-				offset, _bmin, _bmax
-			);
+	for (int i=0; i<3; i++) {
+		if (node.max[i] < min[i] || node.min[i] > max[i]) return;
+	}
 
-			for (int i=0; i<coord.size(); i++) {
-				if (coord[i] < bmin[i]) bmin[i] = coord[i]; 
-				if (coord[i] > bmax[i]) bmax[i] = coord[i]; 
+	// Nothing to gain if the node's blocks are already in the range
+	//
+	if (intersection) {
+		bool inside = true;
+		for (int i=0; i<3; i++) {
+			if (node.bmin[i] < bmin[i] || node.bmax[i] > bmax[i]) {
+				inside = false;
 			}
 		}
+		if (inside) return;
+	}
+
+	if (! node.right) {
+		for (int i=0; i<3; i++) {
+			if (! intersection || node.bmin[i] < bmin[i]) bmin[i] = node.bmin[i];
+			if (! intersection || node.bmax[i] > bmax[i]) bmax[i] = node.bmax[i];
+		}
+		intersection = true;
+		return;
 	}
 
-	return(intersection);
+	_intersect(index + 1, min, max, bmin, bmax, intersection);
+	_intersect(node.right, min, max, bmin, bmax, intersection);
 }
 
 
@@ -2720,6 +5158,7 @@ RegularGrid *DataMgr::_make_grid_empty(string varname) const {
 
 RegularGrid *DataMgr::_make_grid_regular(
 	const vector <size_t> &dims,
+    const vector <float *> &data_blks,
     const vector <float *> &blkvec,
 	const vector <size_t> &bs,
 	const vector <size_t> &bmin,
@@ -2737,28 +5176,14 @@ RegularGrid *DataMgr::_make_grid_regular(
 		maxu.push_back(coords[dims[i]-1]);
 	}
 
-
-	size_t nblocks = 1;
-	size_t block_size = 1;
-    for (int i=0; i<bs.size(); i++) {
-        nblocks *= bmax[i]-bmin[i]+1;
-        block_size *= bs[i];
-    }
-
-	vector <float *> blkptrs;
-	if (blkvec[0]) {
-		for (int i=0; i<nblocks; i++) {
-			blkptrs.push_back(blkvec[0] + i*block_size);
-		}
-	}
-
-	RegularGrid *rg = new RegularGrid(dims, bs, blkptrs, minu, maxu);
+	RegularGrid *rg = new RegularGrid(dims, bs, data_blks, minu, maxu);
 
 	return(rg);
 }
 
 StretchedGrid *DataMgr::_make_grid_stretched(
 	const vector <size_t> &dims,
+    const vector <float *> &data_blks,
     const vector <float *> &blkvec,
 	const vector <size_t> &bs,
 	const vector <size_t> &bmin,
@@ -2769,20 +5194,6 @@ StretchedGrid *DataMgr::_make_grid_stretched(
 	assert (dims.size() == bmin.size());
 	assert (dims.size() == bmax.size());
 
-	size_t nblocks = 1;
-	size_t block_size = 1;
-    for (int i=0; i<bs.size(); i++) {
-        nblocks *= bmax[i]-bmin[i]+1;
-        block_size *= bs[i];
-    }
-
-	vector <float *> blkptrs;
-	if (blkvec[0]) {
-		for (int i=0; i<nblocks; i++) {
-			blkptrs.push_back(blkvec[0] + i*block_size);
-		}
-	}
-
 	vector <double> xcoords;
 	for (int i=0; i<dims[0]; i++) xcoords.push_back(blkvec[1][i]);
 
@@ -2795,7 +5206,7 @@ StretchedGrid *DataMgr::_make_grid_stretched(
 	}
 
 	StretchedGrid *sg = new StretchedGrid(
-		dims, bs, blkptrs, xcoords, ycoords, zcoords
+		dims, bs, data_blks, xcoords, ycoords, zcoords
 	);
 
 	return(sg);
@@ -2803,6 +5214,7 @@ StretchedGrid *DataMgr::_make_grid_stretched(
 
 LayeredGrid *DataMgr::_make_grid_layered(
 	const vector <size_t> &dims,
+    const vector <float *> &data_blks,
     const vector <float *> &blkvec,
 	const vector <size_t > &bs,
 	const vector <size_t > &bmin,
@@ -2823,27 +5235,12 @@ LayeredGrid *DataMgr::_make_grid_layered(
 		hmaxu.push_back(coords[dims[i]-1]);
 	}
 
-	// Data blocks
-	//
-	size_t nblocks = 1;
-	size_t block_size = 1;
-    for (int i=0; i<bs.size(); i++) {
-        nblocks *= bmax[i]-bmin[i]+1;
-        block_size *= bs[i];
-    }
-
-	vector <float *> blkptrs, zcblkptrs;
-
-	if (blkvec[0]) {
-		for (int i=0; i<nblocks; i++) {
-			blkptrs.push_back(blkvec[0] + i*block_size);
-		}
-	}
+	vector <float *> zcblkptrs;
 
 	// Z Coord blocks
 	//
-	nblocks = 1;
-	block_size = 1;
+	size_t nblocks = 1;
+	size_t block_size = 1;
     for (int i=0; i<bs.size(); i++) {
         nblocks *= bmax[i]-bmin[i]+1;
         block_size *= bs[i];
@@ -2857,7 +5254,7 @@ LayeredGrid *DataMgr::_make_grid_layered(
 		dims, bs, zcblkptrs, vector <double> (3,0.0), vector <double> (3,1.0)
 	);
 
-	LayeredGrid *lg = new LayeredGrid(dims, bs, blkptrs, hminu, hmaxu, rg);
+	LayeredGrid *lg = new LayeredGrid(dims, bs, data_blks, hminu, hmaxu, rg);
 
 	return(lg);
 }
@@ -2868,6 +5265,7 @@ CurvilinearGrid *DataMgr::_make_grid_curvilinear(
 	int lod,
 	const vector <DC::CoordVar> &cvarsinfo,
 	const vector <size_t> &dims,
+    const vector <float *> &data_blks,
     const vector <float *> &blkvec,
 	const vector <size_t> &bs,
 	const vector <size_t> &bmin,
@@ -2879,27 +5277,11 @@ CurvilinearGrid *DataMgr::_make_grid_curvilinear(
 	assert (dims.size() == bmin.size());
 	assert (dims.size() == bmax.size());
 
-	// Data blocks
-	//
-	size_t nblocks = 1;
-	size_t block_size = 1;
-    for (int i=0; i<bs.size(); i++) {
-        nblocks *= bmax[i]-bmin[i]+1;
-        block_size *= bs[i];
-    }
-
-	// block pointers for data
-	//
-	vector <float *> blkptrs;
-    for (int i=0; i<nblocks; i++) {
-        if (blkvec[0]) blkptrs.push_back(blkvec[0] + i*block_size);
-	}
-
 	// X horizontal coord blocks
 	//
 	vector <size_t> bs2d = {bs[0], bs[1]};
-	nblocks = 1;
-	block_size = 1;
+	size_t nblocks = 1;
+	size_t block_size = 1;
     for (int i=0; i<bs2d.size(); i++) {
         nblocks *= bmax[i]-bmin[i]+1;
         block_size *= bs2d[i];
@@ -2938,9 +5320,13 @@ CurvilinearGrid *DataMgr::_make_grid_curvilinear(
 		ts, level, lod, cvarsinfo, xrg, yrg, bmin, bmax
 	);
 
+	const CellLocatorRG *locator = _getCellLocator2D(
+		ts, level, lod, cvarsinfo, xrg, yrg, bmin, bmax
+	);
+
 	CurvilinearGrid *g = new CurvilinearGrid(
-		dims, bs, blkptrs, xrg, yrg, 
-		zcoords, kdtree
+		dims, bs, data_blks, xrg, yrg, 
+		zcoords, kdtree, locator
 	);
 
 	return(g);
@@ -3026,6 +5412,7 @@ UnstructuredGrid2D *DataMgr::_make_grid_unstructured2d(
 	const DC::DataVar &dvarinfo,
 	const vector <DC::CoordVar> &cvarsinfo,
 	const vector <size_t> &dims,
+    const vector <float *> &data_blks,
     const vector <float *> &blkvec,
 	const vector <size_t> &bs,
 	const vector <size_t> &bmin,
@@ -3056,7 +5443,7 @@ UnstructuredGrid2D *DataMgr::_make_grid_unstructured2d(
 		maxVertexPerFace, maxFacePerVertex, vertexOffset, faceOffset
 	);
 
-	// block pointers for data
+	// Block pointers for X coordinates, which are always 1D
 	//
 	size_t nblocks = 1;
 	size_t block_size = 1;
@@ -3065,21 +5452,6 @@ UnstructuredGrid2D *DataMgr::_make_grid_unstructured2d(
         block_size *= bs[i];
     }
 
-	vector <float *> blkptrs;
-    for (int i=0; i<nblocks; i++) {
-        if (blkvec[0]) blkptrs.push_back(blkvec[0] + i*block_size);
-	}
-
-
-	// Block pointers for X coordinates, which are always 1D
-	//
-	nblocks = 1;
-	block_size = 1;
-    for (int i=0; i<bs.size(); i++) {
-        nblocks *= bmax[i]-bmin[i]+1;
-        block_size *= bs[i];
-    }
-
 	vector <float *> xcblkptrs;
     for (int i=0; i<nblocks; i++) {
         xcblkptrs.push_back(blkvec[1] + i*block_size);
@@ -3126,11 +5498,15 @@ UnstructuredGrid2D *DataMgr::_make_grid_unstructured2d(
 		ts, level, lod, cvarsinfo, xug, yug, bmin, bmax
 	);
 
+	const FaceLocatorUG2D *locator = _getFaceLocator2D(
+		ts, level, lod, cvarsinfo, xug, yug, bmin, bmax
+	);
+
 	UnstructuredGrid2D *g = new UnstructuredGrid2D(
-		vertexDims, faceDims, edgeDims, bs, blkptrs, 
+		vertexDims, faceDims, edgeDims, bs, data_blks, 
 		vertexOnFace, faceOnVertex, faceOnFace, location,
 		maxVertexPerFace, maxFacePerVertex,
-		xug, yug, zug, kdtree
+		xug, yug, zug, kdtree, locator
 	);
 	g->SetNodeOffset(vertexOffset);
 	g->SetCellOffset(faceOffset);
@@ -3156,6 +5532,7 @@ Grid *DataMgr::_make_grid(
 	const DC::DataVar &var,
 	const vector <size_t> &roi_dims, 
 	const vector <size_t> &dims,
+	const vector <float *> &data_blks,
 	const vector <float *> &blkvec,
 	const vector < vector <size_t > > &bsvec,
 	const vector < vector <size_t > > &bminvec,
@@ -3188,29 +5565,29 @@ Grid *DataMgr::_make_grid(
 	Grid *rg = NULL;
     if (grid_type == REGULAR) {
 		rg = _make_grid_regular(
-			roi_dims, blkvec, bsvec[0], bminvec[0], bmaxvec[0]
+			roi_dims, data_blks, blkvec, bsvec[0], bminvec[0], bmaxvec[0]
 		);
 	}
 	else if (grid_type == STRETCHED) {
 		rg = _make_grid_stretched(
-			roi_dims, blkvec, bsvec[0], bminvec[0], bmaxvec[0]
+			roi_dims, data_blks, blkvec, bsvec[0], bminvec[0], bmaxvec[0]
 		);
 	}
 	else if (grid_type == LAYERED) {
 		rg = _make_grid_layered(
-			roi_dims, blkvec, bsvec[0], bminvec[0], bmaxvec[0]
+			roi_dims, data_blks, blkvec, bsvec[0], bminvec[0], bmaxvec[0]
 		);
 	}
 	else if (grid_type == CURVILINEAR) {
 		rg = _make_grid_curvilinear(
 			ts, level, lod, cvarsinfo, roi_dims, 
-			blkvec, bsvec[0], bminvec[0], bmaxvec[0]
+			data_blks, blkvec, bsvec[0], bminvec[0], bmaxvec[0]
 		);
 	}
 	else if (grid_type == UNSTRUC_2D) {
 		rg = _make_grid_unstructured2d(
 			ts, level, lod, var, cvarsinfo, roi_dims, 
-			blkvec, bsvec[0], bminvec[0], bmaxvec[0],
+			data_blks, blkvec, bsvec[0], bminvec[0], bmaxvec[0],
 			conn_blkvec, conn_bsvec[0], conn_bminvec[0], conn_bmaxvec[0]
 		);
 	}
@@ -3369,6 +5746,7 @@ int DataMgr::_find_bounding_grid(
 	// See if bounding volumes for individual blocks are already 
 	// cached for this grid
 	//
+	std::unique_lock <std::recursive_mutex> guard(_cacheMutex);
 	map <string, BlkExts >::iterator itr = _blkExtsCache.find(hash);
 
 	if (itr == _blkExtsCache.end()) {
@@ -3376,10 +5754,14 @@ int DataMgr::_find_bounding_grid(
 			"DataMgr::_find_bounding_grid() - coordinates not in cache"
 		);
 
+		// Can't hold the cache lock while reading
+		//
+		guard.unlock();
+
 		// Get a "dataless" Grid - a Grid class the contains
 		// coordiante information, but not data
 		//
-		Grid *rg = _getVariable(ts, varname, level, lod, false, true);
+		Grid *rg = _getVariable(ts, varname, level, lod, true, true);
 		if (! rg) return(-1);
 
 		// Voxel and block min and max coordinates of entire grid
@@ -3398,41 +5780,68 @@ int DataMgr::_find_bounding_grid(
 
 		// For each block in the grid compute the block's bounding 
 		// box. Include a one-voxel halo region on all non-boundary
-		// faces
+		// faces. Blocks are independent, so they're shared among 
+		// threads in interleaved order.
 		//
 		size_t nblocks = Wasp::LinearizeCoords(bmax, bmin, bmax) + 1;
-		for (size_t offset = 0; offset<nblocks; offset++) {
+		auto worker = [&](size_t first, size_t stride) {
 			vector <double> my_min, my_max;
 			vector <size_t> my_vmin(vmin.size()), my_vmax(vmin.size());
 
-			// Get coordinates for current block
-			//
-			vector <size_t> bcoord = Wasp::VectorizeCoords(
-				offset, bmin, bmax
-			);
+			for (size_t offset = first; offset<nblocks; offset += stride) {
 
-			for (int i=0; i<bcoord.size(); i++) {
-				my_vmin[i] = bcoord[i] * bs_at_level[i];
-				if (my_vmin[i] > 0) my_vmin[i] -= 1;	// not boundary face
+				// Get coordinates for current block
+				//
+				vector <size_t> bcoord = Wasp::VectorizeCoords(
+					offset, bmin, bmax
+				);
 
-				my_vmax[i] = bcoord[i] * bs_at_level[i] + bs_at_level[i] - 1;
-				if (my_vmax[i] > vmax[i]) my_vmax[i] = vmax[i];
-				if (my_vmax[i] < vmax[i]) my_vmax[i] += 1;
-			}
+				for (int i=0; i<bcoord.size(); i++) {
+					my_vmin[i] = bcoord[i] * bs_at_level[i];
+					if (my_vmin[i] > 0) my_vmin[i] -= 1;	// not boundary face
 
-			// Use the regular grid class to compute the user-coordinate
-			// axis aligned bounding volume for the block+halo
-			//
-			rg->GetBoundingBox(my_vmin, my_vmax, my_min, my_max);
+					my_vmax[i] = bcoord[i] * bs_at_level[i] + bs_at_level[i] - 1;
+					if (my_vmax[i] > vmax[i]) my_vmax[i] = vmax[i];
+					if (my_vmax[i] < vmax[i]) my_vmax[i] += 1;
+				}
 
-			// Insert the bounding volume into blkexts
-			//
-			blkexts.Insert(bcoord, my_min, my_max);
+				// Use the grid class to compute the user-coordinate
+				// axis aligned bounding volume for the block+halo
+				//
+				rg->GetBoundingBox(my_vmin, my_vmax, my_min, my_max);
 
-		} 
+				// Insert the bounding volume into blkexts
+				//
+				blkexts.Insert(bcoord, my_min, my_max);
+			}
+		};
+
+		size_t nthreads = _nthreads > 0 ? _nthreads : EasyThreads::NProc();
+		if (nthreads > nblocks) nthreads = nblocks;
+		if (nthreads > 1) {
+			vector <std::thread> threads;
+			for (size_t t=0; t<nthreads; t++) {
+				threads.push_back(std::thread(worker, t, nthreads));
+			}
+			for (size_t t=0; t<nthreads; t++) threads[t].join();
+		}
+		else {
+			worker(0, 1);
+		}
+
+		UnlockGrid(rg);
+		delete rg;
+
+		double t0 = Wasp::GetTime();
+		blkexts.Build();
+		SetDiagMsg(
+			"DataMgr::_find_bounding_grid() - indexed %zu blocks in %f seconds",
+			nblocks, Wasp::GetTime() - t0
+		);
 
 		// Add to the hash table
 		//
+		guard.lock();
 		_blkExtsCache[hash] = blkexts;
 		itr = _blkExtsCache.find(hash);
 		assert (itr != _blkExtsCache.end());
@@ -3472,18 +5881,23 @@ void	DataMgr::_unlock_blocks(
 	const void *blks
 ) {
 
-	list <region_t>::iterator itr;
-	for(itr = _regionsList.begin(); itr!=_regionsList.end(); itr++) {
-		region_t &region = *itr;
+	std::lock_guard <std::recursive_mutex> guard(_cacheMutex);
 
-		if (region.blks == blks && region.lock_counter>0) {
-			region.lock_counter--;
-			return;
-		}
+	region_t *region = _regionCache.Find(blks);
+	if (region && region->lock_counter>0) {
+		region->lock_counter--;
 	}
 	return;
 }
 
+void	DataMgr::_unlock_blocks(
+	const vector <float *> &blks
+) {
+	for (int i=0; i<blks.size(); i++) {
+		_unlock_blocks(blks[i]);
+	}
+}
+
 const KDTreeRG *DataMgr::_getKDTree2D(
 	size_t ts,
 	int level,
@@ -3510,6 +5924,10 @@ const KDTreeRG *DataMgr::_getKDTree2D(
 	
 	KDTreeRG *kdtree = NULL;
 
+	// Hold lock while building so concurrent requests share one tree
+	//
+	std::lock_guard <std::mutex> guard(_kdtreeMutex);
+
 	vector <void *> values;
 	bool found = _varInfoCache.Get(ts,varnames,level,lod,key, values);
 	if (found) {
@@ -3517,7 +5935,21 @@ const KDTreeRG *DataMgr::_getKDTree2D(
 		kdtree = (KDTreeRG *) values[0];
 	}
 	else {
-		kdtree = new KDTreeRG(xg, yg);
+		string path;
+		if (! _kdtreeCacheDir.empty()) {
+			path = _kdtreeCacheDir + "/" + 
+				kdtree_cache_file(varnames, {&xg, &yg});
+			kdtree = _readKDTree(path, xg.GetDimensions(), 2);
+		}
+		if (! kdtree) {
+			double t0 = Wasp::GetTime();
+			kdtree = new KDTreeRG(xg, yg, _nthreads);
+			SetDiagMsg(
+				"DataMgr::_getKDTree2D() - built %s in %f seconds, %zu bytes",
+				key.c_str(), Wasp::GetTime() - t0, kdtree->GetMemoryUsage()
+			);
+			if (! path.empty()) _writeKDTree(path, kdtree);
+		}
 		values.push_back(kdtree);
 		_varInfoCache.Set(ts, varnames, level,lod, key, values);
 	}
@@ -3525,6 +5957,142 @@ const KDTreeRG *DataMgr::_getKDTree2D(
 	return(kdtree);
 }
 
+// Read a cached k-d tree. Errors are not reported: the caller simply
+// rebuilds the tree.
+//
+KDTreeRG *DataMgr::_readKDTree(
+	string path, const vector <size_t> &dims, int ncoords
+) const {
+	bool enabled = EnableErrMsg(false);
+	KDTreeRG *kdtree = KDTreeRG::Read(path);
+	(void) EnableErrMsg(enabled);
+
+	if (kdtree && (
+		kdtree->GetDimensions() != dims || 
+		kdtree->GetNumCoordinates() != ncoords)
+	) {
+		delete kdtree;
+		kdtree = NULL;
+	}
+
+	if (kdtree) {
+		SetDiagMsg("DataMgr::_readKDTree() - mapped %s", path.c_str());
+	}
+	return(kdtree);
+}
+
+void DataMgr::_writeKDTree(string path, const KDTreeRG *kdtree) const {
+	bool enabled = EnableErrMsg(false);
+	int rc = kdtree->Write(path);
+	(void) EnableErrMsg(enabled);
+
+	if (rc < 0) {
+		SetDiagMsg("DataMgr::_writeKDTree() - failed to write %s", path.c_str());
+	}
+}
+
+const CellLocatorRG *DataMgr::_getCellLocator2D(
+	size_t ts,
+	int level,
+	int lod,
+    const vector <DC::CoordVar> &cvarsinfo, 
+	const Grid &xg,
+	const Grid &yg,
+	const vector <size_t> &bmin,
+	const vector <size_t> &bmax
+) {
+	assert(cvarsinfo.size() >= 2);
+	assert(xg.GetDimensions() == yg.GetDimensions());
+
+	vector <string> varnames;
+	for (int i=0; i<2; i++) {
+		varnames.push_back(cvarsinfo[i].GetName());
+	}
+
+	// N.B. Clear() relies on the "CellLocator" prefix to identify
+	// the type of the cached pointer
+	//
+	string key = "CellLocator";
+	key += ":";
+	key += vector_to_string(bmin);
+	key += ":";
+	key += vector_to_string(bmax);
+	
+	CellLocatorRG *locator = NULL;
+
+	std::lock_guard <std::mutex> guard(_kdtreeMutex);
+
+	vector <void *> values;
+	bool found = _varInfoCache.Get(ts,varnames,level,lod,key, values);
+	if (found) {
+		assert(values.size() == 1);
+		locator = (CellLocatorRG *) values[0];
+	}
+	else {
+		double t0 = Wasp::GetTime();
+		locator = new CellLocatorRG(xg, yg);
+		SetDiagMsg(
+			"DataMgr::_getCellLocator2D() - built %s in %f seconds, %zu bytes",
+			key.c_str(), Wasp::GetTime() - t0, locator->GetMemoryUsage()
+		);
+		values.push_back(locator);
+		_varInfoCache.Set(ts, varnames, level,lod, key, values);
+	}
+
+	return(locator);
+}
+
+const FaceLocatorUG2D *DataMgr::_getFaceLocator2D(
+	size_t ts,
+	int level,
+	int lod,
+    const vector <DC::CoordVar> &cvarsinfo, 
+	const UnstructuredGrid &xg,
+	const UnstructuredGrid &yg,
+	const vector <size_t> &bmin,
+	const vector <size_t> &bmax
+) {
+	assert(cvarsinfo.size() >= 2);
+	assert(xg.GetDimensions() == yg.GetDimensions());
+
+	vector <string> varnames;
+	for (int i=0; i<2; i++) {
+		varnames.push_back(cvarsinfo[i].GetName());
+	}
+
+	// N.B. Clear() relies on the "FaceLocator" prefix to identify
+	// the type of the cached pointer
+	//
+	string key = "FaceLocator";
+	key += ":";
+	key += vector_to_string(bmin);
+	key += ":";
+	key += vector_to_string(bmax);
+	
+	FaceLocatorUG2D *locator = NULL;
+
+	std::lock_guard <std::mutex> guard(_kdtreeMutex);
+
+	vector <void *> values;
+	bool found = _varInfoCache.Get(ts,varnames,level,lod,key, values);
+	if (found) {
+		assert(values.size() == 1);
+		locator = (FaceLocatorUG2D *) values[0];
+	}
+	else {
+		double t0 = Wasp::GetTime();
+		locator = new FaceLocatorUG2D(xg, yg);
+		SetDiagMsg(
+			"DataMgr::_getFaceLocator2D() - built %s in %f seconds, %zu bytes",
+			key.c_str(), Wasp::GetTime() - t0, locator->GetMemoryUsage()
+		);
+		values.push_back(locator);
+		_varInfoCache.Set(ts, varnames, level,lod, key, values);
+	}
+
+	return(locator);
+}
+
 vector <string> DataMgr::_getDataVarNamesDerived(int ndim) const {
 	vector <string> names;
 
@@ -3966,6 +6534,8 @@ int DataMgr::_getVar(
 		max.push_back(dims_at_level[i]-1);
 	}
 
+	std::lock_guard <std::recursive_mutex> dcguard(_dcMutex);
+
 	int fd = _dc->OpenVariableRead(ts, varname, level, lod);
 	if (fd<0) return(-1);
 
@@ -4165,14 +6735,14 @@ std::ostream &operator<<(
 		o << "  " << b._bmin[i] << " " << b._bmax[i] << endl;
 	}
 	o << "Block coordinates" << endl;
-	for (int i=0;i<b._mins.size(); i++) {
-		assert(b._mins[i].size() == b._maxs[i].size());
+	for (size_t i=0;i<b.GetNumBlocks(); i++) {
 		o << "Block index " << i << endl;
-		for (int j=0;j<b._mins[i].size(); j++) {
-			o << "  " << b._mins[i][j] << " " << b._maxs[i][j] << endl;
+		for (int j=0;j<3; j++) {
+			o << "  " << b._mins[3*i+j] << " " << b._maxs[3*i+j] << endl;
 		}
 		o << endl;
 	}
+	o << "Hierarchy nodes : " << b._nodes.size() << endl;
 
     return(o);
 }
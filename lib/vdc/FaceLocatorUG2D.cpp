@@ -0,0 +1,327 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+#include <vapor/FaceLocatorUG2D.h>
+#include <vapor/vizutil.h>
+
+using namespace std;
+using namespace VAPoR;
+
+namespace {
+
+// Maximum number of faces visited by a walking search before giving up
+// and searching the bin grid
+//
+const int MaxWalkSteps = 16;
+
+// Points more than this many bins away from the seed face are located
+// with the bin grid instead of by walking. Bins are about the size of a
+// face, and each step of a walk is likely a cache miss on a large mesh.
+//
+const double MaxWalkBins = 3.0;
+
+};
+
+FaceLocatorUG2D::FaceLocatorUG2D(
+	const UnstructuredGrid &xug, const UnstructuredGrid &yug
+) {
+	assert(xug.GetDimensions() == yug.GetDimensions());
+	assert(xug.GetDimensions().size() == 1);
+
+	_maxVertexPerFace = xug.GetMaxVertexPerFace();
+	for (int i=0; i<2; i++) {
+		_min[i] = _max[i] = 0.0;
+		_scale[i] = 0.0;
+		_nbins[i] = 1;
+	}
+
+	size_t nnodes = xug.GetNodeDimensions()[0];
+	size_t nfaces = xug.GetCellDimensions()[0];
+	size_t maxv = _maxVertexPerFace;
+	size_t maxf = xug.GetMaxFacePerVertex();
+
+	vector <double> x(nnodes), y(nnodes);
+	Grid::ConstIterator xitr = xug.cbegin();
+	Grid::ConstIterator yitr = yug.cbegin();
+	for (size_t i=0; i<nnodes; ++i, ++xitr, ++yitr) {
+		x[i] = *xitr;
+		y[i] = *yitr;
+	}
+
+	// Copy the coordinates of each face's nodes, and remember the node
+	// IDs so that neighbors can be found below
+	//
+	_nverts.assign(nfaces, 0);
+	_verts.assign(nfaces * maxv * 2, 0.0);
+	vector <long> nodes(nfaces * maxv, -1);
+
+	const int *vertexOnFace = xug.GetVertexOnFace();
+	long nodeOffset = xug.GetNodeOffset();
+	bool first = true;
+	for (size_t f=0; f<nfaces; f++) {
+		const int *ptr = vertexOnFace + (f * maxv);
+		int n = 0;
+		bool finite = true;
+		for (int i=0; i<maxv; i++, ptr++) {
+			long vertex = *ptr + nodeOffset;
+			if (vertex == xug.GetMissingID() || vertex < 0) break;
+			assert(vertex < nnodes);
+
+			nodes[f*maxv + n] = vertex;
+			_verts[(f*maxv + n)*2] = x[vertex];
+			_verts[(f*maxv + n)*2 + 1] = y[vertex];
+			if (! (std::isfinite(x[vertex]) && std::isfinite(y[vertex]))) {
+				finite = false;
+			}
+			n++;
+		}
+		if (n < 3 || ! finite) continue;
+
+		_nverts[f] = n;
+
+		double fmin[2], fmax[2];
+		_faceBounds(f, fmin, fmax);
+		if (first) {
+			_min[0] = fmin[0]; _min[1] = fmin[1];
+			_max[0] = fmax[0]; _max[1] = fmax[1];
+			first = false;
+		}
+		for (int i=0; i<2; i++) {
+			_min[i] = min(_min[i], fmin[i]);
+			_max[i] = max(_max[i], fmax[i]);
+		}
+	}
+
+	// The neighbor across the edge from node k to node k+1 of a face is
+	// the other face sharing node k that also has node k+1
+	//
+	const int *faceOnVertex = xug.GetFaceOnVertex();
+	long cellOffset = xug.GetCellOffset();
+	_neighbors.assign(nfaces * maxv, -1);
+	for (size_t f=0; f<nfaces; f++) {
+		int n = _nverts[f];
+		for (int k=0; k<n; k++) {
+			long a = nodes[f*maxv + k];
+			long b = nodes[f*maxv + (k+1) % n];
+
+			const int *ptr = faceOnVertex + (a * maxf);
+			for (int i=0; i<maxf; i++, ptr++) {
+				long g = *ptr + cellOffset;
+				if (g == xug.GetMissingID() || g < 0) break;
+				if (g == xug.GetBoundaryID() || g == f || g >= nfaces) continue;
+				if (! _nverts[g]) continue;
+
+				const long *gnodes = &nodes[g*maxv];
+				if (std::find(gnodes, gnodes + _nverts[g], b) != gnodes + _nverts[g]) {
+					_neighbors[f*maxv + k] = g;
+					break;
+				}
+			}
+		}
+	}
+
+	// Size the bin grid so that there is about one bin per face, with
+	// bins that are roughly square in user coordinates
+	//
+	double w = _max[0] - _min[0];
+	double h = _max[1] - _min[1];
+	if (! first) {
+		double aspect = (w > 0.0 && h > 0.0) ? w / h : 1.0;
+		if (w > 0.0) {
+			_nbins[0] = max((size_t) 1, (size_t) sqrt(nfaces * aspect));
+		}
+		if (h > 0.0) {
+			_nbins[1] = max((size_t) 1, nfaces / _nbins[0]);
+		}
+	}
+	if (w > 0.0) _scale[0] = _nbins[0] / w;
+	if (h > 0.0) _scale[1] = _nbins[1] / h;
+
+	// Register each face with every bin its bounding rectangle overlaps.
+	// The first pass counts the faces in each bin, the second stores
+	// them.
+	//
+	_binOffsets.assign(_nbins[0] * _nbins[1] + 1, 0);
+	double fmin[2], fmax[2];
+	size_t b0[2], b1[2];
+	for (size_t f=0; f<nfaces; f++) {
+		if (! _faceBounds(f, fmin, fmax)) continue;
+
+		_binRange(fmin, fmax, b0, b1);
+		for (size_t bj=b0[1]; bj<=b1[1]; bj++) {
+		for (size_t bi=b0[0]; bi<=b1[0]; bi++) {
+			_binOffsets[bj*_nbins[0] + bi + 1]++;
+		}
+		}
+	}
+
+	for (size_t b=1; b<_binOffsets.size(); b++) {
+		_binOffsets[b] += _binOffsets[b-1];
+	}
+	_faces.resize(_binOffsets.back());
+
+	vector <size_t> fill(_binOffsets.begin(), _binOffsets.end()-1);
+	for (size_t f=0; f<nfaces; f++) {
+		if (! _faceBounds(f, fmin, fmax)) continue;
+
+		_binRange(fmin, fmax, b0, b1);
+		for (size_t bj=b0[1]; bj<=b1[1]; bj++) {
+		for (size_t bi=b0[0]; bi<=b1[0]; bi++) {
+			_faces[fill[bj*_nbins[0] + bi]++] = f;
+		}
+		}
+	}
+}
+
+bool FaceLocatorUG2D::FindFace(
+	double x, double y, size_t &face, double *lambda, int &nlambda
+) const {
+	face = 0;
+	nlambda = 0;
+
+	// Comparisons are false for NaN
+	//
+	if (! (x >= _min[0] && x <= _max[0] && y >= _min[1] && y <= _max[1])) {
+		return(false);
+	}
+	if (_faces.empty()) return(false);
+
+	size_t bi = min((size_t) ((x - _min[0]) * _scale[0]), _nbins[0]-1);
+	size_t bj = min((size_t) ((y - _min[1]) * _scale[1]), _nbins[1]-1);
+	size_t b = bj*_nbins[0] + bi;
+
+	double pt[] = {x,y};
+	for (size_t l=_binOffsets[b]; l<_binOffsets[b+1]; l++) {
+		size_t f = _faces[l];
+
+		const double *verts = &_verts[f * _maxVertexPerFace * 2];
+		int n = _nverts[f];
+		double xmin = verts[0], xmax = verts[0];
+		double ymin = verts[1], ymax = verts[1];
+		for (int k=1; k<n; k++) {
+			xmin = min(xmin, verts[2*k]);
+			xmax = max(xmax, verts[2*k]);
+			ymin = min(ymin, verts[2*k+1]);
+			ymax = max(ymax, verts[2*k+1]);
+		}
+		if (x < xmin || x > xmax || y < ymin || y > ymax) continue;
+
+		if (_insideFace(f, pt, lambda, nlambda)) {
+			face = f;
+			return(true);
+		}
+	}
+	return(false);
+}
+
+bool FaceLocatorUG2D::FindFace(
+	double x, double y, size_t seed,
+	size_t &face, double *lambda, int &nlambda
+) const {
+	double pt[] = {x,y};
+
+	if (seed >= _nverts.size() || ! _nverts[seed]) {
+		return(FindFace(x, y, face, lambda, nlambda));
+	}
+
+	const double *sverts = &_verts[seed * _maxVertexPerFace * 2];
+	double dx = fabs(x - sverts[0]) * _scale[0];
+	double dy = fabs(y - sverts[1]) * _scale[1];
+	if (! (dx <= MaxWalkBins && dy <= MaxWalkBins)) {
+		return(FindFace(x, y, face, lambda, nlambda));
+	}
+
+	size_t f = seed;
+	for (int step=0; step<MaxWalkSteps && f<_nverts.size(); step++) {
+		int n = _nverts[f];
+		if (! n) break;
+
+		// Nodes are counter-clockwise, so the point is to the left of
+		// (has a positive signed area with) every edge of the face
+		// containing it. Otherwise move across the edge the point is
+		// furthest outside of.
+		//
+		const double *verts = &_verts[f * _maxVertexPerFace * 2];
+		int exit = -1;
+		double amin = 0.0;
+		for (int k=0; k<n; k++) {
+			double a = SignedTriArea2D(
+				pt, &verts[2*k], &verts[2*((k+1) % n)]
+			);
+			if (a < amin) {
+				amin = a;
+				exit = k;
+			}
+		}
+
+		if (exit < 0) {
+			if (_insideFace(f, pt, lambda, nlambda)) {
+				face = f;
+				return(true);
+			}
+			break;
+		}
+
+		int next = _neighbors[f * _maxVertexPerFace + exit];
+		if (next < 0) break;
+		f = next;
+	}
+
+	return(FindFace(x, y, face, lambda, nlambda));
+}
+
+size_t FaceLocatorUG2D::GetMemoryUsage() const {
+	return(
+		sizeof(*this) +
+		_nverts.capacity() * sizeof(_nverts[0]) +
+		_verts.capacity() * sizeof(_verts[0]) +
+		_neighbors.capacity() * sizeof(_neighbors[0]) +
+		_binOffsets.capacity() * sizeof(_binOffsets[0]) +
+		_faces.capacity() * sizeof(_faces[0])
+	);
+}
+
+// Compute the bounding rectangle of a face. Returns false if the face
+// is never returned by a search
+//
+bool FaceLocatorUG2D::_faceBounds(
+	size_t face, double min[2], double max[2]
+) const {
+	int n = _nverts[face];
+	if (! n) return(false);
+
+	const double *verts = &_verts[face * _maxVertexPerFace * 2];
+	for (int k=0; k<n; k++) {
+		double x = verts[2*k];
+		double y = verts[2*k+1];
+
+		if (k == 0 || x < min[0]) min[0] = x;
+		if (k == 0 || x > max[0]) max[0] = x;
+		if (k == 0 || y < min[1]) min[1] = y;
+		if (k == 0 || y > max[1]) max[1] = y;
+	}
+	return(true);
+}
+
+// Range of bins overlapped by a rectangle that lies within the bin grid
+//
+void FaceLocatorUG2D::_binRange(
+	const double min[2], const double max[2], size_t b0[2], size_t b1[2]
+) const {
+	for (int i=0; i<2; i++) {
+		b0[i] = std::min((size_t) ((min[i] - _min[i]) * _scale[i]), _nbins[i]-1);
+		b1[i] = std::min((size_t) ((max[i] - _min[i]) * _scale[i]), _nbins[i]-1);
+	}
+}
+
+bool FaceLocatorUG2D::_insideFace(
+	size_t face, const double pt[2], double *lambda, int &nlambda
+) const {
+	nlambda = _nverts[face];
+	const double *verts = &_verts[face * _maxVertexPerFace * 2];
+
+	return(WachspressCoords2D(verts, pt, nlambda, lambda));
+}
@@ -4,6 +4,9 @@
 #include <numeric>
 #include <cmath>
 #include <time.h>
+#include <thread>
+#include <atomic>
+#include <mutex>
 #ifdef  Darwin
 #include <mach/mach_time.h>
 #endif
@@ -14,6 +17,7 @@
 #endif
 
 #include <vapor/utils.h>
+#include <vapor/EasyThreads.h>
 #include <vapor/Grid.h>
 
 using namespace std;
@@ -49,6 +53,8 @@ Grid::Grid(
 	_missingValue = INFINITY;
 	_hasMissing = false;
 	_interpolationOrder = 0;
+	_nodeIDOffset = 0;
+	_cellIDOffset = 0;
 
     //
     // Shallow  copy blocks
@@ -57,56 +63,177 @@ Grid::Grid(
 }
 
 
+// Blocks decoded on first access. The decoded pointer of each block is
+// published atomically, so that blocks already decoded are read without
+// taking the lock
+//
+class Grid::DecodedBlocks {
+public:
+	DecodedBlocks(
+		const vector <float *> &blks, size_t blksize, 
+		const BlockDecoder &decoder
+	) : _encoded(blks), _blksize(blksize), _decoder(decoder),
+		_blocks(new std::atomic <float *>[blks.size()]) {
+
+		for (size_t b=0; b<_encoded.size(); b++) _blocks[b] = NULL;
+	}
+
+	~DecodedBlocks() {
+		for (size_t i=0; i<_buffers.size(); i++) delete [] _buffers[i];
+	}
+
+	float *Get(size_t b) {
+		float *blk = _blocks[b].load(std::memory_order_acquire);
+		if (blk) return(blk);
+
+		std::lock_guard <std::mutex> guard(_mutex);
+		return(_get(b));
+	}
+
+	const vector <float *> &GetAll() {
+		std::lock_guard <std::mutex> guard(_mutex);
+
+		if (_all.empty()) {
+			for (size_t b=0; b<_encoded.size(); b++) _all.push_back(_get(b));
+		}
+		return(_all);
+	}
+
+private:
+	vector <float *> _encoded;
+	size_t _blksize;
+	BlockDecoder _decoder;
+	std::unique_ptr <std::atomic <float *>[]> _blocks;
+	vector <float *> _buffers;	// decoded blocks
+	vector <float *> _all;		// every block, once GetAll() is called
+	std::mutex _mutex;
+
+	float *_get(size_t b) {
+		float *blk = _blocks[b].load(std::memory_order_relaxed);
+		if (blk) return(blk);
+
+		float *buf = new float[_blksize];
+		const float *decoded = _decoder(b, _encoded[b], buf);
+		if (decoded == buf) {
+			_buffers.push_back(buf);
+			blk = buf;
+		}
+		else {
+			delete [] buf;
+			blk = _encoded[b];
+		}
+
+		_blocks[b].store(blk, std::memory_order_release);
+		return(blk);
+	}
+};
+
+void Grid::SetBlockDecoder(const BlockDecoder &decoder) {
+	size_t blksize = std::accumulate(
+		_bs.begin(), _bs.end(), 1, std::multiplies<size_t>()
+	);
+	_decoded.reset(new DecodedBlocks(_blks, blksize, decoder));
+}
+
+const std::vector <float *> &Grid::GetBlks() const {
+	if (_decoded) return(_decoded->GetAll());
+	return(_blks);
+}
+
+float *Grid::_decodeBlock(size_t b) const {
+	return(_decoded->Get(b));
+}
+
 float Grid::AccessIndex(const std::vector <size_t> &indices) const {
-	float *fptr = AccessIndex(_blks, indices);
+	Size_tArr3 cIndices;
+	CopyToArr3(indices, cIndices);
+	return(AccessIndex(cIndices));
+}
+
+float Grid::AccessIndex(const Size_tArr3 &indices) const {
+	float *fptr = _accessIndex(indices);
 	if (! fptr) return(GetMissingValue());
 	return (*fptr);
 }
 
 void Grid::SetValue(const std::vector <size_t> &indices, float v) {
-	float *fptr = AccessIndex(_blks, indices);
+	Size_tArr3 cIndices;
+	CopyToArr3(indices, cIndices);
+	float *fptr = _accessIndex(cIndices);
 	if (! fptr) return;
 	*fptr = v;
 }
 
+float *Grid::_accessIndex(const Size_tArr3 &indices) const {
+	size_t b, offset;
+	if (! _blockOffset(indices, b, offset)) return(NULL);
+
+	return(GetBlock(b) + offset);
+}
+
 float *Grid::AccessIndex(
 	const std::vector <float *> &blks,
 	const std::vector <size_t> &indices
 ) const {
+	Size_tArr3 cIndices;
+	CopyToArr3(indices, cIndices);
+	return(AccessIndex(blks, cIndices));
+}
 
-	std::vector <size_t> cIndices = indices;
-	ClampIndex(cIndices);
-
-	size_t bs[] = {0,0,0};
-	size_t bdims[] = {0,0,0};
+float *Grid::AccessIndex(
+	const std::vector <float *> &blks,
+	const Size_tArr3 &indices
+) const {
 
 	if (! blks.size()) return(NULL);
 
-	vector <size_t> dims = GetDimensions();
+	size_t b, offset;
+	if (! _blockOffset(indices, b, offset)) return(NULL);
+
+	return(blks[b] + offset);
+}
+
+// Find the block containing the node with grid indices, and the node's
+// offset within the block. Returns false if the indices are outside
+// the grid
+//
+bool Grid::_blockOffset(
+	const Size_tArr3 &indices, size_t &b, size_t &offset
+) const {
+
+	if (! _blks.size()) return(false);
+
+	Size_tArr3 cIndices = indices;
+	ClampIndex(cIndices);
+
+	const vector <size_t> &dims = GetDimensions();
 	size_t ndim = dims.size();
+	size_t bs[] = {1,1,1};
+	size_t bdims[] = {1,1,1};
 	for (int i=0; i<ndim; i++) {
 		if (cIndices[i] >= dims[i]) {
-			return(NULL);
+			return(false);
 		}
 		bs[i] = _bs[i];
 		bdims[i] = _bdims[i];
 	}
 
 	size_t xb = cIndices[0] / bs[0];
-	size_t yb = ndim > 1 ? cIndices[1] / bs[1] : 0;
-	size_t zb = ndim > 2 ? cIndices[2] / bs[2] : 0;
+	size_t yb = cIndices[1] / bs[1];
+	size_t zb = cIndices[2] / bs[2];
 
 	size_t x = cIndices[0] % bs[0];
-	size_t y = ndim > 1 ? cIndices[1] % bs[1] : 0;
-	size_t z = ndim > 2 ? cIndices[2] % bs[2] : 0;
+	size_t y = cIndices[1] % bs[1];
+	size_t z = cIndices[2] % bs[2];
 
-	float *blk = blks[zb*bdims[0]*bdims[1] + yb*bdims[0] + xb];
-	return(&blk[z*bs[0]*bs[1] + y*bs[0] + x]);
+	b = zb*bdims[0]*bdims[1] + yb*bdims[0] + xb;
+	offset = z*bs[0]*bs[1] + y*bs[0] + x;
+	return(true);
 }
 
 float Grid::AccessIJK(size_t i, size_t j, size_t k) const {
-    std::vector <size_t> indices = {i,j,k};
-    return(AccessIndex(indices));
+	Size_tArr3 indices = {{i,j,k}};
+	return(AccessIndex(indices));
 }
 
 void Grid::SetValueIJK(size_t i, size_t j, size_t k, float v) {
@@ -115,24 +242,160 @@ void Grid::SetValueIJK(size_t i, size_t j, size_t k, float v) {
 }
 
 
-void Grid::GetRange(float range[2]) const {
+// Find the range of grid indices, and of blocks, spanned by the region
+// with grid indices min and max. Returns false if the region is empty
+//
+bool Grid::_blockRange(
+	const std::vector <size_t> &min, const std::vector <size_t> &max,
+	size_t rmin[3], size_t rmax[3], size_t bmin[3], size_t bmax[3],
+	size_t bs[3], size_t bdims[3]
+) const {
+	if (! _blks.size()) return(false);
+
+	for (int i=0; i<3; i++) {
+		bool used = i < _dims.size();
+		bs[i] = used ? _bs[i] : 1;
+		bdims[i] = used ? _bdims[i] : 1;
+		rmin[i] = used && i < min.size() ? min[i] : 0;
+		rmax[i] = used && i < max.size() ? std::min(max[i], _dims[i]-1) : 0;
+		if (rmin[i] > rmax[i]) return(false);	// empty region
+
+		bmin[i] = rmin[i] / bs[i];
+		bmax[i] = rmax[i] / bs[i];
+	}
+	return(true);
+}
 
-	bool first = true;
-	range[0] = range[1] = GetMissingValue();
-	float missingValue = GetMissingValue();
-	Grid::ConstIterator itr;
-	Grid::ConstIterator enditr = this->cend();
-	for (itr = this->cbegin(); itr!=enditr; ++itr) {
-		if (first && *itr != missingValue) {
-			range[0] = range[1] = *itr;
-			first = false;
+// Extents of block (ib, jb, kb) within the region rmin, rmax
+//
+void Grid::_blockExtents(
+	size_t ib, size_t jb, size_t kb,
+	const size_t rmin[3], const size_t rmax[3], BlockExtents &ext
+) const {
+	size_t b[] = {ib, jb, kb};
+	for (int i=0; i<3; i++) {
+		ext.origin[i] = b[i] * ext.bs[i];
+		ext.min[i] = rmin[i] > ext.origin[i] ? rmin[i] - ext.origin[i] : 0;
+		ext.max[i] = std::min(rmax[i] - ext.origin[i], ext.bs[i] - 1);
+	}
+}
+
+void Grid::ForEachBlock(
+	const std::vector <size_t> &min, const std::vector <size_t> &max,
+	const std::function <void (const float *, const BlockExtents &)> &fn
+) const {
+	BlockExtents ext;
+	size_t rmin[3], rmax[3];
+	size_t bmin[3], bmax[3], bdims[3];
+	if (! _blockRange(min, max, rmin, rmax, bmin, bmax, ext.bs, bdims)) {
+		return;
+	}
+
+	for (size_t kb=bmin[2]; kb<=bmax[2]; kb++) {
+	for (size_t jb=bmin[1]; jb<=bmax[1]; jb++) {
+	for (size_t ib=bmin[0]; ib<=bmax[0]; ib++) {
+		_blockExtents(ib, jb, kb, rmin, rmax, ext);
+		fn(GetBlock((kb * bdims[1] + jb) * bdims[0] + ib), ext);
+	}
+	}
+	}
+}
+
+int Grid::ForEachBlockParallel(
+	const std::vector <size_t> &min, const std::vector <size_t> &max,
+	const std::function <void (const float *, const BlockExtents &, int)> &fn,
+	int nthreads
+) const {
+	BlockExtents ext0;
+	size_t rmin[3], rmax[3];
+	size_t bmin[3], bmax[3], bdims[3];
+	if (! _blockRange(min, max, rmin, rmax, bmin, bmax, ext0.bs, bdims)) {
+		return(1);
+	}
+
+	size_t nb[3];
+	for (int i=0; i<3; i++) nb[i] = bmax[i] - bmin[i] + 1;
+	size_t nblocks = nb[0] * nb[1] * nb[2];
+
+	if (nthreads < 1) nthreads = Wasp::EasyThreads::NProc();
+	if (nthreads > nblocks) nthreads = nblocks;
+	if (nthreads < 1) nthreads = 1;
+
+	// Threads take the next unvisited block until there are none left,
+	// so uneven costs (e.g. partial blocks at the region boundary)
+	// balance out
+	//
+	std::atomic <size_t> next(0);
+	auto worker = [&](int t) {
+		BlockExtents ext = ext0;
+		for (size_t b = next++; b < nblocks; b = next++) {
+			size_t ib = bmin[0] + b % nb[0];
+			size_t jb = bmin[1] + (b / nb[0]) % nb[1];
+			size_t kb = bmin[2] + b / (nb[0] * nb[1]);
+
+			_blockExtents(ib, jb, kb, rmin, rmax, ext);
+			fn(GetBlock((kb * bdims[1] + jb) * bdims[0] + ib), ext, t);
 		}
+	};
+
+	if (nthreads == 1) {
+		worker(0);
+		return(1);
+	}
+
+	vector <std::thread> threads;
+	for (int t=0; t<nthreads; t++) {
+		threads.push_back(std::thread(worker, t));
+	}
+	for (int t=0; t<nthreads; t++) {
+		threads[t].join();
+	}
+	return(nthreads);
+}
 
-		if (! first) {
-			if (*itr < range[0] && *itr != missingValue) range[0] = *itr;
-			else if (*itr > range[1] && *itr != missingValue) range[1] = *itr;
+void Grid::ForEachBlock(
+	const std::function <void (const float *, const BlockExtents &)> &fn
+) const {
+	ForEachBlock(vector <size_t> (), _dims, fn);
+}
+
+namespace {
+
+// Accumulate the range of the non-missing values of a block
+//
+void block_range(
+	const float *blk, const Grid::BlockExtents &ext, float mv,
+	bool &first, float range[2]
+) {
+	for (size_t k=ext.min[2]; k<=ext.max[2]; k++) {
+	for (size_t j=ext.min[1]; j<=ext.max[1]; j++) {
+		const float *row = blk + (k * ext.bs[1] + j) * ext.bs[0];
+		for (size_t i=ext.min[0]; i<=ext.max[0]; i++) {
+			float v = row[i];
+			if (v == mv) continue;
+
+			if (first) {
+				range[0] = range[1] = v;
+				first = false;
+			}
+			if (v < range[0]) range[0] = v;
+			else if (v > range[1]) range[1] = v;
 		}
 	}
+	}
+}
+
+};
+
+void Grid::GetRange(float range[2]) const {
+
+	bool first = true;
+	float mv = GetMissingValue();
+	range[0] = range[1] = mv;
+
+	ForEachBlock([&](const float *blk, const BlockExtents &ext) {
+		block_range(blk, ext, mv, first, range);
+	});
 }
 
 void Grid::GetRange(
@@ -146,47 +409,15 @@ void Grid::GetRange(
 	vector <size_t> cMax = max;
 	ClampIndex(cMax);
 
-	const vector <size_t> &dims = GetDimensions();
-
     assert(cMin.size() == cMax.size());
 
-
+	bool first = true;
 	float mv = GetMissingValue();
-
 	range[0] = range[1] = mv;
 
-	size_t jmin = 0;
-	size_t jmax = 0;
-	if (dims.size() > 1) {
-		jmin = cMin[1];
-		jmax = cMax[1];
-	}
-
-	size_t kmin = 0;
-	size_t kmax = 0;
-	if (dims.size() > 2) {
-		kmin = cMin[2];
-		kmax = cMax[2];
-	}
-
-	bool first = true;
-	for (size_t k=kmin; k<=kmax; k++) {
-	for (size_t j=jmin; j<=jmax; j++) {
-	for (size_t i=cMin[0]; i<=cMax[0]; i++) {
-		float v = AccessIJK(i,j,k);
-		if (first &&  v != mv) {
-			range[0] = range[1] = v;
-			first = false;
-		}
-
-		if (! first) {
-			if (v < range[0] && v != mv) range[0] = v;
-			else if (v > range[1] && v != mv) range[1] = v;
-		}
-
-	}
-	}
-	}
+	ForEachBlock(cMin, cMax, [&](const float *blk, const BlockExtents &ext) {
+		block_range(blk, ext, mv, first, range);
+	});
 }
 
 float Grid::GetValue(const std::vector <double> &coords) const {
@@ -212,48 +443,232 @@ float Grid::GetValue(const std::vector <double> &coords) const {
     }
 }
 
-void Grid::_getUserCoordinatesHelper(
-	const vector <double> &coords, double &x, double &y, double &z
+void Grid::GetValues(const double *xyz, size_t n, float *values) const {
+	size_t ndim = GetGeometryDim();
+
+	vector <double> coords(ndim);
+	for (size_t p=0; p<n; p++) {
+		for (int i=0; i<ndim && i<3; i++) {
+			coords[i] = xyz[3*p + i];
+		}
+		values[p] = GetValue(coords);
+	}
+}
+
+namespace {
+
+// Number of points located and interpolated at a time by
+// InterpolatePoints(). Small enough that the locations of a batch
+// stay in cache.
+//
+const size_t BatchSize = 8192;
+
+};
+
+void Grid::InterpolatePoints(
+	const double *xyz, size_t n, bool nearest,
+	const std::function <void (const double *, CellLocation &)> &locate,
+	float *values
 ) const {
-	if (coords.size() >= 1) {
-		x = coords[0];
+
+	vector <CellLocation> locs;
+	for (size_t p0=0; p0<n; p0+=BatchSize) {
+		size_t m = std::min(BatchSize, n-p0);
+
+		locs.resize(m);
+		for (size_t p=0; p<m; p++) {
+			locate(xyz + 3*(p0+p), locs[p]);
+		}
+		_interpolateCells(locs, nearest, values + p0);
 	}
-	if (coords.size() >= 2) {
-		y = coords[1];
+}
+
+void Grid::_interpolateCells(
+	const std::vector <CellLocation> &locs, bool nearest, float *values
+) const {
+	size_t n = locs.size();
+	float mv = GetMissingValue();
+
+	if (! _blks.size()) {
+		for (size_t p=0; p<n; p++) values[p] = mv;
+		return;
 	}
-	if (coords.size() >= 3) {
-		z = coords[2];
+
+	size_t dims[3], bs[3], bdims[3];
+	for (int i=0; i<3; i++) {
+		bool used = i < _dims.size();
+		dims[i] = used ? _dims[i] : 1;
+		bs[i] = used ? _bs[i] : 1;
+		bdims[i] = used ? _bdims[i] : 1;
+	}
+
+	for (size_t p=0; p<n; p++) {
+		const CellLocation &l = locs[p];
+
+		if (! l.inside) {
+			values[p] = mv;
+			continue;
+		}
+
+		// Block, and offset within the block, of the minimum (0) and
+		// maximum (1) nodes of the cell along each axis. Nodes past
+		// the grid boundary are clamped to it, as AccessIJK() does
+		//
+		size_t b[3][2], o[3][2];
+		for (int i=0; i<3; i++) {
+			size_t i0 = std::min(l.index[i], dims[i]-1);
+			b[i][0] = b[i][1] = i0 / bs[i];
+			o[i][0] = o[i][1] = i0 - b[i][0] * bs[i];
+			if (i0+1 < dims[i]) {
+				if (++o[i][1] == bs[i]) {
+					o[i][1] = 0;
+					b[i][1]++;
+				}
+			}
+		}
+
+		auto node = [&](int ci, int cj, int ck) -> float {
+			const float *blk = GetBlock(
+				(b[2][ck] * bdims[1] + b[1][cj]) * bdims[0] + b[0][ci]
+			);
+			return(blk[(o[2][ck] * bs[1] + o[1][cj]) * bs[0] + o[0][ci]]);
+		};
+
+		double iwgt = l.wgt[0];
+		double jwgt = l.wgt[1];
+		double kwgt = l.wgt[2];
+
+		if (nearest) {
+			values[p] = node(iwgt>0.5, jwgt>0.5, kwgt>0.5);
+			continue;
+		}
+
+		double p0,p1,p2,p3,p4,p5,p6,p7;
+		p1 = p2 = p3 = p4 = p5 = p6 = p7 = 0.0;
+
+		p0 = node(0,0,0);
+		bool missing = p0 == mv;
+
+		if (! missing && iwgt!=0.0) {
+			p1 = node(1,0,0);
+			missing = p1 == mv;
+		}
+		if (! missing && jwgt!=0.0) {
+			p2 = node(0,1,0);
+			missing = p2 == mv;
+		}
+		if (! missing && iwgt!=0.0 && jwgt!=0.0) {
+			p3 = node(1,1,0);
+			missing = p3 == mv;
+		}
+		if (! missing && kwgt!=0.0) {
+			p4 = node(0,0,1);
+			missing = p4 == mv;
+		}
+		if (! missing && kwgt!=0.0 && iwgt!=0.0) {
+			p5 = node(1,0,1);
+			missing = p5 == mv;
+		}
+		if (! missing && kwgt!=0.0 && jwgt!=0.0) {
+			p6 = node(0,1,1);
+			missing = p6 == mv;
+		}
+		if (! missing && kwgt!=0.0 && iwgt!=0.0 && jwgt!=0.0) {
+			p7 = node(1,1,1);
+			missing = p7 == mv;
+		}
+
+		if (missing) {
+			values[p] = mv;
+			continue;
+		}
+
+		double c0 = p0+iwgt*(p1-p0) + jwgt*((p2+iwgt*(p3-p2))-(p0+iwgt*(p1-p0)));
+		double c1 = p4+iwgt*(p5-p4) + jwgt*((p6+iwgt*(p7-p6))-(p4+iwgt*(p5-p4)));
+
+		values[p] = c0+kwgt*(c1-c0);
 	}
 }
 
 void Grid::GetUserCoordinates(
 	size_t i, double &x, double &y, double &z
 ) const {
-	x = y = z = 0.0;
-	vector <size_t> indices = {i};
-	vector <double> coords;
-	GetUserCoordinates(indices, coords);
-	_getUserCoordinatesHelper(coords, x, y, z);
+	GetUserCoordinates(i, 0, 0, x, y, z);
 }
 
 void Grid::GetUserCoordinates(
 	size_t i, size_t j, double &x, double &y, double &z
 ) const {
-	x = y = z = 0.0;
-	vector <size_t> indices = {i, j};
-	vector <double> coords;
-	GetUserCoordinates(indices, coords);
-	_getUserCoordinatesHelper(coords, x, y, z);
+	GetUserCoordinates(i, j, 0, x, y, z);
 }
 
 void Grid::GetUserCoordinates(
 	size_t i, size_t j, size_t k, double &x, double &y, double &z
 ) const {
-	x = y = z = 0.0;
-	vector <size_t> indices = {i, j, k};
-	vector <double> coords;
+	Size_tArr3 indices = {i, j, k};
+	DblArr3 coords;
 	GetUserCoordinates(indices, coords);
-	_getUserCoordinatesHelper(coords, x, y, z);
+	x = coords[0];
+	y = coords[1];
+	z = coords[2];
+}
+
+// The fixed size array methods below fall back on the vector methods,
+// for derived classes that don't provide allocation free versions
+//
+void Grid::GetUserCoordinates(
+	const Size_tArr3 &indices, DblArr3 &coords
+) const {
+	size_t n = std::min(GetNodeDimensions().size(), (size_t) 3);
+	vector <size_t> vIndices(indices.begin(), indices.begin() + n);
+	vector <double> vCoords;
+	GetUserCoordinates(vIndices, vCoords);
+	CopyToArr3(vCoords, coords);
+}
+
+void Grid::GetIndices(const DblArr3 &coords, Size_tArr3 &indices) const {
+	size_t n = std::min(GetGeometryDim(), (size_t) 3);
+	vector <double> vCoords(coords.begin(), coords.begin() + n);
+	vector <size_t> vIndices;
+	GetIndices(vCoords, vIndices);
+	CopyToArr3(vIndices, indices);
+}
+
+bool Grid::GetIndicesCell(const DblArr3 &coords, Size_tArr3 &indices) const {
+	size_t n = std::min(GetGeometryDim(), (size_t) 3);
+	vector <double> vCoords(coords.begin(), coords.begin() + n);
+	vector <size_t> vIndices;
+	bool status = GetIndicesCell(vCoords, vIndices);
+	CopyToArr3(vIndices, indices);
+	return(status);
+}
+
+bool Grid::InsideGrid(const DblArr3 &coords) const {
+	size_t n = std::min(GetGeometryDim(), (size_t) 3);
+	vector <double> vCoords(coords.begin(), coords.begin() + n);
+	return(InsideGrid(vCoords));
+}
+
+bool Grid::GetCellNodes(
+	const Size_tArr3 &cindices, std::vector <Size_tArr3> &nodes
+) const {
+	size_t n = std::min(GetCellDimensions().size(), (size_t) 3);
+	vector <size_t> vCindices(cindices.begin(), cindices.begin() + n);
+	vector <vector <size_t> > vNodes;
+	bool status = GetCellNodes(vCindices, vNodes);
+
+	nodes.resize(vNodes.size());
+	for (int i=0; i<vNodes.size(); i++) {
+		CopyToArr3(vNodes[i], nodes[i]);
+	}
+	return(status);
+}
+
+void Grid::ClampCoord(DblArr3 &coords) const {
+	size_t n = std::min(GetGeometryDim(), (size_t) 3);
+	vector <double> vCoords(coords.begin(), coords.begin() + n);
+	ClampCoord(vCoords);
+	CopyToArr3(vCoords, coords);
 }
 
 void Grid::SetInterpolationOrder(int order) {
@@ -460,14 +875,16 @@ void Grid::ConstCellIteratorSG::next(const long &offset) {
 bool Grid::ConstCellIteratorBoxSG::_cellInsideBox(
 	const std::vector <size_t> &cindices
 ) const {
-	vector <std::vector <size_t> > nodes;
-	bool status = _g->GetCellNodes(cindices, nodes);
+	Size_tArr3 cell;
+	CopyToArr3(cindices, cell);
+	bool status = _g->GetCellNodes(cell, _nodes);
 	if (! status) return(false);
 
-	for (int i=0; i<nodes.size(); i++) {
-		vector <double> coords;
-		_g->GetUserCoordinates(nodes[i], coords);
-		if (!_pred(coords)) return (false);
+	size_t ncoords = _g->GetGeometryDim();
+	DblArr3 coords;
+	for (int i=0; i<_nodes.size(); i++) {
+		_g->GetUserCoordinates(_nodes[i], coords);
+		if (!_pred(coords.data(), ncoords)) return (false);
 	}
 
 	return(true);
@@ -569,14 +986,14 @@ Grid::ForwardIterator<T>::ForwardIterator (
 	_index = vector <size_t> (dims.size(), 0);
 	_end_index = vector <size_t> (dims.size(), 0);
 	if (dims.size()) _end_index[dims.size()-1] = dims[dims.size()-1];
-	if (! begin || ! rg->GetBlks().size()) {
+	if (! begin || ! rg->GetBlock(0)) {
 		_index = _end_index;
 		return;
 	}
 
 	_coordItr = rg->ConstCoordBegin();
 	_xb = 0;
-	_itr = &rg->GetBlks()[0][0];
+	_itr = rg->GetBlock(0);
 
 
 	if (! _pred(*_coordItr)) {
@@ -620,7 +1037,7 @@ template <class T>
 Grid::ForwardIterator<T>
 &Grid::ForwardIterator<T>::operator++() {
 
-	if (! _rg->GetBlks().size()) return(*this);
+	if (! _rg->GetBlock(0)) return(*this);
 
 	const vector <size_t> &dims = _rg->GetDimensions();
 	const vector <size_t> &bdims = _rg->GetDimensionInBlks();
@@ -679,7 +1096,7 @@ Grid::ForwardIterator<T>
 		z = 0;
 		if (dims.size() == 3) z = _index[2] % bs[2];
 
-		float *blk = _rg->GetBlks()[zb*bdims[0]*bdims[1] + yb*bdims[0] + xb];
+		float *blk = _rg->GetBlock(zb*bdims[0]*bdims[1] + yb*bdims[0] + xb);
 		_itr = &blk[z*bs[0]*bs[1] + y*bs[0] + x];
 
 
@@ -702,7 +1119,7 @@ template <class T>
 Grid::ForwardIterator<T> &Grid::ForwardIterator<T>::
 operator+=(const long int &offset) {
 
-	if (! _rg->GetBlks().size()) return(*this);
+	if (! _rg->GetBlock(0)) return(*this);
 
 	const vector <size_t> &dims = _rg->GetDimensions();
 	const vector <size_t> &bdims = _rg->GetDimensionInBlks();
@@ -740,7 +1157,7 @@ operator+=(const long int &offset) {
 	z = 0;
 	if (dims.size() == 3) z = _index[2] % bs[2];
 
-	float *blk = _rg->GetBlks()[zb*bdims[0]*bdims[1] + yb*bdims[0] + xb];
+	float *blk = _rg->GetBlock(zb*bdims[0]*bdims[1] + yb*bdims[0] + xb);
 	_itr = &blk[z*bs[0]*bs[1] + y*bs[0] + x];
 
 	_coordItr += offset;
@@ -792,7 +1209,7 @@ operator+=(const long int &offset) {
 		z = 0;
 		if (dims.size() == 3) z = _index[2] % bs[2];
 
-		float *blk = _rg->GetBlks()[zb*bdims[0]*bdims[1] + yb*bdims[0] + xb];
+		float *blk = _rg->GetBlock(zb*bdims[0]*bdims[1] + yb*bdims[0] + xb);
 		_itr = &blk[z*bs[0]*bs[1] + y*bs[0] + x];
 
 
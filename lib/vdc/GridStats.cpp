@@ -0,0 +1,363 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+#include <vapor/MyBase.h>
+#include <vapor/EasyThreads.h>
+#include <vapor/GridStats.h>
+
+using namespace std;
+using namespace Wasp;
+using namespace VAPoR;
+
+namespace {
+
+int num_threads(int nthreads) {
+	if (nthreads < 1) nthreads = EasyThreads::NProc();
+	return(nthreads < 1 ? 1 : nthreads);
+}
+
+// Grid indices of the last element of a grid
+//
+vector <size_t> last_index(const Grid &g) {
+	vector <size_t> max = g.GetDimensions();
+	for (int i=0; i<max.size(); i++) {
+		if (max[i]) max[i]--;
+	}
+	return(max);
+}
+
+// Invoke f(row, n) for each of the contiguous rows of the part of a
+// block described by ext
+//
+template <typename F>
+void for_each_row(const float *blk, const Grid::BlockExtents &ext, F f) {
+	size_t n = ext.max[0] - ext.min[0] + 1;
+	for (size_t k=ext.min[2]; k<=ext.max[2]; k++) {
+	for (size_t j=ext.min[1]; j<=ext.max[1]; j++) {
+		f(blk + (k * ext.bs[1] + j) * ext.bs[0] + ext.min[0], n);
+	}
+	}
+}
+
+// Offset of the block described by ext, as passed to Grid::GetBlock()
+//
+size_t block_offset(const Grid &g, const Grid::BlockExtents &ext) {
+	const vector <size_t> &dims = g.GetDimensions();
+	size_t offset = 0;
+	for (int i=dims.size()-1; i>=0; i--) {
+		size_t bdim = (dims[i] + ext.bs[i] - 1) / ext.bs[i];
+		offset = offset * bdim + ext.origin[i] / ext.bs[i];
+	}
+	return(offset);
+}
+
+// Test whether v is neither the missing value nor NaN or infinite
+//
+inline bool valid(float v, bool hasMissing, float mv) {
+	return(std::isfinite(v) && ! (hasMissing && v == mv));
+}
+
+};
+
+void GridStats::Moments::Add(double v, double w) {
+	if (! (w > 0.0)) return;
+
+	if (! count) min = max = v;
+	if (v < min) min = v;
+	if (v > max) max = v;
+
+	count++;
+	weight += w;
+	double delta = v - mean;
+	mean += delta * w / weight;
+	m2 += w * delta * (v - mean);
+}
+
+void GridStats::Moments::Merge(const Moments &m) {
+	if (! m.count) return;
+	if (! count) {
+		*this = m;
+		return;
+	}
+
+	double w = weight + m.weight;
+	double delta = m.mean - mean;
+	mean += delta * m.weight / w;
+	m2 += m.m2 + delta * delta * weight * m.weight / w;
+	weight = w;
+	count += m.count;
+	if (m.min < min) min = m.min;
+	if (m.max > max) max = m.max;
+}
+
+double GridStats::Moments::StdDev() const {
+	return(sqrt(Variance()));
+}
+
+void GridStats::Histogram::Init(double lo_, double hi_, size_t nbins) {
+	if (nbins < 1) nbins = 1;
+
+	lo = lo_;
+	hi = hi_;
+	counts.assign(nbins, 0);
+	below = above = 0;
+	_scale = hi > lo ? nbins / (hi - lo) : 0.0;
+}
+
+void GridStats::Histogram::Merge(const Histogram &h) {
+	assert(h.counts.size() == counts.size());
+
+	for (size_t b=0; b<counts.size(); b++) counts[b] += h.counts[b];
+	below += h.below;
+	above += h.above;
+}
+
+size_t GridStats::Histogram::GetTotal() const {
+	size_t total = below + above;
+	for (size_t b=0; b<counts.size(); b++) total += counts[b];
+	return(total);
+}
+
+double GridStats::Histogram::Percentile(double p) const {
+	size_t total = GetTotal();
+	if (! total) return(lo);
+
+	p = std::min(std::max(p, 0.0), 1.0);
+	double target = p * total;
+
+	double cum = below;
+	if (target <= cum) return(lo);
+
+	double width = (hi - lo) / counts.size();
+	for (size_t b=0; b<counts.size(); b++) {
+		if (counts[b] && cum + counts[b] >= target) {
+			return(lo + (b + (target - cum) / counts[b]) * width);
+		}
+		cum += counts[b];
+	}
+	return(hi);
+}
+
+size_t GridStats::ComputeRange(
+	const Grid &g,
+	const vector <size_t> &min, const vector <size_t> &max,
+	double range[2], int nthreads
+) {
+	nthreads = num_threads(nthreads);
+
+	vector <size_t> counts(nthreads, 0);
+	vector <float> mins(nthreads, 0.0);
+	vector <float> maxs(nthreads, 0.0);
+
+	bool hasMissing = g.HasMissingData();
+	float mv = g.GetMissingValue();
+
+	g.ForEachBlockParallel(
+		min, max,
+		[&](const float *blk, const Grid::BlockExtents &ext, int t) {
+			size_t count = counts[t];
+			float vmin = mins[t];
+			float vmax = maxs[t];
+			for_each_row(blk, ext, [&](const float *row, size_t n) {
+				for (size_t i=0; i<n; i++) {
+					float v = row[i];
+					if (! valid(v, hasMissing, mv)) continue;
+					if (! count++) vmin = vmax = v;
+					if (v < vmin) vmin = v;
+					if (v > vmax) vmax = v;
+				}
+			});
+			counts[t] = count;
+			mins[t] = vmin;
+			maxs[t] = vmax;
+		},
+		nthreads
+	);
+
+	size_t count = 0;
+	range[0] = range[1] = 0.0;
+	for (int t=0; t<nthreads; t++) {
+		if (! counts[t]) continue;
+		if (! count) {
+			range[0] = mins[t];
+			range[1] = maxs[t];
+		}
+		range[0] = std::min(range[0], (double) mins[t]);
+		range[1] = std::max(range[1], (double) maxs[t]);
+		count += counts[t];
+	}
+	return(count);
+}
+
+size_t GridStats::ComputeRange(const Grid &g, double range[2], int nthreads) {
+	vector <size_t> min(g.GetDimensions().size(), 0);
+	return(ComputeRange(g, min, last_index(g), range, nthreads));
+}
+
+void GridStats::ComputeMoments(
+	const Grid &g,
+	const vector <size_t> &min, const vector <size_t> &max,
+	Moments &m, int nthreads
+) {
+	nthreads = num_threads(nthreads);
+	vector <Moments> partials(nthreads);
+
+	bool hasMissing = g.HasMissingData();
+	float mv = g.GetMissingValue();
+
+	// Each block is reduced with two passes - the mean, then the squared
+	// deviations from it - while its data are in cache, and the result
+	// merged into the thread's partial moments
+	//
+	g.ForEachBlockParallel(
+		min, max,
+		[&](const float *blk, const Grid::BlockExtents &ext, int t) {
+			Moments bm;
+			double sum = 0.0;
+			for_each_row(blk, ext, [&](const float *row, size_t n) {
+				for (size_t i=0; i<n; i++) {
+					float v = row[i];
+					if (! valid(v, hasMissing, mv)) continue;
+					if (! bm.count++) bm.min = bm.max = v;
+					if (v < bm.min) bm.min = v;
+					if (v > bm.max) bm.max = v;
+					sum += v;
+				}
+			});
+			if (! bm.count) return;
+
+			bm.weight = bm.count;
+			bm.mean = sum / bm.count;
+			for_each_row(blk, ext, [&](const float *row, size_t n) {
+				for (size_t i=0; i<n; i++) {
+					float v = row[i];
+					if (! valid(v, hasMissing, mv)) continue;
+					double delta = v - bm.mean;
+					bm.m2 += delta * delta;
+				}
+			});
+			partials[t].Merge(bm);
+		},
+		nthreads
+	);
+
+	m.Clear();
+	for (int t=0; t<nthreads; t++) m.Merge(partials[t]);
+}
+
+void GridStats::ComputeMoments(const Grid &g, Moments &m, int nthreads) {
+	vector <size_t> min(g.GetDimensions().size(), 0);
+	ComputeMoments(g, min, last_index(g), m, nthreads);
+}
+
+int GridStats::ComputeWeightedMoments(
+	const Grid &g, const Grid &w,
+	const vector <size_t> &min, const vector <size_t> &max,
+	Moments &m, int nthreads
+) {
+	m.Clear();
+
+	if (
+		g.GetDimensions() != w.GetDimensions() ||
+		g.GetBlockSize() != w.GetBlockSize()
+	) {
+		MyBase::SetErrMsg("Weights grid does not match data grid");
+		return(-1);
+	}
+
+	nthreads = num_threads(nthreads);
+	vector <Moments> partials(nthreads);
+
+	bool hasMissing = g.HasMissingData();
+	float mv = g.GetMissingValue();
+	bool wHasMissing = w.HasMissingData();
+	float wmv = w.GetMissingValue();
+
+	g.ForEachBlockParallel(
+		min, max,
+		[&](const float *blk, const Grid::BlockExtents &ext, int t) {
+			const float *wblk = w.GetBlock(block_offset(g, ext));
+
+			auto usable = [&](float v, float wt) {
+				return(
+					valid(v, hasMissing, mv) &&
+					valid(wt, wHasMissing, wmv) && wt > 0.0
+				);
+			};
+
+			Moments bm;
+			double sum = 0.0;
+			for_each_row(blk, ext, [&](const float *row, size_t n) {
+				const float *wrow = wblk + (row - blk);
+				for (size_t i=0; i<n; i++) {
+					float v = row[i];
+					float wt = wrow[i];
+					if (! usable(v, wt)) continue;
+					if (! bm.count++) bm.min = bm.max = v;
+					if (v < bm.min) bm.min = v;
+					if (v > bm.max) bm.max = v;
+					bm.weight += wt;
+					sum += (double) wt * v;
+				}
+			});
+			if (! bm.count) return;
+
+			bm.mean = sum / bm.weight;
+			for_each_row(blk, ext, [&](const float *row, size_t n) {
+				const float *wrow = wblk + (row - blk);
+				for (size_t i=0; i<n; i++) {
+					float v = row[i];
+					float wt = wrow[i];
+					if (! usable(v, wt)) continue;
+					double delta = v - bm.mean;
+					bm.m2 += wt * delta * delta;
+				}
+			});
+			partials[t].Merge(bm);
+		},
+		nthreads
+	);
+
+	for (int t=0; t<nthreads; t++) m.Merge(partials[t]);
+	return(0);
+}
+
+void GridStats::ComputeHistogram(
+	const Grid &g,
+	const vector <size_t> &min, const vector <size_t> &max,
+	Histogram &h, int nthreads
+) {
+	nthreads = num_threads(nthreads);
+
+	Histogram empty = h;
+	empty.Init(h.lo, h.hi, h.counts.size());
+	vector <Histogram> partials(nthreads, empty);
+
+	bool hasMissing = g.HasMissingData();
+	float mv = g.GetMissingValue();
+
+	g.ForEachBlockParallel(
+		min, max,
+		[&](const float *blk, const Grid::BlockExtents &ext, int t) {
+			Histogram &ph = partials[t];
+			for_each_row(blk, ext, [&](const float *row, size_t n) {
+				for (size_t i=0; i<n; i++) {
+					float v = row[i];
+					if (! valid(v, hasMissing, mv)) continue;
+					ph.Add(v);
+				}
+			});
+		},
+		nthreads
+	);
+
+	for (int t=0; t<nthreads; t++) h.Merge(partials[t]);
+}
+
+void GridStats::ComputeHistogram(const Grid &g, Histogram &h, int nthreads) {
+	vector <size_t> min(g.GetDimensions().size(), 0);
+	ComputeHistogram(g, min, last_index(g), h, nthreads);
+}
@@ -2,40 +2,491 @@
 #include <vector>
 #include <cassert>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <thread>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #include <vapor/utils.h>
+#include <vapor/MyBase.h>
+#include <vapor/EasyThreads.h>
 #include <vapor/KDTreeRG.h>
-#include "kdtree.h"
 
 
 using namespace std;
 using namespace VAPoR;
+using namespace Wasp;
 
-KDTreeRG::KDTreeRG( const Grid &xg, 
-                    const Grid &yg ) 
-                :   _points( xg, yg ), 
-                    _kdtree(2 /* dimension */, _points, nanoflann::KDTreeSingleIndexAdaptorParams(20 /* max leaf num */))
-{
-    _dims = xg.GetDimensions();
-    _kdtree.buildIndex();
+namespace {
+
+// Subtrees with no more than this many points are leaves, and are 
+// searched exhaustively
+//
+const size_t LeafSize = 16;
+
+// Subtrees with fewer points than this are not worth handing off to 
+// another thread
+//
+const size_t MinParallelPoints = 65536;
+
+const char FileMagic[8] = {'V','A','P','K','D','T','R','G'};
+const uint32_t FileVersion = 1;
+
+// File header. The header is followed by the offsets, coordinates, and
+// splitting dimensions arrays, in that order. The header size is a
+// multiple of 8 so that all of the arrays are naturally aligned.
+//
+struct header_t {
+	char magic[8];
+	uint32_t version;
+	uint32_t sizeofSizeT;
+	uint32_t ncoords;
+	uint32_t ndims;
+	uint64_t dims[3];
+	uint64_t npoints;
+	uint64_t leafSize;
+	float bounds[6];
+	uint32_t pad[2];
+};
+
+struct point_t {
+	float c[3];
+	size_t offset;
+};
+
+inline float dist2(const float *a, const float *b, int n) {
+	float d = 0.0;
+	for (int i=0; i<n; i++) {
+		d += (a[i] - b[i]) * (a[i] - b[i]);
+	}
+	return(d);
+}
+
+// Recursively partition pts[lo..hi) about the median along the 
+// dimension of greatest extent. The median point stays at the middle of 
+// the range, and the left and right subtrees occupy the two halves, so
+// the tree needs no explicit nodes.
+//
+void build(
+	point_t *pts, size_t lo, size_t hi, unsigned char *splits,
+	int ncoords, int nthreads
+) {
+	if (hi - lo <= LeafSize) return;
+
+	float min[3], max[3];
+	for (int c=0; c<ncoords; c++) min[c] = max[c] = pts[lo].c[c];
+	for (size_t i=lo+1; i<hi; i++) {
+		for (int c=0; c<ncoords; c++) {
+			if (pts[i].c[c] < min[c]) min[c] = pts[i].c[c];
+			if (pts[i].c[c] > max[c]) max[c] = pts[i].c[c];
+		}
+	}
+	int d = 0;
+	for (int c=1; c<ncoords; c++) {
+		if (max[c] - min[c] > max[d] - min[d]) d = c;
+	}
+
+	size_t mid = lo + (hi - lo) / 2;
+	std::nth_element(
+		pts + lo, pts + mid, pts + hi,
+		[d](const point_t &a, const point_t &b) {return(a.c[d] < b.c[d]);}
+	);
+	splits[mid] = d;
+
+	if (nthreads > 1 && hi - lo > MinParallelPoints) {
+		int nleft = nthreads / 2;
+		std::thread left(build, pts, lo, mid, splits, ncoords, nleft);
+		build(pts, mid+1, hi, splits, ncoords, nthreads - nleft);
+		left.join();
+	}
+	else {
+		build(pts, lo, mid, splits, ncoords, 1);
+		build(pts, mid+1, hi, splits, ncoords, 1);
+	}
+}
+
+};
+
+KDTreeRG::KDTreeRG() {
+	_ncoords = 0;
+	_npoints = 0;
+	_dims.clear();
+	for (int i=0; i<6; i++) _bounds[i] = 0.0;
+	_coords = NULL;
+	_offsets = NULL;
+	_splits = NULL;
+	_map = NULL;
+	_mapSize = 0;
+}
+
+KDTreeRG::KDTreeRG( 
+	const Grid &xg, const Grid &yg, int nthreads 
+) : KDTreeRG() {
+	assert(xg.GetDimensions().size() <= 2);
+
+	vector <const Grid *> grids = {&xg, &yg};
+	_build(grids, nthreads);
+}
+
+KDTreeRG::KDTreeRG( 
+	const Grid &xg, const Grid &yg, const Grid &zg, int nthreads 
+) : KDTreeRG() {
+	vector <const Grid *> grids = {&xg, &yg, &zg};
+	_build(grids, nthreads);
 }
 
-KDTreeRG::~KDTreeRG() { }
+KDTreeRG::~KDTreeRG() { 
+	if (! _map) return;
+
+#ifndef WIN32
+	munmap(_map, _mapSize);
+#else
+	delete [] (char *) _map;
+#endif
+}
+
+void KDTreeRG::_build(const vector <const Grid *> &grids, int nthreads) {
+	assert(grids.size() == 2 || grids.size() == 3);
+
+	_dims = grids[0]->GetDimensions();
+	_ncoords = grids.size();
+
+	size_t nelem = 1;
+	for (int i=0; i<_dims.size(); i++) nelem *= _dims[i];
+
+	// Gather the coordinates of every point with finite coordinates
+	//
+	vector <Grid::ConstIterator> itrs;
+	for (int c=0; c<_ncoords; c++) {
+		assert(grids[c]->GetDimensions() == _dims);
+		itrs.push_back(grids[c]->cbegin());
+	}
+
+	vector <point_t> pts;
+	pts.reserve(nelem);
+	for (size_t i=0; i<nelem; i++) {
+		point_t p = {{0.0, 0.0, 0.0}, i};
+		bool finite = true;
+		for (int c=0; c<_ncoords; c++) {
+			p.c[c] = *itrs[c];
+			++itrs[c];
+			if (! std::isfinite(p.c[c])) finite = false;
+		}
+		if (finite) pts.push_back(p);
+	}
+	_npoints = pts.size();
+
+	for (size_t i=0; i<_npoints; i++) {
+		for (int c=0; c<_ncoords; c++) {
+			if (i == 0 || pts[i].c[c] < _bounds[c]) _bounds[c] = pts[i].c[c];
+			if (i == 0 || pts[i].c[c] > _bounds[3+c]) _bounds[3+c] = pts[i].c[c];
+		}
+	}
+
+	if (nthreads < 1) nthreads = EasyThreads::NProc();
+	if (nthreads < 1) nthreads = 1;
+
+	_splitsBuf.assign(_npoints, 0);
+	build(pts.data(), 0, _npoints, _splitsBuf.data(), _ncoords, nthreads);
+
+	_coordsBuf.resize(_npoints * _ncoords);
+	_offsetsBuf.resize(_npoints);
+	for (size_t i=0; i<_npoints; i++) {
+		for (int c=0; c<_ncoords; c++) {
+			_coordsBuf[i*_ncoords + c] = pts[i].c[c];
+		}
+		_offsetsBuf[i] = pts[i].offset;
+	}
+
+	_coords = _coordsBuf.data();
+	_offsets = _offsetsBuf.data();
+	_splits = _splitsBuf.data();
+}
 
 void KDTreeRG::Nearest( const vector <float> &coordu, vector <size_t> &coord) const 
 {
-    assert( coordu.size() == 2 );   // 3D case isn't supported yet
-
-    size_t  ret_index;
-    float   dist_sqr;
-    nanoflann::KNNResultSet<float, size_t> resultSet(1);
-    resultSet.init( &ret_index, &dist_sqr );
-    bool rt = _kdtree.findNeighbors( resultSet, coordu.data(), nanoflann::SearchParams() );
-    assert( rt );
+    assert( coordu.size() == _ncoords );
 
     // De-serialize the linear offset and put it back in vector form
     coord.clear();
-    coord = Wasp::VectorizeCoords( ret_index, _dims );
+    coord = Wasp::VectorizeCoords( _nearestOffset(coordu.data()), _dims );
+}
+
+void KDTreeRG::Nearest(const Grid::DblArr3 &coordu, Grid::Size_tArr3 &index) const
+{
+    float pt[3];
+    for (int c=0; c<3; c++) pt[c] = coordu[c];
+
+    size_t offset = _nearestOffset(pt);
+
+    index = {0, 0, 0};
+    for (int i=0; i<_dims.size() && i<3; i++) {
+        index[i] = offset % _dims[i];
+        offset /= _dims[i];
+    }
+}
+
+// Linear offset of the point nearest pt
+//
+size_t KDTreeRG::_nearestOffset(const float *pt) const
+{
+    if (! _npoints) return(0);
+
+    size_t best = 0;
+    float bestDist = std::numeric_limits<float>::infinity();
+
+    // Squared distances from the point to the bounding box of the
+    // points along each axis
+    //
+    float dists[3] = {0.0, 0.0, 0.0};
+    float mindist = 0.0;
+    for (int c=0; c<_ncoords; c++) {
+        float d = 0.0;
+        if (pt[c] < _bounds[c]) d = _bounds[c] - pt[c];
+        if (pt[c] > _bounds[3+c]) d = pt[c] - _bounds[3+c];
+        dists[c] = d * d;
+        mindist += dists[c];
+    }
+
+    _nearest(pt, 0, _npoints, mindist, dists, best, bestDist);
+
+    return(_offsets[best]);
+}
+
+void KDTreeRG::_nearest(
+	const float *pt, size_t lo, size_t hi, float mindist, float dists[3],
+	size_t &best, float &bestDist
+) const {
+	if (hi - lo <= LeafSize) {
+		for (size_t i=lo; i<hi; i++) {
+			float d = dist2(pt, &_coords[i*_ncoords], _ncoords);
+			if (d < bestDist) {
+				bestDist = d;
+				best = i;
+			}
+		}
+		return;
+	}
+
+	size_t mid = lo + (hi - lo) / 2;
+	const float *p = &_coords[mid*_ncoords];
+	float d = dist2(pt, p, _ncoords);
+	if (d < bestDist) {
+		bestDist = d;
+		best = mid;
+	}
+
+	// Search the side of the splitting plane containing the point
+	// first. The other side can only contain a closer point if its
+	// bounding box is closer than the best point found so far. The
+	// distance to the box is updated incrementally: crossing the plane 
+	// replaces the distance along the splitting axis with the distance
+	// to the plane.
+	//
+	int s = _splits[mid];
+	float diff = pt[s] - p[s];
+	size_t nlo = diff < 0.0 ? lo : mid+1;
+	size_t nhi = diff < 0.0 ? mid : hi;
+	size_t flo = diff < 0.0 ? mid+1 : lo;
+	size_t fhi = diff < 0.0 ? hi : mid;
+
+	_nearest(pt, nlo, nhi, mindist, dists, best, bestDist);
+
+	float saved = dists[s];
+	float fmindist = mindist + diff * diff - saved;
+	if (fmindist < bestDist) {
+		dists[s] = diff * diff;
+		_nearest(pt, flo, fhi, fmindist, dists, best, bestDist);
+		dists[s] = saved;
+	}
+}
+
+size_t KDTreeRG::GetMemoryUsage() const {
+	return(
+		sizeof(*this) +
+		_coordsBuf.capacity() * sizeof(_coordsBuf[0]) +
+		_offsetsBuf.capacity() * sizeof(_offsetsBuf[0]) +
+		_splitsBuf.capacity() * sizeof(_splitsBuf[0]) +
+		_mapSize
+	);
+}
+
+int KDTreeRG::Write(const string &path) const {
+
+	header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, FileMagic, sizeof(header.magic));
+	header.version = FileVersion;
+	header.sizeofSizeT = sizeof(size_t);
+	header.ncoords = _ncoords;
+	header.ndims = _dims.size();
+	for (int i=0; i<_dims.size() && i<3; i++) header.dims[i] = _dims[i];
+	header.npoints = _npoints;
+	header.leafSize = LeafSize;
+	for (int i=0; i<6; i++) header.bounds[i] = _bounds[i];
+
+	// Write to a temporary file and rename it, so that a reader never
+	// sees a partially written file
+	//
+	string tmppath = path + ".XXXXXX";
+	vector <char> pathbuf(tmppath.begin(), tmppath.end());
+	pathbuf.push_back('\0');
+
+#ifndef WIN32
+	int fd = mkstemp(pathbuf.data());
+	FILE *fp = fd < 0 ? NULL : fdopen(fd, "wb");
+#else
+	FILE *fp = fopen(_mktemp(pathbuf.data()), "wb");
+#endif
+	if (! fp) {
+		MyBase::SetErrMsg("Failed to create file %s : %M", pathbuf.data());
+		return(-1);
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+	if (ok && _npoints) {
+		ok = 
+			fwrite(_offsets, sizeof(*_offsets), _npoints, fp) == _npoints &&
+			fwrite(
+				_coords, sizeof(*_coords), _npoints*_ncoords, fp
+			) == _npoints*_ncoords &&
+			fwrite(_splits, sizeof(*_splits), _npoints, fp) == _npoints;
+	}
+	if (fclose(fp) != 0) ok = false;
+
+	if (! ok || rename(pathbuf.data(), path.c_str()) != 0) {
+		MyBase::SetErrMsg("Failed to write file %s : %M", path.c_str());
+		remove(pathbuf.data());
+		return(-1);
+	}
+	return(0);
+}
+
+KDTreeRG *KDTreeRG::Read(const string &path) {
+
+	void *map = NULL;
+	size_t mapSize = 0;
+
+#ifndef WIN32
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		MyBase::SetErrMsg("Failed to open file %s : %M", path.c_str());
+		return(NULL);
+	}
+	struct stat statbuf;
+	if (fstat(fd, &statbuf) < 0) {
+		MyBase::SetErrMsg("Failed to stat file %s : %M", path.c_str());
+		close(fd);
+		return(NULL);
+	}
+	mapSize = statbuf.st_size;
+	if (mapSize >= sizeof(header_t)) {
+		map = mmap(NULL, mapSize, PROT_READ, MAP_SHARED, fd, 0);
+		if (map == MAP_FAILED) {
+			MyBase::SetErrMsg("Failed to map file %s : %M", path.c_str());
+			close(fd);
+			return(NULL);
+		}
+	}
+	close(fd);
+#else
+	FILE *fp = fopen(path.c_str(), "rb");
+	if (! fp) {
+		MyBase::SetErrMsg("Failed to open file %s : %M", path.c_str());
+		return(NULL);
+	}
+	fseek(fp, 0, SEEK_END);
+	mapSize = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if (mapSize >= sizeof(header_t)) {
+		map = new char[mapSize];
+		if (fread(map, 1, mapSize, fp) != mapSize) mapSize = 0;
+	}
+	fclose(fp);
+#endif
+
+	header_t header;
+	memset(&header, 0, sizeof(header));
+	if (map && mapSize >= sizeof(header)) {
+		memcpy(&header, map, sizeof(header));
+	}
+
+	size_t npoints = header.npoints;
+	bool ok = 
+		memcmp(header.magic, FileMagic, sizeof(header.magic)) == 0 &&
+		header.version == FileVersion &&
+		header.sizeofSizeT == sizeof(size_t) &&
+		(header.ncoords == 2 || header.ncoords == 3) &&
+		header.ndims >= 1 && header.ndims <= 3 &&
+		header.leafSize == LeafSize &&
+		npoints <= mapSize &&
+		mapSize == sizeof(header) + npoints * (
+			sizeof(size_t) + header.ncoords * sizeof(float) + 1
+		);
+
+	// The tree holds at most one point for each node of the grid
+	//
+	size_t nelem = 1;
+	for (int i=0; ok && i<header.ndims; i++) {
+		if (header.dims[i] && 
+			nelem > std::numeric_limits<size_t>::max() / header.dims[i]) {
+
+			ok = false;
+		}
+		nelem *= header.dims[i];
+	}
+	ok = ok && npoints <= nelem;
+
+	KDTreeRG *kdtree = new KDTreeRG();
+	kdtree->_map = map;
+	kdtree->_mapSize = mapSize;
+
+	// The searches index the grid with the offsets, and the coordinates
+	// with the splitting dimensions, without checking them
+	//
+	const size_t *offsets = NULL;
+	const float *coords = NULL;
+	const unsigned char *splits = NULL;
+	if (ok) {
+		const char *ptr = (const char *) map + sizeof(header);
+		offsets = (const size_t *) ptr;
+		ptr += npoints * sizeof(size_t);
+		coords = (const float *) ptr;
+		ptr += npoints * header.ncoords * sizeof(float);
+		splits = (const unsigned char *) ptr;
+	}
+
+	for (size_t i=0; ok && i<npoints; i++) {
+		if (offsets[i] >= nelem || splits[i] >= header.ncoords) ok = false;
+	}
+
+	if (! ok) {
+		MyBase::SetErrMsg("Invalid k-d tree file %s", path.c_str());
+		delete kdtree;
+		return(NULL);
+	}
+
+	kdtree->_ncoords = header.ncoords;
+	kdtree->_npoints = npoints;
+	for (int i=0; i<6; i++) kdtree->_bounds[i] = header.bounds[i];
+	for (int i=0; i<header.ndims; i++) {
+		kdtree->_dims.push_back(header.dims[i]);
+	}
+
+	kdtree->_offsets = offsets;
+	kdtree->_coords = coords;
+	kdtree->_splits = splits;
+
+	return(kdtree);
 }
 
 
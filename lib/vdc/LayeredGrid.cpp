@@ -3,12 +3,50 @@
 #include <cassert>
 #include <cmath>
 #include <cfloat>
+#include <algorithm>
+#include <thread>
 #include "vapor/utils.h"
+#include "vapor/EasyThreads.h"
 #include "vapor/LayeredGrid.h"
 #include "vapor/glutil.h"
 
 using namespace std;
 using namespace VAPoR;
+using namespace Wasp;
+
+namespace {
+
+// Number of points located together by GetValues(). Points in a batch
+// are sorted by column so that each column is gathered once.
+//
+const size_t ColumnBatchSize = 4096;
+
+// Find the layer of a column containing z. zk(k) returns the vertical
+// coordinate of level k of the column, which must increase with k.
+// Returns -1 if z is below the column and 1 if it is above, otherwise 
+// returns 0 and sets k to the largest level in [0, nz-2] with 
+// zk(k) <= z. The search has a fixed trip count and the comparison 
+// only selects the next base, so the compiler can use a conditional 
+// move rather than a hard to predict branch.
+//
+template <class ZK>
+int search_column(const ZK &zk, size_t nz, double z, size_t &k) {
+	k = 0;
+	if (z < zk(0)) return(-1);
+	if (z > zk(nz-1)) return(1);
+
+	size_t base = 0;
+	size_t len = nz > 1 ? nz - 1 : 1;
+	while (len > 1) {
+		size_t half = len / 2;
+		base = zk(base + half) <= z ? base + half : base;
+		len -= half;
+	}
+	k = base;
+	return(0);
+}
+
+};
 
 void LayeredGrid::_layeredGrid(
     const vector <double> &minu,
@@ -140,20 +178,23 @@ void    LayeredGrid::GetEnclosingRegion(
 	//
 	// Get coords for non-varying dimension AND varying dimension. 
 	//
+	// Round outward to the nearest grid points, so that the region is
+	// enclosed
+	//
+	vector <size_t> dims = GetDimensions();
 	for (int i=0; i<2; i++) {
 		assert(cMinu[i] <= cMaxu[i]);
-		double u = cMinu[i];
-		if (u < cMinu[i]) {
-			u = cMinu[i];
+		size_t index = 0;
+		if (_delta[i] != 0.0) {
+			index = (size_t) floor ((cMinu[i] - _minu[i]) / _delta[i]);
 		}
-		size_t index = (u - _minu[i]) / _delta[i];
 		min.push_back(index);
 
-		u = cMaxu[i];
-		if (u > cMaxu[i]) {
-			u = cMaxu[i];
+		index = 0;
+		if (_delta[i] != 0.0) {
+			index = (size_t) ceil ((cMaxu[i] - _minu[i]) / _delta[i]);
 		}
-		index = (u - _maxu[i]) / _delta[i];
+		if (index > dims[i]-1) index = dims[i]-1;
 		max.push_back(index);
 	}
 
@@ -163,7 +204,6 @@ void    LayeredGrid::GetEnclosingRegion(
 
 	min.push_back(0.0);
 	max.push_back(0.0);
-	vector <size_t> dims = GetDimensions();
 
 	bool done;
 	double z;
@@ -358,6 +398,220 @@ float LayeredGrid::GetValue(const std::vector <double> &coords) const {
 
 }
 
+void LayeredGrid::GetValues(
+	const double *xyz, size_t n, float *values
+) const {
+
+	vector <size_t> dims = GetDimensions();
+
+	// Only linear interpolation is done in batch
+	//
+	int interp_order = _interpolationOrder;
+	if (interp_order == 2 && dims[2] < 3) interp_order = 1;
+	if (interp_order != 1) {
+		StructuredGrid::GetValues(xyz, n, values);
+		return;
+	}
+
+	vector <bool> periodic = GetPeriodic();
+	const size_t outside = (size_t) -1;
+
+	// Cell indices are found as in GetIndicesCell(), and weights computed
+	// as in GetValueLinear(), so that the results match GetValue().
+	// Points are located a batch at a time. The points of a batch are 
+	// sorted by the column (I,J) containing them, and the Z coordinates 
+	// of each column are gathered from the blocks once, into a contiguous
+	// array that is searched for each of the column's points.
+	//
+	vector <float> zcol(dims[2]);
+	vector <CellLocation> locs;
+	vector <pair <size_t, size_t> > order;
+	vector <double> clamped;
+
+	for (size_t p0=0; p0<n; p0+=ColumnBatchSize) {
+		size_t m = std::min(ColumnBatchSize, n-p0);
+		const double *batch = xyz + 3*p0;
+
+		locs.resize(m);
+		order.resize(m);
+		clamped.resize(3*m);
+		for (size_t p=0; p<m; p++) {
+			CellLocation &l = locs[p];
+			l.inside = false;
+			for (int i=0; i<3; i++) {
+				l.index[i] = 0;
+				l.wgt[i] = 0.0;
+			}
+
+			const double *coords = batch + 3*p;
+			double *c = &clamped[3*p];
+			for (int i=0; i<3; i++) {
+				c[i] = ClampCoord(
+					coords[i], dims[i], periodic[i], _minu[i], _maxu[i]
+				);
+			}
+
+			order[p] = make_pair(outside, p);
+			if (c[0] < _minu[0] || c[0] > _maxu[0]) continue;
+			if (c[1] < _minu[1] || c[1] > _maxu[1]) continue;
+
+			size_t i0 = 0;
+			size_t j0 = 0;
+			if (_delta[0] != 0.0) i0 = (size_t) floor ((c[0]-_minu[0]) / _delta[0]);
+			if (_delta[1] != 0.0) j0 = (size_t) floor ((c[1]-_minu[1]) / _delta[1]);
+			order[p].first = j0 * dims[0] + i0;
+		}
+		std::sort(order.begin(), order.end());
+
+		size_t column = outside;
+		for (size_t o=0; o<m && order[o].first != outside; o++) {
+			size_t p = order[o].second;
+			size_t i0 = order[o].first % dims[0];
+			size_t j0 = order[o].first / dims[0];
+			if (order[o].first != column) {
+				_getColumn(i0, j0, zcol.data());
+				column = order[o].first;
+			}
+
+			double x = clamped[3*p];
+			double y = clamped[3*p+1];
+			double z = clamped[3*p+2];
+
+			size_t k0;
+			auto zk = [&](size_t k) {return(zcol[k]);};
+			if (search_column(zk, dims[2], z, k0) != 0) continue;
+
+			size_t i1 = i0+1 < dims[0] ? i0+1 : dims[0]-1;
+			size_t j1 = j0+1 < dims[1] ? j0+1 : dims[1]-1;
+
+			double x0 = i0 * _delta[0] + _minu[0];
+			double y0 = j0 * _delta[1] + _minu[1];
+			double x1 = i1 * _delta[0] + _minu[0];
+			double y1 = j1 * _delta[1] + _minu[1];
+			double z0 = _interpolateVaryingCoord(i0,j0,k0,x,y);
+			double z1 = _interpolateVaryingCoord(i0,j0,k0+1,x,y);
+
+			CellLocation &l = locs[p];
+			l.inside = true;
+			l.index[0] = i0;
+			l.index[1] = j0;
+			l.index[2] = k0;
+			if (x1!=x0) l.wgt[0] = fabs((x-x0) / (x1-x0));
+			if (y1!=y0) l.wgt[1] = fabs((y-y0) / (y1-y0));
+			if (z1!=z0) l.wgt[2] = fabs((z-z0) / (z1-z0));
+		}
+
+		auto locate = [&](const double *coords, CellLocation &l) {
+			l = locs[(coords - batch) / 3];
+		};
+		InterpolatePoints(batch, m, false, locate, values + p0);
+	}
+}
+
+void LayeredGrid::GetValuesAtHeight(
+	double z, float *values, int nthreads
+) const {
+	GetValuesAtLevel(_rg, z, values, nthreads);
+}
+
+void LayeredGrid::GetValuesAtLevel(
+	const Grid &level, double value, float *values, int nthreads
+) const {
+	const vector <size_t> &dims = GetDimensions();
+	const vector <size_t> &bs = GetBlockSize();
+	const vector <size_t> &bdims = GetDimensionInBlks();
+	float mv = GetMissingValue();
+	float lmv = level.GetMissingValue();
+	bool hasMissing = HasMissingData();
+	bool levelHasMissing = level.HasMissingData();
+
+	assert(level.GetDimensions() == dims);
+	assert(level.GetBlockSize() == bs);
+
+	size_t nxy = dims[0] * dims[1];
+	for (size_t ij=0; ij<nxy; ij++) values[ij] = mv;
+	if (! GetBlock(0) || ! level.GetBlock(0)) return;
+
+	if (nthreads < 1) nthreads = EasyThreads::NProc();
+	size_t ncols = bdims[0] * bdims[1];
+	if (nthreads > ncols) nthreads = ncols;
+	if (nthreads < 1) nthreads = 1;
+
+	// Each thread handles a contiguous range of block columns, and walks
+	// down the blocks of each block column once, bottom to top. The level 
+	// and function values at the previous K of every (I,J) in the block
+	// column are kept so that the first layer crossing the level can be 
+	// found, and interpolated, without revisiting any block. The output
+	// values of different block columns don't overlap.
+	//
+	auto worker = [&](size_t c0, size_t c1) {
+		size_t bsxy = bs[0] * bs[1];
+		vector <float> prevLevel(bsxy);
+		vector <float> prevValue(bsxy);
+		vector <bool> done(bsxy);
+
+		for (size_t c=c0; c<c1; c++) {
+			size_t ib = c % bdims[0];
+			size_t jb = c / bdims[0];
+			size_t ni = std::min(bs[0], dims[0] - ib*bs[0]);
+			size_t nj = std::min(bs[1], dims[1] - jb*bs[1]);
+
+			std::fill(done.begin(), done.end(), false);
+			for (size_t kb=0, k=0; kb<bdims[2]; kb++) {
+				size_t b = (kb * bdims[1] + jb) * bdims[0] + ib;
+				const float *blk = GetBlock(b);
+				const float *lblk = level.GetBlock(b);
+				size_t nk = std::min(bs[2], dims[2] - kb*bs[2]);
+
+				for (size_t kk=0; kk<nk; kk++, k++) {
+				for (size_t jj=0; jj<nj; jj++) {
+				for (size_t ii=0; ii<ni; ii++) {
+					size_t q = jj * bs[0] + ii;
+					if (done[q]) continue;
+
+					size_t offset = kk * bsxy + q;
+					float l1 = lblk[offset];
+					float v1 = blk[offset];
+					bool valid = ! (levelHasMissing && l1 == lmv);
+
+					if (k > 0 && valid && ! std::isnan(prevLevel[q])) {
+						float l0 = prevLevel[q];
+						if ((l0 <= value && value <= l1) || 
+							(l1 <= value && value <= l0)) {
+
+							size_t ij = (jb*bs[1] + jj) * dims[0] + ib*bs[0] + ii;
+							float v0 = prevValue[q];
+							if (! (hasMissing && (v0 == mv || v1 == mv))) {
+								double w = l1 != l0 ? (value - l0) / (l1 - l0) : 0.0;
+								values[ij] = v0 + w * (v1 - v0);
+							}
+							done[q] = true;
+							continue;
+						}
+					}
+					prevLevel[q] = valid ? l1 : NAN;
+					prevValue[q] = v1;
+				}
+				}
+				}
+			}
+		}
+	};
+
+	vector <std::thread> threads;
+	for (int t=0; t<nthreads; t++) {
+		size_t c0 = ncols * t / nthreads;
+		size_t c1 = ncols * (t+1) / nthreads;
+		if (t == nthreads-1) {
+			worker(c0, c1);
+		}
+		else {
+			threads.push_back(std::thread(worker, c0, c1));
+		}
+	}
+	for (auto &t : threads) t.join();
+}
+
 void LayeredGrid::SetInterpolationOrder(int order) {
     if (order<0 || order>3) order = 2;
     _interpolationOrder = order;
@@ -367,53 +621,57 @@ void LayeredGrid::GetUserCoordinates(
 	const std::vector <size_t> &indices,
 	std::vector <double> &coords
 ) const {
+	Size_tArr3 cIndices;
+	CopyToArr3(indices, cIndices);
 
-    vector <size_t> cIndices = indices;
-    ClampIndex(cIndices); 
-	
-	assert(cIndices.size() == 3);
-	coords.clear();
+	DblArr3 cCoords;
+	GetUserCoordinates(cIndices, cCoords);
+	CopyFromArr3(cCoords, 3, coords);
+}
+
+void LayeredGrid::GetUserCoordinates(
+	const Size_tArr3 &indices, DblArr3 &coords
+) const {
+
+	Size_tArr3 cIndices = indices;
+	ClampIndex(cIndices); 
 
 	// First get coordinates of non-varying (horizontal) dimensions
 	//
-	vector <size_t> dims = GetDimensions();
-	assert(cIndices.size() == dims.size());
-
 	for (int i=0; i<2; i++) {
-		size_t index = cIndices[i];
-
-		if (index >= dims[i]) {
-			index = dims[i] - 1;
-		}
-
-		coords.push_back(cIndices[i] * _delta[i] + _minu[i]);
+		coords[i] = cIndices[i] * _delta[i] + _minu[i];
 	}
 
 	// Now get coordinates of varying dimension
 	//
-	float v = _rg.AccessIndex(cIndices);
-	coords.push_back(v);
+	coords[2] = _zAt(cIndices[0], cIndices[1], cIndices[2]);
 }
 
 void LayeredGrid::GetIndices(
 	const std::vector <double> &coords,
 	std::vector <size_t> &indices
 ) const {
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
 
-	indices.clear();
+	Size_tArr3 cIndices;
+	GetIndices(cCoords, cIndices);
+	CopyFromArr3(cIndices, 3, indices);
+}
 
-	std::vector <double> clampedCoords = coords;
-	ClampCoord(clampedCoords);
+void LayeredGrid::GetIndices(
+	const DblArr3 &coords, Size_tArr3 &indices
+) const {
 
-	vector <size_t> dims = GetDimensions();
+	DblArr3 clampedCoords = coords;
+	ClampCoord(clampedCoords);
 
-	vector <double> wgts;
+	const vector <size_t> &dims = GetDimensions();
 
 	// Get the two horizontal offsets
 	//
+	indices = {0, 0, 0};
 	for (int i=0; i<2; i++) {
-		indices.push_back(0);
-
 		if (clampedCoords[i] < _minu[i]) {
 			indices[i] = 0;
 			continue;
@@ -433,7 +691,7 @@ void LayeredGrid::GetIndices(
 
 		double wgt = 0.0;
 
-		if (_delta[0] != 0.0) {
+		if (_delta[i] != 0.0) {
 			wgt = ((clampedCoords[i]-_minu[i]) - (indices[i]*_delta[i])) /
 			_delta[i];
 		}
@@ -452,17 +710,10 @@ void LayeredGrid::GetIndices(
 	// vertical column  (negative number if below, positive if above);
 	//
 	if (rc != 0) {
-		if (rc < 0) {
-			indices.push_back(0);
-			return;
-		}
-		else {
-			indices.push_back(dims[2]-1);
-			return;
-		}
+		indices[2] = rc < 0 ? 0 : dims[2]-1;
+		return;
 	}
 
-
 	double z0 = _interpolateVaryingCoord(
 		indices[0],indices[1],k0,clampedCoords[0],clampedCoords[1]
 	);
@@ -470,10 +721,10 @@ void LayeredGrid::GetIndices(
 		indices[0],indices[1],k0+1,clampedCoords[0],clampedCoords[1]
 	);
 	if (fabs(clampedCoords[2]-z0) < fabs(clampedCoords[2]-z1)) {
-		indices.push_back(k0);
+		indices[2] = k0;
 	}
 	else {
-		indices.push_back(k0+1);
+		indices[2] = k0+1;
 	}
 }
 
@@ -481,19 +732,30 @@ bool LayeredGrid::GetIndicesCell(
 	const std::vector <double> &coords,
 	std::vector <size_t> &indices
 ) const {
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
+
+	Size_tArr3 cIndices;
+	bool status = GetIndicesCell(cCoords, cIndices);
 
 	indices.clear();
+	if (status) CopyFromArr3(cIndices, 3, indices);
+	return(status);
+}
+
+bool LayeredGrid::GetIndicesCell(
+	const DblArr3 &coords, Size_tArr3 &indices
+) const {
 
-	std::vector <double> clampedCoords = coords;
+	DblArr3 clampedCoords = coords;
 	ClampCoord(clampedCoords);
 
-	vector <size_t> dims = GetDimensions();
+	const vector <size_t> &dims = GetDimensions();
 
 	// Get horizontal indices from regular grid
 	//
+	indices = {0, 0, 0};
 	for (int i=0; i<2; i++) {
-		indices.push_back(0);
-
 		if (clampedCoords[i] < _minu[i] || clampedCoords[i] > _maxu[i]) {
 			return(false);
 		}
@@ -513,22 +775,29 @@ bool LayeredGrid::GetIndicesCell(
 	int rc = _bsearchKIndexCell(indices[0],indices[1],clampedCoords[2], k);
 	if (rc != 0) return (false);
 
-	indices.push_back(k);
+	indices[2] = k;
 
 	return(true);
 }
 
-
 bool LayeredGrid::InsideGrid(const std::vector <double> &coords) const {
 	assert(coords.size() == 3);
 
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
+
+	return(InsideGrid(cCoords));
+}
+
+bool LayeredGrid::InsideGrid(const DblArr3 &coords) const {
+
 	// Clamp coordinates on periodic boundaries to reside within the 
 	// grid extents (vary-dimensions can not have periodic boundaries)
 	//
-	vector <double> clampedCoords = coords;
+	DblArr3 clampedCoords = coords;
 	ClampCoord(clampedCoords);
 
-	vector <size_t> indices;
+	Size_tArr3 indices;
 	bool found = GetIndicesCell(clampedCoords, indices);
 	return (found);
 
@@ -788,31 +1057,29 @@ double LayeredGrid::_interpolateVaryingCoord(
 	size_t i0, size_t j0, size_t k0,
 	double x, double y) const {
 
-	// varying dimension coord at corner grid points of cell face
-	//
-	double c00, c01, c10, c11;	
-
-	vector <size_t> dims = GetDimensions();
+	const vector <size_t> &dims = GetDimensions();
 
-	size_t i1, j1, k1;
+	size_t i1, j1;
 	if (i0 == dims[0]-1) i1 = i0;
 	else i1 = i0+1;
 	if (j0 == dims[1]-1) j1 = j0;
 	else j1 = j0+1;
-	if (k0 == dims[2]-1) k1 = k0;
-	else k1 = k0+1;
 
 	// Coordinates of grid points for non-varying dimensions 
-	double x0, y0, z0, x1, y1, z1;	
-	GetUserCoordinates(i0,j0,k0, x0, y0, z0);
-	GetUserCoordinates(i1,j1,k1, x1, y1, z1);
-	double iwgt, jwgt;
+	//
+	double x0 = i0 * _delta[0] + _minu[0];
+	double y0 = j0 * _delta[1] + _minu[1];
+	double x1 = i1 * _delta[0] + _minu[0];
+	double y1 = j1 * _delta[1] + _minu[1];
 
-	c00 = _rg.AccessIJK( i0, j0, k0);
-	c01 = _rg.AccessIJK( i1, j0, k0);
-	c10 = _rg.AccessIJK( i0, j1, k0);
-	c11 = _rg.AccessIJK( i1, j1, k0);
+	// varying dimension coord at corner grid points of cell face
+	//
+	double c00 = _zAt(i0, j0, k0);
+	double c01 = _zAt(i1, j0, k0);
+	double c10 = _zAt(i0, j1, k0);
+	double c11 = _zAt(i1, j1, k0);
 
+	double iwgt, jwgt;
 	if (x1!=x0) iwgt = fabs((x-x0) / (x1-x0));
 	else iwgt = 0.0;
 	if (y1!=y0) jwgt = fabs((y-y0) / (y1-y0));
@@ -822,108 +1089,44 @@ double LayeredGrid::_interpolateVaryingCoord(
 	return(z);
 }
 
-namespace {
-double pointDotPlane(
-	const vector <double> &v1,
-	const vector <double> &v2,
-	const vector <double> &v3,
-	const vector <double> &p
-) {
-	double vec1_2[3] = {v2[0] - v1[0], v2[1] - v1[1], v2[2] - v1[2]};
-	double vec1_3[3] = {v3[0] - v1[0], v3[1] - v1[1], v3[2] - v1[2]};
-	double vp[3] = {p[0] - v1[0], p[1] - v1[1], p[2] - v1[2]};
-	double normal[3];
-
-	vcross(vec1_2, vec1_3, normal);
-
-	return(vdot(normal, vp));
-}
-};
-
 int LayeredGrid::_bsearchKIndexCell(
 	size_t i, size_t j, double z,
 	size_t &k
 ) const {
-	k = 0;
+	const vector <size_t> &dims = GetDimensions();
 
-	vector <size_t> dims = GetDimensions();
-	
-    // Binary search for starting index of cell containing z
-    //
-
-	// Indices of bottom level triangle inside of column containing point
-	//
-	vector <size_t> v1idx = {i,j,0};
-	vector <size_t> v2idx = {i+1,j,0};
-	vector <size_t> v3idx = {i,j+1,0};
-
-	// Coordinates of bottom level triangle inside column containing point
-	// The horizontal coordinates (X & Y) don't change for the search
+	// The layers of a column are bounded by the horizontal planes 
+	// through its nodes, so the search compares z with the column's Z 
+	// coordinates
 	//
-	vector <double> v1;
-	vector <double> v2;
-	vector <double> v3;
-	vector <double> pt;
-
-	GetUserCoordinates(v1idx, v1);
-	GetUserCoordinates(v2idx, v2);
-	GetUserCoordinates(v3idx, v3);
-
-	// Coordinates of point we're looking for. X & Y are meaningless. Just
-	// use first triangle vertex.
-	//
-	pt = v1;
-	pt[2] = z;
-
-    size_t k0 = 0;
-    size_t k1 = dims[2]-1;
-
-	// See if point is below or above the column
-	//
-	v1[2] = _rg.AccessIJK(i, j, k0);
-	v2[2] = _rg.AccessIJK(i+1, j, k0);
-	v3[2] = _rg.AccessIJK(i, j+1, k0);
-	double d = pointDotPlane(v1, v2, v3, pt);
-	if (d<0.0) return(-1);
-
-	v1[2] = _rg.AccessIJK(i, j, k1);
-	v2[2] = _rg.AccessIJK(i+1, j, k1);
-	v3[2] = _rg.AccessIJK(i, j+1, k1);
-	d = pointDotPlane(v1, v2, v3, pt);
-	if (d>0.0) return(1);
-
-
-	// point is inside column. Now find it
-	//
-	while (k1-k0>1) {
-
-		// Update Z coordinate only for search
-		//
-		v1[2] = _rg.AccessIJK(i, j, (k0+k1)>>1);
-		v2[2] = _rg.AccessIJK(i+1, j, (k0+k1)>>1);
-		v3[2] = _rg.AccessIJK(i, j+1, (k0+k1)>>1);
-
-		// d is signed distance from plane. Sign determines if it is
-		// above triangle (positive) or below (negative)
-		//
-		double d = pointDotPlane(v1, v2, v3, pt);
+	auto zk = [&](size_t kk) {return(_zAt(i, j, kk));};
+	return(search_column(zk, dims[2], z, k));
+}
 
-		// Pathlogical case. Point is on triangle.
-		//
-		if (d == 0.0) {
-			k0 = (k0+k1)>>1;
-			break;
-		}
+float LayeredGrid::_zAt(size_t i, size_t j, size_t k) const {
+	const vector <size_t> &bs = _rg.GetBlockSize();
+	const vector <size_t> &bdims = _rg.GetDimensionInBlks();
+	const float *blk = _rg.GetBlock(
+		((k / bs[2]) * bdims[1] + (j / bs[1])) * bdims[0] + (i / bs[0])
+	);
+	return(blk[((k % bs[2]) * bs[1] + (j % bs[1])) * bs[0] + (i % bs[0])]);
+}
 
-		if (d < 0.0) {
-			k1 = (k0+k1)>>1;
+void LayeredGrid::_getColumn(size_t i, size_t j, float *zcol) const {
+	const vector <size_t> &dims = GetDimensions();
+	const vector <size_t> &bs = _rg.GetBlockSize();
+	const vector <size_t> &bdims = _rg.GetDimensionInBlks();
+	size_t ib = i / bs[0];
+	size_t jb = j / bs[1];
+	size_t offset = (j % bs[1]) * bs[0] + (i % bs[0]);
+	size_t stride = bs[0] * bs[1];
+
+	for (size_t kb=0, k=0; k<dims[2]; kb++) {
+		const float *ptr = _rg.GetBlock(
+			(kb * bdims[1] + jb) * bdims[0] + ib
+		) + offset;
+		for (size_t kk=0; kk<bs[2] && k<dims[2]; kk++, k++, ptr += stride) {
+			zcol[k] = *ptr;
 		}
-		else {
-			k0 = (k0+k1)>>1;
-		}
-
 	}
-	k = k0;
-
-    return(0);
 }
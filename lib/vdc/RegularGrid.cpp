@@ -218,6 +218,45 @@ float RegularGrid::GetValueLinear(const std::vector <double> &coords) const {
 
 }
 
+void RegularGrid::GetValues(
+	const double *xyz, size_t n, float *values
+) const {
+
+	vector <size_t> dims = GetDimensions();
+	vector <bool> periodic = GetPeriodic();
+	size_t ndim = dims.size();
+
+	// Cell indices and weights are computed as in GetValueLinear() so
+	// that the results match GetValue()
+	//
+	auto locate = [&](const double *coords, CellLocation &l) {
+		l.inside = true;
+		for (int i=0; i<3; i++) {
+			l.index[i] = 0;
+			l.wgt[i] = 0.0;
+		}
+
+		for (int i=0; i<ndim; i++) {
+			double x = ClampCoord(
+				coords[i], dims[i], periodic[i], _minu[i], _maxu[i]
+			);
+			if (! (x >= _minu[i] && x <= _maxu[i])) {
+				l.inside = false;
+				return;
+			}
+
+			if (dims[i] > 1 && _delta[i] != 0.0) {
+				l.index[i] = (size_t) floor ((x-_minu[i]) / _delta[i]);
+				l.wgt[i] = ((x - _minu[i]) - (l.index[i] * _delta[i])) / _delta[i];
+			}
+		}
+	};
+
+	InterpolatePoints(
+		xyz, n, GetInterpolationOrder() == 0, locate, values
+	);
+}
+
 void RegularGrid::GetUserExtents(
 	vector <double> &minu, vector <double> &maxu
 ) const {
@@ -257,20 +296,23 @@ void    RegularGrid::GetEnclosingRegion(
 	min.clear();
 	max.clear();
 
+	// Round outward to the nearest grid points, so that the region is
+	// enclosed
+	//
+	vector <size_t> dims = GetDimensions();
 	for (int i=0; i<cMinu.size(); i++) {
 		assert(cMinu[i] <= cMaxu[i]);
-		double u = cMinu[i]; 
-		if (u < cMinu[i]) {
-			u = cMinu[i];
+		size_t index = 0;
+		if (_delta[i] != 0.0) {
+			index = (size_t) floor ((cMinu[i] - _minu[i]) / _delta[i]);
 		}
-		size_t index = (u - _minu[i]) / _delta[i];
 		min.push_back(index);
 
-		u = cMaxu[i]; 
-		if (u > cMaxu[i]) {
-			u = cMaxu[i];
+		index = 0;
+		if (_delta[i] != 0.0) {
+			index = (size_t) ceil ((cMaxu[i] - _minu[i]) / _delta[i]);
 		}
-		index = (u - _maxu[i]) / _delta[i];
+		if (index > dims[i]-1) index = dims[i]-1;
 		max.push_back(index);
 	}
 
@@ -280,22 +322,26 @@ void RegularGrid::GetUserCoordinates(
 	const std::vector <size_t> &indices,
 	std::vector <double> &coords
 ) const {
+	Size_tArr3 cIndices;
+	CopyToArr3(indices, cIndices);
 
-	vector <size_t> cIndices = indices;
-	ClampIndex(cIndices);
+	DblArr3 cCoords;
+	GetUserCoordinates(cIndices, cCoords);
+	CopyFromArr3(cCoords, GetDimensions().size(), coords);
+}
 
-	coords.clear();
+void RegularGrid::GetUserCoordinates(
+	const Size_tArr3 &indices, DblArr3 &coords
+) const {
 
-	vector <size_t> dims = GetDimensions();
+	Size_tArr3 cIndices = indices;
+	ClampIndex(cIndices);
 
-	for (int i=0; i<cIndices.size(); i++) {
-		size_t index = cIndices[i];
-		
-		if (index >= dims[i]) {
-			index = dims[i] - 1;
-		}
+	const vector <size_t> &dims = GetDimensions();
 
-		coords.push_back(cIndices[i] * _delta[i] + _minu[i]);
+	coords = {0.0, 0.0, 0.0};
+	for (int i=0; i<dims.size(); i++) {
+		coords[i] = cIndices[i] * _delta[i] + _minu[i];
 	}
 }
 
@@ -303,18 +349,25 @@ void RegularGrid::GetIndices(
     const std::vector <double> &coords,
     std::vector <size_t> &indices
 ) const {
-	indices.clear();
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
+
+	Size_tArr3 cIndices;
+	GetIndices(cCoords, cIndices);
+	CopyFromArr3(cIndices, GetDimensions().size(), indices);
+}
+
+void RegularGrid::GetIndices(
+	const DblArr3 &coords, Size_tArr3 &indices
+) const {
 
-	std::vector <double> clampedCoords = coords;
+	DblArr3 clampedCoords = coords;
 	ClampCoord(clampedCoords);
 
-	vector <size_t> dims = GetDimensions();
+	const vector <size_t> &dims = GetDimensions();
 
-	vector <double> wgts;
-	
-	for (int i=0; i<clampedCoords.size(); i++) {
-		indices.push_back(0);
-	
+	indices = {0, 0, 0};
+	for (int i=0; i<dims.size(); i++) {
 		if (clampedCoords[i] < _minu[i]) {
 			indices[i] = 0;
 			continue;
@@ -334,7 +387,7 @@ void RegularGrid::GetIndices(
 
 		double wgt = 0.0;
 
-		if (_delta[0] != 0.0) {
+		if (_delta[i] != 0.0) {
 			wgt = ((clampedCoords[i]-_minu[i]) - (indices[i]*_delta[i])) /
 				_delta[i];
 		}
@@ -346,17 +399,28 @@ bool RegularGrid::GetIndicesCell(
     const std::vector <double> &coords,
     std::vector <size_t> &indices
 ) const {
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
+
+	Size_tArr3 cIndices;
+	bool status = GetIndicesCell(cCoords, cIndices);
+
 	indices.clear();
+	if (status) CopyFromArr3(cIndices, GetDimensions().size(), indices);
+	return(status);
+}
 
-	std::vector <double> clampedCoords = coords;
+bool RegularGrid::GetIndicesCell(
+	const DblArr3 &coords, Size_tArr3 &indices
+) const {
+
+	DblArr3 clampedCoords = coords;
 	ClampCoord(clampedCoords);
 
-	vector <size_t> dims = GetDimensions();
+	const vector <size_t> &dims = GetDimensions();
 
-	vector <double> wgts;
-	
-	for (int i=0; i<clampedCoords.size(); i++) {
-		indices.push_back(0);
+	indices = {0, 0, 0};
+	for (int i=0; i<dims.size(); i++) {
 
 		if (clampedCoords[i] < _minu[i] || clampedCoords[i] > _maxu[i]) {
 			return(false);
@@ -369,20 +433,27 @@ bool RegularGrid::GetIndicesCell(
 		}
 
 		assert(indices[i]<dims[i]);
-
 	}
 
 	return(true);
-
 }
 
 bool RegularGrid::InsideGrid(const std::vector <double> &coords) const
+{
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
+
+	return(InsideGrid(cCoords));
+}
+
+bool RegularGrid::InsideGrid(const DblArr3 &coords) const
 {
 
-	std::vector <double> clampedCoords = coords;
+	DblArr3 clampedCoords = coords;
 	ClampCoord(clampedCoords);
 
-	for (int i=0; i<clampedCoords.size(); i++) {
+	size_t ncoords = GetGeometryDim();
+	for (int i=0; i<ncoords && i<3; i++) {
 		if (clampedCoords[i] < _minu[i]) return(false);
 
 		if (clampedCoords[i] > _maxu[i]) return(false);
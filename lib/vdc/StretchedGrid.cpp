@@ -3,6 +3,7 @@
 #include <cassert>
 #include <cmath>
 #include <cfloat>
+#include <algorithm>
 #include <vapor/utils.h>
 #include <vapor/StretchedGrid.h>
 #include <vapor/KDTreeRG.h>
@@ -106,72 +107,26 @@ void StretchedGrid::GetEnclosingRegion(
 
 	assert(cMinu.size() == cMaxu.size());
 
-	// Initialize voxels coords to full grid
+	min.clear();
+	max.clear();
+
+	// Round outward to the nearest grid points, so that the region is
+	// enclosed. Coordinates increase along each axis
 	//
+	const vector <double> *coords[] = {&_xcoords, &_ycoords, &_zcoords};
 	vector <size_t> dims = GetDimensions();
-	for (int i=0; i<dims.size(); i++) {
-		min[i] = 0;
-		max[i] = dims[i] - 1;
-	}
-
-	float xmin = cMinu[0];
-	int imin = min[0];
-	bool outside = true;
-	for (int i=0; i<_xcoords.size() && outside; i++) {
-		if (_xcoords[i] < xmin) outside = false;
-		if (outside) imin = i;
-	}
-	min[0] = imin;
-
-	float xmax = cMaxu[0];
-	int imax = max[0];
-	outside = true;
-	for (int i=_xcoords.size()-1; i>=min[0] && outside; i--) {
-		if (_xcoords[i] > xmax) outside = false;
-		if (outside) imax = i;
-	}
-	max[0] = imax;
-
-	float ymin = cMinu[1];
-	int jmin = min[1];
-	outside = true;
-	for (int j=0; j<_ycoords.size() && outside; j++) {
-		if (_ycoords[j] < ymin) outside = false;
-		if (outside) jmin = j;
-	}
-	min[1] = jmin;
-
-	float ymax = cMaxu[1];
-	int jmax = max[1];
-	outside = true;
-	for (int j=_ycoords.size()-1; j>=min[1] && outside; j--) {
-		if (_ycoords[j] > ymax) outside = false;
-		if (outside) jmax = j;
-	}
-	max[1] = jmax;
-
+	for (int i=0; i<dims.size() && i<cMinu.size(); i++) {
+		const vector <double> &c = *coords[i];
+		assert(c.size());
 
-	if (dims.size() < 3) return;	// 2D => we're done.
+		size_t imin = upper_bound(c.begin(), c.end(), cMinu[i]) - c.begin();
+		if (imin > 0) imin--;
+		min.push_back(imin);
 
-	// Finally, get Z
-	//
-	float zmin = cMinu[2];
-	int kmin = min[2];
-	outside = true;
-	for (int k=0; k<_zcoords.size() && outside; k++) {
-		if (_zcoords[k] < zmin) outside = false;
-		if (outside) kmin = k;
-	}
-	min[2] = kmin;
-
-	float zmax = cMaxu[2];
-	int kmax = max[2];
-	outside = true;
-	for (int k=_zcoords.size()-1; k>=min[2] && outside; k--) {
-		if (_zcoords[k] > zmax) outside = false;
-		if (outside) kmax = k;
+		size_t imax = lower_bound(c.begin(), c.end(), cMaxu[i]) - c.begin();
+		if (imax > c.size()-1) imax = c.size()-1;
+		max.push_back(imax);
 	}
-	max[2] = kmax;
 }
 
 
@@ -179,19 +134,27 @@ void StretchedGrid::GetUserCoordinates(
 	const std::vector <size_t> &indices,
 	std::vector <double> &coords
 ) const {
+	Size_tArr3 cIndices;
+	CopyToArr3(indices, cIndices);
 
-    vector <size_t> cIndices = indices;
-    ClampIndex(cIndices);
+	DblArr3 cCoords;
+	GetUserCoordinates(cIndices, cCoords);
+	CopyFromArr3(cCoords, GetGeometryDim(), coords);
+}
 
-	coords.clear();
+void StretchedGrid::GetUserCoordinates(
+	const Size_tArr3 &indices, DblArr3 &coords
+) const {
 
-	vector <size_t> dims = StructuredGrid::GetDimensions();
+	Size_tArr3 cIndices = indices;
+	ClampIndex(cIndices);
 
-	coords.push_back(_xcoords[cIndices[0]]);
-	coords.push_back(_ycoords[cIndices[1]]);
+	coords[0] = _xcoords[cIndices[0]];
+	coords[1] = _ycoords[cIndices[1]];
+	coords[2] = 0.0;
 
 	if (GetGeometryDim() > 2) {
-		coords.push_back(_zcoords[cIndices[2]]);
+		coords[2] = _zcoords[cIndices[2]];
 	}
 }
 
@@ -199,107 +162,114 @@ void StretchedGrid::GetIndices(
 	const std::vector <double> &coords,
 	std::vector <size_t> &indices
 ) const {
-	indices.clear();
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
+
+	Size_tArr3 cIndices;
+	GetIndices(cCoords, cIndices);
+	CopyFromArr3(cIndices, GetGeometryDim(), indices);
+}
+
+void StretchedGrid::GetIndices(
+	const DblArr3 &coords, Size_tArr3 &indices
+) const {
 
 	// Clamp coordinates on periodic boundaries to grid extents
 	//
-	vector <double> cCoords = coords;
+	DblArr3 cCoords = coords;
 	ClampCoord(cCoords);
 
-	size_t i;
-	int rc = _binarySearchRange(_zcoords, cCoords[0], i);
-	if (rc < 0) {
-		indices.push_back(0);
-	}
-	else if (rc > 0) {
-		indices.push_back(i);
-	}
-	else {
-		indices.push_back(GetDimensions()[0] - 1);
-	}
+	// Search each axis for the cell containing the point, then pick
+	// the closer of the cell's two nodes
+	//
+	const vector <double> *axes[] = {&_xcoords, &_ycoords, &_zcoords};
 
-	size_t j;
-	rc = _binarySearchRange(_zcoords, cCoords[1], j);
-	if (rc < 0) {
-		indices.push_back(0);
-	}
-	else if (rc > 0) {
-		indices.push_back(j);
-	}
-	else {
-		indices.push_back(GetDimensions()[1] - 1);
-	}
+	indices = {0, 0, 0};
+	for (int i=0; i<GetGeometryDim(); i++) {
+		const vector <double> &c = *axes[i];
 
-	if (cCoords.size() == 2) return;
+		size_t index;
+		int rc = _binarySearchRange(c, cCoords[i], index);
+		if (rc < 0) {
+			indices[i] = 0;
+		}
+		else if (rc > 0) {
+			indices[i] = c.size() - 1;
+		}
+		else {
+			indices[i] = index;
+			if (index+1 < c.size() && 
+				cCoords[i] - c[index] > c[index+1] - cCoords[i]) {
 
-	size_t k;
-	rc = _binarySearchRange(_zcoords, cCoords[2], k);
-	if (rc < 0) {
-		indices.push_back(0);
-	}
-	else if (rc > 0) {
-		indices.push_back(k);
-	}
-	else {
-		indices.push_back(GetDimensions()[2] - 1);
+				indices[i]++;
+			}
+		}
 	}
 }
 
-
 bool StretchedGrid::GetIndicesCell(
 	const std::vector <double> &coords,
 	std::vector <size_t> &indices
 ) const {
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
+
+	Size_tArr3 cIndices;
+	bool status = GetIndicesCell(cCoords, cIndices);
+
+	indices.clear();
+	if (status) CopyFromArr3(cIndices, GetGeometryDim(), indices);
+	return(status);
+}
+
+bool StretchedGrid::GetIndicesCell(
+	const DblArr3 &coords, Size_tArr3 &indices
+) const {
 
 	// Clamp coordinates on periodic boundaries to grid extents
 	//
-	vector <double> cCoords = coords;
+	DblArr3 cCoords = coords;
 	ClampCoord(cCoords);
 	
-	double x = cCoords[0];
-	double y = cCoords[1];
-	double z = GetGeometryDim() == 3 ? cCoords[2] : 0.0;
-	
 	double xwgt[2], ywgt[2], zwgt[2];
 	size_t i, j, k;
-	bool inside = _insideGrid(x,y,z,i,j,k, xwgt, ywgt, zwgt);
-
-	if (! inside) return (false);
+	bool inside = _insideGrid(
+		cCoords[0], cCoords[1], cCoords[2], i, j, k, xwgt, ywgt, zwgt
+	);
 
-	indices.push_back(i);
-	indices.push_back(j);
+	indices = {i, j, GetGeometryDim() == 3 ? k : 0};
 
-	if (GetGeometryDim() == 2) return(true);
-
-	indices.push_back(k);
-
-	return(true);
+	return(inside);
 }
 	
+bool StretchedGrid::InsideGrid(const std::vector <double> &coords) const {
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
 
+	return(InsideGrid(cCoords));
+}
 
-bool StretchedGrid::InsideGrid(const std::vector <double> &coords) const {
+bool StretchedGrid::InsideGrid(const DblArr3 &coords) const {
 
 	// Clamp coordinates on periodic boundaries to reside within the 
 	// grid extents 
 	//
-	vector <double> cCoords = coords;
+	DblArr3 cCoords = coords;
 	ClampCoord(cCoords);
 
 	// Do a quick check to see if the point is completely outside of 
 	// the grid bounds.
 	//
-	for (int i=0; i<cCoords.size(); i++) {
+	for (int i=0; i<GetGeometryDim(); i++) {
 		if (cCoords[i] < _minu[i] || cCoords[i] > _maxu[i]) return (false);
 	}
 
 	double xwgt[2], ywgt[2], zwgt[2];
 	size_t i,j,k;	// not used
-	double x = cCoords[0];
-	double y = cCoords[1];
-	double z = GetGeometryDim() == 3 ? cCoords[2] : 0.0;
 	
-	bool inside = _insideGrid(x, y, z, i, j, k, xwgt, ywgt, zwgt);
+	bool inside = _insideGrid(
+		cCoords[0], cCoords[1], cCoords[2], i, j, k, xwgt, ywgt, zwgt
+	);
 
 	return(inside);
 }
@@ -435,40 +405,42 @@ float StretchedGrid::GetValueLinear(
 	vector <double> cCoords = coords;
 	ClampCoord(cCoords);
 
-	// handlese case where grid is 2D. I.e. if 2d then zwgt[0] == 1 && 
-	// zwgt[1] = 0.0
-	//
-	double xwgt[2], ywgt[2], zwgt[2];
-	size_t i,j,k;
-	double x = cCoords[0];
-	double y = cCoords[1];
-	double z = GetGeometryDim() == 3 ? cCoords[2] : 0.0;
-	bool inside = _insideGrid(x, y, z, i, j, k, xwgt, ywgt, zwgt);
-
+	float v;
+	InterpolatePoints(
+		cCoords.data(), 1, false,
+		[this](const double *coords, CellLocation &l) {_locateCell(coords, l);},
+		&v
+	);
+	return(v);
+}
 
-	if (! inside) return(GetMissingValue());
+void StretchedGrid::GetValues(
+	const double *xyz, size_t n, float *values
+) const {
 
 	vector <size_t> dims = GetDimensions();
-	assert(i<dims[0]-1);
-	assert(j<dims[1]-1);
-	if (dims.size() > 2) assert(k<dims[2]-1);
-
-	float v0 = AccessIJK(i,j,k) * xwgt[0] + 
-		AccessIJK(i+1,j,k) * xwgt[1] +
-		AccessIJK(i+1,j+1,k) * ywgt[0] +
-		AccessIJK(i,j+1,k) * ywgt[1];
-
-	if (GetGeometryDim() == 2) return(v0);
-
-	float v1 = AccessIJK(i,j,k+1) * xwgt[0] + 
-		AccessIJK(i+1,j,k+1) * xwgt[1] +
-		AccessIJK(i+1,j+1,k+1) * ywgt[0] +
-		AccessIJK(i,j+1,k+1) * ywgt[1];
+	vector <bool> periodic = GetPeriodic();
+	size_t ndim = GetGeometryDim();
+	int order = GetInterpolationOrder();
+
+	auto locate = [&](const double *point, CellLocation &l) {
+		double coords[3] = {0.0, 0.0, 0.0};
+		for (int i=0; i<ndim; i++) {
+			coords[i] = ClampCoord(
+				point[i], dims[i], periodic[i], _minu[i], _maxu[i]
+			);
+		}
+		_locateCell(coords, l);
 
-	// Linearly interpolate along Z axis
-	//
-	return(v0*zwgt[0] + v1*zwgt[1]);
+		// GetValueNearestNeighbor() returns the value at the cell's
+		// minimum corner
+		//
+		if (order == 0) {
+			for (int i=0; i<3; i++) l.wgt[i] = 0.0;
+		}
+	};
 
+	InterpolatePoints(xyz, n, false, locate, values);
 }
 
 void StretchedGrid::_GetUserExtents(
@@ -584,6 +556,38 @@ bool StretchedGrid::_insideGrid(
 	return(true);
 }
 
+// Find the cell containing a point whose coordinates have been clamped
+// with ClampCoord(), and the point's position within the cell
+//
+void StretchedGrid::_locateCell(
+	const double *coords, CellLocation &loc
+) const {
+	const vector <double> *axes[] = {&_xcoords, &_ycoords, &_zcoords};
+
+	loc.inside = true;
+	for (int i=0; i<3; i++) {
+		loc.index[i] = 0;
+		loc.wgt[i] = 0.0;
+	}
+
+	for (int i=0; i<GetGeometryDim(); i++) {
+		const vector <double> &c = *axes[i];
+
+		// ClampCoord() maps coordinates on axes of length 1 to the 
+		// axis' only coordinate
+		//
+		if (c.size() < 2) continue;
+
+		size_t index;
+		if (_binarySearchRange(c, coords[i], index) != 0) {
+			loc.inside = false;
+			return;
+		}
+		loc.index[i] = index;
+		loc.wgt[i] = (coords[i] - c[index]) / (c[index+1] - c[index]);
+	}
+}
+
 void StretchedGrid::_getMinCellExtents(
 	vector <double> &minCellExtents
 ) const {
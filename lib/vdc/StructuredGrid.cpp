@@ -37,57 +37,57 @@ bool StructuredGrid::GetCellNodes(
     const std::vector <size_t> &cindices,
     std::vector <vector <size_t> > &nodes
 ) const {
-	nodes.clear();
+	Size_tArr3 cCindices;
+	CopyToArr3(cindices, cCindices);
 
-    vector <size_t> cCindices = cindices;
-    ClampCellIndex(cCindices);
+	vector <Size_tArr3> aNodes;
+	bool status = GetCellNodes(cCindices, aNodes);
 
-	vector <size_t> dims = GetDimensions();
+	size_t ndims = GetDimensions().size();
+	nodes.resize(aNodes.size());
+	for (int i=0; i<aNodes.size(); i++) {
+		CopyFromArr3(aNodes[i], ndims, nodes[i]);
+	}
+	return(status);
+}
+
+bool StructuredGrid::GetCellNodes(
+	const Size_tArr3 &cindices, std::vector <Size_tArr3> &nodes
+) const {
+
+	Size_tArr3 cCindices = cindices;
+	ClampCellIndex(cCindices);
+
+	const vector <size_t> &dims = GetDimensions();
+
+	size_t i = cCindices[0];
+	size_t j = cCindices[1];
+	size_t k = cCindices[2];
 
 	// Cells have the same ID's as their first node
 	//
 	// walk counter-clockwise order
 	//
-	vector <size_t> indices;
-
 	if (dims.size() == 2) {
-		indices =  {cCindices[0], cCindices[1]};
-		nodes.push_back(indices);
-
-		indices =  {cCindices[0]+1, cCindices[1]};
-		nodes.push_back(indices);
-
-		indices =  {cCindices[0]+1, cCindices[1]+1};
-		nodes.push_back(indices);
-
-		indices =  {cCindices[0], cCindices[1]+1};
-		nodes.push_back(indices);
-
+		nodes.resize(4);
+		nodes[0] = {i, j, 0};
+		nodes[1] = {i+1, j, 0};
+		nodes[2] = {i+1, j+1, 0};
+		nodes[3] = {i, j+1, 0};
 	}
 	else if (dims.size() == 3 && dims[2] > 1) {
-		indices =  {cCindices[0], cCindices[1], cCindices[2]};
-		nodes.push_back(indices);
-
-		indices =  {cCindices[0]+1, cCindices[1], cCindices[2]};
-		nodes.push_back(indices);
-
-		indices =  {cCindices[0]+1, cCindices[1]+1, cCindices[2]};
-		nodes.push_back(indices);
-
-		indices =  {cCindices[0], cCindices[1]+1, cCindices[2]};
-		nodes.push_back(indices);
-
-		indices =  {cCindices[0], cCindices[1], cCindices[2]+1};
-		nodes.push_back(indices);
-
-		indices =  {cCindices[0]+1, cCindices[1], cCindices[2]+1};
-		nodes.push_back(indices);
-
-		indices =  {cCindices[0]+1, cCindices[1]+1, cCindices[2]+1};
-		nodes.push_back(indices);
-
-		indices =  {cCindices[0], cCindices[1]+1, cCindices[2]+1};
-		nodes.push_back(indices);
+		nodes.resize(8);
+		nodes[0] = {i, j, k};
+		nodes[1] = {i+1, j, k};
+		nodes[2] = {i+1, j+1, k};
+		nodes[3] = {i, j+1, k};
+		nodes[4] = {i, j, k+1};
+		nodes[5] = {i+1, j, k+1};
+		nodes[6] = {i+1, j+1, k+1};
+		nodes[7] = {i, j+1, k+1};
+	}
+	else {
+		nodes.clear();
 	}
 
 	return(true);
@@ -183,33 +183,32 @@ bool StructuredGrid::GetNodeCells(
 void StructuredGrid::ClampCoord(std::vector <double> &coords) const {
 	assert(coords.size() >= GetGeometryDim());
 
-	while (coords.size() > GetGeometryDim()) {
-		coords.pop_back();
-	}
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
+	ClampCoord(cCoords);
+	CopyFromArr3(cCoords, GetGeometryDim(), coords);
+}
 
-	vector <bool> periodic = GetPeriodic();
-	vector <size_t> dims = GetDimensions();
+void StructuredGrid::ClampCoord(DblArr3 &coords) const {
+	const vector <size_t> &dims = GetDimensions();
+	size_t ncoords = GetGeometryDim();
 
+	// The user extents are only needed for periodic axes and axes of
+	// length one, so they're only fetched if the grid has either
+	//
 	vector <double> minu, maxu;
-	GetUserExtents(minu, maxu);
-
-	for (int i=0; i<coords.size(); i++) {
-
-		//
-		// Handle coordinates for dimensions of length 1
-		//
-		if (dims[i] == 1) {
-			coords[i] = minu[i];
+	for (int i=0; i<3; i++) {
+		if (i >= ncoords) {
+			coords[i] = 0.0;
 			continue;
 		}
+		if (i >= dims.size()) continue;
+		if (! IsPeriodic(i) && dims[i] != 1) continue;
 
-		if (coords[i]<minu[i] && periodic[i]) {
-			while (coords[i]<minu[i]) coords[i]+= maxu[i]-minu[i];
-		}
-		if (coords[i]>maxu[i] && periodic[i]) {
-			while (coords[i]>maxu[i]) coords[i]-= maxu[i]-minu[i];
-		}
-
+		if (minu.empty()) GetUserExtents(minu, maxu);
+		coords[i] = ClampCoord(
+			coords[i], dims[i], IsPeriodic(i), minu[i], maxu[i]
+		);
 	}
 }
 
@@ -66,49 +66,48 @@ UnstructuredGrid::UnstructuredGrid(
 bool UnstructuredGrid::GetCellNodes(
     const std::vector <size_t> &cindices,
     std::vector <vector <size_t> > &nodes
+) const {
+	Size_tArr3 cCindices;
+	CopyToArr3(cindices, cCindices);
+
+	vector <Size_tArr3> nodes3;
+	bool status = GetCellNodes(cCindices, nodes3);
+
+	size_t ndim = GetNodeDimensions().size();
+	nodes.resize(nodes3.size());
+	for (int i=0; i<nodes3.size(); i++) {
+		CopyFromArr3(nodes3[i], ndim, nodes[i]);
+	}
+	return(status);
+}
+
+bool UnstructuredGrid::GetCellNodes(
+	const Size_tArr3 &cindices, std::vector <Size_tArr3> &nodes
 ) const {
 	nodes.clear();
 
-    vector <size_t> cCindices = cindices;
-    ClampCellIndex(cCindices);
+	Size_tArr3 cCindices = cindices;
+	ClampCellIndex(cCindices);
 
-	vector <size_t> cdims = GetCellDimensions();
+	const vector <size_t> &cdims = GetCellDimensions();
 
 	// _vertexOnFace is dimensioned cdims[0] x _maxVertexPerFace
 	//
-	const int *ptr = _vertexOnFace + (_maxVertexPerFace * cCindices[0]);
+	const int *face = _vertexOnFace + (_maxVertexPerFace * cCindices[0]);
 	long offset = GetNodeOffset();
-	
-	if (cdims.size() == 1) {
-		for (int i=0; i<_maxVertexPerFace; i++, ptr++) {
-			vector <size_t> indices;
-			if (*ptr == GetMissingID() || *ptr + offset < 0) break;
-			if (*ptr == GetBoundaryID()) continue;
-
-			indices.push_back(*ptr + offset);
-			nodes.push_back(indices);
-		}
-	}
-	else {	// layered case
 
+	// The layered case has a layer of nodes below the face, and one
+	// above it
+	//
+	int nlayers = cdims.size() == 1 ? 1 : 2;
+	for (int l=0; l<nlayers; l++) {
+		const int *ptr = face;
 		for (int i=0; i<_maxVertexPerFace; i++, ptr++) {
-			vector <size_t> indices;
-			if (*ptr == GetMissingID() || *ptr + offset < 0) break;
-			if (*ptr == GetBoundaryID()) continue;
-
-			indices.push_back(*ptr + offset);
-			indices.push_back(cCindices[1]);
-			nodes.push_back(indices);
-		}
-
-		ptr = _vertexOnFace + (_maxVertexPerFace * cCindices[0]);
-		for (int i=0; i<_maxVertexPerFace; i++) {
-			vector <size_t> indices;
 			if (*ptr == GetMissingID() || *ptr + offset < 0) break;
 			if (*ptr == GetBoundaryID()) continue;
 
-			indices.push_back(*ptr + offset);
-			indices.push_back(cCindices[1]+1);
+			Size_tArr3 indices = {{(size_t) (*ptr + offset), 0, 0}};
+			if (nlayers > 1) indices[1] = cCindices[1] + l;
 			nodes.push_back(indices);
 		}
 	}
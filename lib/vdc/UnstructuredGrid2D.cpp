@@ -19,6 +19,36 @@
 using namespace std;
 using namespace VAPoR;
 
+namespace {
+
+// Scratch space for per-face quantities (vertex coordinates, 
+// interpolation weights). Lives on the stack unless faces may have
+// more than N nodes, so that point queries don't allocate memory
+//
+template <class T, size_t N>
+class ScratchArray {
+public:
+	ScratchArray(size_t n) : _ptr(_buf) {
+		if (n > N) {
+			_heap.resize(n);
+			_ptr = _heap.data();
+		}
+	}
+	ScratchArray(const ScratchArray &) = delete;
+	ScratchArray &operator=(const ScratchArray &) = delete;
+
+	T *data() { return(_ptr); }
+
+private:
+	T _buf[N];
+	vector <T> _heap;
+	T *_ptr;
+};
+
+const size_t MaxStackVertices = 16;
+
+};
+
 UnstructuredGrid2D::UnstructuredGrid2D(
 	const std::vector <size_t> &vertexDims,
 	const std::vector <size_t> &faceDims,
@@ -34,12 +64,13 @@ UnstructuredGrid2D::UnstructuredGrid2D(
     const UnstructuredGridCoordless &xug,
     const UnstructuredGridCoordless &yug,
     const UnstructuredGridCoordless &zug,
-	const KDTreeRG *kdtree
+	const KDTreeRG *kdtree,
+	const FaceLocatorUG2D *locator
 ) : UnstructuredGrid(
 		vertexDims, faceDims, edgeDims, bs, blks, 2,
 		vertexOnFace, faceOnVertex, faceOnFace, location, 
 		maxVertexPerFace, maxFacePerVertex
-	), _xug(xug), _yug(yug), _zug(zug), _kdtree(kdtree) {
+	), _xug(xug), _yug(yug), _zug(zug), _kdtree(kdtree), _locator(locator) {
 
 	assert(xug.GetDimensions() == GetDimensions());
 	assert(yug.GetDimensions() == GetDimensions());
@@ -49,6 +80,10 @@ UnstructuredGrid2D::UnstructuredGrid2D(
 	 );
 
 	assert(location == NODE);
+	assert(
+		! locator || 
+		locator->GetNumFaces() == GetCellDimensions()[0]
+	);
 
 }
 
@@ -139,35 +174,48 @@ void UnstructuredGrid2D::GetUserCoordinates(
 	const std::vector <size_t> &indices,
 	std::vector <double> &coords
 ) const {
+	Size_tArr3 cIndices;
+	CopyToArr3(indices, cIndices);
+
+	DblArr3 cCoords;
+	GetUserCoordinates(cIndices, cCoords);
+	CopyFromArr3(cCoords, GetGeometryDim(), coords);
+}
 
-    vector <size_t> cIndices = indices;
-    ClampIndex(cIndices);
+void UnstructuredGrid2D::GetUserCoordinates(
+	const Size_tArr3 &indices, DblArr3 &coords
+) const {
 
-	assert(cIndices.size() == 1);
-	coords.clear();
+	Size_tArr3 cIndices = indices;
+	ClampIndex(cIndices);
 
-	coords.push_back(_xug.AccessIndex(cIndices));
-	coords.push_back(_yug.AccessIndex(cIndices));
-	if (GetGeometryDim() == 3) {
-		coords.push_back(_zug.AccessIndex(cIndices));
-	}
-	
+	coords[0] = _xug.AccessIJK(cIndices[0], 0, 0);
+	coords[1] = _yug.AccessIJK(cIndices[0], 0, 0);
+	coords[2] = GetGeometryDim() == 3 ? _zug.AccessIJK(cIndices[0], 0, 0) : 0.0;
 }
 
 void UnstructuredGrid2D::GetIndices(
 	const std::vector <double> &coords,
 	std::vector <size_t> &indices
 ) const {
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
 
-	indices.clear();
+	Size_tArr3 cIndices;
+	GetIndices(cCoords, cIndices);
+	CopyFromArr3(cIndices, GetDimensions().size(), indices);
+}
+
+void UnstructuredGrid2D::GetIndices(
+	const DblArr3 &coords, Size_tArr3 &indices
+) const {
 
 	// Clamp coordinates on periodic boundaries to grid extents
 	//
-	vector <double> cCoords = coords;
+	DblArr3 cCoords = coords;
 	ClampCoord(cCoords);
 
 	_kdtree->Nearest(cCoords, indices);
-	
 }
 
 bool UnstructuredGrid2D::GetIndicesCell(
@@ -176,41 +224,60 @@ bool UnstructuredGrid2D::GetIndicesCell(
 ) const {
 	indices.clear();
 
-	vector <double> cCoords = coords;
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
+
+	Size_tArr3 cIndices;
+	if (! GetIndicesCell(cCoords, cIndices)) return(false);
+
+	CopyFromArr3(cIndices, GetCellDimensions().size(), indices);
+	return(true);
+}
+
+bool UnstructuredGrid2D::GetIndicesCell(
+	const DblArr3 &coords, Size_tArr3 &indices
+) const {
+
+	DblArr3 cCoords = coords;
 	ClampCoord(cCoords);
 
-	double *lambda = new double[_maxVertexPerFace];
+	ScratchArray <double, MaxStackVertices> lambda(_maxVertexPerFace);
 	int nlambda;
 	double zwgt[2];
+	size_t face;
 
 	// See if point is inside any cells (faces) 
 	// 
 	bool status = _insideGridNodeCentered(
-		cCoords, indices, lambda, nlambda, zwgt
+		cCoords.data(), face, lambda.data(), nlambda, zwgt
 	);
+	if (! status) return(false);
 
-	delete [] lambda;
-
-	return(status);
+	indices = {{face, 0, 0}};
+	return(true);
 }
 
 bool UnstructuredGrid2D::InsideGrid(const std::vector <double> &coords) const {
-	vector <double> cCoords = coords;
+	DblArr3 cCoords;
+	CopyToArr3(coords, cCoords);
+	return(InsideGrid(cCoords));
+}
+
+bool UnstructuredGrid2D::InsideGrid(const DblArr3 &coords) const {
+	DblArr3 cCoords = coords;
 	ClampCoord(cCoords);
 
-	double *lambda = new double[_maxVertexPerFace];
+	ScratchArray <double, MaxStackVertices> lambda(_maxVertexPerFace);
 	int nlambda;
 	double zwgt[2];
-	vector <size_t> indices;
+	size_t face;
 
 	// See if point is inside any cells (faces) 
 	// 
 	bool status = _insideGridNodeCentered(
-		cCoords, indices, lambda, nlambda, zwgt
+		cCoords.data(), face, lambda.data(), nlambda, zwgt
 	);
 
-	delete [] lambda;
-
 	return(status);
 
 }
@@ -243,38 +310,77 @@ float UnstructuredGrid2D::GetValueLinear (
 	vector <double> cCoords = coords;
 	ClampCoord(cCoords);
 
-	double *lambda = new double[_maxVertexPerFace];
+	ScratchArray <double, MaxStackVertices> lambda(_maxVertexPerFace);
 	int nlambda;
 	double zwgt[2];
-	vector <size_t> face_indices;
+	size_t face;
 
 	// See if point is inside any cells (faces) 
 	// 
-	bool inside = _insideGrid(
-		cCoords, face_indices, lambda, nlambda, zwgt
-	);
+	double pt[] = {cCoords[0], cCoords[1]};
+	bool inside = _insideGrid(pt, face, lambda.data(), nlambda, zwgt);
 
 	if (! inside) {
-		delete [] lambda;
 		return (GetMissingValue());
 	}
-	assert(face_indices.size() == 1);
-	assert(face_indices[0] < GetCellDimensions()[0]);
+	assert(face < GetCellDimensions()[0]);
 
-	const int *ptr = _vertexOnFace + (face_indices[0] * _maxVertexPerFace);
+	const int *ptr = _vertexOnFace + (face * _maxVertexPerFace);
 
 	double value = 0;
 	long offset = GetNodeOffset();
 	for (int i=0; i<nlambda; i++) {
-		value += AccessIJK(*ptr + offset, 0, 0) * lambda[i];
+		value += AccessIJK(*ptr + offset, 0, 0) * lambda.data()[i];
 		ptr++;
 	}
 
-	delete [] lambda;
-
 	return((float) value);
 }
 
+void UnstructuredGrid2D::GetValues(
+	const double *xyz, size_t n, float *values
+) const {
+	if (! _locator || GetInterpolationOrder() == 0 || ! GetBlock(0)) {
+		Grid::GetValues(xyz, n, values);
+		return;
+	}
+
+	ScratchArray <double, MaxStackVertices> lambda(_maxVertexPerFace);
+	float mv = GetMissingValue();
+	long offset = GetNodeOffset();
+
+	// Start each search at the face containing the last point found
+	//
+	bool haveSeed = false;
+	size_t seed = 0;
+	for (size_t p=0; p<n; p++) {
+		double x = xyz[3*p];
+		double y = xyz[3*p+1];
+
+		size_t face;
+		int nlambda;
+		bool inside = haveSeed ?
+			_locator->FindFace(x, y, seed, face, lambda.data(), nlambda) :
+			_locator->FindFace(x, y, face, lambda.data(), nlambda);
+
+		if (! inside) {
+			values[p] = mv;
+			continue;
+		}
+		haveSeed = true;
+		seed = face;
+
+		const int *ptr = _vertexOnFace + (face * _maxVertexPerFace);
+
+		double value = 0;
+		for (int i=0; i<nlambda; i++) {
+			value += AccessIJK(*ptr + offset, 0, 0) * lambda.data()[i];
+			ptr++;
+		}
+		values[p] = (float) value;
+	}
+}
+
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -368,25 +474,19 @@ std::ostream &operator<<(std::ostream &o, const UnstructuredGrid2D &ug)
 // grid the values of 'lambda', and 'zwgt' are not defined
 //
 bool UnstructuredGrid2D::_insideGrid(
-	const vector <double> &coords,
-	vector <size_t> &face_indices,
+	const double pt[2], size_t &face,
 	double *lambda, int &nlambda, double zwgt[2]
 ) const {
 	if (_location == NODE) {
-		return(_insideGridNodeCentered(
-			coords, face_indices, lambda, nlambda, zwgt
-		));
+		return(_insideGridNodeCentered(pt, face, lambda, nlambda, zwgt));
 	}
 	else {
-		return(_insideGridFaceCentered(
-			coords, face_indices, lambda, nlambda, zwgt
-		));
+		return(_insideGridFaceCentered(pt, face, lambda, nlambda, zwgt));
 	}
 }
 
 bool UnstructuredGrid2D::_insideGridFaceCentered(
-	const vector <double> &coords,
-	vector <size_t> &indices,
+	const double pt[2], size_t &face,
 	double *lambda, int &nlambda, double zwgt[2]
 ) const {
 	assert(0 && "Not supported");
@@ -394,50 +494,47 @@ bool UnstructuredGrid2D::_insideGridFaceCentered(
 }
 
 bool UnstructuredGrid2D::_insideGridNodeCentered(
-	const vector <double> &coords,
-	vector <size_t> &face_indices,
+	const double pt[2], size_t &face,
 	double *lambda, int &nlambda, double zwgt[2]
 ) const {
-	face_indices.clear();
+	face = 0;
 
-	assert(coords.size() == 2);
-
-	double pt[] = {coords[0], coords[1]};
+	if (_locator) {
+		return(_locator->FindFace(pt[0], pt[1], face, lambda, nlambda));
+	}
 
 	// Find the indices for the nearest grid point in the plane
 	//
-	vector <size_t> vertex_indices;
+	DblArr3 coords = {{pt[0], pt[1], 0.0}};
+	Size_tArr3 vertex_indices;
 	_kdtree->Nearest(coords, vertex_indices);
-	assert(vertex_indices.size() == 1);
-
-	vector <size_t> dims = GetDimensions();
-	assert(vertex_indices[0] < dims[0]);
+	assert(vertex_indices[0] < GetDimensions()[0]);
 
 	const int *ptr = _faceOnVertex + (vertex_indices[0] * _maxFacePerVertex);
 	long offset = GetCellOffset();
 
-	for (int i=0; i<_maxFacePerVertex; i++) {
-		long face = *ptr + offset;
-		if (face == GetMissingID() || face < 0) break;
-		if (face == GetBoundaryID()) continue;
+	for (int i=0; i<_maxFacePerVertex; i++, ptr++) {
+		long f = *ptr + offset;
+		if (f == GetMissingID() || f < 0) break;
+		if (f == GetBoundaryID()) continue;
 
-		if (_insideFace(face, pt, lambda, nlambda, zwgt)) {
-			face_indices.push_back(face);
+		if (_insideFace(f, pt, lambda, nlambda, zwgt)) {
+			face = f;
 			return(true);
 		}
-		ptr++;
 	}
 
 	return(false);
 }
 
 bool UnstructuredGrid2D::_insideFace(
-	size_t face, double pt[2],
+	size_t face, const double pt[2],
 	double *lambda, int &nlambda, double zwgt[2]
 ) const {
 	nlambda = 0;
 
-	double *verts = new double[_maxVertexPerFace * 2];
+	ScratchArray <double, 2*MaxStackVertices> vbuf(_maxVertexPerFace * 2);
+	double *verts = vbuf.data();
 
 	const int *ptr = _vertexOnFace + (face * _maxVertexPerFace);
 	long offset = GetNodeOffset();
@@ -454,13 +551,8 @@ bool UnstructuredGrid2D::_insideFace(
 	// Should we test the line case where nlambda == 2?
 	//
 	if (nlambda < 3) {
-		delete [] verts;
 		return (false);
 	}
 
-	bool ret = WachspressCoords2D(verts, pt, nlambda, lambda);
-
-	delete [] verts;
-	
-	return ret;
+	return(WachspressCoords2D(verts, pt, nlambda, lambda));
 }
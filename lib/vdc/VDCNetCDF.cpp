@@ -2,6 +2,7 @@
 #include <sstream>
 #include <map>
 #include <vector>
+#include <limits>
 #include <sys/stat.h>
 #include <netcdf.h>
 #include "vapor/VDCNetCDF.h"
@@ -145,6 +146,19 @@ size_t lcm(size_t n1, size_t n2) {
 	return((n1 * n2) / gcd(n1, n2));
 }
 
+// Names of the NetCDF variable, and its dimension, used to record 
+// the range of each block of a data variable. For each time step 
+// the variable contains the number of blocks, the min and max of the 
+// entire variable, and then a min, max pair for each block.
+//
+string blockrange_varname(string varname) {
+	return(varname + ".BlockRange");
+}
+
+string blockrange_dimname(string varname) {
+	return(varname + ".BlockRange.len");
+}
+
 };
 
 VDCNetCDF::VDCNetCDF(
@@ -155,6 +169,7 @@ VDCNetCDF::VDCNetCDF(
 	_master_threshold = master_threshold;
 	_variable_threshold = variable_threshold;
 	_chunksizehint =  0;
+	_fastTransform = false;
 	_master = new WASP(nthreads);
 	_version = 1;
 }
@@ -430,6 +445,7 @@ WASP *VDCNetCDF::_OpenVariableRead(
 		if (rc<0) return(NULL);
 	}
 
+	wasp->SetFastTransform(_fastTransform);
 	rc = wasp->OpenVarRead(varname, clevel, lod);
 	if (rc<0) return(NULL);
 
@@ -570,6 +586,7 @@ int VDCNetCDF::OpenVariableWrite(size_t ts, string varname, int lod) {
 		if (rc<0) return(-1);
 
 	}
+	wasp->SetFastTransform(_fastTransform);
 	rc = wasp->OpenVarWrite(varname, lod);
 	if (rc<0) return(-1);
 
@@ -597,6 +614,18 @@ int VDCNetCDF::OpenVariableWrite(size_t ts, string varname, int lod) {
 		nlevels-1, file_ts_mask, mv
 	);
 
+	// Record block ranges if the file has room for them. Files 
+	// created by older versions do not.
+	//
+	if (isdvar && _blockRangeVarDefined(wasp, varname)) {
+		size_t nblocks = _numBlocks(varname);
+		vector <double> &blkranges = o->GetBlockRanges();
+		for (size_t i=0; i<nblocks; i++) {
+			blkranges.push_back(std::numeric_limits<double>::max());
+			blkranges.push_back(-std::numeric_limits<double>::max());
+		}
+	}
+
     return(_fileTable.AddEntry(o));
 }
 
@@ -608,6 +637,15 @@ int VDCNetCDF::closeVariable(int fd) {
         SetErrMsg("Invalid file descriptor : %d", fd);
         return(-1);
     }
+
+	// Only record ranges for variables that were written in their 
+	// entirety
+	//
+	int rc = 0;
+	if (! o->GetBlockRanges().empty() && o->GetBlockRangesComplete()) {
+		rc = _writeBlockRanges(o);
+	}
+
 	WASP *wasp = o->GetWaspData();
 
 	if (wasp) {
@@ -630,7 +668,7 @@ int VDCNetCDF::closeVariable(int fd) {
     _fileTable.RemoveEntry(fd);
 	delete o;
 
-	return(0);
+	return(rc);
 }
 
 unsigned char *VDCNetCDF::_read_mask_var(
@@ -691,16 +729,24 @@ int VDCNetCDF::_writeTemplate(int fd, const T *data) {
 
 	double mv;
 	string maskvar = _get_mask_varname(varname, mv);
+	unsigned char *mask = NULL;
 	if (maskvar.empty()) {
-		return(wasp->PutVara(start, count, data));
+		rc = wasp->PutVara(start, count, data);
 	}
+	else {
+		mask = _read_mask_var(
+			o->GetWaspMask(), varname, maskvar, start, count
+		);
+		if (! mask)  return(-1); 
 
-	unsigned char *mask = _read_mask_var(
-		o->GetWaspMask(), varname, maskvar, start, count
-	);
-	if (! mask)  return(-1); 
+		rc = wasp->PutVara(start, count, data, mask);
+	}
+	if (rc < 0) return(rc);
+
+	_updateBlockRanges(o, mins, maxs, data, mask);
+	o->SetBlockRangesComplete(true);
 
-	return(wasp->PutVara(start, count, data, mask));
+	return(0);
 
 }
 
@@ -763,11 +809,12 @@ int VDCNetCDF::_writeSliceTemplate(int fd, const T *slice) {
 
 	double mv;
 	string maskvar = _get_mask_varname(varname, mv);
+	unsigned char *mask = NULL;
 	if (maskvar.empty()) {
 		rc = wasp->PutVara(start, count, slice);
 	}
 	else {
-		unsigned char *mask = _read_mask_var(
+		mask = _read_mask_var(
 			o->GetWaspMask(), varname, maskvar, start, count
 		);
 		if (! mask)  return(-1); 
@@ -776,13 +823,102 @@ int VDCNetCDF::_writeSliceTemplate(int fd, const T *slice) {
 	}
 	if (rc < 0) return(rc);
 
+	_updateBlockRanges(o, min, max, slice, mask);
+
 	slice_num++;
 	o->SetSlice(slice_num);
+	if (slice_num == nslice) o->SetBlockRangesComplete(true);
 
 	return(0);
 
 }
 
+template <class T> 
+void VDCNetCDF::_updateBlockRanges(
+	VDCFileObject *o, const vector <size_t> &min, const vector <size_t> &max,
+	const T *data, const unsigned char *mask
+) {
+	vector <double> &blkranges = o->GetBlockRanges();
+	if (blkranges.empty()) return;
+
+	string varname = o->GetVarname();
+
+	vector <size_t> dims, bs;
+	int rc = GetDimLensAtLevel(varname, -1, dims, bs);
+	if (rc<0) {
+		blkranges.clear();
+		return;
+	}
+
+	VDC::DataVar dvar;
+	bool has_missing = false;
+	T mv = 0;
+	if (VDC::getDataVarInfo(varname, dvar) && dvar.GetHasMissing()) {
+		has_missing = true;
+		mv = (T) dvar.GetMissingValue();
+	}
+
+	vector <size_t> lo = min;
+	vector <size_t> hi = max;
+	while (lo.size() < 3) {
+		lo.push_back(0);
+		hi.push_back(0);
+		dims.push_back(1);
+		bs.push_back(1);
+	}
+
+	size_t nbx = (dims[0] + bs[0] - 1) / bs[0];
+	size_t nby = (dims[1] + bs[1] - 1) / bs[1];
+
+	size_t index = 0;
+	for (size_t z = lo[2]; z <= hi[2]; z++) {
+	for (size_t y = lo[1]; y <= hi[1]; y++) {
+		size_t brow = ((z / bs[2]) * nby + (y / bs[1])) * nbx;
+
+		for (size_t x = lo[0]; x <= hi[0]; x++, index++) {
+			if (mask && ! mask[index]) continue;
+
+			T v = data[index];
+			if (has_missing && v == mv) continue;
+
+			size_t b = 2 * (brow + (x / bs[0]));
+			if (v < blkranges[b]) blkranges[b] = v;
+			if (v > blkranges[b+1]) blkranges[b+1] = v;
+		}
+	}
+	}
+}
+
+int VDCNetCDF::_writeBlockRanges(VDCFileObject *o) {
+	const vector <double> &blkranges = o->GetBlockRanges();
+	string varname = o->GetVarname();
+
+	size_t nblocks = blkranges.size() / 2;
+
+	vector <double> record;
+	record.push_back((double) nblocks);
+	record.push_back(std::numeric_limits<double>::max());
+	record.push_back(-std::numeric_limits<double>::max());
+	for (size_t i=0; i<nblocks; i++) {
+		if (blkranges[2*i] < record[1]) record[1] = blkranges[2*i];
+		if (blkranges[2*i+1] > record[2]) record[2] = blkranges[2*i+1];
+	}
+	record.insert(record.end(), blkranges.begin(), blkranges.end());
+
+	vector <size_t> start;
+	vector <size_t> count;
+	if (IsTimeVarying(varname)) {
+		start.push_back(o->GetFileTS());
+		count.push_back(1);
+	}
+	start.push_back(0);
+	count.push_back(record.size());
+
+	return(((NetCDFCpp *) o->GetWaspData())->PutVara(
+		blockrange_varname(varname), start, count, &record[0]
+	));
+}
+
 template int VDCNetCDF::_writeSliceTemplate<float>(int fd, const float *slice);
 
 template <class T> 
@@ -1233,6 +1369,64 @@ bool VDCNetCDF::variableExists(
     return(true);
 }
 
+int VDCNetCDF::getBlockRanges(
+	size_t ts, string varname, vector <double> &range,
+	vector <double> &blkranges
+) {
+	range.clear();
+	blkranges.clear();
+
+	VDC::DataVar dvar;
+	if (! VDC::getDataVarInfo(varname, dvar)) return(0);
+
+	size_t nblocks = _numBlocks(varname);
+	if (! nblocks) return(0);
+
+	string path;
+	size_t file_ts;
+	size_t max_ts;
+	int rc = GetPath(varname, ts, path, file_ts, max_ts);
+	if (rc<0) return(-1);
+
+	NetCDFCpp ncdf;
+	NetCDFCpp *ncdfptr = _master;
+	if (path.compare(_master_path) != 0) {
+		rc = ncdf.Open(path, NC_NOWRITE);
+		if (rc<0) return(-1);
+		ncdfptr = &ncdf;
+	}
+
+	vector <double> record;
+	if (_blockRangeVarDefined(ncdfptr, varname)) {
+		vector <size_t> start;
+		vector <size_t> count;
+		if (IsTimeVarying(varname)) {
+			start.push_back(file_ts);
+			count.push_back(1);
+		}
+		start.push_back(0);
+		count.push_back(3 + 2*nblocks);
+
+		record.resize(3 + 2*nblocks);
+		rc = ncdfptr->GetVara(
+			blockrange_varname(varname), start, count, &record[0]
+		);
+	}
+	if (ncdfptr != _master) ncdf.Close();
+	if (rc<0) return(-1);
+
+	// Files written by older versions, and time steps that were not
+	// written in their entirety, have no ranges
+	//
+	if (record.empty() || record[0] != (double) nblocks) return(0);
+
+	range.push_back(record[1]);
+	range.push_back(record[2]);
+	blkranges.assign(record.begin() + 3, record.end());
+
+	return(0);
+}
+
 int VDCNetCDF::SetFill(int fillmode)
 {
 	int last;
@@ -1979,9 +2173,65 @@ int VDCNetCDF::_DefDataVar(
 		if (rc<0) return(rc);
 	}
 
+	rc = _DefBlockRangeVar(wasp, var, max_ts);
+	if (rc<0) return(rc);
+
 	return(rc);
 }
 
+int VDCNetCDF::_DefBlockRangeVar(
+	WASP *wasp,
+	const VDC::DataVar &var,
+	size_t max_ts
+) {
+	size_t nblocks = _numBlocks(var.GetName());
+	if (! nblocks) return(0);
+
+	string dimname = blockrange_dimname(var.GetName());
+	int rc = wasp->DefDim(dimname, 3 + 2*nblocks);
+	if (rc<0) return(rc);
+
+	// Time dimension, if any, was defined along with the variable
+	//
+	vector <string> dimnames;
+	if (IsTimeVarying(var.GetName())) {
+		vector <VDC::Dimension> dims;
+		bool status = GetVarDimensions(var.GetName(), false, dims); 
+		assert(status);
+
+		dimnames.push_back(dims[dims.size()-1].GetName());
+	}
+	dimnames.push_back(dimname);
+
+	return(wasp->DefVar(
+		blockrange_varname(var.GetName()), NC_DOUBLE, dimnames, "",
+		vector <size_t> (), vector <size_t> ()
+	));
+}
+
+bool VDCNetCDF::_blockRangeVarDefined(NetCDFCpp *ncdf, string varname) const {
+	vector <string> varnames;
+	int rc = ncdf->InqVarnames(varnames);
+	if (rc<0) return(false);
+
+	return(
+		find(varnames.begin(), varnames.end(), blockrange_varname(varname)) !=
+		varnames.end()
+	);
+}
+
+size_t VDCNetCDF::_numBlocks(string varname) const {
+	vector <size_t> dims, bs;
+	int rc = GetDimLensAtLevel(varname, -1, dims, bs);
+	if (rc<0 || dims.empty()) return(0);
+
+	size_t nblocks = 1;
+	for (int i=0; i<dims.size(); i++) {
+		nblocks *= (dims[i] + bs[i] - 1) / bs[i];
+	}
+	return(nblocks);
+}
+
 int VDCNetCDF::_DefCoordVar(
 	WASP *wasp,
 	const VDC::CoordVar &var,
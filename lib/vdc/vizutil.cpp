@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <cassert>
 #include <vapor/vizutil.h>
@@ -191,7 +192,17 @@ bool VAPoR::WachspressCoords2D(
 	for (int i=0; i<n; i++) lambda[i] = 0.0;
 
 	double wTotal = 0.0;
-	const double epsilon = 1e-6;
+
+	// Tolerance for deciding that the point lies on an edge. It is 
+	// relative to the size of the polygon so that small polygons 
+	// aren't treated as being mostly edge
+	//
+	double size = 0.0;
+	for (int i=1; i<n; i++) {
+		size = std::max(size, std::fabs(verts[i*2] - verts[0]));
+		size = std::max(size, std::fabs(verts[i*2+1] - verts[1]));
+	}
+	const double epsilon = 1e-6 * size * size;
 
 	int curr = 0;
 	int prev = (curr+n-1) % n;
@@ -220,6 +231,11 @@ bool VAPoR::WachspressCoords2D(
 	if (onEdge) {
 		int i0, i1;
 
+		// Discard weights computed for vertices visited before the
+		// edge was found
+		//
+		for (int i=0; i<n; i++) lambda[i] = 0.0;
+
 		// Which edge is point on? beteen points prev and curr, or curr 
 		// and next ?
 		//
@@ -0,0 +1,166 @@
+//
+// Bit streams shared by the significance map and coefficient coders.
+// Internal to the wasp library.
+//
+
+#ifndef	_BitStream_h_
+#define	_BitStream_h_
+
+#include <cstddef>
+
+namespace VAPoR {
+
+// Byte lookup tables for decoding
+//
+struct bit_decode_tables {
+	unsigned char lz[256];			// leading zero bits. 8 for zero
+	unsigned char nset[256];		// number of bits set
+	unsigned char pos[256][8];		// positions of set bits, from the MSB
+
+	bit_decode_tables() {
+		for (int b = 0; b<256; b++) {
+			lz[b] = 8;
+			nset[b] = 0;
+			for (int i = 0; i<8; i++) {
+				if (! (b & (0x80 >> i))) continue;
+				if (lz[b] == 8) lz[b] = i;
+				pos[b][nset[b]++] = i;
+			}
+		}
+	}
+};
+
+inline const bit_decode_tables &get_bit_decode_tables() {
+	static const bit_decode_tables tables;
+	return(tables);
+}
+
+// Writes a stream of bits, most significant bit first
+//
+class bit_writer {
+public:
+	bit_writer(unsigned char *ptr) : _ptr(ptr), _acc(0), _nbits(0) {}
+
+	// Append the n low order bits of v, 0 <= n <= 32
+	//
+	void put(unsigned long long v, int n) {
+		_acc = (_acc << n) | (v & ~(~0ULL << n));
+		_nbits += n;
+		while (_nbits >= 8) {
+			_nbits -= 8;
+			*_ptr++ = (unsigned char) (_acc >> _nbits);
+		}
+	}
+
+	// Append the n low order bits of v, 0 <= n <= 64
+	//
+	void put_wide(unsigned long long v, int n) {
+		if (n > 32) {
+			put(v >> 32, n - 32);
+			n = 32;
+		}
+		put(v, n);
+	}
+
+	// Append n zero bits
+	//
+	void zeros(size_t n) {
+		for (; n > 32; n -= 32) put(0, 32);
+		put(0, (int) n);
+	}
+
+	// Write any partial byte, padded with zeros. Returns the end of the
+	// stream
+	//
+	unsigned char *flush() {
+		if (_nbits) *_ptr++ = (unsigned char) (_acc << (8 - _nbits));
+		_nbits = 0;
+		return(_ptr);
+	}
+
+private:
+	unsigned char *_ptr;
+	unsigned long long _acc;
+	int _nbits;
+};
+
+// Reads a stream of bits written by bit_writer. Bits are buffered
+// left-adjusted in a 64 bit word. Nothing is read from at or beyond
+// 'end'; zero bits are returned instead, and reported by overrun()
+// once they are consumed.
+//
+class bit_reader {
+public:
+	bit_reader(const unsigned char *ptr, const unsigned char *end) :
+		_ptr(ptr), _end(end), _acc(0), _nbits(0), _npad(0),
+		_tables(get_bit_decode_tables()) { _refill(); }
+
+	// Return the next n bits, 0 <= n <= 32
+	//
+	unsigned long long get(int n) {
+		if (! n) return(0);
+		if (_nbits < n) _refill();
+		unsigned long long v = _acc >> (64 - n);
+		skip(n);
+		return(v);
+	}
+
+	// Return the next n bits, 0 <= n <= 64
+	//
+	unsigned long long get_wide(int n) {
+		if (n <= 32) return(get(n));
+		unsigned long long hi = get(n - 32);
+		return((hi << 32) | get(32));
+	}
+
+	// Return the number of one bits before the next zero bit, up to
+	// max, and consume them and, if fewer than max, the zero bit.
+	// max must not exceed 8
+	//
+	int get_unary(int max) {
+		int n = _tables.lz[peek8() ^ 0xff];
+		if (n > max) n = max;
+		skip(n < max ? n + 1 : n);
+		return(n);
+	}
+
+	// Return the next 8 bits without consuming them
+	//
+	unsigned int peek8() {
+		if (_nbits < 8) _refill();
+		return((unsigned int) (_acc >> 56));
+	}
+
+	// Consume n bits. There must be at least n bits buffered
+	//
+	void skip(int n) {
+		_acc <<= n;
+		_nbits -= n;
+	}
+
+	// True if bits beyond 'end' were consumed
+	//
+	bool overrun() const {return(_nbits < _npad); }
+
+private:
+	const unsigned char *_ptr;
+	const unsigned char *_end;
+	unsigned long long _acc;
+	int _nbits;
+	int _npad;	// zero bits buffered from beyond 'end'
+	const bit_decode_tables &_tables;
+
+	void _refill() {
+		while (_nbits <= 56) {
+			unsigned long long b = 0;
+			if (_ptr < _end) b = *_ptr++;
+			else _npad += 8;
+			_acc |= b << (56 - _nbits);
+			_nbits += 8;
+		}
+	}
+};
+
+};
+
+#endif
@@ -1,11 +1,13 @@
 //
 // $Id: Compressor.cpp,v 1.6 2013/05/15 23:05:48 clynejp Exp $
 //
+#include <cassert>
 #include <cstring>
 #include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <vapor/Compressor.h>
+#include "BitStream.h"
 
 using namespace VAPoR;
 using namespace std;
@@ -91,6 +93,38 @@ void Compressor::_Compressor(
 	}
 	_indexvec.reserve(_CLen);
 
+	// Offsets of the approximation subband and of the detail subbands
+	// in the coefficient array, coarsest level first
+	//
+	size_t offset = 0;
+	if (_dims.size() == 3) {
+		_subbands.push_back(offset);
+		offset += _L[0]*_L[1]*_L[2];
+		for (int i=1; i<=_nlevels; i++) {
+			for (int j=-18; j<=0; j+=3) {
+				_subbands.push_back(offset);
+				offset += _L[(i*21)+j] * _L[(i*21)+j+1] * _L[(i*21)+j+2];
+			}
+		}
+	}
+	else if (_dims.size() == 2) {
+		_subbands.push_back(offset);
+		offset += _L[0]*_L[1];
+		for (int i=1; i<=_nlevels; i++) {
+			for (int j=-4; j<=0; j+=2) {
+				_subbands.push_back(offset);
+				offset += _L[(i*6)+j] * _L[(i*6)+j+1];
+			}
+		}
+	}
+	else {
+		for (int i=0; i<=_nlevels; i++) {
+			_subbands.push_back(offset);
+			offset += _L[i];
+		}
+	}
+	assert(offset == _CLen);
+
 }
 
 Compressor::Compressor(
@@ -126,26 +160,102 @@ Compressor::~Compressor() {
 
 
 //
-// Comparision functions for the C++ Std Lib sort function
+// Comparision functions for the C++ Std Lib selection functions. 
+// Coefficients are ordered by decreasing magnitude, and coefficients
+// of equal magnitude by increasing address, so the order is total and
+// the coefficients selected never depend on the selection algorithm
 //
 inline bool my_compare_f(const void * x1, const void * x2) {
-	return(fabsf(* (float *) x1) > fabsf(* (float *) x2));
+	float a = fabsf(* (float *) x1);
+	float b = fabsf(* (float *) x2);
+	return(a > b || (a == b && x1 < x2));
 }
 
 inline bool my_compare_d(const void * x1, const void * x2) {
-	return(fabs(* (double *) x1) > fabs(* (double *) x2));
+	double a = fabs(* (double *) x1);
+	double b = fabs(* (double *) x2);
+	return(a > b || (a == b && x1 < x2));
 }
 
 inline bool my_compare_i(const void * x1, const void * x2) {
-	return(abs(* (int *) x1) > abs(* (int *) x2));
+	int a = abs(* (int *) x1);
+	int b = abs(* (int *) x2);
+	return(a > b || (a == b && x1 < x2));
 }
 
 inline bool my_compare_l(const void * x1, const void * x2) {
-	return(labs(* (long *) x1) > labs(* (long *) x2));
+	long a = labs(* (long *) x1);
+	long b = labs(* (long *) x2);
+	return(a > b || (a == b && x1 < x2));
 }
 
 namespace {
 
+// Partition the detail coefficients C[numkeep..clen-1] into sets of
+// decreasing magnitude with lens[j] coefficients in set j, and
+// coefficients in no set. Rather than sorting all of the coefficients
+// the boundaries between sets are found with a selection algorithm,
+// O(n) on average. The boundaries are returned in bounds: bounds[j] 
+// is the coefficient with the largest magnitude that comes after
+// set j, or NULL if there are none. The set of a coefficient is then
+// found with set_of().
+//
+template <class T>
+void select_coefficients(
+	const T *C,
+	size_t numkeep,
+	size_t clen,
+	const vector <size_t> &lens,
+	vector <void *> &indexvec,
+	bool my_compare(const void *, const void *),
+	vector <const void *> &bounds
+) {
+	bounds.assign(lens.size(), NULL);
+
+	indexvec.clear();
+	for (size_t i=numkeep; i<clen; i++) indexvec.push_back((void *) &C[i]);
+
+	vector <size_t> ends;	// end of each set within indexvec
+	size_t end = 0;
+	for (int j=0; j<lens.size(); j++) {
+		end += lens[j];
+		ends.push_back(end);
+	}
+
+	// Select the last boundary over all of the coefficients, then each
+	// preceding one within the coefficients ahead of the last
+	//
+	size_t last = indexvec.size();
+	for (int j=lens.size()-1; j>=0; j--) {
+		if (ends[j] >= indexvec.size()) continue;
+
+		nth_element(
+			indexvec.begin(), indexvec.begin() + ends[j],
+			indexvec.begin() + last, my_compare
+		);
+		bounds[j] = indexvec[ends[j]];
+		last = ends[j];
+	}
+}
+
+// Return the set containing coefficient c, or -1 if c is in no set
+//
+inline int set_of(
+	const void *c, const vector <const void *> &bounds,
+	bool my_compare(const void *, const void *)
+) {
+	int n = bounds.size();
+
+	// Most coefficients are in no set
+	//
+	if (bounds[n-1] && ! my_compare(c, bounds[n-1])) return(-1);
+
+	for (int j=0; j<n-1; j++) {
+		if (! bounds[j] || my_compare(c, bounds[j])) return(j);
+	}
+	return(n-1);
+}
+
 template <class T>
 int compress_template(
 	Compressor *cmp,
@@ -158,7 +268,7 @@ int compress_template(
 	SignificanceMap *sigmap,
 	const vector <size_t> &dims,
 	size_t nlevels,
-	vector <void *> indexvec,
+	vector <void *> &indexvec,
 	bool my_compare(const void *, const void *)
 ) {
 
@@ -226,21 +336,21 @@ int compress_template(
 		dst_arr_len -= numkeep;
 	}
 
-	indexvec.clear();
-	for (size_t i=numkeep; i<clen; i++) indexvec.push_back(&C[i]);
-    sort(indexvec.begin(), indexvec.end(), my_compare);
-
+	vector <const void *> bounds;
+	select_coefficients(
+		C, numkeep, clen, vector <size_t> (1, dst_arr_len), indexvec,
+		my_compare, bounds
+	);
 
 	// Copy coefficients that are larger than the threshold to
-	// the destination array. Record their location in the significance
-	// map.
+	// the destination array in the order they are stored. Record their 
+	// location in the significance map.
 	//
-
-	sort(indexvec.begin(), indexvec.begin()+dst_arr_len);
 	for (size_t idx = numkeep, i = 0; idx<clen && i<dst_arr_len; idx++) {
-		const T *cptr =  (T *) indexvec[i];
-		dst_arr[i++] = *cptr;
-		sigmap->Set(cptr - C);
+		if (set_of(&C[idx], bounds, my_compare) < 0) continue;
+
+		dst_arr[i++] = C[idx];
+		sigmap->Set(idx);
 	}
 	return(0);
 }
@@ -444,7 +554,7 @@ int decompose_template(
 	vector <SignificanceMap> &sigmaps,
 	const vector <size_t> &dims,
 	size_t nlevels,
-	vector <void *> indexvec,
+	vector <void *> &indexvec,
 	bool my_compare(const void *, const void *)
 ) {
 	if (! C) {
@@ -524,26 +634,32 @@ int decompose_template(
 	}
 
 	//
-	// sort the **indecies** of the coefficients based on the 
-	// coefficient's magnitude
+	// Find the boundaries between the sets of coefficients, based
+	// on the coefficient's magnitude
 	//
-	indexvec.clear();
-	for (size_t i=numkeep; i<clen; i++)  indexvec.push_back(&C[i]); 
-    sort(indexvec.begin(), indexvec.end(), my_compare);
+	vector <const void *> bounds;
+	select_coefficients(
+		C, numkeep, clen, my_dst_arr_lens, indexvec, my_compare, bounds
+	);
 
-	
-	vector <void *>::iterator itr = indexvec.begin();
-	for (int j = 0, idx=0; j<my_dst_arr_lens.size(); j++) {
-		sort(itr, itr+my_dst_arr_lens[j]);	// sort coefficient's indecies
-		itr += my_dst_arr_lens[j];
-		for (int i = 0; i<my_dst_arr_lens[j]; i++, idx++) {
-			const T *cptr =  (T *) indexvec[idx];
-			dst_arr[i] = *cptr;
-			sigmaps[j].Set(cptr - C);
-		}
+	// Copy each set's coefficients to its part of the destination
+	// array, in the order they are stored, with a single pass over
+	// the coefficients
+	//
+	vector <T *> dst_ptrs;
+	for (int j = 0; j<my_dst_arr_lens.size(); j++) {
+		dst_ptrs.push_back(dst_arr);
 		dst_arr += my_dst_arr_lens[j];
 	}
 
+	for (size_t idx = numkeep; idx<clen; idx++) {
+		int j = set_of(&C[idx], bounds, my_compare);
+		if (j < 0) continue;
+
+		*dst_ptrs[j]++ = C[idx];
+		sigmaps[j].Set(idx);
+	}
+
 	return(0);
 }
 
@@ -716,7 +832,519 @@ int Compressor::Reconstruct(
 	);
 }
 
+namespace {
+
+// A quantized collection of coefficients starts with the quantization
+// step, as a 64 bit IEEE double. A step of zero means every quantized
+// coefficient is zero, and nothing else is stored. Otherwise the step
+// is followed by a description of each subband: its Rice parameter,
+// or QuantNoSubband if none of the collection's coefficients are in the
+// subband. For the other subbands the parameter is followed by the bit
+// depth of their magnitudes, less the smallest magnitude, and by the 
+// smallest magnitude, as a variable length integer. The coefficients 
+// follow in the order of the significance map: the magnitude, less the
+// subband's smallest, and a sign bit if the magnitude isn't zero. The
+// magnitude is Rice coded, or stored with the subband's bit depth if 
+// the Rice parameter equals the bit depth.
+//
+const size_t QuantStepSize = 8;
+const size_t QuantMaxSubbandSize = 7;
+const unsigned char QuantNoSubband = 0xff;
+
+// Rice quotients of QuantEscape or more are coded as QuantEscape one
+// bits followed by the magnitude with the subband's bit depth. This
+// bounds the size of a coded magnitude
+//
+const int QuantEscape = 8;
+
+// Quantized magnitudes are kept below 2^QuantMaxBits + 1
+//
+const int QuantMaxBits = 30;
+
+// Store and load a double, most significant byte first
+//
+void put_double(double d, unsigned char *ptr) {
+	unsigned long long v;
+	memcpy(&v, &d, sizeof(v));
+	for (int i=0; i<8; i++) ptr[i] = (unsigned char) (v >> (56 - 8*i));
+}
+
+double get_double(const unsigned char *ptr) {
+	unsigned long long v = 0;
+	for (int i=0; i<8; i++) v = (v << 8) | ptr[i];
+	double d;
+	memcpy(&d, &v, sizeof(d));
+	return(d);
+}
+
+// Store and load an unsigned integer, seven bits per byte, least 
+// significant first
+//
+unsigned char *put_varint(unsigned long long v, unsigned char *ptr) {
+	while (v >= 0x80) {
+		*ptr++ = (unsigned char) (v | 0x80);
+		v >>= 7;
+	}
+	*ptr++ = (unsigned char) v;
+	return(ptr);
+}
+
+const unsigned char *get_varint(
+	const unsigned char *ptr, const unsigned char *end, unsigned long long &v
+) {
+	v = 0;
+	for (int shift = 0; ptr < end && shift < 64; shift += 7) {
+		v |= (unsigned long long) (*ptr & 0x7f) << shift;
+		if (! (*ptr++ & 0x80)) return(ptr);
+	}
+	return(NULL);
+}
+
+inline size_t varint_size(unsigned long long v) {
+	size_t n = 1;
+	for (; v >= 0x80; v >>= 7) n++;
+	return(n);
+}
+
+// Number of bits needed to store 'v'
+//
+inline int bit_length(unsigned long long v) {
+	int n = 0;
+	for (; v; v >>= 1) n++;
+	return(n);
+}
+
+// Coding parameters of the coefficients of a collection that are in 
+// one subband
+//
+struct subband_code_t {
+	size_t n;	// number of coefficients
+	unsigned long long qmin;	// smallest quantized magnitude
+	unsigned long long qmax;	// largest quantized magnitude
+	double qsum;	// sum of quantized magnitudes
+	int w;	// bit depth of magnitudes less qmin
+	int k;	// Rice parameter
+};
+
+// Number of bits of the code of magnitude 'm'
+//
+inline size_t rice_size(unsigned long long m, int k, int w) {
+	if (k >= w) return(w);	// fixed width, or every magnitude is qmin
+
+	unsigned long long u = m >> k;
+	return(u < QuantEscape ? u + 1 + k : QuantEscape + w);
+}
+
+// Index of the subband holding coefficient 'idx'
+//
+inline size_t subband_of(const vector <size_t> &subbands, size_t idx) {
+	return(upper_bound(subbands.begin(), subbands.end(), idx) - 
+		subbands.begin() - 1);
+}
+
+// Quantize the magnitudes 'mag', whose subbands are 'sb', with 'step',
+// and choose the coding parameters of each subband. Returns the size 
+// in bytes of the coded collection
+//
+size_t choose_codes(
+	const vector <double> &mag, const vector <unsigned short> &sb,
+	double step, vector <unsigned long long> &q, 
+	vector <subband_code_t> &codes
+) {
+	for (size_t s=0; s<codes.size(); s++) {
+		codes[s].n = 0;
+		codes[s].qmin = ~0ULL;
+		codes[s].qmax = 0;
+		codes[s].qsum = 0.0;
+	}
+
+	double scale = 1.0 / step;
+	for (size_t i=0; i<mag.size(); i++) {
+		q[i] = (unsigned long long) (mag[i] * scale + 0.5);
+
+		subband_code_t &c = codes[sb[i]];
+		c.n++;
+		if (q[i] < c.qmin) c.qmin = q[i];
+		if (q[i] > c.qmax) c.qmax = q[i];
+		c.qsum += q[i];
+	}
+
+	// The best Rice parameter for geometrically distributed magnitudes
+	// is close to the log of their mean. Count the bits needed with 
+	// it, its two neighbors, and with fixed width magnitudes, which suit
+	// uniformly distributed ones
+	//
+	size_t nbytes = QuantStepSize;
+	for (size_t s=0; s<codes.size(); s++) {
+		subband_code_t &c = codes[s];
+		if (! c.n) {
+			nbytes++;
+			continue;
+		}
+		c.w = bit_length(c.qmax - c.qmin);
+		double mean = c.qsum / c.n - c.qmin;
+		c.k = mean >= 2.0 ? bit_length((unsigned long long) mean) - 2 : 0;
+		nbytes += 2 + varint_size(c.qmin);
+	}
+
+	vector <size_t> nbits(codes.size() * 4, 0);
+	for (size_t i=0; i<mag.size(); i++) {
+		const subband_code_t &c = codes[sb[i]];
+		unsigned long long m = q[i] - c.qmin;
+		size_t sign = q[i] ? 1 : 0;
+		size_t *bits = &nbits[sb[i] * 4];
+		for (int j=0; j<3; j++) {
+			bits[j] += rice_size(m, min(c.k + j, c.w), c.w) + sign;
+		}
+		bits[3] += c.w + sign;
+	}
+
+	size_t total = 0;
+	for (size_t s=0; s<codes.size(); s++) {
+		subband_code_t &c = codes[s];
+		if (! c.n) continue;
+
+		const size_t *bits = &nbits[s * 4];
+		int best = 0;
+		for (int j=1; j<4; j++) {
+			if (bits[j] < bits[best]) best = j;
+		}
+		c.k = best == 3 ? c.w : min(c.k + best, c.w);
+		total += bits[best];
+	}
+	return(nbytes + (total + 7) / 8);
+}
 
+// Store a collection quantized and coded by choose_codes(). Returns
+// the number of bytes stored
+//
+size_t put_codes(
+	double step, const vector <unsigned long long> &q, 
+	const vector <unsigned char> &neg, const vector <unsigned short> &sb,
+	const vector <subband_code_t> &codes, unsigned char *dst_arr
+) {
+	put_double(step, dst_arr);
+
+	unsigned char *ptr = dst_arr + QuantStepSize;
+	for (size_t s=0; s<codes.size(); s++) {
+		const subband_code_t &c = codes[s];
+		if (! c.n) {
+			*ptr++ = QuantNoSubband;
+			continue;
+		}
+		*ptr++ = (unsigned char) c.k;
+		*ptr++ = (unsigned char) c.w;
+		ptr = put_varint(c.qmin, ptr);
+	}
+
+	bit_writer bw(ptr);
+	for (size_t i=0; i<q.size(); i++) {
+		const subband_code_t &c = codes[sb[i]];
+		unsigned long long m = q[i] - c.qmin;
+
+		if (c.k == c.w) {
+			bw.put(m, c.w);
+		}
+		else {
+			unsigned long long u = m >> c.k;
+			if (u < QuantEscape) {
+				bw.put((1ULL << (u+1)) - 2, (int) u + 1);
+				bw.put(m & ((1ULL << c.k) - 1), c.k);
+			}
+			else {
+				bw.put((1ULL << QuantEscape) - 1, QuantEscape);
+				bw.put(m, c.w);
+			}
+		}
+		if (q[i]) bw.put(neg[i], 1);
+	}
+	return(bw.flush() - dst_arr);
+}
+
+template <class T> inline T round_to(double v) { return((T) v); }
+template <> inline int round_to<int>(double v) { return((int) lrint(v)); }
+template <> inline long round_to<long>(double v) { return(lrint(v)); }
+
+bool valid_nbits(int nbits) {
+	if (nbits < 2 || nbits > 32) {
+		Compressor::SetErrMsg("Invalid quantization bit depth : %d", nbits);
+		return(false);
+	}
+	return(true);
+}
+
+template <class T>
+int quantize_template(
+	const Compressor *cmp, const vector <size_t> &subbands,
+	const T *src_arr, SignificanceMap &sigmap, int nbits, 
+	unsigned char *dst_arr
+) {
+	if (! valid_nbits(nbits)) return(-1);
+
+	// Magnitude, sign, and subband of each coefficient that is
+	// quantized
+	//
+	size_t nexact = cmp->GetNumUnquantized();
+	size_t nsig = sigmap.GetNumSignificant();
+	vector <double> mag;
+	vector <unsigned char> neg;
+	vector <unsigned short> sb;
+	mag.reserve(nsig);
+	neg.reserve(nsig);
+	sb.reserve(nsig);
+
+	double maxmag = 0.0;
+	sigmap.GetNextEntryRestart();
+	for (size_t i=0; i<nsig; i++) {
+		size_t idx;
+		if (! sigmap.GetNextEntry(&idx)) {
+			Compressor::SetErrMsg("Invalid significance map");
+			return(-1);
+		}
+		if (idx < nexact) continue;
+
+		double v = (double) src_arr[i];
+		if (! std::isfinite(v)) {
+			Compressor::SetErrMsg("Invalid coefficient : %f", v);
+			return(-1);
+		}
+		mag.push_back(fabs(v));
+		neg.push_back(v < 0.0);
+		sb.push_back(subband_of(subbands, idx));
+		if (fabs(v) > maxmag) maxmag = fabs(v);
+	}
+
+	if (maxmag == 0.0) {
+		put_double(0.0, dst_arr);
+		return(QuantStepSize);
+	}
+
+	// Find the finest step for which the coded collection fits, 
+	// between the step that keeps magnitudes below 2^QuantMaxBits and 
+	// 4 * maxmag, which makes every magnitude zero so that only the 
+	// subband descriptions are stored. That always fits. 
+	//
+	// Halving the step adds about a bit per coefficient, so the coded 
+	// size is nearly linear in the log of the step. The step is found by
+	// false position on its log, starting from the step of a fixed width 
+	// quantizer with 'nbits' bits
+	//
+	size_t size = cmp->GetQuantizedSize(mag.size(), nbits);
+	vector <subband_code_t> codes(subbands.size()), bestcodes;
+	vector <unsigned long long> q(mag.size()), bestq;
+
+	double minlog = log2(maxmag) - QuantMaxBits;
+	double maxlog = log2(maxmag) + 2.0;
+
+	double x = max(log2(maxmag) - (nbits - 1), minlog);
+	double lo = minlog, hi = maxlog;
+	double losize = HUGE_VAL, hisize = 0.0;
+	for (int i=0; i<12 && hi - lo > 1.0 / 32; i++) {
+		double s = (double) choose_codes(mag, sb, exp2(x), q, codes);
+		if (s <= size) {
+			hi = x;
+			hisize = s;
+			bestq.swap(q);
+			bestcodes.swap(codes);
+			q.resize(mag.size());
+			codes.resize(subbands.size());
+		}
+		else {
+			lo = x;
+			losize = s;
+		}
+		if (hi == minlog || hisize >= 0.998 * size) break;
+
+		// Until the step is bracketed, extrapolate at a bit per 
+		// coefficient per octave, overshooting a little. Then 
+		// interpolate, staying clear of the ends of the bracket
+		//
+		double dx = 1.25 * 8.0 * ((double) size - s) / mag.size();
+		if (losize == HUGE_VAL) x = max(x - max(dx, 0.125), lo);
+		else if (hisize == 0.0) x = min(x - min(dx, -0.125), hi);
+		else {
+			double t = (losize - size) / (losize - hisize);
+			x = lo + min(max(t, 0.05), 0.95) * (hi - lo);
+		}
+	}
+	if (hisize == 0.0) {
+		(void) choose_codes(mag, sb, exp2(hi), q, codes);
+		bestq.swap(q);
+		bestcodes.swap(codes);
+	}
+
+	return((int) put_codes(exp2(hi), bestq, neg, sb, bestcodes, dst_arr));
+}
+
+template <class T>
+int dequantize_template(
+	const Compressor *cmp, const vector <size_t> &subbands,
+	const unsigned char *src_arr, SignificanceMap &sigmap, int nbits, 
+	T *dst_arr
+) {
+	if (! valid_nbits(nbits)) return(-1);
+
+	size_t nexact = cmp->GetNumUnquantized();
+	size_t nsig = sigmap.GetNumSignificant();
+	size_t n = 0;
+	size_t idx;
+	sigmap.GetNextEntryRestart();
+	while (sigmap.GetNextEntry(&idx)) {
+		if (idx >= nexact) n++;
+	}
+	const unsigned char *end = src_arr + cmp->GetQuantizedSize(n, nbits);
+
+	double step = get_double(src_arr);
+	const unsigned char *ptr = src_arr + QuantStepSize;
+
+	bool valid = step >= 0.0;
+	vector <subband_code_t> codes(subbands.size());
+	for (size_t s=0; s<codes.size(); s++) {
+		subband_code_t &c = codes[s];
+		c.n = 0;
+		if (step == 0.0 || ! valid) continue;
+
+		if (end - ptr < 1) {
+			valid = false;
+			continue;
+		}
+		if (*ptr == QuantNoSubband) {
+			ptr++;
+			continue;
+		}
+		if (end - ptr < 3) {
+			valid = false;
+			continue;
+		}
+		c.n = 1;
+		c.k = *ptr++;
+		c.w = *ptr++;
+		ptr = get_varint(ptr, end, c.qmin);
+		valid = ptr && c.w <= QuantMaxBits + 1 && c.k <= c.w;
+	}
+	if (! valid) {
+		Compressor::SetErrMsg("Invalid quantized coefficients");
+		return(-1);
+	}
+
+	bit_reader br(ptr, end);
+	sigmap.GetNextEntryRestart();
+	for (size_t i=0; i<nsig; i++) {
+		(void) sigmap.GetNextEntry(&idx);
+		if (idx < nexact) continue;
+
+		if (step == 0.0) {
+			dst_arr[i] = 0;
+			continue;
+		}
+
+		const subband_code_t &c = codes[subband_of(subbands, idx)];
+		if (! c.n) {
+			Compressor::SetErrMsg("Invalid quantized coefficients");
+			return(-1);
+		}
+
+		unsigned long long m = 0;
+		if (c.k == c.w) {
+			m = br.get(c.w);
+		}
+		else {
+			int u = br.get_unary(QuantEscape);
+
+			if (u < QuantEscape) m = ((unsigned long long) u << c.k) | br.get(c.k);
+			else m = br.get(c.w);
+		}
+
+		unsigned long long qv = c.qmin + m;
+		double v = qv * step;
+		if (qv && br.get(1)) v = -v;
+		dst_arr[i] = round_to<T>(v);
+	}
+	if (br.overrun()) {
+		Compressor::SetErrMsg("Invalid quantized coefficients");
+		return(-1);
+	}
+	return(0);
+}
+
+};
+
+size_t Compressor::GetQuantizedSize(size_t num_entries, int nbits) const {
+
+	// Descriptions of the subbands, of which at most num_entries
+	// hold coefficients, and the coded coefficients
+	//
+	size_t nsubbands = _subbands.size();
+	size_t nused = min(num_entries, nsubbands);
+	return(
+		QuantStepSize + nsubbands + nused * (QuantMaxSubbandSize - 1) +
+		(num_entries * nbits + 7) / 8
+	);
+}
+
+double Compressor::GetQuantizationStep(const unsigned char *src_arr) {
+	return(get_double(src_arr));
+}
+
+size_t Compressor::GetNumUnquantized() const {
+	return(_keepapp ? GetMinCompression() : 0);
+}
+
+int Compressor::Quantize(
+	const float *src_arr, SignificanceMap &sigmap, int nbits, 
+	unsigned char *dst_arr
+) const {
+	return(quantize_template(this, _subbands, src_arr, sigmap, nbits, dst_arr));
+}
+
+int Compressor::Quantize(
+	const double *src_arr, SignificanceMap &sigmap, int nbits, 
+	unsigned char *dst_arr
+) const {
+	return(quantize_template(this, _subbands, src_arr, sigmap, nbits, dst_arr));
+}
+
+int Compressor::Quantize(
+	const int *src_arr, SignificanceMap &sigmap, int nbits, 
+	unsigned char *dst_arr
+) const {
+	return(quantize_template(this, _subbands, src_arr, sigmap, nbits, dst_arr));
+}
+
+int Compressor::Quantize(
+	const long *src_arr, SignificanceMap &sigmap, int nbits, 
+	unsigned char *dst_arr
+) const {
+	return(quantize_template(this, _subbands, src_arr, sigmap, nbits, dst_arr));
+}
+
+int Compressor::Dequantize(
+	const unsigned char *src_arr, SignificanceMap &sigmap, int nbits, 
+	float *dst_arr
+) const {
+	return(dequantize_template(this, _subbands, src_arr, sigmap, nbits, dst_arr));
+}
+
+int Compressor::Dequantize(
+	const unsigned char *src_arr, SignificanceMap &sigmap, int nbits, 
+	double *dst_arr
+) const {
+	return(dequantize_template(this, _subbands, src_arr, sigmap, nbits, dst_arr));
+}
+
+int Compressor::Dequantize(
+	const unsigned char *src_arr, SignificanceMap &sigmap, int nbits, 
+	int *dst_arr
+) const {
+	return(dequantize_template(this, _subbands, src_arr, sigmap, nbits, dst_arr));
+}
+
+int Compressor::Dequantize(
+	const unsigned char *src_arr, SignificanceMap &sigmap, int nbits, 
+	long *dst_arr
+) const {
+	return(dequantize_template(this, _subbands, src_arr, sigmap, nbits, dst_arr));
+}
 
 #ifdef	VAPOR3_0_0_ALPHA
 bool Compressor::IsCompressible(
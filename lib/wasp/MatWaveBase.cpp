@@ -14,6 +14,7 @@ MatWaveBase::MatWaveBase(const string &wname, const string &mode) {
 	_wf = NULL;
 	_mode = PER;
 	_wname = wname;
+	_FastTransform = false;
 
 	_wf = _create_wf(wname);
 	if (! _wf) return;
@@ -29,6 +30,7 @@ MatWaveBase::MatWaveBase(const string &wname) {
 	_wf = NULL;
 	_mode = PER;
 	_wname = wname;
+	_FastTransform = false;
 
 	_wf = _create_wf(wname);
 	if (! _wf) return;
@@ -4,22 +4,10 @@
 #include <iostream>
 #include <cstring>
 #include <vapor/SignificanceMap.h>
+#include "BitStream.h"
 
 using namespace VAPoR;
 
-// gets the right-adjusted N bits of quantity TARG
-// starting from bit position POSS
-//
-#define GETBITS(TARG,POSS,N) (((TARG) >> ((POSS)+1-(N))) & ~(~0ULL << (N)))
-
-// set N bits of quantity TARG starting from position
-// POSS to the right-most N bits in integer SRC
-//
-#define PUTBITS(TARG, POSS, N, SRC) \
-    (TARG) &= ~(~((~0ULL) << (N)) << (((POSS)+1) - (N))); \
-    (TARG) |= (((SRC) & ~((~0ULL) << (N))) << (((POSS)+1) - (N)))
-
-
 using namespace std;
 
 
@@ -432,14 +420,54 @@ int SignificanceMap::GetNextEntryXYZT(
 	return(0);
 
 }
+size_t SignificanceMap::_GetEncoding(
+	vector <size_t> dims, size_t num_entries, bool packed,
+	encoding_t &encoding, int &k
+) {
+	size_t size = 1;
+	for (int i = 0; i<dims.size(); i++) size *= dims[i];
+
+	size_t bits_per_idx = _GetBitsPerIdx(dims);
+
+	encoding = PACKED;
+	k = 0;
+	size_t tbits = num_entries * bits_per_idx;
+	if (packed) return(tbits);
+
+	// Each Rice coded gap takes k+1 bits plus one bit for every 2^k
+	// in the gap. The gaps sum to at most size-1, which bounds the
+	// size of the encoding for any set of entries. Ties favor the
+	// packed encoding, which older readers understand
+	//
+	for (int i = 0; i<bits_per_idx && i<=MaxRiceK; i++) {
+		size_t nbits = num_entries * (i+1) + ((size-1) >> i);
+		if (nbits < tbits) {
+			tbits = nbits;
+			encoding = GAPS;
+			k = i;
+		}
+	}
+
+	if (size < tbits) {
+		tbits = size;
+		encoding = BITMAP;
+		k = 0;
+	}
+	return(tbits);
+}
+
 size_t SignificanceMap::GetMapSize(
 	vector <size_t> dims,
-	size_t num_entries
+	size_t num_entries,
+	bool packed
 ) {
+	encoding_t encoding;
+	int k;
+
 	// Calculate size of encoded map
 	//
 	size_t mapsize;
-	size_t tbits  = num_entries * _GetBitsPerIdx(dims);
+	size_t tbits  = _GetEncoding(dims, num_entries, packed, encoding, k);
 	if (tbits) 
 		mapsize = (tbits - 1) / BITSPERBYTE + 1 + HEADER_SIZE;
 	else
@@ -449,12 +477,12 @@ size_t SignificanceMap::GetMapSize(
 
 }
 
-size_t SignificanceMap::GetMapSize(size_t num_entries) const {
+size_t SignificanceMap::GetMapSize(size_t num_entries, bool packed) const {
 
-	return(GetMapSize(_dimsVec, num_entries));
+	return(GetMapSize(_dimsVec, num_entries, packed));
 }
 
-void SignificanceMap::GetMap(unsigned char *encodedMap) {
+void SignificanceMap::GetMap(unsigned char *encodedMap, bool packed) {
 
 	unsigned long LSBTest = 1;
 	bool do_swapbytes = false;
@@ -463,21 +491,42 @@ void SignificanceMap::GetMap(unsigned char *encodedMap) {
 		do_swapbytes = true;
 	}
 	
-	memset(_sigMapEncode, 0, _sigMapEncodeSize);
+	if (! _sorted) SignificanceMap::Sort();
+
+	encoding_t encoding;
+	int k;
+	(void) _GetEncoding(_dimsVec, _sigMapVec.size(), packed, encoding, k);
+
+	// The bitmap can't represent duplicate entries
+	//
+	size_t numentries = _sigMapVec.size();
+	if (encoding == BITMAP) {
+		for (size_t i = 1; i<_sigMapVec.size(); i++) {
+			if (_sigMapVec[i] == _sigMapVec[i-1]) numentries--;
+		}
+	}
 
 	// 
 	//  Encode header
 	//		bytes[0-2] : magic
 	//		bytes[3] : version number
-	//		bytes[4-11] : _sigMapVec.size()
+	//		bytes[4-11] : number of entries
 	//		bytes[12-19] : _dimsVec.size()
-	//		bytes[20-] : _dimsVec[i]
+	//		bytes[20-59] : _dimsVec[i]
+	//		bytes[60] : encoding (version 3 and later)
+	//		bytes[61] : Rice parameter of GAPS encoding (version 3 and later)
 	//
+	// Maps with the packed encoding are written as version 2 so that
+	// they may be read by older versions of this class
+	//
+	memset(encodedMap, 0, HEADER_SIZE);
 	encodedMap[0] = encodedMap[1] = encodedMap[2] = 'c';
-	encodedMap[3] = VDF_VERSION;
+	encodedMap[3] = encoding == PACKED ? PACKED_VERSION : VDF_VERSION;
+	encodedMap[60] = encoding;
+	encodedMap[61] = k;
 
 	vector <size_t> header_data;
-	header_data.push_back(_sigMapVec.size());
+	header_data.push_back(numentries);
 	header_data.push_back(_dimsVec.size());
 	for (int i=0; i<_dimsVec.size(); i++) header_data.push_back(_dimsVec[i]);
 
@@ -488,7 +537,7 @@ void SignificanceMap::GetMap(unsigned char *encodedMap) {
 	for (int i=0; i<header_data.size(); i++) {
 		size_t entry = header_data[i];
 
-		assert(((ucptr + 8) - encodedMap) <= HEADER_SIZE);
+		assert(((ucptr + 8) - encodedMap) <= 60);
 
 		if (do_swapbytes) {
 			swapbytes(&entry, 1);
@@ -505,34 +554,46 @@ void SignificanceMap::GetMap(unsigned char *encodedMap) {
 	}
 
 	unsigned char *ptr = encodedMap + HEADER_SIZE;
-	int bib = BITSPERBYTE; // bits available in current byte
-	int p = BITSPERBYTE-1;
 
-	if (! _sorted) SignificanceMap::Sort();
+	if (encoding == BITMAP) {
+		memset(ptr, 0, (_sigMapSize - 1) / BITSPERBYTE + 1);
+		for (size_t i = 0; i<_sigMapVec.size(); i++) {
+			size_t idx = _sigMapVec[i];
+			ptr[idx / BITSPERBYTE] |= 0x80 >> (idx % BITSPERBYTE);
+		}
+		return;
+	}
 
-	for (size_t i = 0; i<_sigMapVec.size(); i++) {
-		size_t idx = _sigMapVec[i];
-		int tbits = _bits_per_idx;
-		while (tbits) {
-			int n = min(tbits, bib);
-			PUTBITS(*ptr, p, n, idx>>(tbits-n));
-			p -= n;
-			tbits -= n;
-			bib -= n;
-			if (bib == 0) {
-				ptr++;
-				bib = BITSPERBYTE;
-				p = BITSPERBYTE-1;
-			}
+	bit_writer bw(ptr);
+	if (encoding == GAPS) {
+
+		// Each gap, g, is written as g >> k in unary (zeros terminated
+		// by a one) followed by the k low order bits of g
+		//
+		size_t idxprev = 0;
+		for (size_t i = 0; i<_sigMapVec.size(); i++) {
+			size_t gap = _sigMapVec[i] - idxprev;
+			idxprev = _sigMapVec[i];
+
+			bw.zeros(gap >> k);
+			bw.put((1ULL << k) | gap, k+1);
+		}
+	}
+	else {
+		for (size_t i = 0; i<_sigMapVec.size(); i++) {
+			bw.put_wide(_sigMapVec[i], _bits_per_idx);
 		}
 	}
+	bw.flush();
 }
 
-void SignificanceMap::GetMap(const unsigned char **map, size_t *maplen) {
+void SignificanceMap::GetMap(
+	const unsigned char **map, size_t *maplen, bool packed
+) {
 	*map = NULL;
 	*maplen = 0;
 
-	size_t mapsize = GetMapSize();
+	size_t mapsize = GetMapSize(GetNumSignificant(), packed);
 
 	if (_sigMapEncodeSize < mapsize) {
         size_t l = mapsize;	// hack to allow word-size reads
@@ -548,7 +609,7 @@ void SignificanceMap::GetMap(const unsigned char **map, size_t *maplen) {
 	*map = _sigMapEncode;
 	*maplen = mapsize;
 
-	return(GetMap(_sigMapEncode));
+	return(GetMap(_sigMapEncode, packed));
 }
 			
 
@@ -620,29 +681,105 @@ int SignificanceMap::SetMap(const unsigned char *map) {
 		if (_SignificanceMap(dims) < 0) return(-1);
 	}
 
+	int encoding = PACKED;
+	int k = 0;
+	if (version > PACKED_VERSION) {
+		encoding = map[60];
+		k = map[61];
+		if (encoding > BITMAP || k > MaxRiceK) {
+			SetErrMsg("Invalid significance map - bogus header");
+			return(-1);
+		}
+	}
+
 	_sigMapVec.clear();
 	_sigMapVec.reserve(numentries);
 
 	const unsigned char *ptr = map + header_size;
-	int bib = BITSPERBYTE; // bits remaining in current byte
 
-	_sorted = true;
-	size_t idxprev = 0;
-	for (size_t i = 0; i<numentries; i++) {
+	if (encoding == BITMAP) {
+		const bit_decode_tables &tables = get_bit_decode_tables();
+
+		if (numentries > _sigMapSize) {
+			SetErrMsg("Invalid significance map - corrupt entries");
+			return(-1);
+		}
+		_sigMapVec.resize(numentries);
+		size_t *out = _sigMapVec.data();
+		size_t count = 0;
+
+		size_t nbytes = (_sigMapSize - 1) / BITSPERBYTE + 1;
+		for (size_t i = 0; i<nbytes; i++) {
+			unsigned int b = ptr[i];
+			if (! b) continue;
+
+			int nset = tables.nset[b];
+			if (count + nset > numentries) break;
+
+			size_t idx0 = i * BITSPERBYTE;
+			for (int j = 0; j<nset; j++) {
+				out[count++] = idx0 + tables.pos[b][j];
+			}
+		}
+		if (count != numentries ||
+			(numentries && _sigMapVec.back() >= _sigMapSize)) {
+
+			_sigMapVec.clear();
+			SetErrMsg("Invalid significance map - corrupt entries");
+			return(-1);
+		}
+		_sorted = true;
+		return(0);
+	}
+
+	if (encoding == GAPS) {
+		const bit_decode_tables &tables = get_bit_decode_tables();
+
+		size_t nbits = numentries * (k+1) + ((_sigMapSize-1) >> k);
+		bit_reader br(ptr, ptr + (nbits + BITSPERBYTE - 1) / BITSPERBYTE);
+
+		_sigMapVec.resize(numentries);
+		size_t *out = _sigMapVec.data();
+
 		size_t idx = 0;
-		int tbits = _bits_per_idx;
-		int p = _bits_per_idx - 1;
-		while (tbits) {
-			int n = min(tbits, bib);
-			PUTBITS(idx, p, n, *ptr >> (bib-n));
-			p -= n;
-			tbits -= n;
-			bib -= n;
-			if (bib == 0) {
-				ptr++;
-				bib = BITSPERBYTE;
+		for (size_t i = 0; i<numentries; i++) {
+
+			// Count the zeros of the unary coded quotient a byte at a time
+			//
+			size_t q = 0;
+			unsigned int b;
+			while (! (b = br.peek8())) {
+				br.skip(BITSPERBYTE);
+				q += BITSPERBYTE;
+				if (q >= _sigMapSize) {
+					_sigMapVec.clear();
+					SetErrMsg("Invalid significance map - corrupt entries");
+					return(-1);
+				}
 			}
+			q += tables.lz[b];
+			br.skip(tables.lz[b] + 1);
+
+			idx += k ? (q << k) | br.get(k) : q;
+			if (idx >= _sigMapSize) {
+				_sigMapVec.clear();
+				SetErrMsg("Invalid significance map - corrupt entries");
+				return(-1);
+			}
+			out[i] = idx;
 		}
+		_sorted = true;
+		return(0);
+	}
+
+	size_t nbits = numentries * _bits_per_idx;
+	bit_reader br(ptr, ptr + (nbits + BITSPERBYTE - 1) / BITSPERBYTE);
+
+	_sorted = true;
+	size_t idxprev = 0;
+	for (size_t i = 0; i<numentries; i++) {
+		size_t idx = br.get_wide(_bits_per_idx);
+
 		//
 		// Should probably call SignificanceMap::Set() here so
 		// that we check for duplicate values. But this is quicker.
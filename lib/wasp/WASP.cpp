@@ -233,6 +233,8 @@ public:
  unsigned char *_maps;	// private (not shared)
  int _level;
  bool _unblock_flag; // unblock the data after reconstruction?
+ bool _packed_sigmaps; // encode significance maps with packed encoding only?
+ int _qbits;	// bits per quantized coefficient, or 0 if not quantized
  static int _status;	// error indicator
 
  thread_state(
@@ -245,7 +247,7 @@ public:
 	const vector <Compressor *> &compressors,  
 	void *data, int data_type, unsigned char *mask, void *block, 
 	void *coeffs, int block_type, int xtype, unsigned char *maps, int level, 
-	bool unblock_flag
+	bool unblock_flag, bool packed_sigmaps, int qbits
  ) : _id(id), _et(et), _nthreads(nthreads), _varname(varname), 
 	_ncdfcptrs(ncdfcptrs), 
 	_start(start), _count(count), _bs(bs), _udims(udims),
@@ -253,12 +255,36 @@ public:
 	_compressors(compressors), _data(data), _data_type(data_type), 
 	_mask(mask), _block(block), _coeffs(coeffs), _block_type(block_type),
 	_xtype(xtype), _maps(maps), _level(level),
-	_unblock_flag(unblock_flag)
+	_unblock_flag(unblock_flag), _packed_sigmaps(packed_sigmaps),
+	_qbits(qbits)
  {_status = 0;}
 
 };
 int thread_state::_status = 0;
 
+// Number of words of external type 'xtype' needed to store 'n' 
+// coefficients quantized by 'cmp' to an average of 'qbits' bits
+//
+size_t quantized_words(const Compressor *cmp, size_t n, int qbits, int xtype) {
+	size_t ws = NetCDFCpp::SizeOf(xtype);
+	return((cmp->GetQuantizedSize(n, qbits) + ws - 1) / ws);
+}
+
+// Number of coefficients of each set that are stored with the 
+// external type of the variable. If the coefficients are quantized
+// only the approximation coefficients, at the start of the first set,
+// are. The others are stored as raw bytes, ahead of the set's 
+// significance map
+//
+vector <size_t> typed_ncoeffs(
+	const Compressor *cmp, const vector <size_t> &ncoeffs, int qbits
+) {
+	if (! qbits) return(ncoeffs);
+
+	vector <size_t> typed(ncoeffs.size(), 0);
+	if (! typed.empty()) typed[0] = cmp->GetNumUnquantized();
+	return(typed);
+}
 
 
 // Convert voxel coordinates, 'vcoords', to block coordinates, 'bcoords', 
@@ -736,6 +762,10 @@ void UnBlock(
 // ncoeffs : vector describing partitioning of coefficients in 'coeffs'
 // encoded_dims : vector describing dimension of encoded block at
 // each compression level.
+// packed_sigmaps : if true, maps are encoded with the packed encoding
+// readable by older versions of WASP
+// qbits : if non-zero, coefficients are quantized to 'qbits' bits and
+// stored in 'maps' ahead of each set's map
 //
 template <class T>
 int DecomposeBlock(
@@ -746,8 +776,9 @@ int DecomposeBlock(
 	unsigned char *maps,
 	int xtype,
 	vector <size_t> ncoeffs,
-	vector <size_t> encoded_dims
-	
+	vector <size_t> encoded_dims,
+	bool packed_sigmaps,
+	int qbits
 ) {
 
 	vector <SignificanceMap> sigmaps(ncoeffs.size());
@@ -758,15 +789,32 @@ int DecomposeBlock(
 	//
 	// Extract signficance maps from 'sigmaps' and copy them to 'maps'
 	//
+	vector <size_t> typed = typed_ncoeffs(cmp, ncoeffs, qbits);
 	unsigned char *mapptr = maps;
 	for (int i=0; i<ncoeffs.size(); i++) {
 		size_t dimlen = i==0 ? encoded_dims[i]-BLK_HDR_SZ : encoded_dims[i]; 
+		dimlen -= typed[i];
 
-		if (dimlen != ncoeffs[i]) {	// last map not stored
-			size_t sz = NetCDFCpp::SizeOf(xtype) * (dimlen-ncoeffs[i]);
+		if (qbits) {
+			size_t nwords = quantized_words(
+				cmp, ncoeffs[i] - typed[i], qbits, xtype
+			);
+			size_t sz = NetCDFCpp::SizeOf(xtype) * nwords;
 
 			memset(mapptr, 0, sz);
-			sigmaps[i].GetMap(mapptr);
+			rc = cmp->Quantize(coeffs, sigmaps[i], qbits, mapptr);
+			if (rc<0) return(-1);
+
+			coeffs += ncoeffs[i];
+			mapptr += sz;
+			dimlen -= nwords;
+		}
+
+		if (dimlen) {	// last map not stored
+			size_t sz = NetCDFCpp::SizeOf(xtype) * dimlen;
+
+			memset(mapptr, 0, sz);
+			sigmaps[i].GetMap(mapptr, packed_sigmaps);
 			mapptr += sz;
 		}
 	}
@@ -785,11 +833,14 @@ int DecomposeBlock(
 // block : block of data
 // n : num elements in 'block'
 // level : reconstruction level in wavelet hierarchy
+// qbits : if non-zero, coefficients other than the approximation
+// coefficients are quantized to an average of 'qbits' bits and stored
+// in 'maps' ahead of each set's map. They are restored to 'coeffs'
 //
 template <class T>
 int ReconstructBlock(
 	Compressor *cmp,
-	const T *coeffs,
+	T *coeffs,
 	const T *datarange,
 	const unsigned char *maps,
 	int xtype,
@@ -797,7 +848,8 @@ int ReconstructBlock(
 	vector <size_t> encoded_dims,
 	T *block,
 	size_t n,
-	int level 
+	int level,
+	int qbits
 ) {
 
 	// Clamp reconstructed values to original data range
@@ -812,17 +864,29 @@ int ReconstructBlock(
 	// 
 	// Extract encoded significance maps
 	//
+	vector <size_t> typed = typed_ncoeffs(cmp, ncoeffs, qbits);
+	vector <const unsigned char *> qptrs(ncoeffs.size(), NULL);
 	const unsigned char *mapptr = maps;
 	bool reconstruct_map = false;
 	for (int i=0; i<ncoeffs.size(); i++) {
 
 		size_t dimlen = i==0 ? encoded_dims[i]-BLK_HDR_SZ : encoded_dims[i]; 
+		dimlen -= typed[i];
+
+		if (qbits) {
+			size_t nwords = quantized_words(
+				cmp, ncoeffs[i] - typed[i], qbits, xtype
+			);
+			qptrs[i] = mapptr;
+			mapptr += NetCDFCpp::SizeOf(xtype) * nwords;
+			dimlen -= nwords;
+		}
 
-		if (dimlen != ncoeffs[i]) {	// last map not stored
+		if (dimlen) {	// last map not stored
 			int rc = sigmaps[i].SetMap(mapptr);
 			if (rc<0) return(-1);
 
-			size_t sz = NetCDFCpp::SizeOf(xtype) * (dimlen - ncoeffs[i]);
+			size_t sz = NetCDFCpp::SizeOf(xtype) * dimlen;
 			mapptr += sz;
 		}
 		else {
@@ -839,7 +903,7 @@ int ReconstructBlock(
 
 		// Edge case for when sigmap isn't stored at all
 		//
-		if (ncoeffs.size() == 1 && encoded_dims[0]-BLK_HDR_SZ == ncoeffs[0]) {
+		if (ncoeffs.size() == 1) {
 			sigmaps[0].Reshape(ncoeffs[0]);
 			for (int i=0; i<ncoeffs[0]; i++) {
 				sigmaps[0].Set(i);
@@ -855,6 +919,16 @@ int ReconstructBlock(
 		}
 	}
 
+	// Quantized coefficients are coded by subband, so they're restored
+	// once every set's map is known
+	//
+	T *coeffptr = coeffs;
+	for (int i=0; i<ncoeffs.size() && qbits; i++) {
+		int rc = cmp->Dequantize(qptrs[i], sigmaps[i], qbits, coeffptr);
+		if (rc<0) return(-1);
+		coeffptr += ncoeffs[i];
+	}
+
 	int rc = cmp->Reconstruct(coeffs, block, sigmaps, level);
 	if (rc<0) return(-1);
 
@@ -896,7 +970,8 @@ int StoreBlock(
 // varname : name of variable
 // ncdfcptrs : NetCDFCpp file points, one for each compression level
 // bcoords : coordinates of block in voxel coords relative to start of variable
-// ncoeffs : vector describing partitioning of coefficients in 'coeffs'
+// ncoeffs : vector describing partitioning of coefficients in 'coeffs'.
+// All zero if the coefficients are quantized and stored with the maps
 // encoded_dims : vector describing dimension of encoded block at
 // each compression level.
 // coeffs : transformed coefficients for each compression level
@@ -941,10 +1016,14 @@ int StoreBlockCompressed(
 		start[start.size()-1] = i==0 ? BLK_HDR_SZ : 0;	// skip header
 		count[start.size()-1] = ncoeffs[i];
 
-		int rc = ncdfcptrs[i]->NetCDFCpp::PutVara(
-			varname, start, count, coeffs
-		);
-		if (rc<0) return(rc);
+		// No typed coefficients if they're quantized
+		//
+		if (ncoeffs[i]) {
+			int rc = ncdfcptrs[i]->NetCDFCpp::PutVara(
+				varname, start, count, coeffs
+			);
+			if (rc<0) return(rc);
+		}
 
 		coeffs += ncoeffs[i];
 
@@ -1022,7 +1101,8 @@ int FetchBlock(
 // varname : name of variable
 // ncdfcptrs : NetCDFCpp file points, one for each compression level
 // bcoords : coordinates of block
-// ncoeffs : vector describing partitioning of coefficients in 'coeffs'
+// ncoeffs : vector describing partitioning of coefficients in 'coeffs'.
+// All zero if the coefficients are quantized and stored with the maps
 // encoded_dims : vector describing dimension of encoded block at
 // each compression level.
 // coeffs : transformed coefficients for each compression level
@@ -1064,10 +1144,14 @@ int FetchBlockCompressed(
 		start[start.size()-1] = i==0 ? BLK_HDR_SZ : 0;	// skip header
 		count[start.size()-1] = ncoeffs[i];
 
-		int rc = ncdfcptrs[i]->NetCDFCpp::GetVara(
-			varname, start, count, coeffs
-		);
-		if (rc<0) return(rc);
+		// No typed coefficients if they're quantized
+		//
+		if (ncoeffs[i]) {
+			int rc = ncdfcptrs[i]->NetCDFCpp::GetVara(
+				varname, start, count, coeffs
+			);
+			if (rc<0) return(rc);
+		}
 
 		coeffs += ncoeffs[i];
 
@@ -1236,7 +1320,8 @@ void *RunWriteThreadCompressedTemplate(thread_state &s, T dummy1, U dummy2) {
 		//
 		int rc = DecomposeBlock(
 			s._compressors[s._id], (const U *) s._block, vproduct(s._bs),
-			(U *) s._coeffs, s._maps, s._xtype, s._ncoeffs, s._encoded_dims
+			(U *) s._coeffs, s._maps, s._xtype, s._ncoeffs, s._encoded_dims,
+			s._packed_sigmaps, s._qbits
 		);
 		if (rc<0) {
 			s._status = -1;
@@ -1256,7 +1341,9 @@ void *RunWriteThreadCompressedTemplate(thread_state &s, T dummy1, U dummy2) {
 		//
 		s._et->MutexLock();
 			rc = StoreBlockCompressed(
-				s._varname, s._ncdfcptrs, bcoords, s._ncoeffs, s._encoded_dims,
+				s._varname, s._ncdfcptrs, bcoords, 
+				typed_ncoeffs(s._compressors[s._id], s._ncoeffs, s._qbits), 
+				s._encoded_dims,
 				(U *) s._coeffs, datarange, s._maps, s._xtype
 			);
 			if (rc<0) {
@@ -1485,8 +1572,10 @@ void *RunReadThreadCompressedTemplate(thread_state &s, T dummy1, U dummy2) {
 		U datarange[2];
 		s._et->MutexLock();
 			int rc = FetchBlockCompressed(
-				s._varname, s._ncdfcptrs, bcoords, s._ncoeffs, 
-				s._encoded_dims, (U *) s._coeffs, datarange, s._maps, s._xtype
+				s._varname, s._ncdfcptrs, bcoords, 
+				typed_ncoeffs(s._compressors[s._id], s._ncoeffs, s._qbits), 
+				s._encoded_dims,
+				(U *) s._coeffs, datarange, s._maps, s._xtype
 			);
 			if (rc<0) s._status = -1;
 		s._et->MutexUnlock();
@@ -1504,7 +1593,7 @@ void *RunReadThreadCompressedTemplate(thread_state &s, T dummy1, U dummy2) {
 		rc = ReconstructBlock(
 			s._compressors[s._id], (U *) s._coeffs, datarange, s._maps, 
 			s._xtype, s._ncoeffs, s._encoded_dims, blockptr, 
-			vproduct(s._bs), s._level
+			vproduct(s._bs), s._level, s._qbits
 		);
 		if (rc<0) {
 			s._status = -1;
@@ -1612,8 +1701,10 @@ WASP::WASP(int nthreads) {
 
 	_waspFile = false;
 	_nthreads = 1;
-	_currentVersion = 3;
+	_currentVersion = 4;	// 4: entropy coded significance maps
 	_fileVersion = 0;
+	_quantization = 0;
+	_fastTransform = false;
 
 	_open = false;
 	_open_wname.clear();
@@ -1625,6 +1716,8 @@ WASP::WASP(int nthreads) {
 	_open_level = 0;
 	_open_write = false;
 	_open_varname.clear();
+	_open_varxtype = 0;
+	_open_qbits = 0;
 
 	_et = NULL;
 
@@ -1917,9 +2010,16 @@ int WASP::DefVar(
 	vector <string> cdimnames;
 	vector <size_t> cdims;
 
+	// Only floating point coefficients are quantized
+	//
+	int qbits = 0;
+	if (! wname.empty() && (xtype == NC_FLOAT || xtype == NC_DOUBLE)) {
+		qbits = _quantization;
+	}
+
 	int rc;
 	rc = _GetCompressedDims(
-		dimnames, wname, bs, cratios, xtype, cdimnames, cdims,
+		dimnames, wname, bs, cratios, xtype, qbits, cdimnames, cdims,
 		encoded_dim_names, encoded_dims
 	);
 	if (rc<0) return(rc);
@@ -1983,6 +2083,11 @@ int WASP::DefVar(
 	rc = PutAtt(name, AttNameWavelet(), wname);
 	if (rc<0) return(rc);
 
+	if (qbits) {
+		rc = PutAtt(name, AttNameQuantization(), qbits);
+		if (rc<0) return(rc);
+	}
+
 	rc = PutAtt(name, AttNameBlockSize(), bs);
 	if (rc<0) return(rc);
 
@@ -2073,6 +2178,41 @@ int WASP::InqVarCompressionParams(
 	return(0);
 }
 
+int WASP::SetQuantization(int nbits) {
+	if (nbits != 0 && (nbits < 2 || nbits > 32)) {
+		SetErrMsg("Invalid quantization : %d", nbits);
+		return(-1);
+	}
+	_quantization = nbits;
+	return(0);
+}
+
+int WASP::InqVarQuantization(string name, int &nbits) const {
+	nbits = 0;
+
+	if (! _waspFile) {
+		SetErrMsg("Not a WASP file");
+		return(-1);
+	}
+
+	// disable error reporting otherwise an error is generated 
+	// if the attribute doesn't exist
+	//
+	bool enabled = MyBase::EnableErrMsg(false);
+
+	int xtype;
+	size_t len;
+	int rc = NetCDFCpp::InqAtt(name, AttNameQuantization(), xtype, len);
+
+	(void) MyBase::EnableErrMsg(enabled);
+
+	// Not quantized if the attribute doesn't exist
+	//
+	if (rc<0 || len != 1) return(0);
+
+	return(GetAtt(name, AttNameQuantization(), nbits));
+}
+
 int WASP::InqVarDimlens(
 	string name, int level, 
 	vector <size_t> &dims_at_level, vector <size_t> &bs_at_level
@@ -2329,6 +2469,7 @@ int WASP::OpenVarWrite(string name, int lod) {
 	_open_write = false;
 	_open_varname.clear();
 	_open_varxtype = 0;
+	_open_qbits = 0;
 	_open = false;
 
 	nc_type xtype;
@@ -2338,6 +2479,10 @@ int WASP::OpenVarWrite(string name, int lod) {
 	rc = _get_compression_params(name, bs, cratios, udims, dims, wname);
 	if (rc<0) return(rc);
 
+	int qbits;
+	rc = InqVarQuantization(name, qbits);
+	if (rc<0) return(rc);
+
 	if (lod < 0)  lod = cratios.size() - 1;
 
     if (lod >= cratios.size()) {
@@ -2350,6 +2495,7 @@ int WASP::OpenVarWrite(string name, int lod) {
 	if (! wname.empty()) {
 		for (int i=0; i<_nthreads; i++) {
 			_open_compressors[i] = new Compressor(compressor_bs(bs), wname);
+			_open_compressors[i]->FastTransformOnOff() = _fastTransform;
 		}
 	}
 
@@ -2364,6 +2510,7 @@ int WASP::OpenVarWrite(string name, int lod) {
 	_open_write = true;
 	_open_varname = name;
 	_open_varxtype = xtype;
+	_open_qbits = qbits;
 	_open = true;
 
 	return(NC_NOERR);
@@ -2412,6 +2559,7 @@ int WASP::OpenVarRead(string name, int level, int lod) {
 	_open_write = false;
 	_open_varname.clear();
 	_open_varxtype = 0;
+	_open_qbits = 0;
 	_open = false;
 
 	nc_type xtype;
@@ -2421,6 +2569,10 @@ int WASP::OpenVarRead(string name, int level, int lod) {
 	rc = _get_compression_params(name, bs, cratios, udims, dims, wname);
 	if (rc<0) return(rc);
 
+	int qbits;
+	rc = InqVarQuantization(name, qbits);
+	if (rc<0) return(rc);
+
 	// For multi-file storage higher-numbered files may be missing
 	// and the max LOD is determined by the number files actually present.
 	// In general cratios.size() == _ncdfcptrs.size()
@@ -2438,6 +2590,7 @@ int WASP::OpenVarRead(string name, int level, int lod) {
 	if (! wname.empty()) {	// May simply be blocked, not compressed
 		for (int i=0; i<_nthreads; i++) {
 			_open_compressors[i] = new Compressor(compressor_bs(bs), wname);
+			_open_compressors[i]->FastTransformOnOff() = _fastTransform;
 		}
 		assert(_nthreads >= 1);
 		numlevels = _open_compressors[0]->GetNumLevels();
@@ -2467,6 +2620,7 @@ int WASP::OpenVarRead(string name, int level, int lod) {
 	_open_write = false;
 	_open_varname = name;
 	_open_varxtype = xtype;
+	_open_qbits = qbits;
 	_open = true;
 
 	return(NC_NOERR);
@@ -2583,7 +2737,7 @@ int WASP::_PutVara(
 	vector <size_t> ncoeffs;
 	vector <size_t> encoded_dims;
 	_get_encoding_vectors(
-		_open_wname, _open_bs, _open_cratios, _open_varxtype, 
+		_open_wname, _open_bs, _open_cratios, _open_varxtype, _open_qbits,
 		ncoeffs, encoded_dims
 	);
 
@@ -2609,7 +2763,8 @@ int WASP::_PutVara(
 		coeffs_size = vsum(ncoeffs);
 		coeffs = (U *) _coeffbuf.Alloc(coeffs_size * _nthreads * sizeof(U));
 
-		maps_size = vsum(encoded_dims) - vsum(ncoeffs);  
+		maps_size = vsum(encoded_dims) - 
+			vsum(typed_ncoeffs(_open_compressors[0], ncoeffs, _open_qbits));
 		maps_size -= BLK_HDR_SZ; 
 		maps = (unsigned char*) _sigbuf.Alloc(
 			maps_size * _nthreads * NetCDFCpp::SizeOf(_open_varxtype)
@@ -2634,7 +2789,8 @@ int WASP::_PutVara(
 			(void *) data, data_type, (unsigned char *) mask,
 			block + i*block_size, coeffs + i*coeffs_size, 
 			block_type, _open_varxtype,
-			maps + i*maps_size*NetCDFCpp::SizeOf(_open_varxtype), 0, true
+			maps + i*maps_size*NetCDFCpp::SizeOf(_open_varxtype), 0, true,
+			_packed_sigmaps(), _open_qbits
 		));
 	}
 
@@ -2881,7 +3037,7 @@ int WASP::_GetVara(
 	vector <size_t> ncoeffs;
 	vector <size_t> encoded_dims;
 	_get_encoding_vectors(
-		_open_wname, _open_bs, _open_cratios, _open_varxtype, 
+		_open_wname, _open_bs, _open_cratios, _open_varxtype, _open_qbits,
 		ncoeffs, encoded_dims
 	);
 
@@ -2924,7 +3080,8 @@ int WASP::_GetVara(
 		coeffs_size = vsum(ncoeffs);
 		coeffs = (U *) _coeffbuf.Alloc(coeffs_size * _nthreads * sizeof(U));
 
-		maps_size = vsum(encoded_dims) - vsum(ncoeffs);  
+		maps_size = vsum(encoded_dims) - 
+			vsum(typed_ncoeffs(_open_compressors[0], ncoeffs, _open_qbits));
 		maps_size -= BLK_HDR_SZ;
 		maps = (unsigned char*) _sigbuf.Alloc(
 			maps_size * _nthreads * NetCDFCpp::SizeOf(_open_varxtype)
@@ -2951,7 +3108,7 @@ int WASP::_GetVara(
 			encoded_dims, _open_compressors, data, data_type, NULL,
 			blkptr, coeffs + i*coeffs_size, block_type, _open_varxtype,
 			maps + i*maps_size*NetCDFCpp::SizeOf(_open_varxtype), 
-			_open_level, unblock_flag
+			_open_level, unblock_flag, _packed_sigmaps(), _open_qbits
 		));
 	}
 
@@ -3355,6 +3512,7 @@ int WASP::_GetCompressedDims(
 	vector <size_t> bs,
 	vector <size_t> cratios,
 	int xtype,
+	int qbits,
 	vector <string> &cdimnames, 
 	vector <size_t> &cdims,
 	vector <string> &encoded_dim_names, 
@@ -3407,7 +3565,9 @@ int WASP::_GetCompressedDims(
 	// coefficients. There is one coefficient dimension for each LOD
 	//
 	vector <size_t> ncoeffs;
-	_get_encoding_vectors(wname, bs, cratios, xtype, ncoeffs, encoded_dims);
+	_get_encoding_vectors(
+		wname, bs, cratios, xtype, qbits, ncoeffs, encoded_dims
+	);
 
 	string encoded_dim_base;
 	for (int i=0; i<cdimnames.size(); i++) {
@@ -3425,6 +3585,10 @@ int WASP::_GetCompressedDims(
 		for (int i=0; i<encoded_dims.size(); i++) {
 			ostringstream oss;
 			oss << encoded_dim_base << i;
+
+			// Quantized encodings differ in length from unquantized ones
+			//
+			if (qbits) oss << "Q" << qbits;
 			encoded_dim_names.push_back(oss.str());
 		}
 //	}
@@ -3444,13 +3608,16 @@ int WASP::_GetCompressedDims(
 // bs : dimensions of compression block
 // cratio : vector of compression ratios
 // xtype : NetCDF external storage type
+// qbits : bits per quantized coefficient, or 0 if not quantized
 // ncoeffs : number of wavelet coefficients for each compression level
 // encoded_dims : dimension of encoded block for each compression
-// level.  The dimension is ncoeffs + size of encoded sig map
+// level.  The dimension is ncoeffs (or the number of words needed for
+// the quantized coefficients and the unquantized approximation 
+// coefficients) + size of encoded sig map
 //
 void WASP::_get_encoding_vectors(
 	string wname, vector <size_t> bs, vector <size_t> cratios, int xtype,
-	vector <size_t> &ncoeffs, 
+	int qbits, vector <size_t> &ncoeffs, 
 	vector <size_t> &encoded_dims
 ) const {
 	ncoeffs.clear();
@@ -3493,24 +3660,29 @@ void WASP::_get_encoding_vectors(
 
 		ncoeffs.push_back(n);
 
+		size_t c = n;
+		if (qbits) {
+			size_t typed = i==0 ? compressor.GetNumUnquantized() : 0;
+			c = typed + quantized_words(&compressor, n - typed, qbits, xtype);
+		}
 
 		// Signifance map is encoded with the wavelet coefficients. 
 		// Size of sigmap returned by GetSigMapSize() is in bytes. Need to
 		// convert bytes to word size of POD
 		//
 		if (cratios[i] != 1) {
-			size_t s = compressor.GetSigMapSize(n);
+			size_t s = compressor.GetSigMapSize(n, _packed_sigmaps());
 
 			s = (s + SizeOf(xtype)-1) / SizeOf(xtype);
 
-			encoded_dims.push_back(header_size+n+s);
+			encoded_dims.push_back(header_size+c+s);
 		}
 		else {
 			assert (naccum == ntotal);
 
 			// Special case. Don't need to explicitly store sigmap
 			//
-			encoded_dims.push_back(header_size+n+0);
+			encoded_dims.push_back(header_size+c+0);
 		}
 	}
 }
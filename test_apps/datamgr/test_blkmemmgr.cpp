@@ -0,0 +1,377 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/BlkMemMgr.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Allocator benchmark for BlkMemMgr. Replays an allocation trace, either
+// recorded with BlkMemMgr::SetTraceFile() or generated by simulating a
+// cache that frees its oldest allocations when full. Reports the time
+// per operation, the number of allocations that failed even though
+// enough memory was free in total, and the final fragmentation of the
+// pool. Optionally compares against a first-fit scan of a list of runs,
+// which is how BlkMemMgr was originally implemented.
+//
+
+struct {
+	string	trace;
+	string	savetrace;
+	int	poolsize;
+	int	blksize;
+	int	nops;
+	int	maxblks;
+	int	seed;
+	OptionParser::Boolean_T	firstfit;
+	OptionParser::Boolean_T	report;
+	OptionParser::Boolean_T	help;
+} opt;
+
+OptionParser::OptDescRec_T	set_opts[] = {
+	{"trace",	1, 	"",	"Replay allocation trace recorded with "
+		"BlkMemMgr::SetTraceFile(). If not specified a trace is generated"},
+	{"savetrace",	1, 	"",	"Write the generated trace to this file"},
+	{"poolsize",	1, 	"0","Size of memory pool in blocks. 0 => peak "
+		"number of blocks in use by the trace"},
+	{"blksize",	1, 	"64","Size of a memory block in bytes"},
+	{"nops",	1, 	"1000000","Number of allocations in generated trace"},
+	{"maxblks",	1, 	"64","Maximum size in blocks of a generated "
+		"allocation"},
+	{"seed",	1, 	"0","Random number generator seed"},
+	{"firstfit",	0,	"",	"Also replay the trace with a first-fit "
+		"allocator for comparison"},
+	{"report",	0,	"",	"Print fragmentation report after replay"},
+	{"help",	0,	"",	"Print this message and exit"},
+	{NULL}
+};
+
+OptionParser::Option_T	get_options[] = {
+	{"trace", Wasp::CvtToCPPStr, &opt.trace, sizeof(opt.trace)},
+	{"savetrace", Wasp::CvtToCPPStr, &opt.savetrace, sizeof(opt.savetrace)},
+	{"poolsize", Wasp::CvtToInt, &opt.poolsize, sizeof(opt.poolsize)},
+	{"blksize", Wasp::CvtToInt, &opt.blksize, sizeof(opt.blksize)},
+	{"nops", Wasp::CvtToInt, &opt.nops, sizeof(opt.nops)},
+	{"maxblks", Wasp::CvtToInt, &opt.maxblks, sizeof(opt.maxblks)},
+	{"seed", Wasp::CvtToInt, &opt.seed, sizeof(opt.seed)},
+	{"firstfit", Wasp::CvtToBoolean, &opt.firstfit, sizeof(opt.firstfit)},
+	{"report", Wasp::CvtToBoolean, &opt.report, sizeof(opt.report)},
+	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+	{NULL}
+};
+
+const char	*ProgName;
+
+// A trace operation. Allocations are numbered, and frees refer to
+// allocations by number.
+//
+struct op_t {
+	bool alloc;
+	size_t id;
+	size_t nblks;
+};
+
+int read_trace(string path, vector <op_t> &ops) {
+	FILE *fp = fopen(path.c_str(), "r");
+	if (! fp) {
+		cerr << "Failed to open " << path << endl;
+		return(-1);
+	}
+
+	map <string, size_t> live;
+	size_t nallocs = 0;
+	char type;
+	char ptr[64];
+	while (fscanf(fp, " %c", &type) == 1) {
+		op_t op;
+		if (type == 'A') {
+			if (fscanf(fp, "%zu %63s", &op.nblks, ptr) != 2) break;
+
+			// Failed allocation
+			//
+			if (strcmp(ptr, "(nil)") == 0 || strcmp(ptr, "0") == 0 ||
+				strcmp(ptr, "0x0") == 0) continue;
+
+			op.alloc = true;
+			op.id = nallocs++;
+			live[ptr] = op.id;
+		}
+		else if (type == 'F') {
+			if (fscanf(fp, "%63s", ptr) != 1) break;
+
+			map <string, size_t>::iterator itr = live.find(ptr);
+			if (itr == live.end()) continue;
+
+			op.alloc = false;
+			op.id = itr->second;
+			op.nblks = 0;
+			live.erase(itr);
+		}
+		else break;
+
+		ops.push_back(op);
+	}
+	fclose(fp);
+	return(0);
+}
+
+// Simulate a cache of opt.poolsize blocks (or 1024 * opt.maxblks if not
+// specified) that frees its oldest allocations until a new one fits,
+// ignoring fragmentation
+//
+void gen_trace(vector <op_t> &ops) {
+	size_t poolsize = opt.poolsize ? opt.poolsize : 1024 * opt.maxblks;
+
+	deque <op_t> live;
+	size_t inuse = 0;
+	for (size_t i=0; i<opt.nops; i++) {
+		op_t op;
+		op.alloc = true;
+		op.id = i;
+		op.nblks = (rand() % opt.maxblks) + 1;
+		if (op.nblks > poolsize) op.nblks = poolsize;
+
+		while (inuse + op.nblks > poolsize) {
+			op_t f = live.front();
+			live.pop_front();
+			inuse -= f.nblks;
+			f.alloc = false;
+			ops.push_back(f);
+		}
+		live.push_back(op);
+		inuse += op.nblks;
+		ops.push_back(op);
+	}
+}
+
+size_t peak_usage(const vector <op_t> &ops) {
+	map <size_t, size_t> sizes;
+	size_t inuse = 0;
+	size_t peak = 0;
+	for (size_t i=0; i<ops.size(); i++) {
+		if (ops[i].alloc) {
+			sizes[ops[i].id] = ops[i].nblks;
+			inuse += ops[i].nblks;
+			if (inuse > peak) peak = inuse;
+		}
+		else {
+			inuse -= sizes[ops[i].id];
+			sizes.erase(ops[i].id);
+		}
+	}
+	return(peak);
+}
+
+// The original BlkMemMgr algorithm: a first-fit scan over a list of
+// runs of blocks, coalescing free neighbors after each free.
+//
+class FirstFit {
+public:
+	FirstFit(size_t nblks) {
+		run_t r = {nblks, 0, 0};
+		_runs.push_back(r);
+	}
+
+	bool Alloc(size_t n, size_t &offset) {
+		for (size_t i=0; i<_runs.size(); i++) {
+			if (n <= _runs[i].nfree) {
+				offset = _runs[i].offset;
+				if (n < _runs[i].nfree) {
+					run_t r = {_runs[i].nfree - n, 0, _runs[i].offset + n};
+					_runs.insert(_runs.begin()+i+1, r);
+				}
+				_runs[i].nused = n;
+				_runs[i].nfree = 0;
+				return(true);
+			}
+		}
+		return(false);
+	}
+
+	void FreeMem(size_t offset) {
+		for (size_t i=0; i<_runs.size(); i++) {
+			if (_runs[i].offset == offset && _runs[i].nused) {
+				_runs[i].nfree = _runs[i].nused;
+				_runs[i].nused = 0;
+				break;
+			}
+		}
+		bool collapse;
+		do {
+			collapse = false;
+			for (size_t i=0; i+1<_runs.size(); i++) {
+				if (_runs[i].nfree && _runs[i+1].nfree) {
+					_runs[i].nfree += _runs[i+1].nfree;
+					_runs.erase(_runs.begin() + i+1);
+					collapse = true;
+					break;
+				}
+			}
+		} while (collapse);
+	}
+
+	double Fragmentation() const {
+		size_t free = 0, largest = 0;
+		for (size_t i=0; i<_runs.size(); i++) {
+			free += _runs[i].nfree;
+			if (_runs[i].nfree > largest) largest = _runs[i].nfree;
+		}
+		return(free ? 1.0 - (double) largest / free : 0.0);
+	}
+
+private:
+	struct run_t {
+		size_t nfree;
+		size_t nused;
+		size_t offset;
+	};
+	vector <run_t> _runs;
+};
+
+void print_result(
+	string name, double t, size_t nops, size_t nfail, double frag
+) {
+	cout << setw(12) << name << setw(14) << fixed << setprecision(1)
+		<< t / nops * 1e9 << setw(12) << nfail << setw(16)
+		<< setprecision(4) << frag << endl;
+}
+
+void replay_blkmemmgr(const vector <op_t> &ops, size_t poolsize) {
+	BlkMemMgr::RequestMemSize(opt.blksize, poolsize);
+	BlkMemMgr *mgr = new BlkMemMgr();
+
+	// Grow the pool to its full size up front, as a single region
+	//
+	void *p = mgr->Alloc(poolsize);
+	if (p) mgr->FreeMem(p);
+
+	vector <void *> ptrs;
+	size_t nfail = 0;
+	double t0 = Wasp::GetTime();
+	for (size_t i=0; i<ops.size(); i++) {
+		const op_t &op = ops[i];
+		if (op.alloc) {
+			if (ptrs.size() <= op.id) ptrs.resize(op.id+1, NULL);
+			ptrs[op.id] = mgr->Alloc(op.nblks);
+			if (! ptrs[op.id]) nfail++;
+		}
+		else if (ptrs[op.id]) {
+			mgr->FreeMem(ptrs[op.id]);
+			ptrs[op.id] = NULL;
+		}
+	}
+	double t = Wasp::GetTime() - t0;
+
+	BlkMemMgr::Stats stats = BlkMemMgr::GetStats();
+	print_result("BlkMemMgr", t, ops.size(), nfail, stats.Fragmentation());
+
+	if (opt.report) BlkMemMgr::PrintFragmentationReport(stdout);
+
+	delete mgr;
+}
+
+void replay_firstfit(const vector <op_t> &ops, size_t poolsize) {
+	FirstFit ff(poolsize);
+
+	vector <size_t> offsets;
+	vector <bool> ok;
+	size_t nfail = 0;
+	double t0 = Wasp::GetTime();
+	for (size_t i=0; i<ops.size(); i++) {
+		const op_t &op = ops[i];
+		if (op.alloc) {
+			if (offsets.size() <= op.id) {
+				offsets.resize(op.id+1, 0);
+				ok.resize(op.id+1, false);
+			}
+			ok[op.id] = ff.Alloc(op.nblks, offsets[op.id]);
+			if (! ok[op.id]) nfail++;
+		}
+		else if (ok[op.id]) {
+			ff.FreeMem(offsets[op.id]);
+			ok[op.id] = false;
+		}
+	}
+	double t = Wasp::GetTime() - t0;
+
+	print_result("first-fit", t, ops.size(), nfail, ff.Fragmentation());
+}
+
+int main(int argc, char **argv) {
+
+	OptionParser op;
+
+	ProgName = Basename(argv[0]);
+
+	MyBase::SetErrMsgFilePtr(stderr);
+
+	if (op.AppendOptions(set_opts) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (op.ParseOptions(&argc, argv, get_options) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (opt.help) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(0);
+	}
+
+	if (opt.maxblks < 1) opt.maxblks = 1;
+	srand(opt.seed);
+
+	vector <op_t> ops;
+	if (! opt.trace.empty()) {
+		if (read_trace(opt.trace, ops) < 0) exit(1);
+	}
+	else {
+		gen_trace(ops);
+
+		if (! opt.savetrace.empty()) {
+			FILE *fp = fopen(opt.savetrace.c_str(), "w");
+			if (! fp) {
+				cerr << "Failed to open " << opt.savetrace << endl;
+				exit(1);
+			}
+			for (size_t i=0; i<ops.size(); i++) {
+				if (ops[i].alloc) {
+					fprintf(fp, "A %zu 0x%zx\n", ops[i].nblks, ops[i].id+1);
+				}
+				else {
+					fprintf(fp, "F 0x%zx\n", ops[i].id+1);
+				}
+			}
+			fclose(fp);
+		}
+	}
+	if (ops.empty()) {
+		cerr << "Empty trace" << endl;
+		exit(1);
+	}
+
+	size_t poolsize = opt.poolsize ? opt.poolsize : peak_usage(ops);
+
+	cout << "Operations : " << ops.size() << ", pool size : " << poolsize
+		<< " blocks" << endl;
+	cout << setw(12) << "allocator" << setw(14) << "ns/op"
+		<< setw(12) << "failures" << setw(16) << "fragmentation" << endl;
+
+	replay_blkmemmgr(ops, poolsize);
+	if (opt.firstfit) replay_firstfit(ops, poolsize);
+
+	return(0);
+}
@@ -0,0 +1,249 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/VDCNetCDF.h>
+#include <vapor/DataMgr.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Check that the cost aware eviction policies keep regions that are
+// expensive to produce in preference to cheaper regions of the same
+// size. The policies are first checked directly, with fixed costs.
+// Then a synthetic VDC holding a wavelet compressed and an uncompressed
+// variable of the same dimensions is read through a DataMgr, so that
+// the costs are the ones the DataMgr measures when reading.
+//
+
+struct {
+	int	dim;
+	int	memsize;
+	OptionParser::Boolean_T	help;
+	OptionParser::Boolean_T	debug;
+} opt;
+
+OptionParser::OptDescRec_T	set_opts[] = {
+	{"dim",		1, 	"128","Length of each dimension of the synthetic "
+		"variables"},
+	{"memsize",	1, 	"20","Cache size in MBs. Must hold two of the "
+		"synthetic variables, but not three"},
+	{"help",	0,	"",	"Print this message and exit"},
+	{"debug",	0,	"",	"Debug mode"},
+	{NULL}
+};
+
+OptionParser::Option_T	get_options[] = {
+	{"dim", Wasp::CvtToInt, &opt.dim, sizeof(opt.dim)},
+	{"memsize", Wasp::CvtToInt, &opt.memsize, sizeof(opt.memsize)},
+	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+	{"debug", Wasp::CvtToBoolean, &opt.debug, sizeof(opt.debug)},
+	{NULL}
+};
+
+const char	*ProgName;
+
+int nerrors = 0;
+
+void check(bool ok, string msg) {
+	cout << (ok ? "ok     " : "FAILED ") << msg << endl;
+	if (! ok) nerrors++;
+}
+
+// Two items of the same size. The expensive one is inserted first, so
+// it is also the least recently used. Return true if the cheap one is
+// chosen for eviction
+//
+bool evicts_cheap(string name) {
+	CachePolicy *policy = CachePolicy::Create(name);
+	if (! policy) return(false);
+
+	int expensive, cheap;
+	policy->Insert(&expensive, 1024*1024, 1e-2);
+	policy->Insert(&cheap, 1024*1024, 1e-3);
+
+	const void *victim = policy->Victim([](const void *) {return(true);});
+	delete policy;
+
+	return(victim == &cheap);
+}
+
+// Write a VDC with a wavelet compressed variable, "wavelet", and an
+// uncompressed variable, "raw", each with two time steps
+//
+string make_synthetic(string dir) {
+	string master = dir + "/synthetic.nc";
+	VDCNetCDF vdc;
+	int rc = vdc.Initialize(master, vector <string> (), VDC::W, {64,64,64});
+	if (rc<0) return("");
+
+	vector <string> dimnames = {"Nx", "Ny", "Nz", "Nt"};
+	size_t n = opt.dim;
+	vector <size_t> dimlens = {n, n, n, 2};
+
+	rc = vdc.SetCompressionBlock("", vector <size_t> (1,1));
+	if (rc<0) return("");
+
+	for (int i=0; i<dimnames.size(); i++) {
+		rc = vdc.DefineDimension(dimnames[i], dimlens[i], i);
+		if (rc<0) return("");
+	}
+
+	rc = vdc.DefineDataVar("raw", dimnames, dimnames, "", DC::FLOAT, false);
+	if (rc<0) return("");
+
+	rc = vdc.SetCompressionBlock("bior4.4", vector <size_t> (1,1));
+	if (rc<0) return("");
+
+	rc = vdc.DefineDataVar(
+		"wavelet", dimnames, dimnames, "", DC::FLOAT, true
+	);
+	if (rc<0) return("");
+
+	rc = vdc.EndDefine();
+	if (rc<0) return("");
+
+	vector <float> data(n*n*n);
+	for (size_t i=0; i<data.size(); i++) {
+		data[i] = sin((double) i * 0.001);
+	}
+
+	for (size_t ts=0; ts<2; ts++) {
+		rc = vdc.PutVar(ts, "raw", -1, data.data());
+		if (rc<0) return("");
+
+		rc = vdc.PutVar(ts, "wavelet", -1, data.data());
+		if (rc<0) return("");
+	}
+
+	return(master);
+}
+
+bool read_var(DataMgr &datamgr, size_t ts, string varname) {
+	Grid *g = datamgr.GetVariable(ts, varname, -1, -1, false);
+	if (! g) return(false);
+
+	delete g;
+	return(true);
+}
+
+// Sum the statistics of all levels and lods of a variable
+//
+DataMgr::VarStats var_stats(const DataMgr &datamgr, string varname) {
+	DataMgr::CacheStats stats = datamgr.GetCacheStats();
+
+	DataMgr::VarStats sum;
+	sum.varname = varname;
+	for (int i=0; i<stats.vars.size(); i++) {
+		if (stats.vars[i].varname != varname) continue;
+
+		sum.hits += stats.vars[i].hits;
+		sum.misses += stats.vars[i].misses;
+		sum.bytes_read += stats.vars[i].bytes_read;
+		sum.read_time += stats.vars[i].read_time;
+	}
+	return(sum);
+}
+
+// Read both variables at the first time step, then the uncompressed
+// variable at the second, which forces evictions. Return the number
+// of misses when the compressed variable is read again
+//
+int wavelet_rereads(DataMgr &datamgr, string policy) {
+	datamgr.Clear();
+	if (datamgr.SetCachePolicy(policy) < 0) return(-1);
+	datamgr.ResetCacheStats();
+
+	if (! read_var(datamgr, 0, "wavelet")) return(-1);
+	if (! read_var(datamgr, 0, "raw")) return(-1);
+
+	DataMgr::VarStats wavelet = var_stats(datamgr, "wavelet");
+	DataMgr::VarStats raw = var_stats(datamgr, "raw");
+
+	check(
+		wavelet.read_time > 0.0 && raw.read_time > 0.0,
+		policy + " : miss costs measured"
+	);
+	if (opt.debug) {
+		cout << "  read time : wavelet " << wavelet.read_time
+			<< ", raw " << raw.read_time << endl;
+	}
+
+	if (! read_var(datamgr, 1, "raw")) return(-1);
+	check(
+		datamgr.GetCacheStats().evictions > 0, policy + " : regions evicted"
+	);
+
+	datamgr.ResetCacheStats();
+	if (! read_var(datamgr, 0, "wavelet")) return(-1);
+
+	return(var_stats(datamgr, "wavelet").misses);
+}
+
+int main(int argc, char **argv) {
+
+	OptionParser op;
+
+	ProgName = Basename(argv[0]);
+
+	MyBase::SetErrMsgFilePtr(stderr);
+
+	if (op.AppendOptions(set_opts) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (op.ParseOptions(&argc, argv, get_options) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (opt.help) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(0);
+	}
+
+	if (opt.debug) {
+		MyBase::SetDiagMsgFilePtr(stderr);
+	}
+
+	check(! evicts_cheap("lru"), "lru : evicts least recently used");
+	check(evicts_cheap("gd"), "gd : evicts cheaper of equal sizes");
+	check(evicts_cheap("gdsf"), "gdsf : evicts cheaper of equal sizes");
+
+	char tmpl[] = "/tmp/test_cache_policy.XXXXXX";
+	if (! mkdtemp(tmpl)) {
+		MyBase::SetErrMsg("mkdtemp(%s) : %M", tmpl);
+		exit(1);
+	}
+	string tmpdir = tmpl;
+
+	string master = make_synthetic(tmpdir);
+	if (master.empty()) exit(1);
+
+	DataMgr	datamgr("vdc", opt.memsize, 0);
+	int rc = datamgr.Initialize(vector <string> (1, master), vector <string> ());
+	if (rc<0) exit(1);
+
+	int misses = wavelet_rereads(datamgr, "lru");
+	check(misses > 0, "lru : compressed variable evicted");
+
+	misses = wavelet_rereads(datamgr, "gd");
+	check(misses == 0, "gd : compressed variable kept");
+
+	misses = wavelet_rereads(datamgr, "gdsf");
+	check(misses == 0, "gdsf : compressed variable kept");
+
+	string cmd = "rm -rf " + tmpdir;
+	(void) system(cmd.c_str());
+
+	exit(nerrors ? 1 : 0);
+}
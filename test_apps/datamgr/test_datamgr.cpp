@@ -22,9 +22,16 @@ struct {
 	int	level;
 	int	lod;
 	int	nthreads;
+	int	compressed_cache_size;
+	string compressed_cache_mode;
+	double compressed_cache_tolerance;
+	string cache_storage_mode;
+	double cache_storage_tolerance;
 	string varname;
 	string savefilebase;
 	string ftype;
+	string cache_policy;
+	string mem_backing;
 	std::vector <double> minu;
 	std::vector <double> maxu;
 	OptionParser::Boolean_T	nogeoxform;
@@ -46,6 +53,21 @@ OptionParser::OptDescRec_T	set_opts[] = {
 	{"varname",	1, 	"",	"Name of variable"},
 	{"savefilebase",	1, 	"",	"Base path name to output file"},
 	{"ftype",	1,	"vdc",	"data set type (vdc|wrf|cf|mpas)"},
+	{"cache_policy",	1,	"lru",	"Cache eviction policy (lru|gds|gd|gdsf-nocost|gdsf)"},
+	{"mem_backing",	1,	"heap",	"Cache memory backing store "
+		"(heap|hugepages|file)"},
+	{"compressed_cache_size",	1,	"0",	"Size in MBs of compressed "
+		"second tier cache. 0 => disabled"},
+	{"compressed_cache_mode",	1,	"lossless",	"Encoding of compressed "
+		"second tier cache (lossless|half|quant16|quant8)"},
+	{"compressed_cache_tolerance",	1,	"0.005",	"Bound on error, "
+		"relative to each chunk's value range, of the reduced precision "
+		"second tier cache modes"},
+	{"cache_storage_mode",	1,	"lossless",	"Encoding of blocks stored "
+		"in the cache (lossless|half|quant16|quant8)"},
+	{"cache_storage_tolerance",	1,	"0.005",	"Bound on error, "
+		"relative to each chunk's value range, of the reduced precision "
+		"cache storage modes"},
 	{
 		"minu",  1,  "",  "Colon delimited 3-element vector "
 		"specifying domain min extents in user coordinates (X0:Y0:Z0)"
@@ -74,6 +96,13 @@ OptionParser::Option_T	get_options[] = {
 	{"varname", Wasp::CvtToCPPStr, &opt.varname, sizeof(opt.varname)},
 	{"savefilebase", Wasp::CvtToCPPStr, &opt.savefilebase, sizeof(opt.savefilebase)},
 	{"ftype", Wasp::CvtToCPPStr, &opt.ftype, sizeof(opt.ftype)},
+	{"cache_policy", Wasp::CvtToCPPStr, &opt.cache_policy, sizeof(opt.cache_policy)},
+	{"mem_backing", Wasp::CvtToCPPStr, &opt.mem_backing, sizeof(opt.mem_backing)},
+	{"compressed_cache_size", Wasp::CvtToInt, &opt.compressed_cache_size, sizeof(opt.compressed_cache_size)},
+	{"compressed_cache_mode", Wasp::CvtToCPPStr, &opt.compressed_cache_mode, sizeof(opt.compressed_cache_mode)},
+	{"compressed_cache_tolerance", Wasp::CvtToDouble, &opt.compressed_cache_tolerance, sizeof(opt.compressed_cache_tolerance)},
+	{"cache_storage_mode", Wasp::CvtToCPPStr, &opt.cache_storage_mode, sizeof(opt.cache_storage_mode)},
+	{"cache_storage_tolerance", Wasp::CvtToDouble, &opt.cache_storage_tolerance, sizeof(opt.cache_storage_tolerance)},
 	{"minu", Wasp::CvtToDoubleVec, &opt.minu, sizeof(opt.minu)},
 	{"maxu", Wasp::CvtToDoubleVec, &opt.maxu, sizeof(opt.maxu)},
 	{"verbose", Wasp::CvtToBoolean, &opt.verbose, sizeof(opt.verbose)},
@@ -208,6 +237,23 @@ int main(int argc, char **argv) {
 	if (! opt.nogeoxform) {
 		options.push_back("-project_to_pcs");
 	}
+	options.push_back("-cache_policy");
+	options.push_back(opt.cache_policy);
+	options.push_back("-mem_backing");
+	options.push_back(opt.mem_backing);
+	if (opt.compressed_cache_size > 0) {
+		options.push_back("-compressed_cache_size");
+		options.push_back(std::to_string(opt.compressed_cache_size));
+		options.push_back("-compressed_cache_mode");
+		options.push_back(opt.compressed_cache_mode);
+		options.push_back("-compressed_cache_tolerance");
+		options.push_back(std::to_string(opt.compressed_cache_tolerance));
+	}
+	options.push_back("-cache_storage_mode");
+	options.push_back(opt.cache_storage_mode);
+	options.push_back("-cache_storage_tolerance");
+	options.push_back(std::to_string(opt.cache_storage_tolerance));
+
 	DataMgr	datamgr(opt.ftype, opt.memsize, opt.nthreads);
 	int rc = datamgr.Initialize(files, options);
 	if (rc<0) exit(1);
@@ -338,6 +384,34 @@ int main(int argc, char **argv) {
 	if (! opt.quiet) {
 
 		fprintf(stdout, "total process time : %f\n", timer);
+
+		DataMgr::CacheStats stats = datamgr.GetCacheStats();
+		fprintf(
+			stdout, "cache policy : %s, hit ratio : %f, "
+			"bytes read : %zu, bytes re-read : %zu, evictions : %zu, "
+			"compressed hits : %zu\n",
+			datamgr.GetCachePolicy().c_str(), stats.HitRatio(),
+			stats.bytes_read, stats.bytes_reread, stats.evictions,
+			stats.compressed_hits
+		);
+		if (stats.compressed_bytes) {
+			fprintf(
+				stdout, "compressed cache : %zu bytes holding %zu bytes, "
+				"ratio : %f, max relative error : %g\n",
+				stats.compressed_bytes, stats.compressed_raw_bytes,
+				(double) stats.compressed_raw_bytes / stats.compressed_bytes,
+				stats.compressed_max_error
+			);
+		}
+		if (stats.reduced_bytes) {
+			fprintf(
+				stdout, "reduced precision blocks : %zu bytes holding %zu "
+				"bytes, ratio : %f, max relative error : %g\n",
+				stats.reduced_bytes, stats.reduced_raw_bytes,
+				(double) stats.reduced_raw_bytes / stats.reduced_bytes,
+				stats.reduced_max_error
+			);
+		}
 	}
 
 	exit(0);
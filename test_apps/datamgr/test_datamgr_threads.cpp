@@ -0,0 +1,494 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/VDCNetCDF.h>
+#include <vapor/DataMgr.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Stress test and scaling benchmark for concurrent DataMgr access. A
+// single DataMgr is shared by 1 to N threads, each of which fetches a
+// mix of variables and time steps. The sum of each grid's values is
+// compared against a reference computed by a single thread. With
+// -misses every request is made exactly once, by one of the threads,
+// so that all requests miss the cache. Some requests are made in 
+// user coordinates, for the middle half of the domain, to check that 
+// grids locked through that interface stay valid while other requests 
+// evict their neighbours. If no
+// metafiles are given a small synthetic VDC is written to a temporary
+// directory and used instead.
+//
+
+struct {
+	int	nts;
+	int	ts0;
+	int	memsize;
+	int	level;
+	int	lod;
+	int	nthreads;
+	int	maxthreads;
+	int	nrequests;
+	int	seed;
+	std::vector <int> dims;
+	std::vector <string> varnames;
+	string ftype;
+	OptionParser::Boolean_T	nogeoxform;
+	OptionParser::Boolean_T	norange;
+	OptionParser::Boolean_T	misses;
+	OptionParser::Boolean_T	help;
+	OptionParser::Boolean_T	debug;
+} opt;
+
+OptionParser::OptDescRec_T	set_opts[] = {
+	{"nts",		1, 	"4","Number of timesteps to process"},
+	{"ts0",		1, 	"0","First time step to process"},
+	{"memsize",	1, 	"16","Cache size in MBs. Make this smaller than "
+		"the data to exercise cache eviction"},
+	{"level",1, "0","Multiresution refinement level. Zero implies coarsest resolution"},
+	{"lod",1, "0","Level of detail. Zero implies coarsest resolution"},
+	{"nthreads",    1,  "0",    "Number of execution threads used by "
+		"the DataMgr. 0 => use number of cores"},
+	{"maxthreads",	1, 	"8","Maximum number of client threads"},
+	{"nrequests",	1, 	"64","Number of requests made by each client thread"},
+	{"seed",	1, 	"0","Random number generator seed"},
+	{"dims",	1, 	"96:80:64","Grid dimensions of the synthetic data set "
+		"used when no metafiles are given"},
+	{"varnames",	1, 	"",	"Colon delimited list of variable names"},
+	{"ftype",	1,	"vdc",	"data set type (vdc|wrf|cf|mpas)"},
+	{"nogeoxform",	0,	"",	"Do not apply geographic transform (projection to PCS"},
+	{"norange",	0,	"",	"Don't interleave GetDataRange() calls"},
+	{"misses",	0,	"",	"Make each request once, so that every request "
+		"misses the cache. -nrequests is ignored"},
+	{"help",	0,	"",	"Print this message and exit"},
+	{"debug",	0,	"",	"Debug mode"},
+	{NULL}
+};
+
+OptionParser::Option_T	get_options[] = {
+	{"nts", Wasp::CvtToInt, &opt.nts, sizeof(opt.nts)},
+	{"ts0", Wasp::CvtToInt, &opt.ts0, sizeof(opt.ts0)},
+	{"memsize", Wasp::CvtToInt, &opt.memsize, sizeof(opt.memsize)},
+	{"level", Wasp::CvtToInt, &opt.level, sizeof(opt.level)},
+	{"lod", Wasp::CvtToInt, &opt.lod, sizeof(opt.lod)},
+	{"nthreads", Wasp::CvtToInt, &opt.nthreads, sizeof(opt.nthreads)},
+	{"maxthreads", Wasp::CvtToInt, &opt.maxthreads, sizeof(opt.maxthreads)},
+	{"nrequests", Wasp::CvtToInt, &opt.nrequests, sizeof(opt.nrequests)},
+	{"seed", Wasp::CvtToInt, &opt.seed, sizeof(opt.seed)},
+	{"dims", Wasp::CvtToIntVec, &opt.dims, sizeof(opt.dims)},
+	{"varnames", Wasp::CvtToStrVec, &opt.varnames, sizeof(opt.varnames)},
+	{"ftype", Wasp::CvtToCPPStr, &opt.ftype, sizeof(opt.ftype)},
+	{"nogeoxform", Wasp::CvtToBoolean, &opt.nogeoxform, sizeof(opt.nogeoxform)},
+	{"norange", Wasp::CvtToBoolean, &opt.norange, sizeof(opt.norange)},
+	{"misses", Wasp::CvtToBoolean, &opt.misses, sizeof(opt.misses)},
+	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+	{"debug", Wasp::CvtToBoolean, &opt.debug, sizeof(opt.debug)},
+	{NULL}
+};
+
+const char	*ProgName;
+
+// A single (time step, variable) request, and the expected sum of
+// the grid's values. roi_sum is the expected sum over the region of
+// interest, given in user coordinates by min and max.
+//
+struct request_t {
+	size_t ts;
+	string varname;
+	double sum;
+	vector <double> min;
+	vector <double> max;
+	double roi_sum;
+};
+
+double grid_sum(const Grid *g) {
+	double sum = 0.0;
+	float mv = g->GetMissingValue();
+	bool has_missing = g->HasMissingData();
+
+	Grid::ConstIterator itr;
+	Grid::ConstIterator enditr = g->cend();
+	for (itr = g->cbegin(); itr!=enditr; ++itr) {
+		float v = *itr;
+		if (has_missing && v == mv) continue;
+		sum += v;
+	}
+	return(sum);
+}
+
+bool same_sum(double a, double b) {
+	double d = fabs(a-b);
+	return(d == 0.0 || d <= 1e-6 * fmax(fabs(a), fabs(b)));
+}
+
+// Fetch a request locked, either whole or only its region of interest,
+// and return the grid's sum. Returns false on failure.
+//
+bool fetch(DataMgr *datamgr, const request_t &r, bool roi, double &sum) {
+	Grid *g;
+	if (roi) {
+		g = datamgr->GetVariable(
+			r.ts, r.varname, opt.level, opt.lod, r.min, r.max, true
+		);
+	}
+	else {
+		g = datamgr->GetVariable(
+			r.ts, r.varname, opt.level, opt.lod, true
+		);
+	}
+	if (! g) return(false);
+
+	sum = grid_sum(g);
+
+	datamgr->UnlockGrid(g);
+	delete g;
+	return(true);
+}
+
+bool check(const request_t &r, bool roi, double sum) {
+	double expected = roi ? r.roi_sum : r.sum;
+	if (same_sum(sum, expected)) return(true);
+
+	cerr << "Mismatch for " << r.varname << (roi ? " region" : "") 
+		<< " at time step " << r.ts << " : " << sum << " != " 
+		<< expected << endl;
+	return(false);
+}
+
+// Lock the region of interest of one request through the user 
+// coordinate interface, then fetch every other request, so that unlocked
+// regions are evicted, and check the locked grid is unchanged
+//
+int check_locked_roi(DataMgr *datamgr, const vector <request_t> &requests) {
+	const request_t &r = requests[0];
+
+	Grid *g = datamgr->GetVariable(
+		r.ts, r.varname, opt.level, opt.lod, r.min, r.max, true
+	);
+	if (! g) return(1);
+
+	int nerrors = 0;
+	if (! check(r, true, grid_sum(g))) nerrors++;
+
+	for (int i=1; i<requests.size(); i++) {
+		double sum;
+		if (! fetch(datamgr, requests[i], false, sum)) nerrors++;
+	}
+
+	if (! check(r, true, grid_sum(g))) nerrors++;
+
+	datamgr->UnlockGrid(g);
+	delete g;
+
+	return(nerrors);
+}
+
+// Body of each client thread. Fetch opt.nrequests randomly selected
+// requests, and check the results.
+//
+void client(
+	DataMgr *datamgr, const vector <request_t> *requests,
+	unsigned int seed, std::atomic <int> *nerrors
+) {
+
+	for (int i=0; i<opt.nrequests; i++) {
+		seed = seed * 1103515245 + 12345;
+		const request_t &r = (*requests)[(seed >> 8) % requests->size()];
+		bool roi = (seed & 0x30) == 0;
+
+		double sum;
+		if (! fetch(datamgr, r, roi, sum)) {
+			(*nerrors)++;
+			continue;
+		}
+
+		if (! check(r, roi, sum)) (*nerrors)++;
+
+		if (! opt.norange && (seed & 0x3) == 0) {
+			vector <double> range;
+			int rc = datamgr->GetDataRange(
+				r.ts, r.varname, opt.level, opt.lod, range
+			);
+			if (rc<0) (*nerrors)++;
+		}
+	}
+}
+
+// Write a VDC with three uncompressed 3D variables and opt.nts time 
+// steps to a new directory under dir. Returns the path of the VDC
+// master file, or the empty string on failure
+//
+string make_synthetic(string dir) {
+	if (opt.dims.size() != 3) {
+		cerr << "Invalid dims option" << endl;
+		return("");
+	}
+
+	string master = dir + "/synthetic.nc";
+	VDCNetCDF vdc;
+	int rc = vdc.Initialize(master, vector <string> (), VDC::W, {16,16,16});
+	if (rc<0) return("");
+
+	vector <string> dimnames = {"Nx", "Ny", "Nz", "Nt"};
+	vector <size_t> dimlens = {
+		(size_t) opt.dims[0], (size_t) opt.dims[1], (size_t) opt.dims[2], 
+		(size_t) (opt.ts0 + opt.nts)
+	};
+
+	rc = vdc.SetCompressionBlock("", vector <size_t> (1,1));
+	if (rc<0) return("");
+
+	for (int i=0; i<dimnames.size(); i++) {
+		rc = vdc.DefineDimension(dimnames[i], dimlens[i], i);
+		if (rc<0) return("");
+	}
+
+	// Time coordinates in seconds, so the DataMgr does not look for a 
+	// derived time coordinate variable
+	//
+	rc = vdc.DefineCoordVar(
+		dimnames[3], vector <string> (), dimnames[3], "seconds", 3, 
+		DC::FLOAT, false
+	);
+	if (rc<0) return("");
+
+	vector <string> varnames = {"u", "v", "w"};
+	for (int i=0; i<varnames.size(); i++) {
+		rc = vdc.DefineDataVar(
+			varnames[i], dimnames, dimnames, "", DC::FLOAT, false
+		);
+		if (rc<0) return("");
+	}
+
+	rc = vdc.EndDefine();
+	if (rc<0) return("");
+
+	for (int i=0; i<3; i++) {
+		vector <float> coords(dimlens[i]);
+		for (size_t j=0; j<dimlens[i]; j++) coords[j] = (float) j;
+
+		rc = vdc.PutVar(0, dimnames[i], -1, coords.data());
+		if (rc<0) return("");
+	}
+
+	for (size_t ts = 0; ts<dimlens[3]; ts++) {
+		float t = (float) ts;
+		rc = vdc.PutVar(ts, dimnames[3], -1, &t);
+		if (rc<0) return("");
+	}
+
+	size_t n = dimlens[0] * dimlens[1] * dimlens[2];
+	vector <float> data(n);
+	for (size_t ts = 0; ts<dimlens[3]; ts++) {
+		for (int v=0; v<varnames.size(); v++) {
+			for (size_t i=0; i<n; i++) {
+				data[i] = (float) ((i * (v+1) + ts * 7) % 1021);
+			}
+			rc = vdc.PutVar(ts, varnames[v], -1, data.data());
+			if (rc<0) return("");
+		}
+	}
+
+	if (opt.varnames.empty()) opt.varnames = varnames;
+	return(master);
+}
+
+// Body of each client thread with -misses. Fetch requests first, 
+// first + stride, ..., and check the results.
+//
+void client_misses(
+	DataMgr *datamgr, const vector <request_t> *requests,
+	size_t first, size_t stride, std::atomic <int> *nerrors
+) {
+	for (size_t i=first; i<requests->size(); i+=stride) {
+		const request_t &r = (*requests)[i];
+
+		double sum;
+		if (! fetch(datamgr, r, false, sum)) {
+			(*nerrors)++;
+			continue;
+		}
+
+		if (! check(r, false, sum)) (*nerrors)++;
+	}
+}
+
+int main(int argc, char **argv) {
+
+	OptionParser op;
+
+	ProgName = Basename(argv[0]);
+
+	MyBase::SetErrMsgFilePtr(stderr);
+
+	if (op.AppendOptions(set_opts) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (op.ParseOptions(&argc, argv, get_options) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (opt.help) {
+		cerr << "Usage: " << ProgName << " [options] metafiles " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(0);
+	}
+
+	if (opt.debug) {
+		MyBase::SetDiagMsgFilePtr(stderr);
+	}
+
+	if (argc >= 2 && opt.varnames.empty()) {
+		cerr << "Usage: " << ProgName << " -varnames v1:v2 [options] [metafiles]"
+			<< endl;
+		op.PrintOptionHelp(stderr);
+		exit(1);
+	}
+
+	vector <string> files;
+	for (int i=1; i<argc; i++) {
+		files.push_back(argv[i]);
+	}
+
+	string tmpdir;
+	if (files.empty()) {
+		char tmpl[] = "/tmp/test_datamgr_threads.XXXXXX";
+		if (! mkdtemp(tmpl)) {
+			MyBase::SetErrMsg("mkdtemp(%s) : %M", tmpl);
+			exit(1);
+		}
+		tmpdir = tmpl;
+		opt.ftype = "vdc";
+
+		string master = make_synthetic(tmpdir);
+		if (master.empty()) exit(1);
+		files.push_back(master);
+	}
+
+	vector <string> options;
+	if (! opt.nogeoxform) {
+		options.push_back("-project_to_pcs");
+	}
+
+	DataMgr	datamgr(opt.ftype, opt.memsize, opt.nthreads);
+	int rc = datamgr.Initialize(files, options);
+	if (rc<0) exit(1);
+
+	// Compute reference results with a single thread
+	//
+	vector <request_t> requests;
+	for (int v=0; v<opt.varnames.size(); v++) {
+		string varname = opt.varnames[v];
+		int nts = datamgr.GetNumTimeSteps(varname);
+		if (nts < 0) {
+			cerr << "Invalid variable " << varname << endl;
+			exit(1);
+		}
+
+		for (int ts = opt.ts0; ts<opt.ts0+opt.nts && ts < nts; ts++) {
+			request_t r;
+			r.ts = ts;
+			r.varname = varname;
+
+			// Region of interest is the middle half of the domain
+			//
+			rc = datamgr.GetVariableExtents(
+				ts, varname, opt.level, r.min, r.max
+			);
+			if (rc<0) exit(1);
+
+			for (int i=0; i<r.min.size(); i++) {
+				double d = r.max[i] - r.min[i];
+				r.min[i] += 0.25 * d;
+				r.max[i] -= 0.25 * d;
+			}
+
+			if (! fetch(&datamgr, r, false, r.sum)) exit(1);
+			if (! fetch(&datamgr, r, true, r.roi_sum)) exit(1);
+
+			requests.push_back(r);
+		}
+	}
+	if (requests.empty()) {
+		cerr << "Nothing to do" << endl;
+		exit(1);
+	}
+
+	int nerrors_total = check_locked_roi(&datamgr, requests);
+	if (nerrors_total) {
+		cerr << nerrors_total << " errors with a locked region of interest"
+			<< endl;
+	}
+
+	cout << setw(10) << "threads" << setw(12) << "seconds"
+		<< setw(14) << "requests/s" << setw(10) << "speedup" << endl;
+
+	double t1 = 0.0;
+	for (int nthreads = 1; nthreads <= opt.maxthreads; nthreads *= 2) {
+
+		// Start each run with an empty cache
+		//
+		datamgr.Clear();
+
+		std::atomic <int> nerrors(0);
+
+		double t0 = Wasp::GetTime();
+
+		vector <std::thread> threads;
+		for (int i=0; i<nthreads; i++) {
+			if (opt.misses) {
+				threads.push_back(std::thread(
+					client_misses, &datamgr, &requests, i, nthreads, &nerrors
+				));
+			}
+			else {
+				threads.push_back(std::thread(
+					client, &datamgr, &requests, opt.seed + i, &nerrors
+				));
+			}
+		}
+		for (int i=0; i<nthreads; i++) {
+			threads[i].join();
+		}
+
+		double t = Wasp::GetTime() - t0;
+		if (nthreads == 1) t1 = t;
+
+		// With -misses the total work is fixed, otherwise each thread
+		// makes opt.nrequests requests
+		//
+		size_t n = opt.misses ? 
+			requests.size() : (size_t) nthreads * opt.nrequests;
+		double speedup = opt.misses ? t1 / t : (t1 / t) * nthreads;
+		cout << setw(10) << nthreads << setw(12) << fixed
+			<< setprecision(3) << t << setw(14) << setprecision(1)
+			<< (double) n / t << setw(10) << setprecision(2)
+			<< speedup << endl;
+
+		if (nerrors) {
+			cerr << nerrors << " errors with " << nthreads << " threads"
+				<< endl;
+		}
+		nerrors_total += nerrors;
+	}
+
+	if (! tmpdir.empty()) {
+		string cmd = "rm -rf " + tmpdir;
+		(void) system(cmd.c_str());
+	}
+
+	exit(nerrors_total ? 1 : 0);
+}
@@ -0,0 +1,215 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <list>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/DataMgr.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Micro-benchmark for the DataMgr region cache. Measures the latency of
+// a cache hit as a function of the number of regions held in the cache.
+// Optionally compares against a linear scan of a list of regions, which
+// is how the DataMgr cache was originally implemented.
+//
+
+struct {
+	std::vector <size_t> sizes;
+	int	nlookups;
+	int	nvars;
+	int	seed;
+	OptionParser::Boolean_T	linear;
+	OptionParser::Boolean_T	help;
+} opt;
+
+OptionParser::OptDescRec_T	set_opts[] = {
+	{
+		"sizes",	1,	"10:100:1000:10000:100000",	"Colon delimited "
+		"list of cache sizes (number of cached regions) to test"
+	},
+	{"nlookups",1, "1000000","Number of cache lookups per cache size"},
+	{"nvars",	1, "16","Number of distinct variable names"},
+	{"seed",	1, "0","Random number generator seed"},
+	{"linear",	0,	"",	"Also time a linear list scan for comparison"},
+	{"help",	0,	"",	"Print this message and exit"},
+	{NULL}
+};
+
+OptionParser::Option_T	get_options[] = {
+	{"sizes", Wasp::CvtToSize_tVec, &opt.sizes, sizeof(opt.sizes)},
+	{"nlookups", Wasp::CvtToInt, &opt.nlookups, sizeof(opt.nlookups)},
+	{"nvars", Wasp::CvtToInt, &opt.nvars, sizeof(opt.nvars)},
+	{"seed", Wasp::CvtToInt, &opt.seed, sizeof(opt.seed)},
+	{"linear", Wasp::CvtToBoolean, &opt.linear, sizeof(opt.linear)},
+	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+	{NULL}
+};
+
+const char	*ProgName;
+
+typedef DataMgr::RegionCache::region_t region_t;
+
+// Generate n distinct regions spread over opt.nvars variables, time steps,
+// and 3D block extents
+//
+vector <region_t> make_regions(size_t n) {
+	vector <string> varnames;
+	for (int i=0; i<opt.nvars; i++) {
+		ostringstream oss;
+		oss << "variable_" << i;
+		varnames.push_back(oss.str());
+	}
+
+	vector <region_t> regions;
+	for (size_t i=0; i<n; i++) {
+		region_t r;
+		size_t v = i % opt.nvars;
+		size_t blk = i / opt.nvars;
+
+		r.ts = blk / 64;
+		r.varname = varnames[v];
+		r.level = -1;
+		r.lod = -1;
+		r.bmin = {blk % 4, (blk / 4) % 4, (blk / 16) % 4};
+		r.bmax = {r.bmin[0] + 1, r.bmin[1] + 1, r.bmin[2] + 1};
+		r.lock_counter = 0;
+		r.blks = (void *) (i+1);	// never dereferenced
+		r.epoch = 0;
+		r.size = 0;
+		r.cost = 0.0;
+		r.stats = NULL;
+		regions.push_back(r);
+	}
+	return(regions);
+}
+
+double time_hashed(const vector <region_t> &regions, const vector <size_t> &q) {
+	DataMgr::RegionCache cache;
+	for (size_t i=0; i<regions.size(); i++) {
+		cache.Insert(regions[i]);
+	}
+
+	size_t misses = 0;
+	double t0 = Wasp::GetTime();
+	for (size_t i=0; i<q.size(); i++) {
+		const region_t &r = regions[q[i]];
+		region_t *found = cache.Find(
+			r.ts, r.varname, r.level, r.lod, r.bmin, r.bmax
+		);
+		if (! found) misses++;
+	}
+	double t = Wasp::GetTime() - t0;
+
+	if (misses) cerr << "Unexpected cache misses : " << misses << endl;
+	return(t);
+}
+
+// The original DataMgr lookup: linear scan, then move to the back of the
+// list by erasing and re-inserting a copy
+//
+double time_linear(const vector <region_t> &regions, const vector <size_t> &q) {
+	list <region_t> cache(regions.begin(), regions.end());
+
+	size_t misses = 0;
+	double t0 = Wasp::GetTime();
+	for (size_t i=0; i<q.size(); i++) {
+		const region_t &r = regions[q[i]];
+		bool found = false;
+
+		list <region_t>::iterator itr;
+		for (itr = cache.begin(); itr!=cache.end(); ++itr) {
+			region_t &region = *itr;
+			if (region.ts == r.ts &&
+				region.varname.compare(r.varname) == 0 &&
+				region.level == r.level &&
+				region.lod == r.lod &&
+				region.bmin == r.bmin &&
+				region.bmax == r.bmax) {
+
+				region_t tmp_region = region;
+				cache.erase(itr);
+				cache.push_back(tmp_region);
+				found = true;
+				break;
+			}
+		}
+		if (! found) misses++;
+	}
+	double t = Wasp::GetTime() - t0;
+
+	if (misses) cerr << "Unexpected cache misses : " << misses << endl;
+	return(t);
+}
+
+int main(int argc, char **argv) {
+
+	OptionParser op;
+
+	ProgName = Basename(argv[0]);
+
+	MyBase::SetErrMsgFilePtr(stderr);
+
+	if (op.AppendOptions(set_opts) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (op.ParseOptions(&argc, argv, get_options) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (opt.help) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(0);
+	}
+
+	if (opt.nvars < 1) opt.nvars = 1;
+	srand(opt.seed);
+
+	cout << setw(12) << "regions" << setw(16) << "hashed (ns)";
+	if (opt.linear) cout << setw(16) << "linear (ns)";
+	cout << endl;
+
+	for (int i=0; i<opt.sizes.size(); i++) {
+		size_t n = opt.sizes[i];
+		if (n < 1) continue;
+
+		vector <region_t> regions = make_regions(n);
+
+		vector <size_t> q;
+		for (int j=0; j<opt.nlookups; j++) {
+			q.push_back(rand() % n);
+		}
+
+		double t = time_hashed(regions, q);
+		cout << setw(12) << n << setw(16) << fixed << setprecision(1)
+			<< t / q.size() * 1e9;
+
+		if (opt.linear) {
+
+			// Linear scan is O(n) so limit number of lookups
+			//
+			size_t nq = q.size();
+			if (nq * n > 1e9) nq = 1e9 / n;
+			if (nq < 1) nq = 1;
+			vector <size_t> lq(q.begin(), q.begin() + nq);
+
+			t = time_linear(regions, lq);
+			cout << setw(16) << t / lq.size() * 1e9;
+		}
+		cout << endl;
+	}
+
+	return(0);
+}
@@ -4,18 +4,40 @@
 #include <vector>
 #include <sstream>
 #include <cstdio>
+#include <cstdlib>
 #include <cassert>
+#include <cmath>
+#include <new>
 
 #include <vapor/CFuncs.h>
 #include <vapor/OptionParser.h>
 #include <vapor/RegularGrid.h>
 #include <vapor/LayeredGrid.h>
+#include <vapor/StretchedGrid.h>
 #include <vapor/CurvilinearGrid.h>
 #include <vapor/KDTreeRG.h>
+#include <vapor/CellLocatorRG.h>
+#include <vapor/GridStats.h>
+#include <vapor/EasyThreads.h>
 
 using namespace Wasp;
 using namespace VAPoR;
 
+// Count heap allocations so that benchmarks can report them
+//
+size_t NumAllocs = 0;
+
+void *operator new(size_t size) {
+	NumAllocs++;
+	void *ptr = malloc(size ? size : 1);
+	if (! ptr) throw std::bad_alloc();
+	return(ptr);
+}
+
+void operator delete(void *ptr) noexcept {
+	free(ptr);
+}
+
 
 struct {
 	std::vector <size_t> bs;
@@ -26,6 +48,8 @@ struct {
 	std::vector <size_t> dims;
 	std::vector <size_t> periodic;
 	string type;
+	int npoints;
+	double warp;
 	OptionParser::Boolean_T debug;
 	OptionParser::Boolean_T help;
 } opt;
@@ -44,12 +68,14 @@ OptionParser::OptDescRec_T	set_opts[] = {
 		"specifying maximum user coordinates"
 	},
 	{
-		"roimin",  1,  "0.0:0.0:0.0",  "Colon delimited 3-element vector "
-		"specifying min bbox coordinates for a region of interest"
+		"roimin",  1,  "",  "Colon delimited 3-element vector "
+		"specifying min bbox coordinates for a region of interest. "
+		"Default is the middle half of the grid along each axis"
 	},
 	{
-		"roimax",  1,  "1.0:1.0:1.0",  "Colon delimited 3-element vector "
-		"specifying max bbox coordinates for a region of interest"
+		"roimax",  1,  "",  "Colon delimited 3-element vector "
+		"specifying max bbox coordinates for a region of interest. "
+		"Default is the middle half of the grid along each axis"
 	},
 	{
 		"dims",  1,  "512:512:128",  "Colon delimited 3-element vector "
@@ -61,7 +87,17 @@ OptionParser::OptDescRec_T	set_opts[] = {
 	},
 	{
 		"type",  1,  "regular",  "Grid type. One of (regular, "
-		"layered, curvlinear"
+		"stretched, layered, curvlinear"
+	},
+	{
+		"npoints",  1,  "1000000",  "Number of random points at which "
+		"to reconstruct values in the interpolation benchmark"
+	},
+	{
+		"warp",  1,  "0.0",  "Shear the horizontal coordinates of a "
+		"curvilinear grid by this fraction of the X extent, varying "
+		"sinusoidally along Y. For a layered grid, raise the levels "
+		"over sinusoidal terrain of this fraction of the Z extent"
 	},
     {"debug",    0,  "", "Print diagnostics"},
     {"help",    0,  "", "Print this message and exit"},
@@ -78,6 +114,8 @@ OptionParser::Option_T	get_options[] = {
 	{"dims", Wasp::CvtToSize_tVec, &opt.dims, sizeof(opt.dims)},
 	{"periodic", Wasp::CvtToSize_tVec, &opt.periodic, sizeof(opt.periodic)},
 	{"type", Wasp::CvtToCPPStr, &opt.type, sizeof(opt.type)},
+	{"npoints", Wasp::CvtToInt, &opt.npoints, sizeof(opt.npoints)},
+	{"warp", Wasp::CvtToDouble, &opt.warp, sizeof(opt.warp)},
 	{"debug", Wasp::CvtToBoolean, &opt.debug, sizeof(opt.debug)},
 	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
 	{NULL}
@@ -146,6 +184,31 @@ VAPoR::RegularGrid *make_regular_grid() {
 	return(rg);
 }
 
+VAPoR::StretchedGrid *make_stretched_grid() {
+	assert(opt.bs.size() == opt.minu.size());
+	assert(opt.bs.size() == opt.maxu.size());
+	assert(opt.bs.size() == opt.dims.size());
+	assert(opt.bs.size() == opt.periodic.size());
+
+	// Node spacing increases quadratically along each axis
+	//
+	vector <double> coords[3];
+	for (int i=0; i<opt.dims.size(); i++) {
+		for (size_t l=0; l<opt.dims[i]; l++) {
+			double t = opt.dims[i] > 1 ? (double) l / (opt.dims[i]-1) : 0.0;
+			coords[i].push_back(opt.minu[i] + (opt.maxu[i]-opt.minu[i]) * t*t);
+		}
+	}
+
+	vector <float *> blks = alloc_blocks(opt.bs, opt.dims);
+
+	StretchedGrid *sg = new StretchedGrid(
+		opt.dims, opt.bs, blks, coords[0], coords[1], coords[2]
+	);
+
+	return(sg);
+}
+
 VAPoR::LayeredGrid *make_layered_grid() {
 	assert(opt.bs.size() == 3);
 	assert(opt.bs.size() == opt.minu.size());
@@ -164,6 +227,14 @@ VAPoR::LayeredGrid *make_layered_grid() {
 	for (size_t i=0; i<rg->GetDimensions()[0]; i++) {
 
 		double z = (opt.maxu[2]-opt.minu[2])/(opt.dims[2]-1) * k + opt.minu[2];
+
+		// Terrain following levels, flattening with height
+		//
+		double h = 0.25 * (2.0 + 
+			sin(2.0 * M_PI * i / (opt.dims[0]-1)) +
+			sin(2.0 * M_PI * j / (opt.dims[1]-1))
+		);
+		z += opt.warp * h * (opt.maxu[2] - z);
 		rg->SetValueIJK(i,j,k, (float) z);
 	}
 	}
@@ -207,12 +278,15 @@ VAPoR::CurvilinearGrid *make_curvilinear_grid() {
 
 		double x = (opt.maxu[0]-opt.minu[0]) / (dims2d[0]-1) * i + opt.minu[0];
 		double y = (opt.maxu[1]-opt.minu[1]) / (dims2d[1]-1) * j + opt.minu[1];
+		x += opt.warp * (opt.maxu[0]-opt.minu[0]) * 
+			sin(M_PI * j / (dims2d[1]-1));
 		xrg->SetValueIJK(i,j,0, x);
 		yrg->SetValueIJK(i,j,0, y);
 	}
 	}
 
 	KDTreeRG *kdtree = new KDTreeRG(*xrg, *yrg);
+	CellLocatorRG *locator = new CellLocatorRG(*xrg, *yrg);
 
 	vector <double> zcoords;
 	for (int k=0; k<opt.dims[2]; k++) {
@@ -225,7 +299,7 @@ VAPoR::CurvilinearGrid *make_curvilinear_grid() {
 	vector <double> minu2d = {opt.minu[0], opt.minu[1]};
 	vector <double> maxu2d = {opt.maxu[0], opt.maxu[1]};
 	CurvilinearGrid *cg = new CurvilinearGrid(
-		opt.dims, opt.bs, blks, *xrg, *yrg, zcoords, kdtree
+		opt.dims, opt.bs, blks, *xrg, *yrg, zcoords, kdtree, locator
 	);
 
 	return(cg);
@@ -275,6 +349,482 @@ void test_iterator(const StructuredGrid *sg) {
 
 }
 
+void print_access_result(string name, double t, double accum, size_t count) {
+	cout << setw(16) << left << name << right << " time : " << setw(10) 
+		<< fixed << setprecision(4) << t << ", sum and count : " 
+		<< setprecision(1) << accum << " " << count << endl;
+	cout.unsetf(ios_base::floatfield);
+}
+
+// Compare the cost of visiting every value within a region of grid 
+// indices using each of the available access methods. All should 
+// produce the same sum.
+//
+void test_value_access(
+	const StructuredGrid *sg,
+	const vector <size_t> &min, const vector <size_t> &max
+) {
+
+	const vector <size_t> &dims = sg->GetDimensions();
+	size_t imin[] = {0,0,0};
+	size_t imax[] = {0,0,0};
+	for (int i=0; i<dims.size(); i++) {
+		imin[i] = min[i];
+		imax[i] = max[i];
+	}
+
+	// Polymorphic iterator. Only usable for the entire grid, since
+	// regions are specified in user coordinates
+	//
+	bool all = true;
+	for (int i=0; i<dims.size(); i++) {
+		if (min[i] != 0 || max[i] != dims[i]-1) all = false;
+	}
+	if (all) {
+		double t0 = Wasp::GetTime();
+		double accum = 0.0;
+		size_t count = 0;
+		Grid::ConstIterator itr;
+		Grid::ConstIterator enditr = sg->cend();
+		for (itr = sg->cbegin(); itr!=enditr; ++itr) {
+			accum += *itr;
+			count++;
+		}
+		print_access_result("Iterator", Wasp::GetTime() - t0, accum, count);
+	}
+
+	// Random access by index
+	//
+	double t0 = Wasp::GetTime();
+	double accum = 0.0;
+	size_t count = 0;
+	for (size_t k=imin[2]; k<=imax[2]; k++) {
+	for (size_t j=imin[1]; j<=imax[1]; j++) {
+	for (size_t i=imin[0]; i<=imax[0]; i++) {
+		accum += sg->AccessIJK(i,j,k);
+		count++;
+	}
+	}
+	}
+	print_access_result("AccessIJK", Wasp::GetTime() - t0, accum, count);
+
+	// Storage order iterator
+	//
+	t0 = Wasp::GetTime();
+	accum = 0.0;
+	count = 0;
+	Grid::ConstBlkIterator bitr = sg->cblkbegin(min, max);
+	Grid::ConstBlkIterator benditr = sg->cblkend();
+	for ( ; bitr!=benditr; ++bitr) {
+		accum += *bitr;
+		count++;
+	}
+	print_access_result("BlockIterator", Wasp::GetTime() - t0, accum, count);
+
+	// Block visitor
+	//
+	t0 = Wasp::GetTime();
+	accum = 0.0;
+	count = 0;
+	sg->ForEachBlock(min, max,
+		[&](const float *blk, const Grid::BlockExtents &ext) {
+
+		for (size_t k=ext.min[2]; k<=ext.max[2]; k++) {
+		for (size_t j=ext.min[1]; j<=ext.max[1]; j++) {
+			const float *row = blk + (k * ext.bs[1] + j) * ext.bs[0];
+			for (size_t i=ext.min[0]; i<=ext.max[0]; i++) {
+				accum += row[i];
+			}
+			count += ext.max[0] - ext.min[0] + 1;
+		}
+		}
+	});
+	print_access_result("ForEachBlock", Wasp::GetTime() - t0, accum, count);
+	cout << endl;
+}
+
+// Compare GetValues() with GetValue() at random points, some of which
+// lie outside of the grid, for each interpolation order, with and 
+// without missing values. The results should be identical.
+//
+void test_get_values(StructuredGrid *sg, size_t n) {
+
+	vector <double> minu, maxu;
+	sg->GetUserExtents(minu, maxu);
+
+	vector <double> xyz(3*n, 0.0);
+	for (size_t p=0; p<n; p++) {
+		for (int i=0; i<minu.size() && i<3; i++) {
+			double w = maxu[i] - minu[i];
+			double t = (double) rand() / RAND_MAX;
+			xyz[3*p+i] = minu[i] - 0.05*w + 1.1*w*t;
+		}
+	}
+
+	vector <float> values(n);
+	int order0 = sg->GetInterpolationOrder();
+	float mv0 = sg->GetMissingValue();
+	bool has_missing0 = sg->HasMissingData();
+
+	for (int missing = 0; missing < 2; missing++) {
+	for (int order = 0; order < 2; order++) {
+		sg->SetInterpolationOrder(order);
+
+		// init_grid() stores k+1 at each node, so this makes the
+		// second layer of nodes missing
+		//
+		if (missing) {
+			sg->SetMissingValue(2.0);
+			sg->SetHasMissingValues(true);
+		}
+
+		double t0 = Wasp::GetTime();
+		double accum = 0.0;
+		for (size_t p=0; p<n; p++) {
+			float v = sg->GetValue(xyz[3*p], xyz[3*p+1], xyz[3*p+2]);
+			values[p] = v;
+			accum += v == sg->GetMissingValue() ? 0.0 : v;
+		}
+		double t1 = Wasp::GetTime() - t0;
+
+		vector <float> batch(n);
+		t0 = Wasp::GetTime();
+		sg->GetValues(xyz.data(), n, batch.data());
+		double t2 = Wasp::GetTime() - t0;
+
+		size_t nbad = 0;
+		for (size_t p=0; p<n; p++) {
+			if (batch[p] != values[p]) nbad++;
+		}
+
+		cout << "Order " << order << (missing ? ", missing values" : "")
+			<< fixed << setprecision(4) << " : GetValue time : " << t1 
+			<< ", GetValues time : " << t2 << ", speedup : " 
+			<< setprecision(1) << t1 / t2 << ", sum : " << accum
+			<< ", mismatches : " << nbad << endl;
+		cout.unsetf(ios_base::floatfield);
+
+		sg->SetMissingValue(mv0);
+		sg->SetHasMissingValues(has_missing0);
+	}
+	}
+	sg->SetInterpolationOrder(order0);
+	cout << endl;
+}
+
+// Report the build time and memory use of a cell locator for the 
+// horizontal coordinates of a curvilinear grid, and compare point 
+// location with the locator against the search of the cells around the
+// nearest vertex found with a k-d tree. Random queries are uniformly 
+// distributed over the grid's extents, coherent queries walk along
+// rows of the grid's bounding box.
+//
+void test_cell_locator(const CurvilinearGrid *cg, size_t n) {
+
+	const RegularGrid &xrg = cg->GetXRG();
+	const RegularGrid &yrg = cg->GetYRG();
+
+	double t0 = Wasp::GetTime();
+	KDTreeRG kdtree(xrg, yrg);
+	cout << "KDTreeRG build time : " << Wasp::GetTime() - t0 << endl;
+
+	t0 = Wasp::GetTime();
+	CellLocatorRG locator(xrg, yrg);
+	cout << "CellLocatorRG build time : " << Wasp::GetTime() - t0 << endl;
+
+	vector <size_t> bdims = locator.GetBinDimensions();
+	cout << "CellLocatorRG bins : " << bdims[0] << "x" << bdims[1] 
+		<< ", memory : " << locator.GetMemoryUsage() << " bytes" << endl;
+
+	// Same grid, but locating cells with the k-d tree
+	//
+	CurvilinearGrid kdgrid(
+		cg->GetDimensions(), cg->GetBlockSize(), cg->GetBlks(), xrg, yrg,
+		cg->GetZCoords(), &kdtree
+	);
+	CurvilinearGrid locgrid(
+		cg->GetDimensions(), cg->GetBlockSize(), cg->GetBlks(), xrg, yrg,
+		cg->GetZCoords(), &kdtree, &locator
+	);
+
+	vector <double> minu, maxu;
+	cg->GetUserExtents(minu, maxu);
+
+	size_t nrows = max((size_t) sqrt((double) n), (size_t) 1);
+	for (int coherent = 0; coherent < 2; coherent++) {
+		vector <double> xy(2*n);
+		for (size_t p=0; p<n; p++) {
+			double s, t;
+			if (coherent) {
+				size_t ncols = (n + nrows - 1) / nrows;
+				s = (p % ncols + 0.5) / ncols;
+				t = (p / ncols + 0.5) / nrows;
+			}
+			else {
+				s = (double) rand() / RAND_MAX;
+				t = (double) rand() / RAND_MAX;
+			}
+			xy[2*p] = minu[0] + (maxu[0]-minu[0]) * s;
+			xy[2*p+1] = minu[1] + (maxu[1]-minu[1]) * t;
+		}
+
+		size_t i, j;
+		double lambda[4];
+		size_t nfound = 0;
+		t0 = Wasp::GetTime();
+		for (size_t p=0; p<n; p++) {
+			if (locator.FindCell(xy[2*p], xy[2*p+1], i, j, lambda)) nfound++;
+		}
+		double t1 = Wasp::GetTime() - t0;
+
+		vector <double> coords(cg->GetGeometryDim(), minu.back());
+		vector <vector <size_t> > cells(n);
+		t0 = Wasp::GetTime();
+		for (size_t p=0; p<n; p++) {
+			coords[0] = xy[2*p];
+			coords[1] = xy[2*p+1];
+			locgrid.GetIndicesCell(coords, cells[p]);
+		}
+		double t2 = Wasp::GetTime() - t0;
+
+		vector <size_t> indices;
+		size_t nkdfound = 0;
+		size_t nbad = 0;
+		t0 = Wasp::GetTime();
+		for (size_t p=0; p<n; p++) {
+			coords[0] = xy[2*p];
+			coords[1] = xy[2*p+1];
+			indices.clear();
+			if (kdgrid.GetIndicesCell(coords, indices)) nkdfound++;
+			if (! indices.empty() && indices != cells[p]) nbad++;
+		}
+		double t3 = Wasp::GetTime() - t0;
+
+		cout << (coherent ? "Coherent" : "Random") << " queries : " 
+			<< fixed << setprecision(1)
+			<< "FindCell " << t1 / n * 1e9 << " ns/pt, "
+			<< "GetIndicesCell " << t2 / n * 1e9 << " ns/pt, "
+			<< "k-d tree GetIndicesCell " << t3 / n * 1e9 << " ns/pt" << endl;
+		cout.unsetf(ios_base::floatfield);
+		cout << "    found : " << nfound << ", k-d tree found : " << nkdfound 
+			<< ", mismatches : " << nbad << endl;
+	}
+	cout << endl;
+}
+
+// Compare horizontal surfaces extracted with GetValuesAtHeight() at 
+// several heights against a search of each grid column with 
+// GetUserCoordinates() and AccessIJK()
+//
+void test_layered_surface(const LayeredGrid *lg) {
+
+	vector <double> minu, maxu;
+	lg->GetUserExtents(minu, maxu);
+	vector <size_t> dims = lg->GetDimensions();
+	float mv = lg->GetMissingValue();
+
+	vector <float> values(dims[0] * dims[1]);
+	const int nheights = 5;
+	for (int h=0; h<nheights; h++) {
+		double z = minu[2] + (maxu[2] - minu[2]) * (h + 0.5) / nheights;
+
+		double t0 = Wasp::GetTime();
+		lg->GetValuesAtHeight(z, values.data());
+		double t1 = Wasp::GetTime() - t0;
+
+		double x, y, z0, z1;
+		size_t nvalid = 0;
+		size_t nbad = 0;
+		t0 = Wasp::GetTime();
+		for (size_t j=0; j<dims[1]; j++) {
+		for (size_t i=0; i<dims[0]; i++) {
+			float v = mv;
+			lg->GetUserCoordinates(i, j, 0, x, y, z0);
+			for (size_t k=1; k<dims[2]; k++, z0 = z1) {
+				lg->GetUserCoordinates(i, j, k, x, y, z1);
+				if (z0 <= z && z <= z1) {
+					float v0 = lg->AccessIJK(i, j, k-1);
+					float v1 = lg->AccessIJK(i, j, k);
+					v = v0 + (z - z0) / (z1 - z0) * (v1 - v0);
+					break;
+				}
+			}
+
+			float s = values[j * dims[0] + i];
+			if (s != mv) nvalid++;
+			if (v == mv || s == mv) {
+				if (v != s) nbad++;
+			}
+			else if (fabs(v - s) > 1e-5 * max(fabs(v), 1.0f)) nbad++;
+		}
+		}
+		double t2 = Wasp::GetTime() - t0;
+
+		cout << "Height " << fixed << setprecision(3) << z 
+			<< " : GetValuesAtHeight time : " << setprecision(4) << t1 
+			<< ", column search time : " << t2 << ", speedup : " 
+			<< setprecision(1) << t2 / t1 << ", valid : " << nvalid
+			<< ", mismatches : " << nbad << endl;
+		cout.unsetf(ios_base::floatfield);
+	}
+	cout << endl;
+}
+
+// Visit every cell, looking up the user coordinates of each of its 
+// nodes, with the std::vector and the fixed size array versions of
+// GetCellNodes() and GetUserCoordinates(). Report the time and heap 
+// allocations per cell of each. Both must produce the same coordinates.
+//
+void test_cell_access(const StructuredGrid *sg) {
+
+	const Grid &g = *sg;
+	Grid::ConstCellIterator itr;
+	Grid::ConstCellIterator enditr = g.ConstCellEnd();
+
+	size_t ncells = 0;
+	double sum1 = 0.0;
+	size_t nallocs0 = NumAllocs;
+	double t0 = Wasp::GetTime();
+	vector <vector <size_t> > nodes;
+	vector <double> coords;
+	for (itr = g.ConstCellBegin(); itr != enditr; ++itr, ncells++) {
+		g.GetCellNodes(*itr, nodes);
+		for (int i=0; i<nodes.size(); i++) {
+			g.GetUserCoordinates(nodes[i], coords);
+			for (int j=0; j<coords.size(); j++) sum1 += coords[j];
+		}
+	}
+	double t1 = Wasp::GetTime() - t0;
+	size_t nallocs1 = NumAllocs - nallocs0;
+
+	// The cell iterator itself allocates, so the array version walks
+	// the cells with nested loops
+	//
+	const vector <size_t> &cdims = g.GetCellDimensions();
+	size_t nk = cdims.size() > 2 ? cdims[2] : 1;
+
+	double sum2 = 0.0;
+	nallocs0 = NumAllocs;
+	t0 = Wasp::GetTime();
+	Grid::Size_tArr3 cell;
+	vector <Grid::Size_tArr3> nodes3;
+	Grid::DblArr3 coords3;
+	for (size_t k=0; k<nk; k++) {
+	for (size_t j=0; j<cdims[1]; j++) {
+	for (size_t i=0; i<cdims[0]; i++) {
+		cell = {{i, j, k}};
+		g.GetCellNodes(cell, nodes3);
+		for (int l=0; l<nodes3.size(); l++) {
+			g.GetUserCoordinates(nodes3[l], coords3);
+			for (int m=0; m<3; m++) sum2 += coords3[m];
+		}
+	}
+	}
+	}
+	double t2 = Wasp::GetTime() - t0;
+	size_t nallocs2 = NumAllocs - nallocs0;
+
+	double nc = max(ncells, (size_t) 1);
+	cout << "Cells : " << ncells << fixed << setprecision(4)
+		<< ", vector time : " << t1 << ", array time : " << t2
+		<< ", speedup : " << setprecision(1) << t1 / t2 << endl;
+	cout << "Allocations per cell : vector : " << nallocs1 / nc
+		<< ", array : " << nallocs2 / nc 
+		<< ", mismatch : " << (sum1 == sum2 ? 0 : 1) << endl;
+	cout.unsetf(ios_base::floatfield);
+	cout << endl;
+}
+
+// Compare the parallel reductions of GridStats over a region of grid
+// indices with a serial loop. The grid itself is used as the weights of
+// the weighted moments.
+//
+void test_grid_stats(
+	const StructuredGrid *sg,
+	const vector <size_t> &min, const vector <size_t> &max
+) {
+	const Grid &g = *sg;
+	size_t kmin = min.size() > 2 ? min[2] : 0;
+	size_t kmax = max.size() > 2 ? max[2] : 0;
+
+	double t0 = Wasp::GetTime();
+	size_t count = 0;
+	double vmin = 0.0, vmax = 0.0, sum = 0.0, wsum = 0.0, wvsum = 0.0;
+	for (size_t k=kmin; k<=kmax; k++) {
+	for (size_t j=min[1]; j<=max[1]; j++) {
+	for (size_t i=min[0]; i<=max[0]; i++) {
+		double v = g.AccessIJK(i,j,k);
+		if (! count || v < vmin) vmin = v;
+		if (! count || v > vmax) vmax = v;
+		sum += v;
+		if (v > 0.0) {
+			wsum += v;
+			wvsum += v * v;
+		}
+		count++;
+	}
+	}
+	}
+	double mean = sum / count;
+	double m2 = 0.0;
+	for (size_t k=kmin; k<=kmax; k++) {
+	for (size_t j=min[1]; j<=max[1]; j++) {
+	for (size_t i=min[0]; i<=max[0]; i++) {
+		double delta = g.AccessIJK(i,j,k) - mean;
+		m2 += delta * delta;
+	}
+	}
+	}
+	double t1 = Wasp::GetTime() - t0;
+
+	GridStats::Moments m1;
+	t0 = Wasp::GetTime();
+	GridStats::ComputeMoments(g, min, max, m1, 1);
+	double t2 = Wasp::GetTime() - t0;
+
+	GridStats::Moments mn;
+	t0 = Wasp::GetTime();
+	GridStats::ComputeMoments(g, min, max, mn);
+	double t3 = Wasp::GetTime() - t0;
+
+	double range[2];
+	size_t rcount = GridStats::ComputeRange(g, min, max, range);
+
+	GridStats::Moments wm;
+	GridStats::ComputeWeightedMoments(g, g, min, max, wm);
+
+	GridStats::Histogram h(vmin, vmax, 64);
+	t0 = Wasp::GetTime();
+	GridStats::ComputeHistogram(g, min, max, h);
+	double t4 = Wasp::GetTime() - t0;
+
+	double var = m2 / count;
+	double tol = 1e-9 * std::max(1.0, fabs(mean) + var);
+	int mismatch = 0;
+	if (m1.count != count || mn.count != count || rcount != count) mismatch++;
+	if (m1.min != vmin || m1.max != vmax || mn.min != vmin || mn.max != vmax) {
+		mismatch++;
+	}
+	if (range[0] != vmin || range[1] != vmax) mismatch++;
+	if (fabs(m1.mean - mean) > tol || fabs(mn.mean - mean) > tol) mismatch++;
+	if (fabs(m1.Variance() - var) > tol || fabs(mn.Variance() - var) > tol) {
+		mismatch++;
+	}
+	if (wsum > 0.0 && fabs(wm.mean - wvsum / wsum) > tol) mismatch++;
+	if (h.GetTotal() != count || h.below || h.above) mismatch++;
+
+	cout << "Values : " << count << fixed << setprecision(4)
+		<< ", serial loop time : " << t1 << ", 1 thread time : " << t2
+		<< ", " << EasyThreads::NProc() << " thread time : " << t3
+		<< ", histogram time : " << t4 << endl;
+	cout << setprecision(6) << "Mean : " << mn.mean << ", stddev : "
+		<< mn.StdDev() << ", weighted mean : " << wm.mean
+		<< ", median : " << h.Percentile(0.5) << ", mismatches : "
+		<< mismatch << endl;
+	cout.unsetf(ios_base::floatfield);
+	cout << endl;
+}
+
 #ifdef	VAPOR3_0_0_ALPHA
 void test_cell_iterator(const StructuredGrid *sg) {
 
@@ -395,7 +945,11 @@ int main(int argc, char **argv) {
 	double t0 = Wasp::GetTime();
 
 	StructuredGrid *sg = NULL;
-	if (opt.type == "layered") {
+	if (opt.type == "stretched") {
+		cout << "Stretched grid" << endl;
+		sg = make_stretched_grid();
+	}
+	else if (opt.type == "layered") {
 		cout << "Layered grid" << endl;
 		sg = make_layered_grid();
 	}
@@ -412,6 +966,20 @@ int main(int argc, char **argv) {
 
 	init_grid(sg);
 
+	// Default region of interest is the middle half of the grid's user
+	// extents along each axis
+	//
+	if (opt.roimin.empty() || opt.roimax.empty()) {
+		vector <double> minu, maxu;
+		sg->GetUserExtents(minu, maxu);
+		opt.roimin.clear();
+		opt.roimax.clear();
+		for (int i=0; i<minu.size(); i++) {
+			opt.roimin.push_back(minu[i] + 0.25 * (maxu[i] - minu[i]));
+			opt.roimax.push_back(minu[i] + 0.75 * (maxu[i] - minu[i]));
+		}
+	}
+
 	cout << "Creation time : " << Wasp::GetTime() - t0 << endl;
 	cout << *sg;
 	cout << endl;
@@ -419,6 +987,40 @@ int main(int argc, char **argv) {
 
 	test_iterator(sg);
 
+	cout << "Value Access Benchmark (entire grid) ----->" << endl;
+	vector <size_t> min(sg->GetDimensions().size(), 0);
+	vector <size_t> max = sg->GetDimensions();
+	for (int i=0; i<max.size(); i++) max[i] -= 1;
+	test_value_access(sg, min, max);
+
+	cout << "Value Access Benchmark (region of interest) ----->" << endl;
+	sg->GetEnclosingRegion(opt.roimin, opt.roimax, min, max);
+	sg->ClampIndex(min);
+	sg->ClampIndex(max);
+	for (int i=0; i<min.size(); i++) {
+		if (max[i] < min[i]) max[i] = min[i];
+	}
+	test_value_access(sg, min, max);
+
+	cout << "Interpolation Benchmark ----->" << endl;
+	test_get_values(sg, opt.npoints);
+
+	if (opt.type == "curvilinear") {
+		cout << "Cell Locator Benchmark ----->" << endl;
+		test_cell_locator(dynamic_cast <CurvilinearGrid *> (sg), opt.npoints);
+	}
+
+	if (opt.type == "layered") {
+		cout << "Layered Surface Benchmark ----->" << endl;
+		test_layered_surface(dynamic_cast <LayeredGrid *> (sg));
+	}
+
+	cout << "Cell Access Benchmark ----->" << endl;
+	test_cell_access(sg);
+
+	cout << "Reduction Benchmark (region of interest) ----->" << endl;
+	test_grid_stats(sg, min, max);
+
 //	test_cell_iterator(sg);
 
 	test_node_iterator(sg);
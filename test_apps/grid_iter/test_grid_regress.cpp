@@ -0,0 +1,538 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <new>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/vizutil.h>
+#include <vapor/RegularGrid.h>
+#include <vapor/StretchedGrid.h>
+#include <vapor/CurvilinearGrid.h>
+#include <vapor/LayeredGrid.h>
+#include <vapor/UnstructuredGrid2D.h>
+#include <vapor/UnstructuredGridCoordless.h>
+#include <vapor/KDTreeRG.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Regression tests for grid point location and interpolation. Each
+// test checks a small case, built by hand, whose answer is known, and
+// returns the number of errors.
+//
+
+struct {
+	OptionParser::Boolean_T	help;
+} opt;
+
+OptionParser::OptDescRec_T	set_opts[] = {
+	{"help", 0, "", "Print this message and exit"},
+	{NULL}
+};
+
+OptionParser::Option_T	get_options[] = {
+	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+	{NULL}
+};
+
+const char	*ProgName;
+
+int check(bool ok, const string &test, const string &what) {
+	if (ok) return(0);
+	cout << test << " : " << what << endl;
+	return(1);
+}
+
+// Check that Wachspress weights reproduce the point and sum to one
+//
+int check_wachspress(
+	const string &test, const double *verts, int n, const double pt[2]
+) {
+	vector <double> lambda(n);
+	if (! WachspressCoords2D(verts, pt, n, lambda.data())) {
+		return(check(false, test, "point not inside"));
+	}
+
+	double sum = 0.0, x = 0.0, y = 0.0;
+	for (int i=0; i<n; i++) {
+		sum += lambda[i];
+		x += lambda[i] * verts[2*i];
+		y += lambda[i] * verts[2*i+1];
+	}
+
+	double size = fabs(verts[2] - verts[0]) + fabs(verts[3] - verts[1]);
+	double tol = 1e-9 * size;
+	int nerrors = 0;
+	nerrors += check(fabs(sum - 1.0) < 1e-9, test, "weights don't sum to one");
+	nerrors += check(
+		fabs(x - pt[0]) < tol && fabs(y - pt[1]) < tol, test,
+		"weights don't reproduce point"
+	);
+	return(nerrors);
+}
+
+// Points in the interior of small polygons must not be treated as
+// lying on an edge
+//
+int test_wachspress_small() {
+	int nerrors = 0;
+	for (double h = 1.0; h >= 1e-5; h /= 10.0) {
+		double square[] = {0.0, 0.0, h, 0.0, h, h, 0.0, h};
+		double pt[] = {0.5 * h, 0.3 * h};
+		nerrors += check_wachspress("wachspress_small", square, 4, pt);
+	}
+	return(nerrors);
+}
+
+// Points on each edge of a polygon get weights from the edge's two
+// vertices only
+//
+int test_wachspress_edge() {
+	int nerrors = 0;
+	double pentagon[] = {0.0, 0.0, 2.0, 0.0, 2.5, 1.5, 1.0, 2.5, -0.5, 1.5};
+	int n = 5;
+	for (int e=0; e<n; e++) {
+		const double *v0 = &pentagon[2*e];
+		const double *v1 = &pentagon[2*((e+1) % n)];
+		double pt[] = {0.7*v0[0] + 0.3*v1[0], 0.7*v0[1] + 0.3*v1[1]};
+		nerrors += check_wachspress("wachspress_edge", pentagon, n, pt);
+	}
+	return(nerrors);
+}
+
+// Grids are constructed with zero node and cell ID offsets. The grid
+// is built in memory filled with a pattern so that a member left
+// uninitialized is detected
+//
+int test_id_offsets() {
+	vector <size_t> dims = {4, 4};
+	vector <float> data(16, 0.0);
+	vector <float *> blks = {data.data()};
+
+	alignas(RegularGrid) unsigned char buf[sizeof(RegularGrid)];
+	memset(buf, 0x5a, sizeof(buf));
+
+	RegularGrid *rg = new (buf) RegularGrid(
+		dims, dims, blks, vector <double> (2, 0.0), vector <double> (2, 1.0)
+	);
+
+	int nerrors = 0;
+	nerrors += check(rg->GetNodeOffset() == 0, "id_offsets", "node offset");
+	nerrors += check(rg->GetCellOffset() == 0, "id_offsets", "cell offset");
+
+	rg->~RegularGrid();
+	return(nerrors);
+}
+
+// Point location with the k-d tree visits every face around the
+// nearest node, skipping boundary entries. The unit square is split
+// into two triangles, and each node lists a boundary entry before its
+// faces
+//
+int test_boundary_faces() {
+	const size_t B = 1000;	// boundary ID
+	float x[] = {0.0, 1.0, 1.0, 0.0};
+	float y[] = {0.0, 0.0, 1.0, 1.0};
+	float data[] = {0.0, 1.0, 3.0, 2.0};	// x + 2y
+	int vertexOnFace[] = {0, 1, 2, 0, 2, 3};
+	int faceOnVertex[] = {B, 1, 0, B, 0, -1, B, 0, 1, B, 1, -1};
+
+	vector <size_t> vertexDims = {4};
+	vector <size_t> faceDims = {2};
+	vector <size_t> edgeDims;
+	vector <size_t> bs = {4};
+
+	UnstructuredGridCoordless xug(
+		vertexDims, faceDims, edgeDims, bs, {x}, 2,
+		vertexOnFace, faceOnVertex, NULL, UnstructuredGrid::NODE, 3, 3
+	);
+	UnstructuredGridCoordless yug(
+		vertexDims, faceDims, edgeDims, bs, {y}, 2,
+		vertexOnFace, faceOnVertex, NULL, UnstructuredGrid::NODE, 3, 3
+	);
+	UnstructuredGridCoordless zug;
+	KDTreeRG kdtree(xug, yug);
+
+	UnstructuredGrid2D ug(
+		vertexDims, faceDims, edgeDims, bs, {data},
+		vertexOnFace, faceOnVertex, NULL, UnstructuredGrid::NODE, 3, 3,
+		xug, yug, zug, &kdtree
+	);
+	ug.SetBoundaryID(B);
+	ug.SetInterpolationOrder(1);
+
+	// Nearest node is node 0. The point is in face 0, listed last
+	//
+	float v = ug.GetValue(0.2, 0.1);
+	return(check(fabs(v - 0.4) < 1e-6, "boundary_faces", "face not found"));
+}
+
+// The last cell along each axis is a valid cell, and its nodes are
+// the last two nodes along that axis
+//
+int test_clamp_cell_index() {
+	vector <size_t> dims = {4, 4};
+	vector <float> data(16, 0.0);
+	vector <float *> blks = {data.data()};
+
+	RegularGrid rg(
+		dims, dims, blks, vector <double> (2, 0.0), vector <double> (2, 1.0)
+	);
+
+	Grid::Size_tArr3 cindices = {{2, 2, 0}};
+	vector <Grid::Size_tArr3> nodes;
+	rg.GetCellNodes(cindices, nodes);
+
+	size_t expect[][2] = {{2, 2}, {3, 2}, {3, 3}, {2, 3}};
+	int nerrors = check(nodes.size() == 4, "clamp_cell_index", "node count");
+	for (int i=0; i<nodes.size() && i<4; i++) {
+		nerrors += check(
+			nodes[i][0] == expect[i][0] && nodes[i][1] == expect[i][1],
+			"clamp_cell_index", "wrong node"
+		);
+	}
+	return(nerrors);
+}
+
+// GetIndices() searches each axis in its own coordinates and returns
+// the nearest node. The axes have different, unevenly spaced
+// coordinates
+//
+int test_stretched_indices() {
+	vector <size_t> dims = {4, 4, 3};
+	vector <float> data(4*4*3, 0.0);
+	vector <float *> blks = {data.data()};
+	vector <double> xcoords = {0.0, 1.0, 3.0, 6.0};
+	vector <double> ycoords = {0.0, 2.0, 3.0, 10.0};
+	vector <double> zcoords = {0.0, 5.0, 7.0};
+
+	StretchedGrid sg(dims, dims, blks, xcoords, ycoords, zcoords);
+
+	// Each point is given with the node expected
+	//
+	double pts[][3] = {
+		{2.6, 2.2, 6.5}, {0.4, 8.0, 1.0}, {6.0, 10.0, 7.0}, {0.0, 0.0, 0.0}
+	};
+	size_t expect[][3] = {{2, 1, 2}, {0, 3, 0}, {3, 3, 2}, {0, 0, 0}};
+
+	int nerrors = 0;
+	for (int i=0; i<4; i++) {
+		Grid::DblArr3 coords = {{pts[i][0], pts[i][1], pts[i][2]}};
+		Grid::Size_tArr3 indices;
+		sg.GetIndices(coords, indices);
+		nerrors += check(
+			indices[0] == expect[i][0] && indices[1] == expect[i][1] &&
+			indices[2] == expect[i][2], "stretched_indices", "wrong node"
+		);
+	}
+	return(nerrors);
+}
+
+// The vertical index returned by CurvilinearGrid::GetIndices() is the
+// nearest level, not the top of the grid
+//
+int test_curvilinear_indices() {
+	vector <size_t> dims2d = {3, 3};
+	vector <float> x(9), y(9);
+	for (int j=0; j<3; j++) {
+	for (int i=0; i<3; i++) {
+		x[j*3+i] = i + 0.1 * j;
+		y[j*3+i] = j;
+	}
+	}
+	RegularGrid xrg(
+		dims2d, dims2d, {x.data()},
+		vector <double> (2, 0.0), vector <double> (2, 1.0)
+	);
+	RegularGrid yrg(
+		dims2d, dims2d, {y.data()},
+		vector <double> (2, 0.0), vector <double> (2, 1.0)
+	);
+	KDTreeRG kdtree(xrg, yrg);
+
+	vector <size_t> dims = {3, 3, 3};
+	vector <float> data(27, 0.0);
+	vector <double> zcoords = {0.0, 5.0, 7.0};
+	CurvilinearGrid cg(dims, dims, {data.data()}, xrg, yrg, zcoords, &kdtree);
+
+	double z[] = {1.0, 4.0, 5.5, 6.5, 7.0};
+	size_t expect[] = {0, 1, 1, 2, 2};
+
+	int nerrors = 0;
+	for (int i=0; i<5; i++) {
+		Grid::DblArr3 coords = {{1.1, 1.0, z[i]}};
+		Grid::Size_tArr3 indices;
+		cg.GetIndices(coords, indices);
+		nerrors += check(
+			indices[0] == 1 && indices[1] == 1 && indices[2] == expect[i],
+			"curvilinear_indices", "wrong node"
+		);
+	}
+	return(nerrors);
+}
+
+// A k-d tree written to a file reads back, but not once an offset in
+// the file no longer refers to a node of the grid
+//
+int test_kdtree_file() {
+	vector <size_t> dims2d = {3, 3};
+	vector <float> x(9), y(9);
+	for (int i=0; i<9; i++) {
+		x[i] = i % 3;
+		y[i] = i / 3;
+	}
+	RegularGrid xrg(
+		dims2d, dims2d, {x.data()},
+		vector <double> (2, 0.0), vector <double> (2, 1.0)
+	);
+	RegularGrid yrg(
+		dims2d, dims2d, {y.data()},
+		vector <double> (2, 0.0), vector <double> (2, 1.0)
+	);
+	KDTreeRG kdtree(xrg, yrg);
+
+	char tmpl[] = "/tmp/test_grid_regressXXXXXX";
+	if (! mkdtemp(tmpl)) {
+		return(check(false, "kdtree_file", "can't create directory"));
+	}
+	string path = string(tmpl) + "/kdtree";
+
+	int nerrors = 0;
+	nerrors += check(kdtree.Write(path) == 0, "kdtree_file", "write failed");
+
+	KDTreeRG *read = KDTreeRG::Read(path);
+	nerrors += check(
+		read && read->GetDimensions() == dims2d, "kdtree_file", "read failed"
+	);
+	if (read) delete read;
+
+	// The offsets array follows the header
+	//
+	FILE *fp = fopen(path.c_str(), "r+b");
+	if (fp) {
+		fseek(fp, 0, SEEK_END);
+		long hdrsize = ftell(fp) - 9 * (sizeof(size_t) + 2*sizeof(float) + 1);
+		size_t offset = 9;
+		fseek(fp, hdrsize, SEEK_SET);
+		fwrite(&offset, sizeof(offset), 1, fp);
+		fclose(fp);
+	}
+
+	bool enabled = MyBase::EnableErrMsg(false);
+	read = KDTreeRG::Read(path);
+	(void) MyBase::EnableErrMsg(enabled);
+	nerrors += check(! read, "kdtree_file", "invalid offset accepted");
+	if (read) delete read;
+
+	remove(path.c_str());
+	remove(tmpl);
+	return(nerrors);
+}
+
+// GetIndices() rounds each axis to the nearest node using that axis'
+// spacing. The X extent is degenerate, so a test of the X spacing in
+// place of each axis' own spacing disables rounding
+//
+int test_degenerate_axis() {
+	int nerrors = 0;
+
+	vector <size_t> dims2d = {2, 5};
+	vector <float> data2d(10, 0.0);
+	vector <double> minu = {0.0, 0.0};
+	vector <double> maxu = {0.0, 4.0};
+	RegularGrid rg(dims2d, dims2d, {data2d.data()}, minu, maxu);
+
+	Grid::DblArr3 coords = {{0.0, 2.9, 0.0}};
+	Grid::Size_tArr3 indices;
+	rg.GetIndices(coords, indices);
+	nerrors += check(indices[1] == 3, "degenerate_axis", "regular grid");
+
+	// Layered grid with unit spaced levels
+	//
+	vector <size_t> dims3d = {2, 5, 3};
+	vector <float> data3d(30, 0.0);
+	vector <float> z(30);
+	for (int i=0; i<z.size(); i++) z[i] = i / 10;
+	RegularGrid zrg(
+		dims3d, dims3d, {z.data()},
+		vector <double> (3, 0.0), vector <double> (3, 1.0)
+	);
+	LayeredGrid lg(dims3d, dims3d, {data3d.data()}, minu, maxu, zrg);
+
+	coords = {{0.0, 2.9, 1.0}};
+	lg.GetIndices(coords, indices);
+	nerrors += check(indices[1] == 3, "degenerate_axis", "layered grid");
+
+	return(nerrors);
+}
+
+// A cell of a layered unstructured grid has the face's nodes on the
+// layer below it, followed by the same nodes on the layer above it
+//
+int test_layered_cell_nodes() {
+	int vertexOnFace[] = {0, 1, 2, 3};
+	int faceOnVertex[] = {0, 0, 0, 0};
+	vector <float> data(12, 0.0);
+
+	vector <size_t> vertexDims = {4, 3};
+	vector <size_t> faceDims = {1, 2};
+	vector <size_t> edgeDims;
+	vector <size_t> bs = {4, 3};
+
+	UnstructuredGridCoordless ug(
+		vertexDims, faceDims, edgeDims, bs, {data.data()}, 2,
+		vertexOnFace, faceOnVertex, NULL, UnstructuredGrid::NODE, 4, 1
+	);
+
+	Grid::Size_tArr3 cindices = {{0, 1, 0}};
+	vector <Grid::Size_tArr3> nodes;
+	ug.GetCellNodes(cindices, nodes);
+
+	int nerrors = check(nodes.size() == 8, "layered_cell_nodes", "node count");
+	for (int i=0; i<nodes.size() && i<8; i++) {
+		nerrors += check(
+			nodes[i][0] == i % 4 && nodes[i][1] == 1 + i / 4,
+			"layered_cell_nodes", "wrong node"
+		);
+	}
+	return(nerrors);
+}
+
+// A grid whose blocks are encoded, here as twice their values, must 
+// return the same values as one built from the decoded blocks, and 
+// decode only the blocks it accesses
+//
+int test_block_decoder() {
+	vector <size_t> dims = {6, 5};
+	vector <size_t> bs = {4, 4};
+	size_t nblocks = 4;
+	size_t blksize = 16;
+
+	vector <float> data(nblocks * blksize);
+	vector <float> encoded(nblocks * blksize);
+	for (size_t i=0; i<data.size(); i++) {
+		data[i] = (float) (i % 7);
+		encoded[i] = 2.0 * data[i];
+	}
+	vector <float *> blks, eblks;
+	for (size_t b=0; b<nblocks; b++) {
+		blks.push_back(data.data() + b*blksize);
+		eblks.push_back(encoded.data() + b*blksize);
+	}
+
+	// Block 1 is not encoded
+	//
+	eblks[1] = blks[1];
+
+	vector <double> minu = {0.0, 0.0};
+	vector <double> maxu = {5.0, 4.0};
+	RegularGrid rg(dims, bs, blks, minu, maxu);
+	RegularGrid erg(dims, bs, eblks, minu, maxu);
+	rg.SetInterpolationOrder(1);
+	erg.SetInterpolationOrder(1);
+
+	int ncalls = 0;
+	erg.SetBlockDecoder(
+		[&](size_t b, const float *blk, float *buf) -> const float * {
+			ncalls++;
+			if (b == 1) return(blk);
+			for (size_t i=0; i<blksize; i++) buf[i] = blk[i] / 2.0;
+			return(buf);
+		}
+	);
+
+	int nerrors = 0;
+	nerrors += check(
+		erg.AccessIJK(0, 0, 0) == rg.AccessIJK(0, 0, 0) && ncalls == 1,
+		"block_decoder", "first access"
+	);
+
+	for (size_t j=0; j<dims[1]; j++) {
+	for (size_t i=0; i<dims[0]; i++) {
+		nerrors += check(
+			erg.AccessIJK(i, j, 0) == rg.AccessIJK(i, j, 0),
+			"block_decoder", "AccessIJK()"
+		);
+	}
+	}
+	nerrors += check(ncalls == nblocks, "block_decoder", "decode count");
+
+	double xyz[] = {0.5, 0.5, 0.0, 3.5, 3.5, 0.0, 4.25, 2.75, 0.0};
+	float v[3], ev[3];
+	rg.GetValues(xyz, 3, v);
+	erg.GetValues(xyz, 3, ev);
+	for (int p=0; p<3; p++) {
+		nerrors += check(v[p] == ev[p], "block_decoder", "GetValues()");
+	}
+
+	float sum = 0.0, esum = 0.0;
+	rg.ForEachBlock([&](const float *blk, const Grid::BlockExtents &ext) {
+		sum += blk[ext.max[1] * ext.bs[0] + ext.max[0]];
+	});
+	erg.ForEachBlock([&](const float *blk, const Grid::BlockExtents &ext) {
+		esum += blk[ext.max[1] * ext.bs[0] + ext.max[0]];
+	});
+	nerrors += check(sum == esum, "block_decoder", "ForEachBlock()");
+
+	sum = esum = 0.0;
+	for (auto itr = rg.cbegin(); itr != rg.cend(); ++itr) sum += *itr;
+	for (auto itr = erg.cbegin(); itr != erg.cend(); ++itr) esum += *itr;
+	nerrors += check(sum == esum, "block_decoder", "ConstIterator");
+
+	RegularGrid copy = erg;
+	nerrors += check(
+		copy.GetBlks()[0][5] == data[5] && copy.GetBlks()[1] == blks[1] &&
+		ncalls == nblocks,
+		"block_decoder", "GetBlks()"
+	);
+
+	return(nerrors);
+}
+
+int main(int argc, char **argv) {
+
+	OptionParser op;
+
+	ProgName = Basename(argv[0]);
+
+	MyBase::SetErrMsgFilePtr(stderr);
+
+	if (op.AppendOptions(set_opts) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (op.ParseOptions(&argc, argv, get_options) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (opt.help) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(0);
+	}
+
+	int nerrors = 0;
+	nerrors += test_wachspress_small();
+	nerrors += test_wachspress_edge();
+	nerrors += test_id_offsets();
+	nerrors += test_boundary_faces();
+	nerrors += test_clamp_cell_index();
+	nerrors += test_stretched_indices();
+	nerrors += test_curvilinear_indices();
+	nerrors += test_degenerate_axis();
+	nerrors += test_layered_cell_nodes();
+	nerrors += test_block_decoder();
+	nerrors += test_kdtree_file();
+
+	cout << "Errors : " << nerrors << endl;
+
+	return(nerrors ? 1 : 0);
+}
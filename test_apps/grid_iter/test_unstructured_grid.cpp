@@ -0,0 +1,284 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/UnstructuredGrid2D.h>
+#include <vapor/UnstructuredGridCoordless.h>
+#include <vapor/KDTreeRG.h>
+#include <vapor/FaceLocatorUG2D.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Point location benchmark for UnstructuredGrid2D. Builds a mesh of
+// quadrilaterals and triangles from a jittered lattice, samples the
+// linear function x + 2y at its nodes, and reconstructs it at random
+// and at coherent (raster order) points: with the k-d tree search,
+// with the FaceLocatorUG2D bin grid, and with the walking search used
+// by GetValues(). Wachspress interpolation reproduces linear functions,
+// so every reconstructed value can be checked.
+//
+
+struct {
+	std::vector <size_t> dims;
+	double jitter;
+	int npoints;
+	int seed;
+	OptionParser::Boolean_T	help;
+} opt;
+
+OptionParser::OptDescRec_T	set_opts[] = {
+	{"dims", 1, "512:512", "Colon delimited 2-element vector specifying "
+		"the dimensions of the lattice of mesh nodes"},
+	{"jitter", 1, "0.3", "Random displacement of mesh nodes as a fraction "
+		"of the lattice spacing"},
+	{"npoints", 1, "1000000", "Number of points at which to reconstruct "
+		"values"},
+	{"seed", 1, "0", "Random number generator seed"},
+	{"help", 0, "", "Print this message and exit"},
+	{NULL}
+};
+
+OptionParser::Option_T	get_options[] = {
+	{"dims", Wasp::CvtToSize_tVec, &opt.dims, sizeof(opt.dims)},
+	{"jitter", Wasp::CvtToDouble, &opt.jitter, sizeof(opt.jitter)},
+	{"npoints", Wasp::CvtToInt, &opt.npoints, sizeof(opt.npoints)},
+	{"seed", Wasp::CvtToInt, &opt.seed, sizeof(opt.seed)},
+	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+	{NULL}
+};
+
+const char	*ProgName;
+
+struct mesh_t {
+	size_t nnodes;
+	size_t nfaces;
+	size_t maxVertexPerFace;
+	size_t maxFacePerVertex;
+	vector <float> x;
+	vector <float> y;
+	vector <float> data;
+	vector <int> vertexOnFace;
+	vector <int> faceOnVertex;
+};
+
+// Lattice cells in even columns are quadrilaterals, those in odd
+// columns are split into two triangles. Nodes are listed
+// counter-clockwise.
+//
+void make_mesh(size_t nx, size_t ny, mesh_t &m) {
+	m.nnodes = nx * ny;
+	m.maxVertexPerFace = 4;
+	m.x.resize(m.nnodes);
+	m.y.resize(m.nnodes);
+	m.data.resize(m.nnodes);
+
+	for (size_t j=0; j<ny; j++) {
+	for (size_t i=0; i<nx; i++) {
+		double dx = 0.0, dy = 0.0;
+		if (i > 0 && i < nx-1 && j > 0 && j < ny-1) {
+			dx = opt.jitter * (2.0 * rand() / RAND_MAX - 1.0) * 0.5;
+			dy = opt.jitter * (2.0 * rand() / RAND_MAX - 1.0) * 0.5;
+		}
+		size_t v = j*nx + i;
+		m.x[v] = (i + dx) / (nx-1);
+		m.y[v] = (j + dy) / (ny-1);
+		m.data[v] = m.x[v] + 2.0 * m.y[v];
+	}
+	}
+
+	m.vertexOnFace.clear();
+	for (size_t j=0; j<ny-1; j++) {
+	for (size_t i=0; i<nx-1; i++) {
+		int v0 = j*nx + i;
+		int v1 = v0 + 1;
+		int v2 = v0 + nx + 1;
+		int v3 = v0 + nx;
+		if (i % 2 == 0) {
+			int f[] = {v0, v1, v2, v3};
+			m.vertexOnFace.insert(m.vertexOnFace.end(), f, f+4);
+		}
+		else {
+			int f[] = {v0, v1, v2, -1, v0, v2, v3, -1};
+			m.vertexOnFace.insert(m.vertexOnFace.end(), f, f+8);
+		}
+	}
+	}
+	m.nfaces = m.vertexOnFace.size() / m.maxVertexPerFace;
+
+	vector <vector <int> > faces(m.nnodes);
+	for (size_t f=0; f<m.nfaces; f++) {
+		for (int k=0; k<m.maxVertexPerFace; k++) {
+			int v = m.vertexOnFace[f*m.maxVertexPerFace + k];
+			if (v < 0) break;
+			faces[v].push_back(f);
+		}
+	}
+	m.maxFacePerVertex = 0;
+	for (size_t v=0; v<m.nnodes; v++) {
+		m.maxFacePerVertex = max(m.maxFacePerVertex, faces[v].size());
+	}
+	m.faceOnVertex.assign(m.nnodes * m.maxFacePerVertex, -1);
+	for (size_t v=0; v<m.nnodes; v++) {
+		for (int k=0; k<faces[v].size(); k++) {
+			m.faceOnVertex[v*m.maxFacePerVertex + k] = faces[v][k];
+		}
+	}
+}
+
+// Reconstruct values at n points with GetValue() or, if batch is
+// true, GetValues(). Report time per point, and the number of points
+// found inside the mesh and whose value is wrong
+//
+void reconstruct(
+	string name, const Grid &g, const vector <double> &xyz, bool batch
+) {
+	size_t n = xyz.size() / 3;
+	vector <float> values(n);
+
+	double t0 = Wasp::GetTime();
+	if (batch) {
+		g.GetValues(xyz.data(), n, values.data());
+	}
+	else {
+		for (size_t p=0; p<n; p++) {
+			values[p] = g.GetValue(xyz[3*p], xyz[3*p+1]);
+		}
+	}
+	double t = Wasp::GetTime() - t0;
+
+	size_t nfound = 0;
+	size_t nbad = 0;
+	for (size_t p=0; p<n; p++) {
+		if (values[p] == g.GetMissingValue()) continue;
+		nfound++;
+
+		double v = xyz[3*p] + 2.0 * xyz[3*p+1];
+		if (fabs(values[p] - v) > 1e-4) nbad++;
+	}
+
+	cout << setw(24) << name << setw(12) << fixed << setprecision(1)
+		<< t / n * 1e9 << setw(12) << nfound << setw(12) << nbad << endl;
+	cout.unsetf(ios_base::floatfield);
+}
+
+int main(int argc, char **argv) {
+
+	OptionParser op;
+
+	ProgName = Basename(argv[0]);
+
+	MyBase::SetErrMsgFilePtr(stderr);
+
+	if (op.AppendOptions(set_opts) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (op.ParseOptions(&argc, argv, get_options) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (opt.help) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(0);
+	}
+
+	if (opt.dims.size() != 2 || opt.dims[0] < 2 || opt.dims[1] < 2) {
+		cerr << ProgName << " : invalid dims" << endl;
+		exit(1);
+	}
+	srand(opt.seed);
+
+	mesh_t m;
+	make_mesh(opt.dims[0], opt.dims[1], m);
+
+	vector <size_t> vertexDims = {m.nnodes};
+	vector <size_t> faceDims = {m.nfaces};
+	vector <size_t> edgeDims;
+	vector <size_t> bs = {m.nnodes};
+
+	UnstructuredGridCoordless xug(
+		vertexDims, faceDims, edgeDims, bs, {m.x.data()}, 2,
+		m.vertexOnFace.data(), m.faceOnVertex.data(), NULL,
+		UnstructuredGrid::NODE, m.maxVertexPerFace, m.maxFacePerVertex
+	);
+	UnstructuredGridCoordless yug(
+		vertexDims, faceDims, edgeDims, bs, {m.y.data()}, 2,
+		m.vertexOnFace.data(), m.faceOnVertex.data(), NULL,
+		UnstructuredGrid::NODE, m.maxVertexPerFace, m.maxFacePerVertex
+	);
+	UnstructuredGridCoordless zug;
+
+	cout << "Nodes : " << m.nnodes << ", faces : " << m.nfaces << endl;
+
+	double t0 = Wasp::GetTime();
+	KDTreeRG kdtree(xug, yug);
+	cout << "KDTreeRG build time : " << Wasp::GetTime() - t0 << endl;
+
+	t0 = Wasp::GetTime();
+	FaceLocatorUG2D locator(xug, yug);
+	cout << "FaceLocatorUG2D build time : " << Wasp::GetTime() - t0 << endl;
+
+	vector <size_t> bdims = locator.GetBinDimensions();
+	cout << "FaceLocatorUG2D bins : " << bdims[0] << "x" << bdims[1]
+		<< ", memory : " << locator.GetMemoryUsage() << " bytes" << endl;
+
+	UnstructuredGrid2D kdgrid(
+		vertexDims, faceDims, edgeDims, bs, {m.data.data()},
+		m.vertexOnFace.data(), m.faceOnVertex.data(), NULL,
+		UnstructuredGrid::NODE, m.maxVertexPerFace, m.maxFacePerVertex,
+		xug, yug, zug, &kdtree
+	);
+	kdgrid.SetInterpolationOrder(1);
+
+	UnstructuredGrid2D locgrid(
+		vertexDims, faceDims, edgeDims, bs, {m.data.data()},
+		m.vertexOnFace.data(), m.faceOnVertex.data(), NULL,
+		UnstructuredGrid::NODE, m.maxVertexPerFace, m.maxFacePerVertex,
+		xug, yug, zug, &kdtree, &locator
+	);
+	locgrid.SetInterpolationOrder(1);
+
+	// Random points, some outside of the mesh, and a raster covering
+	// the mesh
+	//
+	size_t n = opt.npoints;
+	vector <double> random(3*n, 0.0);
+	for (size_t p=0; p<n; p++) {
+		random[3*p] = -0.05 + 1.1 * rand() / RAND_MAX;
+		random[3*p+1] = -0.05 + 1.1 * rand() / RAND_MAX;
+	}
+
+	size_t nrows = max((size_t) sqrt((double) n), (size_t) 1);
+	size_t ncols = (n + nrows - 1) / nrows;
+	vector <double> raster(3*n, 0.0);
+	for (size_t p=0; p<n; p++) {
+		raster[3*p] = (p % ncols + 0.5) / ncols;
+		raster[3*p+1] = (p / ncols + 0.5) / nrows;
+	}
+
+	for (int coherent = 0; coherent < 2; coherent++) {
+		const vector <double> &xyz = coherent ? raster : random;
+
+		cout << endl << (coherent ? "Coherent" : "Random") << " queries"
+			<< endl;
+		cout << setw(24) << "search" << setw(12) << "ns/pt" << setw(12)
+			<< "found" << setw(12) << "wrong" << endl;
+
+		reconstruct("k-d tree", kdgrid, xyz, false);
+		reconstruct("bin grid", locgrid, xyz, false);
+		reconstruct("walk (GetValues)", locgrid, xyz, true);
+	}
+
+	return(0);
+}
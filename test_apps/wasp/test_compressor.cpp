@@ -0,0 +1,309 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cfloat>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/Compressor.h>
+#include <vapor/SignificanceMap.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Wavelet decomposition benchmark. Decomposes blocks of a synthetic
+// field into one set of coefficients per compression ratio, as a VDC
+// conversion does, reports the time per block, and checks that the
+// coefficients of each set are stored in index order and are no
+// smaller in magnitude than those of the following sets. Each block
+// is then reconstructed from all of the sets. If every coefficient was
+// kept (a compression ratio of one) the reconstruction is checked
+// against the original block. If quantization is requested each set
+// is quantized and restored before reconstruction. The size of each
+// quantized set is checked, as is that the approximation coefficients
+// are restored exactly and that no other coefficient is in error by 
+// more than half the quantization step. The RMS error of the restored
+// coefficients of each set is reported next to that of a fixed width
+// quantizer with the same number of bits per coefficient.
+//
+
+struct {
+	std::vector <size_t> bs;
+	std::vector <size_t> cratios;
+	string wname;
+	int nblocks;
+	int qbits;
+	OptionParser::Boolean_T	fast;
+	OptionParser::Boolean_T	help;
+} opt;
+
+OptionParser::OptDescRec_T	set_opts[] = {
+	{"bs", 1, "64:64:64", "Colon delimited 1, 2, or 3-element vector "
+		"specifying the block dimensions"},
+	{"cratios", 1, "500:100:10:1", "Colon delimited vector of compression "
+		"ratios, in decreasing order"},
+	{"wname", 1, "bior4.4", "Wavelet name"},
+	{"nblocks", 1, "16", "Number of blocks to decompose"},
+	{"qbits", 1, "0", "Bits per quantized coefficient, or 0 for no "
+		"quantization"},
+	{"fast", 0, "", "Use the fast, single precision transform"},
+	{"help", 0, "", "Print this message and exit"},
+	{NULL}
+};
+
+OptionParser::Option_T	get_options[] = {
+	{"bs", Wasp::CvtToSize_tVec, &opt.bs, sizeof(opt.bs)},
+	{"cratios", Wasp::CvtToSize_tVec, &opt.cratios, sizeof(opt.cratios)},
+	{"wname", Wasp::CvtToCPPStr, &opt.wname, sizeof(opt.wname)},
+	{"nblocks", Wasp::CvtToInt, &opt.nblocks, sizeof(opt.nblocks)},
+	{"qbits", Wasp::CvtToInt, &opt.qbits, sizeof(opt.qbits)},
+	{"fast", Wasp::CvtToBoolean, &opt.fast, sizeof(opt.fast)},
+	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+	{NULL}
+};
+
+const char	*ProgName;
+
+// Smooth field plus noise, different for each block
+//
+void make_block(int b, vector <float> &data) {
+	size_t nx = opt.bs[0];
+	size_t ny = opt.bs.size() > 1 ? opt.bs[1] : 1;
+	for (size_t i=0; i<data.size(); i++) {
+		double x = (double) (i % nx) / nx;
+		double y = (double) ((i / nx) % ny) / ny;
+		double z = (double) (i / (nx * ny)) / nx;
+		data[i] = sin(6.0 * x + b) * cos(4.0 * y) + z * z +
+			0.01 * rand() / RAND_MAX;
+	}
+}
+
+// Check the sets returned by Decompose(). Returns the number of errors
+//
+int check_sets(
+	const vector <float> &coeffs, const vector <size_t> &ncoeffs,
+	vector <SignificanceMap> &sigmaps, size_t numkeep
+) {
+	int nerrors = 0;
+	double prevmin = HUGE_VAL;
+	const float *ptr = coeffs.data();
+
+	for (int j=0; j<ncoeffs.size(); j++) {
+		if (sigmaps[j].GetNumSignificant() != ncoeffs[j]) nerrors++;
+
+		double smin = HUGE_VAL, smax = 0.0;
+		sigmaps[j].GetNextEntryRestart();
+		size_t idx, last = 0;
+		for (size_t i=0; i<ncoeffs[j]; i++) {
+			if (sigmaps[j].GetNextEntry(&idx) <= 0) {
+				nerrors++;
+				break;
+			}
+			if (i && idx <= last) nerrors++;
+			last = idx;
+
+			// Approximation coefficients are kept regardless of magnitude
+			//
+			if (idx < numkeep) continue;
+
+			double v = fabs(ptr[i]);
+			smin = min(smin, v);
+			smax = max(smax, v);
+		}
+		if (smax > prevmin) nerrors++;
+		if (smin < HUGE_VAL) prevmin = smin;
+		ptr += ncoeffs[j];
+	}
+	return(nerrors);
+}
+
+// Quantize and restore each set in place. Returns the number of sets
+// whose size exceeds GetQuantizedSize(), whose approximation 
+// coefficients changed, or with a restored coefficient in error by more
+// than half the quantization step. The squared errors of each set, and 
+// those of a fixed width quantizer, are accumulated in 'sqerr' and 
+// 'fwsqerr'
+//
+int quantize_sets(
+	const Compressor &cmp, vector <float> &coeffs, 
+	const vector <size_t> &ncoeffs, vector <SignificanceMap> &sigmaps,
+	vector <double> &sqerr, vector <double> &fwsqerr
+) {
+	int nerrors = 0;
+	float *ptr = coeffs.data();
+	vector <float> restored;
+
+	for (int j=0; j<ncoeffs.size(); j++) {
+		size_t n = ncoeffs[j];
+		size_t nexact = j==0 ? cmp.GetNumUnquantized() : 0;
+		size_t size = cmp.GetQuantizedSize(n - nexact, opt.qbits);
+		vector <unsigned char> q(size);
+		restored.assign(ptr, ptr + n);
+
+		int rc = cmp.Quantize(ptr, sigmaps[j], opt.qbits, q.data());
+		if (rc < 0) return(1);
+		if (rc > size) nerrors++;
+
+		rc = cmp.Dequantize(q.data(), sigmaps[j], opt.qbits, restored.data());
+		if (rc < 0) return(1);
+
+		// Allow for the single precision rounding of restored values
+		//
+		double step = Compressor::GetQuantizationStep(q.data());
+		bool bad = false;
+		for (size_t i=0; i<n; i++) {
+			double err = fabs((double) restored[i] - (double) ptr[i]);
+			if (i < nexact && err != 0.0) bad = true;
+			if (err > 0.5 * step + fabs(ptr[i]) * FLT_EPSILON) bad = true;
+			sqerr[j] += err * err;
+		}
+		if (bad) nerrors++;
+
+		// The step of a fixed width quantizer spanning the magnitudes of
+		// the quantized coefficients, if there are any
+		//
+		if (n > nexact) {
+			double lo = HUGE_VAL, hi = 0.0;
+			for (size_t i=nexact; i<n; i++) {
+				lo = min(lo, (double) fabs(ptr[i]));
+				hi = max(hi, (double) fabs(ptr[i]));
+			}
+			double fwstep = (hi - lo) / ((1ULL << (opt.qbits-1)) - 1);
+			fwsqerr[j] += (n - nexact) * fwstep * fwstep / 12.0;
+		}
+
+		for (size_t i=0; i<n; i++) ptr[i] = restored[i];
+		ptr += n;
+	}
+	return(nerrors);
+}
+
+int main(int argc, char **argv) {
+
+	OptionParser op;
+
+	ProgName = Basename(argv[0]);
+
+	MyBase::SetErrMsgFilePtr(stderr);
+
+	if (op.AppendOptions(set_opts) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (op.ParseOptions(&argc, argv, get_options) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (opt.help) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(0);
+	}
+
+	if (opt.bs.size() < 1 || opt.bs.size() > 3 || opt.cratios.empty()) {
+		cerr << ProgName << " : invalid options" << endl;
+		exit(1);
+	}
+
+	Compressor cmp(opt.bs, opt.wname);
+	if (MyBase::GetErrCode() != 0) return(1);
+	cmp.FastTransformOnOff() = opt.fast;
+
+	// Number of coefficients in each set, as computed for a VDC
+	//
+	size_t ntotal = cmp.GetNumWaveCoeffs();
+	size_t naccum = 0;
+	vector <size_t> ncoeffs;
+	for (int i=0; i<opt.cratios.size(); i++) {
+		size_t n = ntotal / opt.cratios[i];
+		if (n < cmp.GetMinCompression()) n = cmp.GetMinCompression();
+		n = n > naccum ? n - naccum : 1;
+		naccum += n;
+		ncoeffs.push_back(n);
+	}
+	if (naccum > ntotal) {
+		cerr << ProgName << " : invalid cratios" << endl;
+		exit(1);
+	}
+
+	size_t nvalues = 1;
+	for (int i=0; i<opt.bs.size(); i++) nvalues *= opt.bs[i];
+
+	vector <float> data(nvalues);
+	vector <float> recon(nvalues);
+	vector <float> coeffs(naccum);
+	vector <SignificanceMap> sigmaps(ncoeffs.size());
+
+	vector <double> sqerr(ncoeffs.size(), 0.0);
+	vector <double> fwsqerr(ncoeffs.size(), 0.0);
+	double t = 0.0;
+	double tq = 0.0;
+	double tr = 0.0;
+	double maxerr = 0.0;
+	int nerrors = 0;
+	for (int b=0; b<opt.nblocks; b++) {
+		make_block(b, data);
+
+		double t0 = Wasp::GetTime();
+		int rc = cmp.Decompose(data.data(), coeffs.data(), ncoeffs, sigmaps);
+		t += Wasp::GetTime() - t0;
+		if (rc < 0) return(1);
+
+		nerrors += check_sets(
+			coeffs, ncoeffs, sigmaps, cmp.GetMinCompression()
+		);
+
+		if (opt.qbits) {
+			t0 = Wasp::GetTime();
+			nerrors += quantize_sets(
+				cmp, coeffs, ncoeffs, sigmaps, sqerr, fwsqerr
+			);
+			tq += Wasp::GetTime() - t0;
+		}
+
+		t0 = Wasp::GetTime();
+		rc = cmp.Reconstruct(coeffs.data(), recon.data(), sigmaps, -1);
+		tr += Wasp::GetTime() - t0;
+		if (rc < 0) return(1);
+
+		for (size_t i=0; i<nvalues; i++) {
+			maxerr = max(maxerr, (double) fabs(recon[i] - data[i]));
+		}
+	}
+
+	// Values are in [-1, 2]. Allow for single precision rounding of
+	// the coefficients
+	//
+	if (naccum == ntotal && ! opt.qbits && maxerr > 1e-5) nerrors++;
+
+	cout << "Coefficients per block : " << ntotal << ", sets :";
+	for (int i=0; i<ncoeffs.size(); i++) cout << " " << ncoeffs[i];
+	cout << endl;
+	cout << "Decompose time per block : " << fixed << setprecision(4)
+		<< t / opt.nblocks << endl;
+	cout << "Reconstruct time per block : " << fixed << setprecision(4)
+		<< tr / opt.nblocks << endl;
+	cout << "Max reconstruction error : " << scientific << setprecision(2)
+		<< maxerr << endl;
+	if (opt.qbits) {
+		cout << "Quantize and restore time per block : " << fixed 
+			<< setprecision(4) << tq / opt.nblocks << endl;
+	}
+	cout << scientific << setprecision(2);
+	for (int i=0; i<ncoeffs.size() && opt.qbits; i++) {
+		double n = (double) ncoeffs[i] * opt.nblocks;
+		cout << "Set " << i << " RMS quantization error : " 
+			<< sqrt(sqerr[i] / n) << ", fixed width : " 
+			<< sqrt(fwsqerr[i] / n) << endl;
+	}
+	cout << "Errors : " << nerrors << endl;
+
+	return(nerrors ? 1 : 0);
+}
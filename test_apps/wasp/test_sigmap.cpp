@@ -0,0 +1,148 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/SignificanceMap.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Significance map encoding test. For each fraction of entries set,
+// builds a map with randomly chosen entries, encodes it both with the
+// packed encoding and with whichever encoding GetMap() chooses, and
+// decodes each with SetMap(). Reports the encoded sizes and the time to
+// decode, and checks that the decoded entries match the original ones.
+//
+
+struct {
+	std::vector <size_t> dims;
+	std::vector <float> fractions;
+	int nreps;
+	OptionParser::Boolean_T	help;
+} opt;
+
+OptionParser::OptDescRec_T	set_opts[] = {
+	{"dims", 1, "64:64:64", "Colon delimited vector of map dimensions"},
+	{"fractions", 1, "0.0:0.0001:0.002:0.02:0.1:0.3:0.6:1.0",
+		"Colon delimited vector of fractions of entries set"},
+	{"nreps", 1, "10", "Number of times to decode each map"},
+	{"help", 0, "", "Print this message and exit"},
+	{NULL}
+};
+
+OptionParser::Option_T	get_options[] = {
+	{"dims", Wasp::CvtToSize_tVec, &opt.dims, sizeof(opt.dims)},
+	{"fractions", Wasp::CvtToFloatVec, &opt.fractions, sizeof(opt.fractions)},
+	{"nreps", Wasp::CvtToInt, &opt.nreps, sizeof(opt.nreps)},
+	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+	{NULL}
+};
+
+const char	*ProgName;
+
+// Encode 'sigmap', decode the result, and compare the entries. Returns
+// the number of errors
+//
+int test(
+	SignificanceMap &sigmap, bool packed, size_t &mapsize, double &t
+) {
+	mapsize = sigmap.GetMapSize(sigmap.GetNumSignificant(), packed);
+
+	// Exactly sized so that memory checkers catch overruns
+	//
+	vector <unsigned char> map(mapsize);
+	sigmap.GetMap(map.data(), packed);
+
+	SignificanceMap decoded;
+	t = 0.0;
+	for (int i=0; i<opt.nreps; i++) {
+		double t0 = Wasp::GetTime();
+		int rc = decoded.SetMap(map.data());
+		t += Wasp::GetTime() - t0;
+		if (rc < 0) return(1);
+	}
+	t /= opt.nreps;
+
+	if (decoded.GetNumSignificant() != sigmap.GetNumSignificant()) return(1);
+
+	int nerrors = 0;
+	size_t idx0, idx1;
+	sigmap.GetNextEntryRestart();
+	decoded.GetNextEntryRestart();
+	while (sigmap.GetNextEntry(&idx0)) {
+		if (! decoded.GetNextEntry(&idx1) || idx0 != idx1) nerrors++;
+	}
+	return(nerrors);
+}
+
+int main(int argc, char **argv) {
+
+	OptionParser op;
+
+	ProgName = Basename(argv[0]);
+
+	MyBase::SetErrMsgFilePtr(stderr);
+
+	if (op.AppendOptions(set_opts) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (op.ParseOptions(&argc, argv, get_options) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (opt.help) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(0);
+	}
+
+	size_t size = 1;
+	for (int i=0; i<opt.dims.size(); i++) size *= opt.dims[i];
+
+	cout << setw(10) << "fraction" << setw(10) << "entries"
+		<< setw(12) << "packed" << setw(12) << "encoded"
+		<< setw(12) << "decode" << setw(12) << "decode" << endl;
+
+	int nerrors = 0;
+	for (int i=0; i<opt.fractions.size(); i++) {
+		SignificanceMap sigmap(opt.dims);
+
+		// Unsorted, as the Compressor sets them
+		//
+		vector <bool> set(size, false);
+		size_t n = (size_t) (opt.fractions[i] * size);
+		while (sigmap.GetNumSignificant() < n) {
+			size_t idx = (((size_t) rand() << 16) ^ rand()) % size;
+			if (set[idx]) continue;
+			set[idx] = true;
+			sigmap.Set(idx);
+		}
+
+		size_t psize, esize;
+		double pt, et;
+		nerrors += test(sigmap, true, psize, pt);
+		nerrors += test(sigmap, false, esize, et);
+
+		// Never larger than the packed encoding
+		//
+		if (esize > psize) nerrors++;
+
+		cout << setw(10) << opt.fractions[i] << setw(10) << n
+			<< setw(12) << psize << setw(12) << esize
+			<< fixed << setprecision(6)
+			<< setw(12) << pt << setw(12) << et << endl;
+		cout.unsetf(ios::floatfield);
+	}
+	cout << "Errors : " << nerrors << endl;
+
+	return(nerrors ? 1 : 0);
+}
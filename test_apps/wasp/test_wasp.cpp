@@ -0,0 +1,384 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <netcdf.h>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/WASP.h>
+#include <vapor/Compressor.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// WASP round trip test. For float and double variables, writes a
+// compressed variable with and without the fast transform (see
+// WASP::SetFastTransform()), reads each back with and without it,
+// and checks that the values read match the ones written to within
+// the rounding of the transform. Then, for each number of bits 
+// requested, writes the variable with its coefficients quantized (see
+// WASP::SetQuantization()), and checks that InqVarQuantization() 
+// reports the number of bits and that the RMS error of the values read
+// is within the bound implied by the quantization step. Reports the 
+// time to write and read each variable.
+//
+
+struct {
+	std::vector <size_t> dims;
+	std::vector <size_t> bs;
+	string wname;
+	string ofile;
+	std::vector <int> qbits;
+	int nthreads;
+	OptionParser::Boolean_T	help;
+} opt;
+
+OptionParser::OptDescRec_T	set_opts[] = {
+	{"dims", 1, "128:128:128", "Colon delimited vector of variable "
+		"dimensions, slowest varying first"},
+	{"bs", 1, "64:64:64", "Colon delimited vector of block dimensions"},
+	{"wname", 1, "bior4.4", "Wavelet family used for compression"},
+	{"ofile", 1, "test_wasp.nc", "Path of the file written"},
+	{"qbits", 1, "4:8:16", "Colon delimited vector of bits per quantized "
+		"coefficient"},
+	{"nthreads", 1, "0", "Number of execution threads (0 => use "
+		"number of cores)"},
+	{"help", 0, "", "Print this message and exit"},
+	{NULL}
+};
+
+OptionParser::Option_T	get_options[] = {
+	{"dims", Wasp::CvtToSize_tVec, &opt.dims, sizeof(opt.dims)},
+	{"bs", Wasp::CvtToSize_tVec, &opt.bs, sizeof(opt.bs)},
+	{"wname", Wasp::CvtToCPPStr, &opt.wname, sizeof(opt.wname)},
+	{"ofile", Wasp::CvtToCPPStr, &opt.ofile, sizeof(opt.ofile)},
+	{"qbits", Wasp::CvtToIntVec, &opt.qbits, sizeof(opt.qbits)},
+	{"nthreads", Wasp::CvtToInt, &opt.nthreads, sizeof(opt.nthreads)},
+	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+	{NULL}
+};
+
+const char	*ProgName;
+
+// Smooth field with a little high frequency content, so that every
+// subband has significant coefficients
+//
+void make_data(vector <double> &data) {
+	size_t nx = opt.dims[opt.dims.size()-1];
+	size_t ny = opt.dims.size() > 1 ? opt.dims[opt.dims.size()-2] : 1;
+
+	for (size_t i=0; i<data.size(); i++) {
+		double x = (double) (i % nx);
+		double y = (double) ((i / nx) % ny);
+		double z = (double) (i / (nx*ny));
+		data[i] = sin(x * 0.1) * cos(y * 0.07) + 0.3 * sin(z * 0.05 + x * 0.02)
+			+ 0.01 * (double) ((i * 2654435761u) % 101) / 101.0;
+	}
+}
+
+// Largest quantization step chosen by Compressor::Quantize() for any
+// block of 'data' quantized to 'qbits' bits. Returns a negative value
+// on failure
+//
+double max_step(const vector <double> &data, int qbits) {
+
+	// Dimensions, fastest varying first
+	//
+	vector <size_t> dims(3, 1), bs(3, 1);
+	for (int i=0; i<opt.dims.size(); i++) {
+		dims[i] = opt.dims[opt.dims.size()-1-i];
+		bs[i] = opt.bs[opt.bs.size()-1-i];
+	}
+
+	Compressor cmp(vector <size_t> (opt.bs.rbegin(), opt.bs.rend()), opt.wname);
+
+	size_t n = bs[0] * bs[1] * bs[2];
+	vector <double> block(n), coeffs(n);
+	vector <size_t> ncoeffs(1, n);
+	vector <SignificanceMap> sigmaps(1);
+	vector <unsigned char> q(cmp.GetQuantizedSize(n, qbits));
+
+	double maxstep = 0.0;
+	for (size_t bz=0; bz<dims[2]; bz += bs[2]) {
+	for (size_t by=0; by<dims[1]; by += bs[1]) {
+	for (size_t bx=0; bx<dims[0]; bx += bs[0]) {
+		for (size_t z=0; z<bs[2]; z++) {
+		for (size_t y=0; y<bs[1]; y++) {
+		for (size_t x=0; x<bs[0]; x++) {
+			block[(z*bs[1] + y)*bs[0] + x] = 
+				data[((bz+z)*dims[1] + by+y)*dims[0] + bx+x];
+		}
+		}
+		}
+
+		int rc = cmp.Decompose(block.data(), coeffs.data(), ncoeffs, sigmaps);
+		if (rc<0) return(-1.0);
+
+		rc = cmp.Quantize(coeffs.data(), sigmaps[0], qbits, q.data());
+		if (rc<0) return(-1.0);
+
+		maxstep = max(maxstep, Compressor::GetQuantizationStep(q.data()));
+	}
+	}
+	}
+	return(maxstep);
+}
+
+template <class T>
+int write_var(
+	int xtype, const vector <T> &data, bool fast, int qbits, double &t
+) {
+	vector <string> dimnames;
+	for (int i=0; i<opt.dims.size(); i++) {
+		dimnames.push_back(string(1, "zyx"[3 - opt.dims.size() + i]));
+	}
+	vector <size_t> cratios(1, 1);
+
+	double t0 = Wasp::GetTime();
+
+	WASP wasp(opt.nthreads);
+	size_t chunksize = 1024*1024*4;
+	int rc = wasp.Create(
+		opt.ofile, NC_64BIT_OFFSET, 0, chunksize, cratios.size()
+	);
+	if (rc<0) return(-1);
+
+	int dummy;
+	rc = wasp.SetFill(NC_NOFILL, dummy);
+	if (rc<0) return(-1);
+
+	rc = wasp.SetQuantization(qbits);
+	if (rc<0) return(-1);
+
+	for (int i=0; i<opt.dims.size(); i++) {
+		rc = wasp.DefDim(dimnames[i], opt.dims[i]);
+		if (rc<0) return(-1);
+	}
+
+	rc = wasp.DefVar("var", xtype, dimnames, opt.wname, opt.bs, cratios);
+	if (rc<0) return(-1);
+
+	rc = wasp.EndDef();
+	if (rc<0) return(-1);
+
+	wasp.SetFastTransform(fast);
+	rc = wasp.OpenVarWrite("var", -1);
+	if (rc<0) return(-1);
+
+	rc = wasp.PutVar(data.data());
+	if (rc<0) return(-1);
+
+	rc = wasp.CloseVar();
+	if (rc<0) return(-1);
+
+	rc = wasp.Close();
+	if (rc<0) return(-1);
+
+	t = Wasp::GetTime() - t0;
+	return(0);
+}
+
+template <class T>
+int read_var(vector <T> &data, bool fast, int &qbits, double &t) {
+	double t0 = Wasp::GetTime();
+
+	WASP wasp(opt.nthreads);
+	int rc = wasp.Open(opt.ofile, NC_NOWRITE);
+	if (rc<0) return(-1);
+
+	rc = wasp.InqVarQuantization("var", qbits);
+	if (rc<0) return(-1);
+
+	wasp.SetFastTransform(fast);
+	rc = wasp.OpenVarRead("var", -1, -1);
+	if (rc<0) return(-1);
+
+	rc = wasp.GetVar(data.data());
+	if (rc<0) return(-1);
+
+	rc = wasp.CloseVar();
+	if (rc<0) return(-1);
+
+	rc = wasp.Close();
+	if (rc<0) return(-1);
+
+	t = Wasp::GetTime() - t0;
+	return(0);
+}
+
+template <class T>
+double max_error(const vector <T> &a, const vector <T> &b) {
+	double maxerr = 0.0;
+	for (size_t i=0; i<a.size(); i++) {
+		maxerr = max(maxerr, fabs((double) a[i] - (double) b[i]));
+	}
+	return(maxerr);
+}
+
+// Write and read a variable of external type 'xtype' with each
+// combination of transforms. Returns the number of errors
+//
+template <class T>
+int test(int xtype, const vector <double> &data, double tolerance) {
+	vector <T> src(data.begin(), data.end());
+	vector <T> dst(src.size());
+
+	int nerrors = 0;
+	for (int w=0; w<2; w++) {
+		double wt;
+		if (write_var(xtype, src, (bool) w, 0, wt) < 0) return(1);
+
+		for (int r=0; r<2; r++) {
+			double rt;
+			int qbits;
+			if (read_var(dst, (bool) r, qbits, rt) < 0) return(1);
+
+			double maxerr = max_error(src, dst);
+			if (! (maxerr <= tolerance)) nerrors++;
+			if (qbits != 0) nerrors++;
+
+			cout << setw(8) << (xtype == NC_FLOAT ? "float" : "double")
+				<< setw(8) << (w ? "fast" : "default")
+				<< setw(8) << (r ? "fast" : "default")
+				<< fixed << setprecision(4)
+				<< setw(10) << wt << setw(10) << rt;
+			cout.unsetf(ios::floatfield);
+			cout << setprecision(2) << scientific
+				<< setw(12) << maxerr << endl;
+			cout.unsetf(ios::floatfield);
+		}
+	}
+	return(nerrors);
+}
+
+// Write a variable of external type 'xtype' quantized to each of
+// opt.qbits bits, read it back, and check the error. Returns the number
+// of errors
+//
+template <class T>
+int test_quantized(int xtype, const vector <double> &data) {
+	vector <T> src(data.begin(), data.end());
+	vector <T> dst(src.size());
+
+	double maxabs = 0.0;
+	for (size_t j=0; j<data.size(); j++) maxabs = max(maxabs, fabs(data[j]));
+
+	int nerrors = 0;
+	for (int i=0; i<opt.qbits.size(); i++) {
+		double wt, rt;
+		int qbits;
+		if (write_var(xtype, src, false, opt.qbits[i], wt) < 0) return(1);
+		if (read_var(dst, false, qbits, rt) < 0) return(1);
+
+		if (qbits != opt.qbits[i]) nerrors++;
+
+		// Coefficients are restored to within half the step, and the
+		// synthesis of the biorthogonal wavelets amplifies coefficient
+		// errors by less than a factor of two. The steps chosen for the
+		// variable's coefficients, transformed in the precision of 'T',
+		// may differ slightly from those for 'data', and the values read
+		// are rounded to 'T'
+		//
+		double step = max_step(data, opt.qbits[i]);
+		if (step < 0.0) return(1);
+		double bound = 1.25 * step + maxabs * numeric_limits<T>::epsilon();
+
+		double sqerr = 0.0;
+		for (size_t j=0; j<src.size(); j++) {
+			sqerr += ((double) dst[j] - src[j]) * ((double) dst[j] - src[j]);
+		}
+		double rms = sqrt(sqerr / src.size());
+		if (! (rms <= bound)) nerrors++;
+
+		cout << setw(8) << (xtype == NC_FLOAT ? "float" : "double")
+			<< setw(8) << opt.qbits[i] << setw(8) << qbits
+			<< fixed << setprecision(4)
+			<< setw(10) << wt << setw(10) << rt;
+		cout.unsetf(ios::floatfield);
+		cout << setprecision(2) << scientific
+			<< setw(12) << rms << setw(12) << bound << endl;
+		cout.unsetf(ios::floatfield);
+	}
+	return(nerrors);
+}
+
+int main(int argc, char **argv) {
+
+	OptionParser op;
+
+	ProgName = Basename(argv[0]);
+
+	MyBase::SetErrMsgFilePtr(stderr);
+
+	if (op.AppendOptions(set_opts) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (op.ParseOptions(&argc, argv, get_options) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (opt.help) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(0);
+	}
+
+	if (opt.dims.size() < 1 || opt.dims.size() > 3 ||
+		opt.dims.size() != opt.bs.size()) {
+
+		cerr << ProgName << " : invalid dimensions" << endl;
+		exit(1);
+	}
+	for (int i=0; i<opt.dims.size(); i++) {
+		if (opt.dims[i] % opt.bs[i]) {
+			cerr << ProgName << " : dimensions must be multiples of the "
+				<< "block dimensions" << endl;
+			exit(1);
+		}
+	}
+	for (int i=0; i<opt.qbits.size(); i++) {
+		if (opt.qbits[i] < 2 || opt.qbits[i] > 32) {
+			cerr << ProgName << " : invalid quantization" << endl;
+			exit(1);
+		}
+	}
+
+	size_t size = 1;
+	for (int i=0; i<opt.dims.size(); i++) size *= opt.dims[i];
+
+	vector <double> data(size);
+	make_data(data);
+
+	cout << setw(8) << "type" << setw(8) << "write" << setw(8) << "read"
+		<< setw(10) << "write" << setw(10) << "read"
+		<< setw(12) << "max error" << endl;
+
+	// With a compression ratio of 1 every coefficient is stored, so the
+	// values read differ from those written only by the rounding of the
+	// transforms
+	//
+	int nerrors = 0;
+	nerrors += test <float> (NC_FLOAT, data, 2e-5);
+	nerrors += test <double> (NC_DOUBLE, data, 1e-9);
+
+	cout << endl;
+	cout << setw(8) << "type" << setw(8) << "qbits" << setw(8) << "stored"
+		<< setw(10) << "write" << setw(10) << "read"
+		<< setw(12) << "rms error" << setw(12) << "bound" << endl;
+
+	nerrors += test_quantized <float> (NC_FLOAT, data);
+	nerrors += test_quantized <double> (NC_DOUBLE, data);
+
+	cout << "Errors : " << nerrors << endl;
+
+	return(nerrors ? 1 : 0);
+}
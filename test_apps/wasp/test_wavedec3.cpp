@@ -0,0 +1,284 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/MatWaveWavedec.h>
+#include <vapor/WaveFiltBase.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// 3D wavelet transform benchmark. For each combination of wavelet and
+// cubic block size, transforms a synthetic block with wavedec3() and
+// reconstructs it with waverec3(), using the wavelet's default boundary
+// extension mode and the maximum number of levels, with the default and
+// with the fast transform (see MatWaveBase::FastTransformOnOff()).
+// Reports the time per block of each and checks the reconstruction 
+// error.
+//
+// For the odd length, symmetric wavelets, which the fast transform
+// computes by lifting, the single level dwt() and idwt() of a 1D signal
+// are also checked against a convolution computed directly from the 
+// wavelet's filters, in double and float precision. With the default
+// transform the float coefficients must be exactly those of the double
+// transform, rounded.
+//
+
+struct {
+	std::vector <size_t> sizes;
+	std::vector <string> wnames;
+	int nblocks;
+	OptionParser::Boolean_T	help;
+} opt;
+
+OptionParser::OptDescRec_T	set_opts[] = {
+	{"sizes", 1, "32:64:128", "Colon delimited vector of block edge lengths"},
+	{"wnames", 1, "haar:bior1.1:bior2.2:bior3.3:bior4.4:db4:coif2",
+		"Colon delimited vector of wavelet names"},
+	{"nblocks", 1, "4", "Number of blocks to transform for each combination"},
+	{"help", 0, "", "Print this message and exit"},
+	{NULL}
+};
+
+OptionParser::Option_T	get_options[] = {
+	{"sizes", Wasp::CvtToSize_tVec, &opt.sizes, sizeof(opt.sizes)},
+	{"wnames", Wasp::CvtToStrVec, &opt.wnames, sizeof(opt.wnames)},
+	{"nblocks", Wasp::CvtToInt, &opt.nblocks, sizeof(opt.nblocks)},
+	{"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+	{NULL}
+};
+
+const char	*ProgName;
+
+// Smooth field plus noise, with values in [-1, 2]
+//
+void make_block(size_t n, vector <float> &data) {
+	for (size_t i=0; i<data.size(); i++) {
+		double x = (double) (i % n) / n;
+		double y = (double) ((i / n) % n) / n;
+		double z = (double) (i / (n * n)) / n;
+		data[i] = sin(6.0 * x) * cos(4.0 * y) + z * z +
+			0.01 * rand() / RAND_MAX;
+	}
+}
+
+// Single level transform of x, computed by convolving the symmetric
+// (W) extension of x with the decomposition filters of wf. wf must be
+// of odd length and symmetric
+//
+void reference_dwt(
+	const WaveFiltBase *wf, const vector <double> &x,
+	vector <double> &cA, vector <double> &cD
+) {
+	int n = x.size();
+	int m = wf->GetLength() >> 1;
+	const double *low = wf->GetLowDecomFilCoef();
+	const double *high = wf->GetHighDecomFilCoef();
+
+	// Reflect about the first and last samples
+	//
+	auto xext = [&](int i) {
+		while (i < 0 || i >= n) {
+			if (i < 0) i = -i;
+			if (i >= n) i = 2*(n-1) - i;
+		}
+		return(x[i]);
+	};
+
+	cA.assign((n+1) / 2, 0.0);
+	cD.assign(n / 2, 0.0);
+	for (int i=0; i<cA.size(); i++) {
+		for (int p=-m; p<=m; p++) cA[i] += low[m-p] * xext(2*i + p);
+	}
+	for (int i=0; i<cD.size(); i++) {
+		for (int p=-m; p<=m; p++) cD[i] += high[m-p] * xext(2*i + 1 + p);
+	}
+}
+
+// Largest difference between a and b, relative to the largest
+// magnitude in b
+//
+template <class T>
+double maxrelerr(const T *a, const vector <double> &b) {
+	double maxerr = 0.0;
+	double maxval = 0.0;
+	for (size_t i=0; i<b.size(); i++) {
+		maxerr = max(maxerr, fabs((double) a[i] - b[i]));
+		maxval = max(maxval, fabs(b[i]));
+	}
+	return(maxval > 0.0 ? maxerr / maxval : maxerr);
+}
+
+// Check dwt() and idwt() of a signal of length n against
+// reference_dwt(), in double and float precision. Returns the number
+// of errors
+//
+int check_1d(const string &wname, size_t n, bool fast) {
+	MatWaveDwt mw(wname, "symw");
+	if (MyBase::GetErrCode() != 0) return(1);
+	mw.FastTransformOnOff() = fast;
+
+	const WaveFiltBase *wf = mw.wavelet();
+	if (! wf->issymmetric() || ! (wf->GetLength() % 2)) return(0);
+
+	vector <double> x(n);
+	for (size_t i=0; i<n; i++) {
+		x[i] = sin(0.3 * i) + 0.01 * rand() / RAND_MAX;
+	}
+
+	vector <double> refA, refD;
+	reference_dwt(wf, x, refA, refD);
+
+	vector <double> ref(refA);
+	ref.insert(ref.end(), refD.begin(), refD.end());
+	vector <float> xf(x.begin(), x.end());
+	vector <float> reff(ref.begin(), ref.end());
+
+	size_t L[3];
+	vector <double> C(ref.size());
+	vector <float> Cf(ref.size());
+	vector <double> y(n);
+	vector <float> yf(n);
+
+	double err[4];
+	if (mw.dwt(x.data(), n, C.data(), L) < 0) return(1);
+	err[0] = maxrelerr(C.data(), ref);
+
+	if (mw.dwt(xf.data(), n, Cf.data(), L) < 0) return(1);
+	err[1] = maxrelerr(Cf.data(), ref);
+
+	vector <double> xfd(xf.begin(), xf.end());
+	vector <double> Cfd(ref.size());
+	if (mw.dwt(xfd.data(), n, Cfd.data(), L) < 0) return(1);
+	bool rounded = true;
+	for (size_t i=0; i<Cf.size(); i++) {
+		rounded = rounded && Cf[i] == (float) Cfd[i];
+	}
+
+	if (mw.idwt(ref.data(), L, y.data()) < 0) return(1);
+	err[2] = maxrelerr(y.data(), x);
+
+	if (mw.idwt(reff.data(), L, yf.data()) < 0) return(1);
+	err[3] = maxrelerr(yf.data(), x);
+
+	cout << setw(10) << wname << setw(6) << n << setw(6) << (fast ? "yes" : "no")
+		<< scientific << setprecision(2)
+		<< setw(12) << err[0] << setw(12) << err[1]
+		<< setw(12) << err[2] << setw(12) << err[3] << endl;
+
+	// Lifting reproduces the exact filters, which differ from the
+	// tabulated bior4.4 coefficients in the twelfth digit
+	//
+	int nerrors = 0;
+	if (err[0] > 1e-10 || err[2] > 1e-10) nerrors++;
+	if (err[1] > 1e-6 || err[3] > 1e-6) nerrors++;
+	if (! fast && ! rounded) nerrors++;
+	return(nerrors);
+}
+
+// Benchmark one wavelet and block size. Returns the number of errors
+//
+int bench(const string &wname, size_t n, bool fast) {
+	MatWaveWavedec mw(wname);
+	if (MyBase::GetErrCode() != 0) return(1);
+	mw.FastTransformOnOff() = fast;
+
+	int nlevels = mw.wmaxlev(n);
+	size_t clen = mw.coefflength3(n, n, n, nlevels);
+
+	vector <float> data(n * n * n);
+	vector <float> recon(n * n * n);
+	vector <float> C(clen);
+	vector <size_t> L((21 * nlevels) + 6);
+
+	make_block(n, data);
+
+	double tdec = 0.0;
+	double trec = 0.0;
+	for (int b=0; b<opt.nblocks; b++) {
+		double t0 = Wasp::GetTime();
+		int rc = mw.wavedec3(data.data(), n, n, n, nlevels, C.data(), L.data());
+		tdec += Wasp::GetTime() - t0;
+		if (rc < 0) return(1);
+
+		t0 = Wasp::GetTime();
+		rc = mw.waverec3(C.data(), L.data(), nlevels, recon.data());
+		trec += Wasp::GetTime() - t0;
+		if (rc < 0) return(1);
+	}
+
+	double maxerr = 0.0;
+	for (size_t i=0; i<data.size(); i++) {
+		maxerr = max(maxerr, (double) fabs(recon[i] - data[i]));
+	}
+
+	cout << setw(10) << wname << setw(6) << n << setw(8) << nlevels
+		<< setw(6) << (fast ? "yes" : "no") << fixed << setprecision(4)
+		<< setw(12) << tdec / opt.nblocks
+		<< setw(12) << trec / opt.nblocks
+		<< scientific << setprecision(2) << setw(12) << maxerr << endl;
+
+	// Allow for single precision rounding of the coefficients
+	//
+	return(maxerr > 1e-5 ? 1 : 0);
+}
+
+int main(int argc, char **argv) {
+
+	OptionParser op;
+
+	ProgName = Basename(argv[0]);
+
+	MyBase::SetErrMsgFilePtr(stderr);
+
+	if (op.AppendOptions(set_opts) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (op.ParseOptions(&argc, argv, get_options) < 0) {
+		cerr << ProgName << " : " << op.GetErrMsg();
+		exit(1);
+	}
+
+	if (opt.help) {
+		cerr << "Usage: " << ProgName << " [options] " << endl;
+		op.PrintOptionHelp(stderr);
+		exit(0);
+	}
+
+	int nerrors = 0;
+
+	cout << setw(10) << "wavelet" << setw(6) << "size" << setw(6) << "fast"
+		<< setw(12) << "dwt" << setw(12) << "dwt float"
+		<< setw(12) << "idwt" << setw(12) << "idwt float" << endl;
+
+	for (int i=0; i<opt.wnames.size(); i++) {
+		for (int fast=0; fast<2; fast++) {
+			nerrors += check_1d(opt.wnames[i], 64, fast);
+			nerrors += check_1d(opt.wnames[i], 37, fast);
+		}
+	}
+	cout << endl;
+
+	cout << setw(10) << "wavelet" << setw(6) << "size" << setw(8) << "levels"
+		<< setw(6) << "fast" << setw(12) << "wavedec3" << setw(12) << "waverec3"
+		<< setw(12) << "max error" << endl;
+
+	for (int i=0; i<opt.wnames.size(); i++) {
+		for (int j=0; j<opt.sizes.size(); j++) {
+			nerrors += bench(opt.wnames[i], opt.sizes[j], false);
+			nerrors += bench(opt.wnames[i], opt.sizes[j], true);
+		}
+	}
+	cout << "Errors : " << nerrors << endl;
+
+	return(nerrors ? 1 : 0);
+}